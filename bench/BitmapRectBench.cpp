@@ -39,8 +39,19 @@ static void draw_into_bitmap(const SkBitmap& bm) {
  */
 
 class BitmapRectBench : public Benchmark {
+public:
+    enum MatrixType {
+        kIdentity_MatrixType,
+        // A fractional translate, with a scale too small to be noticed.
+        kSlight_MatrixType,
+        // A fractional translate and a scale of 3/2, which draws through the
+        // scale+translate shader procs.
+        kScale_MatrixType
+    };
+
+private:
     SkBitmap                fBitmap;
-    bool                    fSlightMatrix;
+    MatrixType              fMatrixType;
     uint8_t                 fAlpha;
     SkPaint::FilterLevel    fFilterLevel;
     SkString                fName;
@@ -50,20 +61,21 @@ class BitmapRectBench : public Benchmark {
     static const int kHeight = 128;
 public:
     BitmapRectBench(U8CPU alpha, SkPaint::FilterLevel filterLevel,
-                    bool slightMatrix)  {
+                    MatrixType matrixType)  {
         fAlpha = SkToU8(alpha);
         fFilterLevel = filterLevel;
-        fSlightMatrix = slightMatrix;
+        fMatrixType = matrixType;
 
         fBitmap.setInfo(SkImageInfo::MakeN32Premul(kWidth, kHeight));
     }
 
 protected:
     virtual const char* onGetName() SK_OVERRIDE {
+        static const char* gMatrixNames[] = { "identity", "trans", "scale" };
         fName.printf("bitmaprect_%02X_%sfilter_%s",
                      fAlpha,
                      SkPaint::kNone_FilterLevel == fFilterLevel ? "no" : "",
-                     fSlightMatrix ? "trans" : "identity");
+                     gMatrixNames[fMatrixType]);
         return fName.c_str();
     }
 
@@ -76,13 +88,16 @@ protected:
         fSrcR.iset(0, 0, kWidth, kHeight);
         fDstR.iset(0, 0, kWidth, kHeight);
 
-        if (fSlightMatrix) {
+        if (kSlight_MatrixType == fMatrixType) {
             // want fractional translate
             fDstR.offset(SK_Scalar1 / 3, SK_Scalar1 * 5 / 7);
             // want enough to create a scale matrix, but not enough to scare
             // off our sniffer which tries to see if the matrix is "effectively"
             // translate-only.
             fDstR.fRight += SK_Scalar1 / (kWidth * 60);
+        } else if (kScale_MatrixType == fMatrixType) {
+            fDstR.set(SK_Scalar1 / 3, SK_Scalar1 * 5 / 7,
+                      SkIntToScalar(kWidth * 3 / 2), SkIntToScalar(kHeight * 3 / 2));
         }
     }
 
@@ -104,10 +119,15 @@ private:
     typedef Benchmark INHERITED;
 };
 
-DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kNone_FilterLevel, false))
-DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kNone_FilterLevel, false))
-DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kLow_FilterLevel, false))
-DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kLow_FilterLevel, false))
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kNone_FilterLevel, BitmapRectBench::kIdentity_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kNone_FilterLevel, BitmapRectBench::kIdentity_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kLow_FilterLevel, BitmapRectBench::kIdentity_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kLow_FilterLevel, BitmapRectBench::kIdentity_MatrixType))
+
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kNone_FilterLevel, BitmapRectBench::kSlight_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kLow_FilterLevel, BitmapRectBench::kSlight_MatrixType))
 
-DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kNone_FilterLevel, true))
-DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kLow_FilterLevel, true))
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kNone_FilterLevel, BitmapRectBench::kScale_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kNone_FilterLevel, BitmapRectBench::kScale_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0xFF, SkPaint::kLow_FilterLevel, BitmapRectBench::kScale_MatrixType))
+DEF_BENCH(return new BitmapRectBench(0x80, SkPaint::kLow_FilterLevel, BitmapRectBench::kScale_MatrixType))
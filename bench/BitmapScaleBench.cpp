@@ -84,19 +84,24 @@ private:
 
 class BitmapFilterScaleBench: public BitmapScaleBench {
  public:
-    BitmapFilterScaleBench( int is, int os) : INHERITED(is, os) {
-        setName( "filter" );
+    BitmapFilterScaleBench( int is, int os,
+                            SkPaint::FilterLevel level = SkPaint::kHigh_FilterLevel)
+        : INHERITED(is, os), fFilterLevel(level) {
+        static const char* gNames[] = { "nearest", "bilerp", "mipmap", "filter" };
+        setName( gNames[level] );
     }
 protected:
     virtual void doScaleImage() SK_OVERRIDE {
         SkCanvas canvas( fOutputBitmap );
         SkPaint paint;
 
-        paint.setFilterLevel(SkPaint::kHigh_FilterLevel);
+        paint.setFilterLevel(fFilterLevel);
         fInputBitmap.notifyPixelsChanged();
         canvas.drawBitmapMatrix( fInputBitmap, fMatrix, &paint );
     }
 private:
+    SkPaint::FilterLevel fFilterLevel;
+
     typedef BitmapScaleBench INHERITED;
 };
 
@@ -109,3 +114,12 @@ DEF_BENCH(return new BitmapFilterScaleBench(90, 30);)
 DEF_BENCH(return new BitmapFilterScaleBench(90, 10);)
 DEF_BENCH(return new BitmapFilterScaleBench(256, 64);)
 DEF_BENCH(return new BitmapFilterScaleBench(64, 256);)
+
+// Scale+translate without the high quality filter's resampling, which draws
+// through the bitmap shader procs.
+DEF_BENCH(return new BitmapFilterScaleBench(256, 64, SkPaint::kNone_FilterLevel);)
+DEF_BENCH(return new BitmapFilterScaleBench(64, 256, SkPaint::kNone_FilterLevel);)
+DEF_BENCH(return new BitmapFilterScaleBench(1024, 600, SkPaint::kNone_FilterLevel);)
+DEF_BENCH(return new BitmapFilterScaleBench(256, 64, SkPaint::kLow_FilterLevel);)
+DEF_BENCH(return new BitmapFilterScaleBench(64, 256, SkPaint::kLow_FilterLevel);)
+DEF_BENCH(return new BitmapFilterScaleBench(1024, 600, SkPaint::kLow_FilterLevel);)
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkColorTable.h"
+#include "SkPaint.h"
+#include "SkShader.h"
+#include "SkString.h"
+#include "sk_tool_utils.h"
+
+/*
+ *  Draws a scaled bitmap shader for every combination of source config, x and
+ *  y tile mode, filtering and paint alpha that SkBitmapProcState has a 32 bit
+ *  shader proc for (see SkBitmapProcState_shaderproc_template.h).
+ */
+
+static const SkColorType gColorTypes[] = {
+    kN32_SkColorType,
+    kRGB_565_SkColorType,
+    kIndex_8_SkColorType,
+    kARGB_4444_SkColorType,
+    kAlpha_8_SkColorType,
+};
+
+static const SkShader::TileMode gTileModes[] = {
+    SkShader::kClamp_TileMode,
+    SkShader::kRepeat_TileMode,
+    SkShader::kMirror_TileMode,
+};
+
+static const char* gTileModeNames[] = { "clamp", "repeat", "mirror" };
+
+static const int kTileModeCount = SK_ARRAY_COUNT(gTileModes);
+static const int kComboCount = SK_ARRAY_COUNT(gColorTypes) * kTileModeCount * kTileModeCount * 4;
+
+static void make_bitmap(SkColorType ct, int w, int h, SkBitmap* bm) {
+    SkBitmap src;
+    src.allocN32Pixels(w, h);
+    for (int y = 0; y < h; ++y) {
+        SkPMColor* row = src.getAddr32(0, y);
+        for (int x = 0; x < w; ++x) {
+            row[x] = SkPackARGB32(0xFF, x * 0xFF / w, y * 0xFF / h, (x ^ y) & 0xFF);
+        }
+    }
+
+    switch (ct) {
+        case kN32_SkColorType:
+            *bm = src;
+            break;
+        case kIndex_8_SkColorType: {
+            // A 3-3-2 palette.
+            SkPMColor colors[256];
+            for (int i = 0; i < 256; ++i) {
+                colors[i] = SkPackARGB32(0xFF, (i >> 5) * 0xFF / 7, ((i >> 2) & 7) * 0xFF / 7,
+                                         (i & 3) * 0xFF / 3);
+            }
+            SkColorTable* ctable = SkNEW_ARGS(SkColorTable, (colors, 256, kOpaque_SkAlphaType));
+            bm->allocPixels(SkImageInfo::Make(w, h, kIndex_8_SkColorType, kOpaque_SkAlphaType),
+                            NULL, ctable);
+            ctable->unref();
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    const SkPMColor c = *src.getAddr32(x, y);
+                    *bm->getAddr8(x, y) = (SkGetPackedR32(c) & 0xE0) |
+                                          ((SkGetPackedG32(c) >> 3) & 0x1C) |
+                                          (SkGetPackedB32(c) >> 6);
+                }
+            }
+            break;
+        }
+        case kAlpha_8_SkColorType:
+            bm->allocPixels(SkImageInfo::MakeA8(w, h));
+            for (int y = 0; y < h; ++y) {
+                for (int x = 0; x < w; ++x) {
+                    *bm->getAddr8(x, y) = SkGetPackedG32(*src.getAddr32(x, y));
+                }
+            }
+            break;
+        default:
+            src.copyTo(bm, ct);
+            break;
+    }
+}
+
+class BitmapShaderBench : public Benchmark {
+public:
+    // index enumerates color type, x tile mode, y tile mode, filter and alpha.
+    explicit BitmapShaderBench(int index) {
+        fAlpha = SkToBool(index & 1);
+        index >>= 1;
+        fFilter = SkToBool(index & 1);
+        index >>= 1;
+        fTileY = gTileModes[index % kTileModeCount];
+        index /= kTileModeCount;
+        fTileX = gTileModes[index % kTileModeCount];
+        index /= kTileModeCount;
+        fColorType = gColorTypes[index];
+
+        fName.printf("bitmapshader_%s_%s_%s_%s_%s",
+                     sk_tool_utils::colortype_name(fColorType),
+                     gTileModeNames[fTileX], gTileModeNames[fTileY],
+                     fFilter ? "bilerp" : "nearest", fAlpha ? "alpha" : "opaque");
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        make_bitmap(fColorType, 100, 100, &fBitmap);
+
+        // Scale up by a non-integer amount, and draw around the bitmap so
+        // every tile mode has to tile.
+        SkMatrix m;
+        m.setScale(SkFloatToScalar(1.7f), SkFloatToScalar(1.3f));
+        m.postTranslate(SkIntToScalar(-37), SkIntToScalar(-23));
+        SkShader* s = SkShader::CreateBitmapShader(fBitmap, fTileX, fTileY, &m);
+        fPaint.setShader(s)->unref();
+        fPaint.setFilterLevel(fFilter ? SkPaint::kLow_FilterLevel : SkPaint::kNone_FilterLevel);
+        fPaint.setAlpha(fAlpha ? 0x80 : 0xFF);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        for (int i = 0; i < loops; i++) {
+            canvas->drawPaint(fPaint);
+        }
+    }
+
+private:
+    SkColorType         fColorType;
+    SkShader::TileMode  fTileX;
+    SkShader::TileMode  fTileY;
+    bool                fFilter;
+    bool                fAlpha;
+    SkString            fName;
+    SkBitmap            fBitmap;
+    SkPaint             fPaint;
+
+    typedef Benchmark INHERITED;
+};
+
+// Registers a BitmapShaderBench for every index below N.
+template <int N> class BitmapShaderBenchRegistry {
+public:
+    BitmapShaderBenchRegistry() : fReg(Factory) {}
+
+private:
+    static Benchmark* Factory(void*) {
+        return SkNEW_ARGS(BitmapShaderBench, (N - 1));
+    }
+
+    BitmapShaderBenchRegistry<N - 1> fNext;
+    BenchRegistry                    fReg;
+};
+
+template <> class BitmapShaderBenchRegistry<0> {};
+
+static BitmapShaderBenchRegistry<kComboCount> gRegistry;
@@ -8,6 +8,7 @@
 #include "SkCanvas.h"
 #include "SkColorFilterImageFilter.h"
 #include "SkColorMatrixFilter.h"
+#include "SkColorPriv.h"
 #include "SkLumaColorFilter.h"
 #include "SkTableColorFilter.h"
 
@@ -342,6 +343,108 @@ private:
     typedef ColorFilterBaseBench INHERITED;
 };
 
+// Draws a bitmap through a chain of kChainLength color filters. The saturation matrices never
+// leave [0, 255], so their chain folds into a single matrix; the brightness matrices saturate, so
+// each one of them filters the spans in turn.
+class ColorFilterChainBench : public ColorFilterBaseBench {
+
+public:
+    ColorFilterChainBench(bool small, bool bright)
+        : INHERITED(small)
+        , fBright(bright) {
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        if (fBright) {
+            return isSmall() ? "colorfilter_bright_chain_small" : "colorfilter_bright_chain_large";
+        }
+        return isSmall() ? "colorfilter_saturation_chain_small"
+                         : "colorfilter_saturation_chain_large";
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRect r = getFilterRect();
+        fBitmap.allocN32Pixels(SkScalarRoundToInt(r.width()), SkScalarRoundToInt(r.height()));
+        for (int y = 0; y < fBitmap.height(); ++y) {
+            for (int x = 0; x < fBitmap.width(); ++x) {
+                const U8CPU alpha = (x + y) & 0xFF;
+                *fBitmap.getAddr32(x, y) = SkPackARGB32(alpha, alpha * x / fBitmap.width(),
+                                                        alpha * y / fBitmap.height(), alpha / 2);
+            }
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        SkPaint paint;
+        for (int i = 0; i < loops; i++) {
+            SkAutoTUnref<SkColorFilter> chain;
+            for (int f = 0; f < kChainLength; ++f) {
+                SkAutoTUnref<SkColorFilter> filter(fBright ? make_bright_filter(f)
+                                                               : make_saturation_filter(f));
+                chain.reset(SkColorFilter::CreateComposeFilter(filter, chain));
+            }
+            paint.setColorFilter(chain);
+            canvas->drawBitmap(fBitmap, 0, 0, &paint);
+        }
+    }
+
+private:
+    static const int kChainLength = 8;
+
+    static SkColorFilter* make_bright_filter(int index) {
+        const SkScalar amount = (index & 1) ? 40 : -30;
+        SkColorMatrix matrix;
+        matrix.setIdentity();
+        matrix.postTranslate(amount, amount, amount);
+        return SkColorMatrixFilter::Create(matrix);
+    }
+
+    static SkColorFilter* make_saturation_filter(int index) {
+        SkColorMatrix matrix;
+        matrix.setSaturation(SkIntToScalar(index + 1) / (kChainLength + 1));
+        return SkColorMatrixFilter::Create(matrix);
+    }
+
+    bool     fBright;
+    SkBitmap fBitmap;
+
+    typedef ColorFilterBaseBench INHERITED;
+};
+
+// Draws a rect through a chain of kChainLength image filters whose brightness matrices saturate,
+// so that they cannot be folded into a single matrix.
+class ColorFilterImageChainBench : public ColorFilterBaseBench {
+
+public:
+    ColorFilterImageChainBench(bool small) : INHERITED(small) {
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return isSmall() ? "colorfilter_image_chain_small" : "colorfilter_image_chain_large";
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
+        SkRect r = getFilterRect();
+        SkPaint paint;
+        paint.setColor(SK_ColorRED);
+        for (int i = 0; i < loops; i++) {
+            SkAutoTUnref<SkImageFilter> chain;
+            for (int f = 0; f < kChainLength; ++f) {
+                chain.reset(make_brightness((f & 1) ? 0.15f : -0.1f, chain));
+            }
+            paint.setImageFilter(chain);
+            canvas->drawRect(r, paint);
+        }
+    }
+
+private:
+    static const int kChainLength = 8;
+
+    typedef ColorFilterBaseBench INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new ColorFilterDimBrightBench(true); )
@@ -354,6 +457,9 @@ DEF_BENCH( return new ColorFilterBlueBench(true); )
 DEF_BENCH( return new ColorFilterGrayBench(true); )
 DEF_BENCH( return new TableColorFilterBench(true); )
 DEF_BENCH( return new LumaColorFilterBench(true); )
+DEF_BENCH( return new ColorFilterChainBench(true, false); )
+DEF_BENCH( return new ColorFilterChainBench(true, true); )
+DEF_BENCH( return new ColorFilterImageChainBench(true); )
 
 DEF_BENCH( return new ColorFilterDimBrightBench(false); )
 DEF_BENCH( return new ColorFilterBrightGrayBench(false); )
@@ -365,3 +471,6 @@ DEF_BENCH( return new ColorFilterBlueBench(false); )
 DEF_BENCH( return new ColorFilterGrayBench(false); )
 DEF_BENCH( return new TableColorFilterBench(false); )
 DEF_BENCH( return new LumaColorFilterBench(false); )
+DEF_BENCH( return new ColorFilterChainBench(false, false); )
+DEF_BENCH( return new ColorFilterChainBench(false, true); )
+DEF_BENCH( return new ColorFilterImageChainBench(false); )
@@ -9,19 +9,42 @@
 #include "SkBitmapSource.h"
 #include "SkCanvas.h"
 #include "SkDisplacementMapEffect.h"
+#include "SkString.h"
 
 #define FILTER_WIDTH_SMALL  32
 #define FILTER_HEIGHT_SMALL 32
 #define FILTER_WIDTH_LARGE  256
 #define FILTER_HEIGHT_LARGE 256
+#define FILTER_WIDTH_HUGE   2048
+#define FILTER_HEIGHT_HUGE  2048
 
 class DisplacementBaseBench : public Benchmark {
 public:
-    DisplacementBaseBench(bool small) :
-        fInitialized(false), fIsSmall(small) {
+    enum Size {
+        kSmall_Size,
+        kLarge_Size,
+        kHuge_Size,     // larger than the default canvas, displaced in several bands
+    };
+
+    DisplacementBaseBench(const char* name, Size size) :
+        fInitialized(false), fSize(size) {
+        static const char* gSuffixes[] = { "small", "large", "huge" };
+        fName.printf("displacement_%s_%s", name, gSuffixes[size]);
     }
 
 protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual SkIPoint onGetSize() SK_OVERRIDE {
+        if (kHuge_Size == fSize) {
+            // Room for the bitmap at the largest offset the benches draw it at.
+            return SkIPoint::Make(FILTER_WIDTH_HUGE + 200, FILTER_HEIGHT_HUGE);
+        }
+        return this->INHERITED::onGetSize();
+    }
+
     virtual void onPreDraw() SK_OVERRIDE {
         if (!fInitialized) {
             this->makeBitmap();
@@ -31,9 +54,7 @@ protected:
     }
 
     void makeBitmap() {
-        const int w = this->isSmall() ? FILTER_WIDTH_SMALL : FILTER_WIDTH_LARGE;
-        const int h = this->isSmall() ? FILTER_HEIGHT_LARGE : FILTER_HEIGHT_LARGE;
-        fBitmap.allocN32Pixels(w, h);
+        fBitmap.allocN32Pixels(this->width(), this->height());
         SkCanvas canvas(fBitmap);
         canvas.clear(0x00000000);
         SkPaint paint;
@@ -45,8 +66,8 @@ protected:
     }
 
     void makeCheckerboard() {
-        const int w = this->isSmall() ? FILTER_WIDTH_SMALL : FILTER_WIDTH_LARGE;
-        const int h = this->isSmall() ? FILTER_HEIGHT_LARGE : FILTER_HEIGHT_LARGE;
+        const int w = this->width();
+        const int h = this->height();
         fCheckerboard.allocN32Pixels(w, h);
         SkCanvas canvas(fCheckerboard);
         canvas.clear(0x00000000);
@@ -76,25 +97,37 @@ protected:
         canvas->restore();
     }
 
-    inline bool isSmall() const { return fIsSmall; }
+    int width() const {
+        switch (fSize) {
+            case kSmall_Size:
+                return FILTER_WIDTH_SMALL;
+            case kLarge_Size:
+                return FILTER_WIDTH_LARGE;
+            case kHuge_Size:
+                return FILTER_WIDTH_HUGE;
+        }
+        return 0;
+    }
+
+    // The small bitmaps have always been as tall as the large ones.
+    int height() const {
+        return kHuge_Size == fSize ? FILTER_HEIGHT_HUGE : FILTER_HEIGHT_LARGE;
+    }
 
     SkBitmap fBitmap, fCheckerboard;
 private:
     bool fInitialized;
-    bool fIsSmall;
+    Size fSize;
+    SkString fName;
     typedef Benchmark INHERITED;
 };
 
 class DisplacementZeroBench : public DisplacementBaseBench {
 public:
-    DisplacementZeroBench(bool small) : INHERITED(small) {
+    DisplacementZeroBench(Size size) : INHERITED("zero", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return this->isSmall() ? "displacement_zero_small" : "displacement_zero_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         SkPaint paint;
         SkAutoTUnref<SkImageFilter> displ(SkBitmapSource::Create(fCheckerboard));
@@ -114,14 +147,10 @@ private:
 
 class DisplacementAlphaBench : public DisplacementBaseBench {
 public:
-    DisplacementAlphaBench(bool small) : INHERITED(small) {
+    DisplacementAlphaBench(Size size) : INHERITED("alpha", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return isSmall() ? "displacement_alpha_small" : "displacement_alpha_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         SkPaint paint;
         SkAutoTUnref<SkImageFilter> displ(SkBitmapSource::Create(fCheckerboard));
@@ -140,14 +169,10 @@ private:
 
 class DisplacementFullBench : public DisplacementBaseBench {
 public:
-    DisplacementFullBench(bool small) : INHERITED(small) {
+    DisplacementFullBench(Size size) : INHERITED("full", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return isSmall() ? "displacement_full_small" : "displacement_full_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         SkPaint paint;
         SkAutoTUnref<SkImageFilter> displ(SkBitmapSource::Create(fCheckerboard));
@@ -166,9 +191,12 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-DEF_BENCH( return new DisplacementZeroBench(true); )
-DEF_BENCH( return new DisplacementAlphaBench(true); )
-DEF_BENCH( return new DisplacementFullBench(true); )
-DEF_BENCH( return new DisplacementZeroBench(false); )
-DEF_BENCH( return new DisplacementAlphaBench(false); )
-DEF_BENCH( return new DisplacementFullBench(false); )
+DEF_BENCH( return new DisplacementZeroBench(DisplacementBaseBench::kSmall_Size); )
+DEF_BENCH( return new DisplacementAlphaBench(DisplacementBaseBench::kSmall_Size); )
+DEF_BENCH( return new DisplacementFullBench(DisplacementBaseBench::kSmall_Size); )
+DEF_BENCH( return new DisplacementZeroBench(DisplacementBaseBench::kLarge_Size); )
+DEF_BENCH( return new DisplacementAlphaBench(DisplacementBaseBench::kLarge_Size); )
+DEF_BENCH( return new DisplacementFullBench(DisplacementBaseBench::kLarge_Size); )
+DEF_BENCH( return new DisplacementZeroBench(DisplacementBaseBench::kHuge_Size); )
+DEF_BENCH( return new DisplacementAlphaBench(DisplacementBaseBench::kHuge_Size); )
+DEF_BENCH( return new DisplacementFullBench(DisplacementBaseBench::kHuge_Size); )
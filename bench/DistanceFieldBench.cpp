@@ -0,0 +1,125 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDistanceFieldBatch.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTArray.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+
+/*
+ *  Generates the distance fields of a set of glyph sized masks, either one at
+ *  a time or as one SkDistanceFieldBatch.
+ */
+
+static const int kGlyphCount = 64;
+
+class DistanceFieldBench : public Benchmark {
+public:
+    static const int kSerial = -2;
+
+    // threadCount == kSerial generates the glyphs one at a time with
+    // SkGenerateDistanceFieldFromA8Image().
+    DistanceFieldBench(SkDistanceFieldMethod method, int threadCount)
+        : fMethod(method)
+        , fThreadCount(threadCount) {
+        fName.printf("distancefield_%s",
+                     kExact_SkDistanceFieldMethod == method ? "exact" : "approximate");
+        if (kSerial == threadCount) {
+            fName.append("_serial");
+        } else if (SkThreadPool::kThreadPerCore == threadCount) {
+            fName.append("_batch_threadpercore");
+        } else {
+            fName.appendf("_batch_%d", threadCount);
+        }
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        SkRandom rand;
+        size_t totalSize = 0;
+        for (int i = 0; i < kGlyphCount; ++i) {
+            const int w = rand.nextRangeU(16, 64);
+            const int h = rand.nextRangeU(16, 64);
+            SkBitmap& glyph = fGlyphs.push_back();
+            glyph.allocPixels(SkImageInfo::MakeA8(w, h));
+            glyph.eraseColor(SK_ColorTRANSPARENT);
+
+            SkCanvas canvas(glyph);
+            SkPaint paint;
+            paint.setAntiAlias(true);
+            canvas.drawCircle(SkIntToScalar(w / 2), SkIntToScalar(h / 2),
+                              SkIntToScalar(SkMin32(w, h) / 3), paint);
+            paint.setStyle(SkPaint::kStroke_Style);
+            paint.setStrokeWidth(SkIntToScalar(3));
+            canvas.drawLine(0, 0, SkIntToScalar(w), SkIntToScalar(h), paint);
+
+            SkDistanceFieldRequest* request = fRequests.append();
+            request->fDistanceField = NULL;
+            request->fImage = glyph.getAddr8(0, 0);
+            request->fWidth = w;
+            request->fHeight = h;
+            request->fRowBytes = SkToInt(glyph.rowBytes());
+            totalSize += SkComputeDistanceFieldSize(w, h);
+        }
+
+        fStorage.reset(totalSize);
+        unsigned char* distanceField = fStorage.get();
+        for (int i = 0; i < kGlyphCount; ++i) {
+            fRequests[i].fDistanceField = distanceField;
+            distanceField += SkComputeDistanceFieldSize(fRequests[i].fWidth,
+                                                        fRequests[i].fHeight);
+        }
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        for (int i = 0; i < loops; ++i) {
+            if (kSerial == fThreadCount) {
+                for (int j = 0; j < fRequests.count(); ++j) {
+                    const SkDistanceFieldRequest& r = fRequests[j];
+                    SkGenerateDistanceFieldFromA8Image(r.fDistanceField, r.fImage,
+                                                       r.fWidth, r.fHeight, r.fRowBytes,
+                                                       fMethod);
+                }
+            } else {
+                SkDistanceFieldBatch::GenerateFromA8Images(fRequests.begin(), fRequests.count(),
+                                                           fMethod, fThreadCount);
+            }
+        }
+    }
+
+private:
+    SkDistanceFieldMethod           fMethod;
+    int                             fThreadCount;
+    SkString                        fName;
+    SkTArray<SkBitmap>              fGlyphs;
+    SkTDArray<SkDistanceFieldRequest> fRequests;
+    SkAutoTMalloc<unsigned char>    fStorage;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(DistanceFieldBench, (kApproximate_SkDistanceFieldMethod,
+                                                  DistanceFieldBench::kSerial)); )
+DEF_BENCH( return SkNEW_ARGS(DistanceFieldBench, (kExact_SkDistanceFieldMethod,
+                                                  DistanceFieldBench::kSerial)); )
+DEF_BENCH( return SkNEW_ARGS(DistanceFieldBench, (kApproximate_SkDistanceFieldMethod,
+                                                  SkThreadPool::kThreadPerCore)); )
+DEF_BENCH( return SkNEW_ARGS(DistanceFieldBench, (kExact_SkDistanceFieldMethod,
+                                                  SkThreadPool::kThreadPerCore)); )
@@ -296,6 +296,7 @@ DEF_BENCH( return new GradientBench(kLinear_GradType); )
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[2]); )
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[0]); )
 DEF_BENCH( return new GradientBench(kRadial_GradType, gGradData[1]); )
@@ -316,18 +317,27 @@ DEF_BENCH( return new GradientBench(kSweep_GradType, gGradData[2]); )
 DEF_BENCH( return new GradientBench(kRadial2_GradType); )
 DEF_BENCH( return new GradientBench(kRadial2_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kRadial2_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kRadial2_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 DEF_BENCH( return new GradientBench(kConical_GradType); )
 DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[2]); )
+DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 DEF_BENCH( return new GradientBench(kConicalZero_GradType); )
 DEF_BENCH( return new GradientBench(kConicalZero_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kConicalZero_GradType, gGradData[2]); )
+DEF_BENCH( return new GradientBench(kConicalZero_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kConicalZero_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 DEF_BENCH( return new GradientBench(kConicalOut_GradType); )
 DEF_BENCH( return new GradientBench(kConicalOut_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kConicalOut_GradType, gGradData[2]); )
+DEF_BENCH( return new GradientBench(kConicalOut_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kConicalOut_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 DEF_BENCH( return new GradientBench(kConicalOutZero_GradType); )
 DEF_BENCH( return new GradientBench(kConicalOutZero_GradType, gGradData[1]); )
 DEF_BENCH( return new GradientBench(kConicalOutZero_GradType, gGradData[2]); )
+DEF_BENCH( return new GradientBench(kConicalOutZero_GradType, gGradData[0], SkShader::kMirror_TileMode); )
+DEF_BENCH( return new GradientBench(kConicalOutZero_GradType, gGradData[0], SkShader::kRepeat_TileMode); )
 
 // Dithering
 DEF_BENCH( return new GradientBench(kLinear_GradType, gGradData[3], true); )
@@ -341,6 +351,93 @@ DEF_BENCH( return new GradientBench(kConical_GradType, gGradData[3], false); )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/*
+ *  Compares SkGradientShader::kInterpolateColorsPerPixel_Flag with the 256-entry cache, both
+ *  over a large area and for small draws with a new paint alpha each time, each of which
+ *  builds a new cache.
+ */
+class GradientInterpolationBench : public Benchmark {
+    SkString                fName;
+    SkAutoTUnref<SkShader>  fShader;
+    bool                    fChangeAlpha;
+    enum {
+        W   = 400,
+        H   = 400,
+    };
+
+public:
+    GradientInterpolationBench(GradType gradType, bool perPixel, bool changeAlpha)
+        : fChangeAlpha(changeAlpha) {
+        fName.printf("gradient_interp_%s_%s%s", gGrads[gradType].fName,
+                     perPixel ? "perpixel" : "cache", changeAlpha ? "_alpha" : "");
+
+        const uint32_t flags = perPixel ? SkGradientShader::kInterpolateColorsPerPixel_Flag : 0;
+        const GradData& data = gGradData[2];
+        const SkPoint center = { SkIntToScalar(W) / 2, SkIntToScalar(H) / 2 };
+        switch (gradType) {
+            case kLinear_GradType: {
+                const SkPoint pts[2] = { { 0, 0 }, { SkIntToScalar(W), SkIntToScalar(H) } };
+                fShader.reset(SkGradientShader::CreateLinear(pts, data.fColors, data.fPos,
+                                                             data.fCount,
+                                                             SkShader::kClamp_TileMode,
+                                                             flags, NULL));
+                break;
+            }
+            case kRadial_GradType:
+                fShader.reset(SkGradientShader::CreateRadial(center, center.fX, data.fColors,
+                                                             data.fPos, data.fCount,
+                                                             SkShader::kClamp_TileMode,
+                                                             flags, NULL));
+                break;
+            default: {
+                SkASSERT(kConical_GradType == gradType);
+                const SkPoint start = { SkIntToScalar(W) * 3 / 5, SkIntToScalar(H) / 4 };
+                fShader.reset(SkGradientShader::CreateTwoPointConical(start, SkIntToScalar(W) / 7,
+                                                                      center, center.fX,
+                                                                      data.fColors, data.fPos,
+                                                                      data.fCount,
+                                                                      SkShader::kClamp_TileMode,
+                                                                      flags, NULL));
+                break;
+            }
+        }
+    }
+
+protected:
+    virtual const char* onGetName() {
+        return fName.c_str();
+    }
+
+    virtual void onDraw(const int loops, SkCanvas* canvas) {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setShader(fShader);
+
+        const SkRect r = fChangeAlpha ? SkRect::MakeWH(SkIntToScalar(16), SkIntToScalar(16))
+                                      : SkRect::MakeWH(SkIntToScalar(W), SkIntToScalar(H));
+        for (int i = 0; i < loops; i++) {
+            if (fChangeAlpha) {
+                paint.setAlpha(0x80 + (i & 0x7F));
+            }
+            canvas->drawRect(r, paint);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new GradientInterpolationBench(kLinear_GradType, false, false); )
+DEF_BENCH( return new GradientInterpolationBench(kLinear_GradType, true, false); )
+DEF_BENCH( return new GradientInterpolationBench(kRadial_GradType, false, false); )
+DEF_BENCH( return new GradientInterpolationBench(kRadial_GradType, true, false); )
+DEF_BENCH( return new GradientInterpolationBench(kConical_GradType, false, false); )
+DEF_BENCH( return new GradientInterpolationBench(kConical_GradType, true, false); )
+DEF_BENCH( return new GradientInterpolationBench(kLinear_GradType, false, true); )
+DEF_BENCH( return new GradientInterpolationBench(kLinear_GradType, true, true); )
+
+///////////////////////////////////////////////////////////////////////////////
+
 class Gradient2Bench : public Benchmark {
     SkString fName;
     bool     fHasAlpha;
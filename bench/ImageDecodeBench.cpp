@@ -7,10 +7,12 @@
 
 #include "Benchmark.h"
 #include "SkBitmap.h"
+#include "SkCommandLineFlags.h"
 #include "SkData.h"
 #include "SkForceLinking.h"
 #include "SkImageDecoder.h"
 #include "SkOSFile.h"
+#include "SkParallelImageDecoder.h"
 #include "SkStream.h"
 #include "SkString.h"
 
@@ -91,3 +93,62 @@ private:
 // These are files which call decodePalette
 //DEF_BENCH( return SkNEW_ARGS(ImageDecodeBench, ("/usr/local/google/home/scroggo/Downloads/images/hal_163x90.png")); )
 //DEF_BENCH( return SkNEW_ARGS(ImageDecodeBench, ("/usr/local/google/home/scroggo/Downloads/images/box_19_top-left.png")); )
+
+DECLARE_string(decodeBenchFilename);
+
+/**
+ *  Decodes FLAGS_decodeBenchFilename in horizontal bands with SkParallelImageDecoder, using
+ *  fThreadCount worker threads. Compare against image_decode_parallel_0_* (all bands decoded
+ *  serially on one thread) for the speedup per core count. Only JPEG images are split into
+ *  bands, so other formats show no speedup.
+ */
+class ParallelImageDecodeBench : public Benchmark {
+public:
+    ParallelImageDecodeBench(int threadCount)
+        : fThreadCount(threadCount)
+        , fValid(false) {
+        fName.printf("image_decode_parallel_%d_%s", threadCount,
+                     SkOSPath::Basename(FLAGS_decodeBenchFilename[0]).c_str());
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        fData.reset(SkData::NewFromFileName(FLAGS_decodeBenchFilename[0]));
+        // Formats without tile based decoding support can't be measured here.
+        SkBitmap bm;
+        fValid = NULL != fData.get() &&
+                 SkParallelImageDecoder::Decode(fData, &bm, kN32_SkColorType, 0);
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        if (!fValid) {
+            return;
+        }
+        for (int i = 0; i < loops; ++i) {
+            SkBitmap bm;
+            SkParallelImageDecoder::Decode(fData, &bm, kN32_SkColorType, fThreadCount);
+        }
+    }
+
+private:
+    SkString              fName;
+    const int             fThreadCount;
+    SkAutoTUnref<SkData>  fData;
+    bool                  fValid;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(ParallelImageDecodeBench, (0)); )
+DEF_BENCH( return SkNEW_ARGS(ParallelImageDecodeBench, (1)); )
+DEF_BENCH( return SkNEW_ARGS(ParallelImageDecodeBench, (2)); )
+DEF_BENCH( return SkNEW_ARGS(ParallelImageDecodeBench, (4)); )
+DEF_BENCH( return SkNEW_ARGS(ParallelImageDecodeBench, (8)); )
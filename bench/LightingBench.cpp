@@ -9,20 +9,54 @@
 #include "SkCanvas.h"
 #include "SkDevice.h"
 #include "SkLightingImageFilter.h"
+#include "SkString.h"
 
 #define FILTER_WIDTH_SMALL  SkIntToScalar(32)
 #define FILTER_HEIGHT_SMALL SkIntToScalar(32)
 #define FILTER_WIDTH_LARGE  SkIntToScalar(256)
 #define FILTER_HEIGHT_LARGE SkIntToScalar(256)
+#define FILTER_WIDTH_HUGE   1024
+#define FILTER_HEIGHT_HUGE  1024
 
 class LightingBaseBench : public Benchmark {
 public:
-    LightingBaseBench(bool small) : fIsSmall(small) { }
+    enum Size {
+        kSmall_Size,
+        kLarge_Size,
+        kHuge_Size,     // larger than the default canvas, lit in several bands
+    };
+
+    LightingBaseBench(const char* name, Size size) : fSize(size) {
+        static const char* gSuffixes[] = { "small", "large", "huge" };
+        fName.printf("%s_%s", name, gSuffixes[size]);
+    }
 
 protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual SkIPoint onGetSize() SK_OVERRIDE {
+        if (kHuge_Size == fSize) {
+            return SkIPoint::Make(FILTER_WIDTH_HUGE, FILTER_HEIGHT_HUGE);
+        }
+        return this->INHERITED::onGetSize();
+    }
+
     void draw(const int loops, SkCanvas* canvas, SkImageFilter* imageFilter) const {
-        SkRect r = fIsSmall ? SkRect::MakeWH(FILTER_WIDTH_SMALL, FILTER_HEIGHT_SMALL) :
-                              SkRect::MakeWH(FILTER_WIDTH_LARGE, FILTER_HEIGHT_LARGE);
+        SkRect r;
+        switch (fSize) {
+            case kSmall_Size:
+                r = SkRect::MakeWH(FILTER_WIDTH_SMALL, FILTER_HEIGHT_SMALL);
+                break;
+            case kLarge_Size:
+                r = SkRect::MakeWH(FILTER_WIDTH_LARGE, FILTER_HEIGHT_LARGE);
+                break;
+            case kHuge_Size:
+                r = SkRect::MakeWH(SkIntToScalar(FILTER_WIDTH_HUGE),
+                                   SkIntToScalar(FILTER_HEIGHT_HUGE));
+                break;
+        }
         SkPaint paint;
         paint.setImageFilter(imageFilter)->unref();
         for (int i = 0; i < loops; i++) {
@@ -91,20 +125,17 @@ protected:
         return white;
     }
 
-    bool fIsSmall;
+    Size     fSize;
+    SkString fName;
     typedef Benchmark INHERITED;
 };
 
 class LightingPointLitDiffuseBench : public LightingBaseBench {
 public:
-    LightingPointLitDiffuseBench(bool small) : INHERITED(small) {
+    LightingPointLitDiffuseBench(Size size) : INHERITED("lightingpointlitdiffuse", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingpointlitdiffuse_small" : "lightingpointlitdiffuse_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreatePointLitDiffuse(getPointLocation(),
                                                                          getWhite(),
@@ -118,14 +149,10 @@ private:
 
 class LightingDistantLitDiffuseBench : public LightingBaseBench {
 public:
-    LightingDistantLitDiffuseBench(bool small) : INHERITED(small) {
+    LightingDistantLitDiffuseBench(Size size) : INHERITED("lightingdistantlitdiffuse", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingdistantlitdiffuse_small" : "lightingdistantlitdiffuse_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreateDistantLitDiffuse(getDistantDirection(),
                                                                            getWhite(),
@@ -139,14 +166,10 @@ private:
 
 class LightingSpotLitDiffuseBench : public LightingBaseBench {
 public:
-    LightingSpotLitDiffuseBench(bool small) : INHERITED(small) {
+    LightingSpotLitDiffuseBench(Size size) : INHERITED("lightingspotlitdiffuse", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingspotlitdiffuse_small" : "lightingspotlitdiffuse_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreateSpotLitDiffuse(getSpotLocation(),
                                                                         getSpotTarget(),
@@ -163,14 +186,10 @@ private:
 
 class LightingPointLitSpecularBench : public LightingBaseBench {
 public:
-    LightingPointLitSpecularBench(bool small) : INHERITED(small) {
+    LightingPointLitSpecularBench(Size size) : INHERITED("lightingpointlitspecular", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingpointlitspecular_small" : "lightingpointlitspecular_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreatePointLitSpecular(getPointLocation(),
                                                                           getWhite(),
@@ -185,14 +204,10 @@ private:
 
 class LightingDistantLitSpecularBench : public LightingBaseBench {
 public:
-    LightingDistantLitSpecularBench(bool small) : INHERITED(small) {
+    LightingDistantLitSpecularBench(Size size) : INHERITED("lightingdistantlitspecular", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingdistantlitspecular_small" : "lightingdistantlitspecular_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreateDistantLitSpecular(getDistantDirection(),
                                                                             getWhite(),
@@ -207,14 +222,10 @@ private:
 
 class LightingSpotLitSpecularBench : public LightingBaseBench {
 public:
-    LightingSpotLitSpecularBench(bool small) : INHERITED(small) {
+    LightingSpotLitSpecularBench(Size size) : INHERITED("lightingspotlitspecular", size) {
     }
 
 protected:
-    virtual const char* onGetName() SK_OVERRIDE {
-        return fIsSmall ? "lightingspotlitspecular_small" : "lightingspotlitspecular_large";
-    }
-
     virtual void onDraw(const int loops, SkCanvas* canvas) SK_OVERRIDE {
         draw(loops, canvas, SkLightingImageFilter::CreateSpotLitSpecular(getSpotLocation(),
                                                                          getSpotTarget(),
@@ -232,15 +243,21 @@ private:
 
 ///////////////////////////////////////////////////////////////////////////////
 
-DEF_BENCH( return new LightingPointLitDiffuseBench(true); )
-DEF_BENCH( return new LightingPointLitDiffuseBench(false); )
-DEF_BENCH( return new LightingDistantLitDiffuseBench(true); )
-DEF_BENCH( return new LightingDistantLitDiffuseBench(false); )
-DEF_BENCH( return new LightingSpotLitDiffuseBench(true); )
-DEF_BENCH( return new LightingSpotLitDiffuseBench(false); )
-DEF_BENCH( return new LightingPointLitSpecularBench(true); )
-DEF_BENCH( return new LightingPointLitSpecularBench(false); )
-DEF_BENCH( return new LightingDistantLitSpecularBench(true); )
-DEF_BENCH( return new LightingDistantLitSpecularBench(false); )
-DEF_BENCH( return new LightingSpotLitSpecularBench(true); )
-DEF_BENCH( return new LightingSpotLitSpecularBench(false); )
+DEF_BENCH( return new LightingPointLitDiffuseBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingPointLitDiffuseBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingPointLitDiffuseBench(LightingBaseBench::kHuge_Size); )
+DEF_BENCH( return new LightingDistantLitDiffuseBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingDistantLitDiffuseBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingDistantLitDiffuseBench(LightingBaseBench::kHuge_Size); )
+DEF_BENCH( return new LightingSpotLitDiffuseBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingSpotLitDiffuseBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingSpotLitDiffuseBench(LightingBaseBench::kHuge_Size); )
+DEF_BENCH( return new LightingPointLitSpecularBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingPointLitSpecularBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingPointLitSpecularBench(LightingBaseBench::kHuge_Size); )
+DEF_BENCH( return new LightingDistantLitSpecularBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingDistantLitSpecularBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingDistantLitSpecularBench(LightingBaseBench::kHuge_Size); )
+DEF_BENCH( return new LightingSpotLitSpecularBench(LightingBaseBench::kSmall_Size); )
+DEF_BENCH( return new LightingSpotLitSpecularBench(LightingBaseBench::kLarge_Size); )
+DEF_BENCH( return new LightingSpotLitSpecularBench(LightingBaseBench::kHuge_Size); )
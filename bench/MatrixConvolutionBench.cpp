@@ -10,6 +10,7 @@
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkString.h"
+#include "SkTemplates.h"
 
 class MatrixConvolutionBench : public Benchmark {
 public:
@@ -26,6 +27,38 @@ public:
         fFilter = SkMatrixConvolutionImageFilter::Create(kernelSize, kernel, gain, bias, kernelOffset, tileMode, convolveAlpha);
     }
 
+    // A size by size kernel: a binomial blur if separable, otherwise the same with a sharper
+    // center.
+    MatrixConvolutionBench(int size, bool separable)
+        : fName("matrixconvolution") {
+        fName.appendf("_%s_%dx%d", separable ? "separable" : "full", size, size);
+        SkAutoTArray<SkScalar> binomial(size);
+        for (int i = 0; i < size; ++i) {
+            binomial[i] = SK_Scalar1;
+            for (int j = i - 1; j > 0; --j) {
+                binomial[j] += binomial[j - 1];
+            }
+        }
+        SkAutoTArray<SkScalar> kernel(size * size);
+        SkScalar sum = 0;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                kernel[y * size + x] = binomial[y] * binomial[x];
+                sum += kernel[y * size + x];
+            }
+        }
+        if (!separable) {
+            kernel[size / 2 * size + size / 2] += sum;
+            sum += sum;
+        }
+        SkISize kernelSize = SkISize::Make(size, size);
+        SkIPoint kernelOffset = SkIPoint::Make(size / 2, size / 2);
+        fFilter = SkMatrixConvolutionImageFilter::Create(kernelSize, kernel.get(),
+                                                         SkScalarInvert(sum), 0, kernelOffset,
+                                                         SkMatrixConvolutionImageFilter::kClamp_TileMode,
+                                                         true);
+    }
+
     ~MatrixConvolutionBench() {
         fFilter->unref();
     }
@@ -58,3 +91,9 @@ DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kCl
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kRepeat_TileMode, true); )
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClampToBlack_TileMode, true); )
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClampToBlack_TileMode, false); )
+DEF_BENCH( return new MatrixConvolutionBench(3, false); )
+DEF_BENCH( return new MatrixConvolutionBench(3, true); )
+DEF_BENCH( return new MatrixConvolutionBench(5, false); )
+DEF_BENCH( return new MatrixConvolutionBench(5, true); )
+DEF_BENCH( return new MatrixConvolutionBench(9, false); )
+DEF_BENCH( return new MatrixConvolutionBench(9, true); )
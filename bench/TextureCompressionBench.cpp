@@ -0,0 +1,238 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkBitmapProcShader.h"
+#include "SkCanvas.h"
+#include "SkDraw.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkRandom.h"
+#include "SkRasterClip.h"
+#include "SkString.h"
+#include "SkTemplates.h"
+#include "SkTextureCompressor.h"
+
+/*
+ *  Measures encoding throughput of SkTextureCompressor: the portable encoders,
+ *  the platform-optimized ones, and the optimized ones run in parallel bands.
+ */
+
+// A multiple of 16 for the SIMD encoders and of 12 for ASTC.
+static const int kSize = 384;
+
+class TextureCompressionBench : public Benchmark {
+public:
+    enum Mode {
+        kPortable_Mode,   // CompressBufferToFormat(..., false)
+        kOptimized_Mode,  // CompressBufferToFormat(...)
+        kParallel_Mode,   // CompressBufferToFormatInParallel(..., kThreadPerCore)
+    };
+
+    TextureCompressionBench(SkTextureCompressor::Format format, SkColorType colorType, Mode mode)
+        : fFormat(format)
+        , fColorType(colorType)
+        , fMode(mode) {
+        static const char* kFormatNames[] = { "latc", "r11eac", "etc1" };
+        static const char* kModeNames[] = { "portable", "optimized", "parallel" };
+        fName.printf("texturecompression_%s_%s_%s",
+                     SkTextureCompressor::kASTC_12x12_Format == format
+                         ? "astc12x12" : kFormatNames[format],
+                     kAlpha_8_SkColorType == colorType
+                         ? "a8" : kRGB_565_SkColorType == colorType ? "565" : "8888",
+                     kModeNames[mode]);
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        const SkAlphaType alphaType = kRGB_565_SkColorType == fColorType
+                                    ? kOpaque_SkAlphaType : kPremul_SkAlphaType;
+        fBitmap.allocPixels(SkImageInfo::Make(kSize, kSize, fColorType, alphaType));
+        fBitmap.eraseColor(SK_ColorTRANSPARENT);
+
+        // Something like an atlas: lots of anti-aliased shapes of all sizes.
+        SkRandom rand;
+        SkCanvas canvas(fBitmap);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        for (int i = 0; i < 200; ++i) {
+            paint.setColor(rand.nextU() | 0xFF000000);
+            canvas.drawCircle(rand.nextRangeScalar(0, SkIntToScalar(kSize)),
+                              rand.nextRangeScalar(0, SkIntToScalar(kSize)),
+                              rand.nextRangeScalar(2, 40), paint);
+        }
+
+        fCompressed.reset(SkTextureCompressor::GetCompressedDataSize(fFormat, kSize, kSize));
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkAutoLockPixels alp(fBitmap);
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(fBitmap.getPixels());
+        const int rowBytes = SkToInt(fBitmap.rowBytes());
+        for (int i = 0; i < loops; ++i) {
+            if (kParallel_Mode == fMode) {
+                SkTextureCompressor::CompressBufferToFormatInParallel(
+                    fCompressed.get(), src, fColorType, kSize, kSize, rowBytes, fFormat);
+            } else {
+                SkTextureCompressor::CompressBufferToFormat(
+                    fCompressed.get(), src, fColorType, kSize, kSize, rowBytes, fFormat,
+                    kOptimized_Mode == fMode);
+            }
+        }
+    }
+
+private:
+    SkTextureCompressor::Format fFormat;
+    SkColorType                 fColorType;
+    Mode                        fMode;
+    SkString                    fName;
+    SkBitmap                    fBitmap;
+    SkAutoTMalloc<uint8_t>      fCompressed;
+
+    typedef Benchmark INHERITED;
+};
+
+typedef TextureCompressionBench TCB;
+
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kLATC_Format, kAlpha_8_SkColorType,
+                                   TCB::kPortable_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kLATC_Format, kAlpha_8_SkColorType,
+                                   TCB::kOptimized_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kLATC_Format, kAlpha_8_SkColorType,
+                                   TCB::kParallel_Mode)); )
+
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kR11_EAC_Format, kAlpha_8_SkColorType,
+                                   TCB::kPortable_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kR11_EAC_Format, kAlpha_8_SkColorType,
+                                   TCB::kOptimized_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kR11_EAC_Format, kAlpha_8_SkColorType,
+                                   TCB::kParallel_Mode)); )
+
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kASTC_12x12_Format, kAlpha_8_SkColorType,
+                                   TCB::kOptimized_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kASTC_12x12_Format, kAlpha_8_SkColorType,
+                                   TCB::kParallel_Mode)); )
+
+#ifndef SK_IGNORE_ETC1_SUPPORT
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kETC1_Format, kRGB_565_SkColorType,
+                                   TCB::kOptimized_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kETC1_Format, kRGB_565_SkColorType,
+                                   TCB::kParallel_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kETC1_Format, kN32_SkColorType,
+                                   TCB::kOptimized_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(TCB, (SkTextureCompressor::kETC1_Format, kN32_SkColorType,
+                                   TCB::kParallel_Mode)); )
+#endif
+
+/*
+ *  Rasterizes a path into a compressed alpha texture, either by drawing a full A8 mask
+ *  and compressing it, or with the band blitter straight from SkScan. At kMaskSize, the
+ *  first holds a kMaskSize * kMaskSize byte mask (256K) alongside the compressed texture,
+ *  and the second only a kMaskSize * 4 byte band (2K).
+ */
+
+static const int kMaskSize = 512;
+
+class CompressedMaskBench : public Benchmark {
+public:
+    CompressedMaskBench(SkTextureCompressor::Format format, bool banded)
+        : fFormat(format)
+        , fBanded(banded) {
+        fName.printf("compressedmask_%s_%s",
+                     SkTextureCompressor::kLATC_Format == format ? "latc" : "r11eac",
+                     banded ? "band" : "a8");
+    }
+
+    virtual bool isSuitableFor(Backend backend) SK_OVERRIDE {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    virtual const char* onGetName() SK_OVERRIDE {
+        return fName.c_str();
+    }
+
+    virtual void onPreDraw() SK_OVERRIDE {
+        // Overlapping anti-aliased circles and stars, like a complex clip.
+        SkRandom rand;
+        for (int i = 0; i < 20; ++i) {
+            const SkScalar x = rand.nextRangeScalar(0, SkIntToScalar(kMaskSize));
+            const SkScalar y = rand.nextRangeScalar(0, SkIntToScalar(kMaskSize));
+            const SkScalar r = rand.nextRangeScalar(10, 100);
+            if (i & 1) {
+                fPath.addCircle(x, y, r);
+            } else {
+                fPath.moveTo(x, y - r);
+                fPath.lineTo(x + r, y + r);
+                fPath.lineTo(x - r, y);
+                fPath.lineTo(x + r, y);
+                fPath.lineTo(x - r, y + r);
+                fPath.close();
+            }
+        }
+
+        fMask.setInfo(SkImageInfo::MakeA8(kMaskSize, kMaskSize));
+        fCompressed.reset(SkTextureCompressor::GetCompressedDataSize(fFormat,
+                                                                     kMaskSize, kMaskSize));
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) SK_OVERRIDE {
+        SkRasterClip rasterClip(SkIRect::MakeWH(kMaskSize, kMaskSize));
+        SkMatrix identity;
+        identity.reset();
+
+        SkDraw draw;
+        draw.fBitmap = &fMask;
+        draw.fMatrix = &identity;
+        draw.fClip = &rasterClip.bwRgn();
+        draw.fRC = &rasterClip;
+
+        SkPaint paint;
+        paint.setAntiAlias(true);
+
+        for (int i = 0; i < loops; ++i) {
+            if (fBanded) {
+                SkTBlitterAllocator allocator;
+                SkBlitter* blitter = SkTextureCompressor::CreateBandBlitterForFormat(
+                    kMaskSize, kMaskSize, fCompressed.get(), &allocator, fFormat);
+                draw.drawPathCoverage(fPath, paint, blitter);
+            } else {
+                // Allocating the mask is part of the cost of this approach.
+                fMask.allocPixels();
+                fMask.eraseColor(SK_ColorTRANSPARENT);
+                draw.drawPathCoverage(fPath, paint);
+                SkTextureCompressor::CompressBufferToFormat(
+                    fCompressed.get(), fMask.getAddr8(0, 0), kAlpha_8_SkColorType,
+                    kMaskSize, kMaskSize, SkToInt(fMask.rowBytes()), fFormat);
+                fMask.setPixels(NULL);
+            }
+        }
+    }
+
+private:
+    SkTextureCompressor::Format fFormat;
+    bool                        fBanded;
+    SkString                    fName;
+    SkPath                      fPath;
+    SkBitmap                    fMask;
+    SkAutoTMalloc<uint8_t>      fCompressed;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(CompressedMaskBench, (SkTextureCompressor::kLATC_Format, false)); )
+DEF_BENCH( return SkNEW_ARGS(CompressedMaskBench, (SkTextureCompressor::kLATC_Format, true)); )
+DEF_BENCH( return SkNEW_ARGS(CompressedMaskBench, (SkTextureCompressor::kR11_EAC_Format, false)); )
+DEF_BENCH( return SkNEW_ARGS(CompressedMaskBench, (SkTextureCompressor::kR11_EAC_Format, true)); )
@@ -19,6 +19,8 @@
         '../src/effects',
         '../src/opts',
         '../src/core',
+        # for access to SkRowBandTask.h
+        '../src/utils',
       ],
       'direct_dependent_settings': {
         'include_dirs': [
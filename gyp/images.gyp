@@ -28,6 +28,8 @@
         '../src/core/',
         # for access to SkImagePriv.h
         '../src/image/',
+        # for access to SkThreadPool.h
+        '../src/utils',
       ],
       'sources': [
         '../include/images/SkDecodingImageGenerator.h',
@@ -35,6 +37,7 @@
         '../src/images/SkJpegUtility.h',
         '../include/images/SkMovie.h',
         '../include/images/SkPageFlipper.h',
+        '../include/images/SkParallelImageDecoder.h',
 
         '../src/images/bmpdecoderhelper.cpp',
         '../src/images/bmpdecoderhelper.h',
@@ -74,6 +77,7 @@
         '../src/images/SkMovie.cpp',
         '../src/images/SkMovie_gif.cpp',
         '../src/images/SkPageFlipper.cpp',
+        '../src/images/SkParallelImageDecoder.cpp',
         '../src/images/SkScaledBitmapSampler.cpp',
         '../src/images/SkScaledBitmapSampler.h',
 
@@ -131,9 +135,6 @@
           ],
         }],
         [ 'skia_os == "android"', {
-          'include_dirs': [
-             '../src/utils',
-          ],
           'dependencies': [
              'android_deps.gyp:gif',
              'android_deps.gyp:png',
@@ -56,8 +56,15 @@
             '../src/opts/SkBlitRow_opts_SSE2.cpp',
             '../src/opts/SkBlitRect_opts_SSE2.cpp',
             '../src/opts/SkBlurImage_opts_SSE2.cpp',
+            '../src/opts/SkColorMatrix_opts_SSE2.cpp',
+            '../src/opts/SkDisplacementMap_opts_SSE2.cpp',
+            '../src/opts/SkDistanceField_opts_SSE2.cpp',
+            '../src/opts/SkGradient_opts_SSE2.cpp',
+            '../src/opts/SkLighting_opts_SSE2.cpp',
+            '../src/opts/SkMatrixConvolution_opts_SSE2.cpp',
             '../src/opts/SkMorphology_opts_SSE2.cpp',
-            '../src/opts/SkTextureCompression_opts_none.cpp',
+            '../src/opts/SkPerlinNoise_opts_SSE2.cpp',
+            '../src/opts/SkTextureCompression_opts_SSE2.cpp',
             '../src/opts/SkUtils_opts_SSE2.cpp',
             '../src/opts/SkXfermode_opts_SSE2.cpp',
           ],
@@ -83,7 +90,14 @@
             '../src/opts/SkBlitMask_opts_arm.cpp',
             '../src/opts/SkBlitRow_opts_arm.cpp',
             '../src/opts/SkBlurImage_opts_arm.cpp',
+            '../src/opts/SkColorMatrix_opts_none.cpp',
+            '../src/opts/SkDisplacementMap_opts_none.cpp',
+            '../src/opts/SkDistanceField_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
+            '../src/opts/SkLighting_opts_none.cpp',
+            '../src/opts/SkMatrixConvolution_opts_none.cpp',
             '../src/opts/SkMorphology_opts_arm.cpp',
+            '../src/opts/SkPerlinNoise_opts_none.cpp',
             '../src/opts/SkTextureCompression_opts_arm.cpp',
             '../src/opts/SkUtils_opts_arm.cpp',
             '../src/opts/SkXfermode_opts_arm.cpp',
@@ -108,7 +122,14 @@
           'sources': [
             '../src/opts/SkBlitMask_opts_none.cpp',
             '../src/opts/SkBlurImage_opts_none.cpp',
+            '../src/opts/SkColorMatrix_opts_none.cpp',
+            '../src/opts/SkDisplacementMap_opts_none.cpp',
+            '../src/opts/SkDistanceField_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
+            '../src/opts/SkLighting_opts_none.cpp',
+            '../src/opts/SkMatrixConvolution_opts_none.cpp',
             '../src/opts/SkMorphology_opts_none.cpp',
+            '../src/opts/SkPerlinNoise_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
             '../src/opts/SkTextureCompression_opts_none.cpp',
             '../src/opts/SkXfermode_opts_none.cpp',
@@ -136,7 +157,14 @@
             '../src/opts/SkBlitMask_opts_none.cpp',
             '../src/opts/SkBlitRow_opts_none.cpp',
             '../src/opts/SkBlurImage_opts_none.cpp',
+            '../src/opts/SkColorMatrix_opts_none.cpp',
+            '../src/opts/SkDisplacementMap_opts_none.cpp',
+            '../src/opts/SkDistanceField_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
+            '../src/opts/SkLighting_opts_none.cpp',
+            '../src/opts/SkMatrixConvolution_opts_none.cpp',
             '../src/opts/SkMorphology_opts_none.cpp',
+            '../src/opts/SkPerlinNoise_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
             '../src/opts/SkTextureCompression_opts_none.cpp',
             '../src/opts/SkXfermode_opts_none.cpp',
@@ -161,8 +189,15 @@
             '../src/opts/SkBlitRow_opts_arm_neon.cpp',
             '../src/opts/SkBlurImage_opts_arm.cpp',
             '../src/opts/SkBlurImage_opts_neon.cpp',
+            '../src/opts/SkColorMatrix_opts_none.cpp',
+            '../src/opts/SkDisplacementMap_opts_none.cpp',
+            '../src/opts/SkDistanceField_opts_none.cpp',
+            '../src/opts/SkGradient_opts_none.cpp',
+            '../src/opts/SkLighting_opts_none.cpp',
+            '../src/opts/SkMatrixConvolution_opts_none.cpp',
             '../src/opts/SkMorphology_opts_arm.cpp',
             '../src/opts/SkMorphology_opts_neon.cpp',
+            '../src/opts/SkPerlinNoise_opts_none.cpp',
             '../src/opts/SkTextureCompression_opts_none.cpp',
             '../src/opts/SkUtils_opts_none.cpp',
             '../src/opts/SkXfermode_opts_arm.cpp',
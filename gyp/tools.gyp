@@ -17,6 +17,7 @@
         'bench_pictures',
         'bench_record',
         'bench_playback',
+        'bench_serialize',
         'dump_record',
         'filter',
         'gpuveto',
@@ -445,6 +446,18 @@
         'skia_lib.gyp:skia_lib',
       ],
     },
+    {
+      'target_name': 'bench_serialize',
+      'type': 'executable',
+      'sources': [
+        '../tools/bench_serialize.cpp',
+      ],
+      'dependencies': [
+        'timer',
+        'flags.gyp:flags',
+        'skia_lib.gyp:skia_lib',
+      ],
+    },
     {
       'target_name': 'dump_record',
       'type': 'executable',
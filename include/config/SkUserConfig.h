@@ -107,6 +107,14 @@
  */
 //#define SK_DEFAULT_IMAGE_CACHE_LIMIT (1024 * 1024)
 
+/*
+ *  The raster lighting, matrix convolution and displacement map filters can
+ *  work on bands of rows on worker threads. To opt in, define this to the
+ *  number of threads, or to -1 for one per core. If this is undefined, they
+ *  work on the calling thread.
+ */
+//#define SK_ROW_BAND_THREAD_COUNT -1
+
 /*  If zlib is available and you want to support the flate compression
     algorithm (used in PDF generation), define SK_ZLIB_INCLUDE to be the
     include path. Alternatively, define SK_SYSTEM_ZLIB to use the system zlib
@@ -11,6 +11,9 @@
 
 #include "SkDevice.h"
 
+class SkLayerInfo;
+class SkPicture;
+
 ///////////////////////////////////////////////////////////////////////////////
 class SK_API SkBitmapDevice : public SkBaseDevice {
 public:
@@ -136,6 +139,12 @@ protected:
     virtual void lockPixels() SK_OVERRIDE;
     virtual void unlockPixels() SK_OVERRIDE;
 
+    /**  PRIVATE / EXPERIMENTAL -- do not call */
+    virtual void EXPERIMENTAL_optimize(const SkPicture* picture) SK_OVERRIDE;
+    /**  PRIVATE / EXPERIMENTAL -- do not call */
+    virtual bool EXPERIMENTAL_drawPicture(SkCanvas* canvas, const SkPicture* picture,
+                                          const SkMatrix*, const SkPaint*) SK_OVERRIDE;
+
 private:
     friend class SkCanvas;
     friend struct DeviceCM; //for setMatrixClip
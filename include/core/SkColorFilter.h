@@ -123,6 +123,22 @@ public:
     */
     static SkColorFilter* CreateLightingFilter(SkColor mul, SkColor add);
 
+    /** Create a colorfilter that applies inner, then outer to its result. If
+        either is NULL, the other is returned (with a new ref). When outer can
+        be folded with inner into a single filter, as two color matrices can,
+        that filter is returned instead; otherwise both filters are applied in
+        turn to each span, and there is no GPU implementation.
+        The caller owns a ref on the returned filter.
+    */
+    static SkColorFilter* CreateComposeFilter(SkColorFilter* outer, SkColorFilter* inner);
+
+    /**
+     *  If this filter applied to the output of inner can be represented by a
+     *  single filter, returns a new one that does so. Otherwise returns NULL.
+     *  If the return is non-NULL then the caller owns a ref on the returned object.
+     */
+    virtual SkColorFilter* newComposed(const SkColorFilter* inner) const;
+
     /** A subclass may implement this factory function to work with the GPU backend. If the return
         is non-NULL then the caller owns a ref on the returned object.
      */
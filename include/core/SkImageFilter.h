@@ -142,6 +142,13 @@ public:
      */
     virtual bool asColorFilter(SkColorFilter** filterPtr) const;
 
+    /**
+     *  Returns whether this image filter only moves its input, by a vector in local coordinates,
+     *  and puts the vector into the "offset" parameter if it is not null. Filters that draw
+     *  anything, or have a crop rect, return false and leave offset unchanged.
+     */
+    virtual bool asOffset(SkVector* offset) const;
+
     /**
      *  Returns the number of inputs this filter will accept (some inputs can
      *  be NULL).
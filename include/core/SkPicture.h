@@ -96,6 +96,28 @@ public:
     static SkPicture* CreateFromStream(SkStream*,
                                        InstallPixelRefProc proc = &SkImageDecoder::DecodeMemory);
 
+    /**
+     *  Recreate a picture that was serialized into data, e.g. a file mapped into memory with
+     *  SkData::NewFromFD(). Unlike CreateFromStream, the op stream and any unencoded bitmap
+     *  pixels are not copied: the picture refs data and plays back directly out of it, so
+     *  their pages are only touched when the picture is drawn. Only SKPs written at version 34
+     *  or later are laid out so that this is possible; older ones are copied as by
+     *  CreateFromStream.
+     *
+     *  As of version 35, bitmaps, paints and paths are also left flattened in data until a
+     *  draw first uses them. If the picture was recorded with a bounding box hierarchy, the
+     *  SKP carries the bounds of each draw, and drawing into a clip skips the draws (and so
+     *  never unflattens the resources) that fall outside it. Drawing one tile of a large
+     *  picture then only costs as much as the part of the picture in that tile.
+     *  @param SkData Serialized picture data.
+     *  @param proc Function pointer for installing pixelrefs on SkBitmaps representing the
+     *              encoded bitmap data from the stream.
+     *  @return A new SkPicture representing the serialized data, or NULL if the data is
+     *          invalid.
+     */
+    static SkPicture* CreateFromData(SkData*,
+                                     InstallPixelRefProc proc = &SkImageDecoder::DecodeMemory);
+
     /**
      *  Recreate a picture that was serialized into a buffer. If the creation requires bitmap
      *  decoding, the decoder must be set on the SkReadBuffer parameter by calling
@@ -160,6 +182,14 @@ public:
      */
     void serialize(SkWStream*, EncodeBitmap encoder = NULL) const;
 
+    /**
+     *  Like serialize(), but delta-encodes the ops and flattened resources, which typically
+     *  makes the result considerably smaller at the cost of some time to decode it. Pictures
+     *  serialized this way can be read by CreateFromStream and CreateFromData, but the latter
+     *  can no longer use the data in place and makes a decoded copy instead.
+     */
+    void serializeCompact(SkWStream*, EncodeBitmap encoder = NULL) const;
+
     /**
      *  Serialize to a buffer.
      */
@@ -242,16 +272,22 @@ private:
     // V30: Remove redundant SkMatrix from SkLocalMatrixShader.
     // V31: Add a serialized UniqueID to SkImageFilter.
     // V32: Removed SkPaintOptionsAndroid from SkPaint
+    // V33: Serialize only public API of effects.
+    // V34: Pad the op stream and buffer chunks of a serialized picture to 4-byte offsets
+    // V35: Add the draw index and resource index chunks
+    // V36: Add the compact op stream and buffer chunks
 
     // Note: If the picture version needs to be increased then please follow the
     // steps to generate new SKPs in (only accessible to Googlers): http://goo.gl/qATVcw
 
     // Only SKPs within the min/current picture version range (inclusive) can be read.
     static const uint32_t MIN_PICTURE_VERSION = 19;
-    static const uint32_t CURRENT_PICTURE_VERSION = 33;
+    static const uint32_t CURRENT_PICTURE_VERSION = 36;
 
     mutable uint32_t      fUniqueID;
 
+    void serialize(SkWStream*, EncodeBitmap, bool compact) const;
+
     // TODO: make SkPictureData const when clone method goes away
     SkAutoTDelete<SkPictureData> fData;
     int                   fWidth, fHeight;
@@ -266,6 +302,10 @@ private:
     // takes ownership of 'data'.
     SkPicture(SkPictureData* data, int width, int height);
 
+    // If backing is not NULL, stream must be reading from it, and the returned picture
+    // plays back in place out of backing (see CreateFromData) rather than being forwardported.
+    static SkPicture* CreateFromStream(SkStream*, InstallPixelRefProc, SkData* backing);
+
     SkPicture(int width, int height, const SkPictureRecord& record, bool deepCopyOps);
 
     // An OperationList encapsulates a set of operation offsets into the picture byte
@@ -294,9 +334,11 @@ private:
     friend class SkPictureData;                // to access OperationList
     friend class SkPictureRecorder;            // just for SkPicture-based constructor
     friend class SkGpuDevice;                  // for EXPERIMENTAL_getActiveOps/OperationList
-    friend class GrGatherCanvas;               // needs to know if old or new picture
+    friend class SkBitmapDevice;               // for EXPERIMENTAL_getActiveOps/OperationList
+    friend class SkLayerGatherCanvas;          // needs to know if old or new picture
     friend class SkPicturePlayback;            // to get fData & OperationList
     friend class SkPictureReplacementPlayback; // to access OperationList
+    friend class SkPictureUtils;               // to diff fRecords
 
     typedef SkRefCnt INHERITED;
 
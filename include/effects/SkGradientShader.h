@@ -26,6 +26,15 @@ public:
          *  between them.
          */
         kInterpolateColorsInPremul_Flag = 1 << 0,
+
+        /** By default gradients look their colors up in a table of 256 entries,
+         *  built for each paint alpha they are drawn with. By setting this flag,
+         *  linear, radial and two point conical gradients instead interpolate
+         *  between their colors for every pixel they draw, which avoids banding
+         *  over large areas and skips building the table. Other gradients
+         *  ignore this flag.
+         */
+        kInterpolateColorsPerPixel_Flag = 1 << 1,
     };
 
     /** Returns a shader that generates a linear gradient between the two
@@ -123,6 +123,13 @@ private:
                             SkBitmap* result,
                             const SkIRect& rect,
                             const SkIRect& bounds) const;
+    void filterRows(const SkBitmap& src,
+                    SkBitmap* result,
+                    const SkIRect& bounds,
+                    int bandTop,
+                    int bandBottom) const;
+
+    class BandTask;
 };
 
 #endif
@@ -23,6 +23,7 @@ public:
         return SkNEW_ARGS(SkOffsetImageFilter, (dx, dy, input, cropRect));
     }
     virtual void computeFastBounds(const SkRect& src, SkRect* dst) const SK_OVERRIDE;
+    virtual bool asOffset(SkVector* offset) const SK_OVERRIDE;
     SK_DECLARE_PUBLIC_FLATTENABLE_DESERIALIZATION_PROCS(SkOffsetImageFilter)
 
 protected:
@@ -10,6 +10,9 @@
 
 #include "SkShader.h"
 
+class SkMallocPixelRef;
+struct SkPerlinNoiseSpan;
+
 /** \class SkPerlinNoiseShader
 
     SkPerlinNoiseShader creates an image using the Perlin turbulence function.
@@ -83,15 +86,23 @@ public:
         virtual void shadeSpan16(int x, int y, uint16_t[], int count) SK_OVERRIDE;
 
     private:
-        SkPMColor shade(const SkPoint& point, StitchData& stitchData) const;
-        SkScalar calculateTurbulenceValueForPoint(
-            int channel,
-            StitchData& stitchData, const SkPoint& point) const;
-        SkScalar noise2D(int channel,
-                         const StitchData& stitchData, const SkPoint& noiseVector) const;
+        typedef void (*SpanProc)(const SkPerlinNoiseSpan&, SkPMColor[], int count);
+
+        // Sets everything but the first point of the span.
+        void initSpan(SkPerlinNoiseSpan*) const;
+
+        // Writes the colors of the noise points (x, y), (x + 1, y), ...
+        void shadeNoise(int x, int y, SkPMColor[], int count) const;
+
+        // With stitched tiles, returns the colors of the noise points of the tile, shared with
+        // other draws of the same noise through SkScaledImageCache, or NULL.
+        const SkPMColor* getTile();
 
         SkMatrix fMatrix;
         PaintingData* fPaintingData;
+        SpanProc fSpanProc;
+        SkMallocPixelRef* fTilePixelRef;
+        bool fTileInited;
 
         typedef SkShader::Context INHERITED;
     };
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkParallelImageDecoder_DEFINED
+#define SkParallelImageDecoder_DEFINED
+
+#include "SkImageInfo.h"
+
+class SkBitmap;
+class SkData;
+
+/**
+ *  Decodes large images by splitting them into horizontal bands and decoding
+ *  each band independently with SkImageDecoder::decodeSubset(), using the
+ *  tile index built by SkImageDecoder::buildTileIndex().
+ *
+ *  Only formats whose decoder supports tile based decoding (currently PNG and
+ *  JPEG on Android, and WEBP) can be decoded this way. Of those, only JPEG's
+ *  tile index can start decoding at any row, so the other formats are decoded
+ *  as a single band on the calling thread.
+ */
+namespace SkParallelImageDecoder {
+    /**
+     *  Pass as threadCount to use one worker thread per core.
+     */
+    static const int kThreadPerCore = -1;
+
+    /**
+     *  Decode the image encoded in data into bitmap.
+     *
+     *  Bands are a multiple of 16 rows tall so that they line up with JPEG
+     *  iMCU rows, and their layout depends only on the image height, so the
+     *  result does not depend on threadCount. Each worker thread owns its
+     *  own decoder and tile index, and the calling thread decodes the first
+     *  band itself.
+     *
+     *  @param pref Either kN32_SkColorType, kRGB_565_SkColorType or
+     *         kUnknown_SkColorType (which decodes to kN32_SkColorType).
+     *  @param threadCount Number of worker threads, or kThreadPerCore. If 0,
+     *         all bands are decoded serially on the calling thread.
+     *
+     *  @return false if the format does not support tile based decoding or
+     *          if any band fails to decode, in which case bitmap is left
+     *          untouched. Callers should fall back to SkImageDecoder::decode().
+     */
+    bool Decode(SkData* data, SkBitmap* bitmap, SkColorType pref, int threadCount);
+}
+
+#endif  // SkParallelImageDecoder_DEFINED
@@ -111,6 +111,31 @@ public:
      */
     void setMaxRecordingStorage(size_t maxStorage);
 
+    /**
+     *  Enable or disable pipelined flushing, which is off by default. When
+     *  enabled, flush() hands the recorded draw commands to a raster thread
+     *  and returns without waiting for them to be drawn, so that the next
+     *  frame can be recorded meanwhile. Only one frame is drawn at a time:
+     *  the next flush(), or reaching the limit set by setMaxRecordingStorage,
+     *  waits for the previous frame to be drawn first. Anything else that
+     *  needs the surface's pixels (e.g. readPixels or newImageSnapshot) waits
+     *  for it too, and flushes synchronously.
+     *  A flush only goes to the raster thread when there are no saves left
+     *  to restore. Only for raster surfaces: the surface's canvas is drawn
+     *  to from the raster thread, which is started by the first such flush
+     *  and kept until pipelined flushing is disabled. With a GPU surface,
+     *  flush() always draws on the calling thread.
+     *  @param pipelined true/false
+     */
+    void setPipelinedFlushing(bool pipelined);
+
+    /**
+     *  Blocks until a frame handed to the raster thread by flush() has been
+     *  drawn. The surface must not be accessed directly (other than through
+     *  this canvas) until this has been called.
+     */
+    void waitForPipelinedFlush();
+
     /**
      *  Returns the number of bytes currently allocated for the purpose of
      *  recording draw commands.
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGPipeRingController_DEFINED
+#define SkGPipeRingController_DEFINED
+
+#include "SkGPipe.h"
+
+class SkCanvas;
+class SkCondVar;
+class SkThread;
+
+/**
+ *  An SkGPipeController that hands the writer blocks out of a fixed size ring buffer, so that
+ *  a reader on another thread (see SkGPipeReaderThread) can play the commands back while
+ *  more are being recorded. There must be exactly one thread writing and one thread reading.
+ *
+ *  Neither side takes a lock while the ring is neither full nor empty. The writer blocks in
+ *  requestBlock() while the ring is too full for the block it asks for, and the reader blocks
+ *  in beginRead() while the ring is empty. If a single block is asked for that could never
+ *  fit, the ring grows the next time the reader has caught up.
+ *
+ *  The reader doesn't share the writer's bitmap heap, so the writer must be started with
+ *  kWriterFlags, which makes it copy everything the reader needs into the stream.
+ */
+class SK_API SkGPipeRingController : public SkGPipeController {
+public:
+    static const uint32_t kWriterFlags = SkGPipeWriter::kCrossProcess_Flag;
+
+    enum {
+        kDefaultCapacity = 1024 * 1024
+    };
+
+    explicit SkGPipeRingController(size_t capacity = kDefaultCapacity);
+    virtual ~SkGPipeRingController();
+
+    // Called by the writer.
+    virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
+    virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
+
+    /**
+     *  Wait until there is something to read, and return it. Returns NULL once the writer
+     *  has finished and everything it wrote has been read. Called by the reader.
+     *
+     *  @param bytes Set to the number of bytes that can be read from the returned address.
+     *      This is always a multiple of 4, and contains only whole commands.
+     */
+    const void* beginRead(size_t* bytes);
+
+    /**
+     *  Hand the space taken by the last bytes returned by beginRead() back to the writer.
+     */
+    void endRead(size_t bytes);
+
+    /**
+     *  Called by the reader if it stops reading before the writer has finished (e.g. on
+     *  error). Any later requestBlock() fails, which stops the writer, rather than waiting
+     *  forever for space.
+     */
+    void close();
+
+private:
+    bool findBlock(size_t minRequest, size_t* start, size_t* size) const;
+
+    // Sleep until mustWait() returns false. *waiting counts the sleepers on one side, so the
+    // other side only has to take the lock to wake them if there are any.
+    void waitWhile(bool (*mustWait)(const SkGPipeRingController*), int32_t* waiting);
+    void wake(int32_t* waiting);
+
+    static bool ReaderMustWait(const SkGPipeRingController*);
+    static bool WriterMustWait(const SkGPipeRingController*);
+
+    char*       fBuffer;
+    size_t      fCapacity;
+
+    // Written only by the writer.
+    size_t      fHead;          // End of the data that has been written.
+    size_t      fWrap;          // When fHead < fTail, where the data before fHead ends.
+    bool        fWriterDone;
+    size_t      fCursor;        // Where the next notifyWritten()'s bytes start.
+    size_t      fMinRequest;    // Of the requestBlock() in progress.
+
+    // Written only by the reader.
+    size_t      fTail;          // Start of the data that has not been read yet.
+    bool        fReaderClosed;
+
+    SkCondVar*  fCond;
+    int32_t     fReaderWaiting;
+    int32_t     fWriterWaiting;
+
+    typedef SkGPipeController INHERITED;
+};
+
+/**
+ *  Plays an SkGPipeRingController's commands back into a canvas on a thread of its own.
+ */
+class SK_API SkGPipeReaderThread : SkNoncopyable {
+public:
+    SkGPipeReaderThread(SkGPipeRingController*, SkCanvas* target);
+
+    /**
+     *  Calls join().
+     */
+    ~SkGPipeReaderThread();
+
+    void setBitmapDecoder(SkPicture::InstallPixelRefProc proc) { fReader.setBitmapDecoder(proc); }
+
+    /**
+     *  Start reading. Returns false if the thread could not be started.
+     */
+    bool start();
+
+    /**
+     *  Wait until the reader reaches the end of the commands (i.e. the writer's endRecording()),
+     *  or fails to read them.
+     *
+     *  @return kDone_Status if every command was played back.
+     */
+    SkGPipeReader::Status join();
+
+private:
+    static void Run(void* self);
+
+    SkGPipeRingController*  fController;
+    SkGPipeReader           fReader;
+    SkThread*               fThread;
+    SkGPipeReader::Status   fStatus;
+};
+
+#endif
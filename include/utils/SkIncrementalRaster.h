@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkIncrementalRaster_DEFINED
+#define SkIncrementalRaster_DEFINED
+
+#include "SkBitmap.h"
+#include "SkPicture.h"
+#include "SkRegion.h"
+
+/**
+ *  Keeps a persistent raster of a sequence of pictures, e.g. the frames of an animation. Each
+ *  new picture is compared op by op with the last one drawn (see SkPictureUtils::ComputeDamage),
+ *  and only the parts of the raster that may have changed are redrawn. Mostly-static frames
+ *  turn into small partial updates.
+ *
+ *  The result is the same as drawing each picture from scratch, except that edges crossing the
+ *  boundary of a redrawn area may rasterize slightly differently, as they can under any clip.
+ *  This mostly affects anti-aliased edges.
+ */
+class SK_API SkIncrementalRaster : SkNoncopyable {
+public:
+    /**
+     *  Allocate the raster. It starts out cleared to transparent black, and
+     *  the first draw() redraws all of it.
+     */
+    explicit SkIncrementalRaster(const SkImageInfo& info);
+
+    const SkBitmap& bitmap() const { return fBitmap; }
+
+    /**
+     *  Update the raster to look as if picture had been drawn into it after
+     *  clearing it to transparent black. If damage is not NULL, it is set to
+     *  the area that was redrawn. That area is made of at most a few rects,
+     *  since each one costs a replay of the picture.
+     */
+    void draw(const SkPicture* picture, SkRegion* damage = NULL);
+
+    /**
+     *  Forget the last picture, so the next draw() redraws the whole raster.
+     */
+    void reset() { fPrevious.reset(NULL); }
+
+private:
+    SkBitmap                      fBitmap;
+    SkAutoTUnref<const SkPicture> fPrevious;
+};
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPicturePrefetcher_DEFINED
+#define SkPicturePrefetcher_DEFINED
+
+#include "SkTDArray.h"
+#include "SkTypes.h"
+
+class SkPicture;
+class SkPixelRef;
+struct SkRect;
+template <typename T> class SkTThreadPool;
+
+/**
+ *  Decodes the lazily-generated bitmaps (e.g. SkDiscardablePixelRef) that a picture will draw
+ *  into some area, on a pool of background threads, ahead of playback. Without this, each
+ *  decode happens synchronously inside the first lockPixels() during playback, stalling the
+ *  raster thread.
+ *
+ *  Prefetched pixel refs are kept locked, so their pixels can't be purged before playback.
+ *  They stay locked until reset() is called or the prefetcher is destroyed.
+ *
+ *  A prefetcher is meant to be driven from a single thread.
+ */
+class SK_API SkPicturePrefetcher : SkNoncopyable {
+public:
+    /**
+     *  Decode on threadCount background threads, or one per core if threadCount is -1. If 0,
+     *  prefetch() decodes synchronously on the calling thread.
+     */
+    explicit SkPicturePrefetcher(int threadCount = -1);
+    ~SkPicturePrefetcher();
+
+    /**
+     *  Schedule decoding of every pixel ref that pict might draw inside area. The set of pixel
+     *  refs comes from SkPictureUtils::GatherPixelRefs, which plays the picture back clipped
+     *  to area (and so only visits the ops its bounding box hierarchy says intersect area).
+     *  Pixel refs that this prefetcher has already scheduled are skipped.
+     *
+     *  The pixel refs are ref()ed, so they outlive pict if need be.
+     *
+     *  @return the number of pixel refs newly scheduled.
+     */
+    int prefetch(const SkPicture* pict, const SkRect& area);
+
+    /**
+     *  Block until every decode scheduled so far has finished.
+     */
+    void wait();
+
+    /**
+     *  wait(), then unlock and unref every prefetched pixel ref, letting their pixels be
+     *  purged again.
+     */
+    void reset();
+
+private:
+    class PrefetchTask;
+
+    int                         fThreadCount;
+    SkTThreadPool<void>*        fPool;     // Created lazily, deleted by wait().
+    SkTDArray<PrefetchTask*>    fTasks;
+    SkTDArray<SkPixelRef*>      fPixelRefs;
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include "SkTDArray.h"
 
 class SkData;
+class SkRegion;
+struct SkIRect;
 struct SkRect;
 
 class SK_API SkPictureUtils {
@@ -78,6 +80,20 @@ public:
      *  and rect information.
      */
     static void GatherPixelRefsAndRects(SkPicture* pict, SkPixelRefContainer* prCont);
+
+    /**
+     *  Compute the part of area that may draw differently if after is drawn in
+     *  place of before, by matching up the two pictures' ops. Redrawing after
+     *  clipped to the damage gives the same pixels as redrawing it entirely
+     *  (see SkIncrementalRaster).
+     *
+     *  The damage is conservative. If the pictures can't be compared op by op
+     *  (e.g. either was recorded with DEPRECATED_beginRecording), or after
+     *  can't be drawn piecewise (e.g. it uses image filters), and they are not
+     *  the same picture, the damage is all of area.
+     */
+    static void ComputeDamage(const SkPicture* before, const SkPicture* after,
+                              const SkIRect& area, SkRegion* damage);
 };
 
 #endif
@@ -24,6 +24,10 @@ void SkBBoxHierarchyRecord::handleBBox(const SkRect& bounds) {
     bounds.roundOut(&r);
     SkPictureStateTree::Draw* draw = fStateTree->appendDraw(this->writeStream().bytesWritten());
     fBoundingHierarchy->insert(draw, r, true);
+
+    SkPictDrawIndexEntry* entry = fDrawIndex.append();
+    entry->fOffset = draw->fOffset;
+    entry->fBounds = r;
 }
 
 void SkBBoxHierarchyRecord::willSave() {
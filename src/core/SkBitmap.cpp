@@ -1220,11 +1220,24 @@ bool SkBitmap::ReadRawPixels(SkReadBuffer* buffer, SkBitmap* bitmap) {
         return false;
     }
 
-    char* dst = (char*)sk_malloc_throw(ramSize);
-    buffer->readByteArray(dst, snugSize);
-    SkAutoDataUnref data(SkData::NewFromMalloc(dst, ramSize));
+    SkAutoDataUnref data;
+    bool sharesBuffer = false;
+    if (snugSize == ramSize) {
+        // The rows are already laid out as we want them, so this can reference the buffer's
+        // backing data in place rather than copying (e.g. SkPicture::CreateFromData).
+        if (!buffer->validate(buffer->getArrayCount() == snugSize)) {
+            return false;
+        }
+        data.reset(buffer->readByteArrayAsData());
+        if (!buffer->validate(data->size() == ramSize)) {
+            return false;
+        }
+        sharesBuffer = true;
+    } else {
+        char* dst = (char*)sk_malloc_throw(ramSize);
+        buffer->readByteArray(dst, snugSize);
+        data.reset(SkData::NewFromMalloc(dst, ramSize));
 
-    if (snugSize != ramSize) {
         const char* srcRow = dst + snugRB * (height - 1);
         char* dstRow = dst + ramRB * (height - 1);
         for (int y = height - 1; y >= 1; --y) {
@@ -1242,6 +1255,10 @@ bool SkBitmap::ReadRawPixels(SkReadBuffer* buffer, SkBitmap* bitmap) {
 
     SkAutoTUnref<SkPixelRef> pr(SkMallocPixelRef::NewWithData(info, info.minRowBytes(),
                                                               ctable.get(), data.get()));
+    if (sharesBuffer) {
+        // The pixels may live in a read-only mapping or in memory owned by the caller.
+        pr->setImmutable();
+    }
     bitmap->setInfo(pr->info());
     bitmap->setPixelRef(pr, 0, 0);
     return true;
@@ -6,6 +6,7 @@
  */
 
 #include "SkBitmapCache.h"
+#include "SkMatrix.h"
 #include "SkRect.h"
 
 /**
@@ -89,3 +90,36 @@ SkScaledImageCache::ID* SkMipMapCache::AddAndLock(const SkBitmap& src, const SkM
     return SkScaledImageCache::AddAndLock(key, result);
 }
 
+
+////
+
+struct LayerKey : public SkScaledImageCache::Key {
+public:
+    LayerKey(uint32_t pictureID, size_t start, size_t stop, const SkMatrix& ctm)
+    : fPictureID(pictureID)
+    , fStart(SkToU32(start))
+    , fStop(SkToU32(stop))
+    {
+        for (int i = 0; i < 9; ++i) {
+            fCTM[i] = ctm[i];
+        }
+        this->init(sizeof(fPictureID) + sizeof(fStart) + sizeof(fStop) + sizeof(fCTM));
+    }
+
+    uint32_t    fPictureID;
+    uint32_t    fStart;
+    uint32_t    fStop;
+    SkScalar    fCTM[9];
+};
+
+SkScaledImageCache::ID* SkLayerCache::FindAndLock(uint32_t pictureID, size_t start, size_t stop,
+                                                  const SkMatrix& ctm, SkBitmap* result) {
+    LayerKey key(pictureID, start, stop, ctm);
+    return SkScaledImageCache::FindAndLock(key, result);
+}
+
+SkScaledImageCache::ID* SkLayerCache::AddAndLock(uint32_t pictureID, size_t start, size_t stop,
+                                                 const SkMatrix& ctm, const SkBitmap& result) {
+    LayerKey key(pictureID, start, stop, ctm);
+    return SkScaledImageCache::AddAndLock(key, result);
+}
@@ -10,6 +10,8 @@
 
 #include "SkScaledImageCache.h"
 
+class SkMatrix;
+
 class SkBitmapCache {
 public:
     typedef SkScaledImageCache::ID ID;
@@ -42,4 +44,19 @@ public:
     static ID* AddAndLock(const SkBitmap& src, const SkMipMap* result);
 };
 
+class SkLayerCache {
+public:
+    typedef SkScaledImageCache::ID ID;
+
+    static void Unlock(ID* id) {
+        SkScaledImageCache::Unlock(id);
+    }
+
+    /* Input: picture_uniqueID+saveLayer_opID+restore_opID+layer_CTM */
+    static ID* FindAndLock(uint32_t pictureID, size_t start, size_t stop, const SkMatrix& ctm,
+                           SkBitmap* result);
+    static ID* AddAndLock(uint32_t pictureID, size_t start, size_t stop, const SkMatrix& ctm,
+                          const SkBitmap& result);
+};
+
 #endif
@@ -6,8 +6,14 @@
  */
 
 #include "SkBitmapDevice.h"
+#include "SkBitmapCache.h"
 #include "SkConfig8888.h"
 #include "SkDraw.h"
+#include "SkLayerInfo.h"
+#include "SkPicture.h"
+#include "SkPictureData.h"
+#include "SkPictureRangePlayback.h"
+#include "SkPictureReplacementPlayback.h"
 #include "SkRasterClip.h"
 #include "SkShader.h"
 #include "SkSurface.h"
@@ -375,6 +381,207 @@ SkImageFilter::Cache* SkBitmapDevice::getImageFilterCache() {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+static SkPicture::AccelData::Key layer_info_key() {
+    static const SkPicture::AccelData::Key gRasterID = SkPicture::AccelData::GenerateDomain();
+
+    return gRasterID;
+}
+
+void SkBitmapDevice::EXPERIMENTAL_optimize(const SkPicture* picture) {
+    // SkPictureReplacementPlayback can only play back SkPictureData-based pictures.
+    if (NULL == picture->fData.get() || !picture->fData->suitableForLayerOptimization()) {
+        return;
+    }
+
+    SkPicture::AccelData::Key key = layer_info_key();
+
+    const SkPicture::AccelData* existing = picture->EXPERIMENTAL_getAccelData(key);
+    if (NULL != existing) {
+        return;
+    }
+
+    SkAutoTUnref<SkLayerInfo> data(SkNEW_ARGS(SkLayerInfo, (key)));
+
+    picture->EXPERIMENTAL_addAccelData(data);
+
+    SkGatherLayerInfo(picture, data);
+}
+
+// Layers are pre-rendered in their entirety, whatever the clip, so that they
+// can be reused. kSaveLayerMaxSize keeps that from costing more than it saves.
+static const int kSaveLayerMaxSize = 256;
+
+static bool layer_is_cacheable(const SkLayerInfo::SaveLayerInfo& info) {
+    // Drawing the layer back as a bitmap would apply an image filter
+    // differently from restore, so those layers are always re-rendered.
+    return info.fValid &&
+           !info.fIsNested &&
+           info.fSize.fWidth <= kSaveLayerMaxSize &&
+           info.fSize.fHeight <= kSaveLayerMaxSize &&
+           NULL != info.fPaint &&
+           NULL == info.fPaint->getImageFilter();
+}
+
+// Mark the layers that cover the drawn region, either those holding one of
+// the active ops (if the picture has a BBH) or those intersecting 'query'.
+static bool find_layers_to_cache(const SkLayerInfo* layerInfo,
+                                 const SkTDArray<uint32_t>* activeOffsets,
+                                 const SkIRect& query,
+                                 bool* pullForward) {
+    bool anyCached = false;
+
+    for (int j = 0; j < layerInfo->numSaveLayers(); ++j) {
+        const SkLayerInfo::SaveLayerInfo& info = layerInfo->saveLayerInfo(j);
+
+        if (!layer_is_cacheable(info)) {
+            continue;
+        }
+
+        bool drawn = false;
+        if (NULL != activeOffsets) {
+            for (int i = 0; i < activeOffsets->count() && !drawn; ++i) {
+                uint32_t offset = (*activeOffsets)[i];
+                drawn = offset >= info.fSaveLayerOpID && offset <= info.fRestoreOpID;
+            }
+        } else {
+            SkIRect layerRect = SkIRect::MakeXYWH(info.fOffset.fX,
+                                                  info.fOffset.fY,
+                                                  info.fSize.fWidth,
+                                                  info.fSize.fHeight);
+            drawn = SkIRect::Intersects(query, layerRect);
+        }
+
+        if (drawn) {
+            pullForward[j] = true;
+            anyCached = true;
+        }
+    }
+
+    return anyCached;
+}
+
+bool SkBitmapDevice::EXPERIMENTAL_drawPicture(SkCanvas* canvas, const SkPicture* picture,
+                                              const SkMatrix* matrix, const SkPaint* paint) {
+    // todo: should handle these natively
+    if (matrix || paint) {
+        return false;
+    }
+
+    const SkPicture::AccelData* data = picture->EXPERIMENTAL_getAccelData(layer_info_key());
+    if (NULL == data) {
+        return false;
+    }
+
+    const SkLayerInfo* layerInfo = static_cast<const SkLayerInfo*>(data);
+
+    if (0 == layerInfo->numSaveLayers()) {
+        return false;
+    }
+
+    // The layers are drawn back unscaled, so they can only stand in for the
+    // real thing when the picture lands on whole device pixels.
+    const SkMatrix& ctm = canvas->getTotalMatrix();
+    if ((ctm.getType() & ~SkMatrix::kTranslate_Mask) ||
+        !SkScalarIsInt(ctm.getTranslateX()) ||
+        !SkScalarIsInt(ctm.getTranslateY())) {
+        return false;
+    }
+
+    SkRect clipBounds;
+    if (!canvas->getClipBounds(&clipBounds)) {
+        return true;
+    }
+    SkIRect query;
+    clipBounds.roundOut(&query);
+
+    SkAutoTDelete<const SkPicture::OperationList> ops(picture->EXPERIMENTAL_getActiveOps(query));
+
+    SkAutoTArray<bool> pullForward(layerInfo->numSaveLayers());
+    for (int i = 0; i < layerInfo->numSaveLayers(); ++i) {
+        pullForward[i] = false;
+    }
+
+    // The op list type is private to SkPicture, so only its offsets are passed on
+    SkTDArray<uint32_t> activeOffsets;
+    if (NULL != ops.get()) {
+        activeOffsets.setCount(ops->numOps());
+        for (int i = 0; i < ops->numOps(); ++i) {
+            activeOffsets[i] = ops->offset(i);
+        }
+    }
+
+    if (!find_layers_to_cache(layerInfo, NULL != ops.get() ? &activeOffsets : NULL,
+                              query, pullForward.get())) {
+        return false;
+    }
+
+    SkPictureReplacementPlayback::PlaybackReplacements replacements;
+    SkTDArray<SkLayerCache::ID*> locked;
+
+    // Find each layer in the cache, or render it and add it
+    for (int i = 0; i < layerInfo->numSaveLayers(); ++i) {
+        if (!pullForward[i]) {
+            continue;
+        }
+
+        const SkLayerInfo::SaveLayerInfo& info = layerInfo->saveLayerInfo(i);
+
+        SkBitmap layer;
+        SkLayerCache::ID* id = SkLayerCache::FindAndLock(picture->uniqueID(),
+                                                         info.fSaveLayerOpID,
+                                                         info.fRestoreOpID,
+                                                         info.fCTM,
+                                                         &layer);
+        if (NULL == id) {
+            layer.setInfo(SkImageInfo::MakeN32Premul(info.fSize.fWidth, info.fSize.fHeight));
+            if (!layer.allocPixels(SkScaledImageCache::GetAllocator(), NULL)) {
+                continue;   // the layer will just be drawn normally
+            }
+            layer.eraseColor(SK_ColorTRANSPARENT);
+
+            SkCanvas layerCanvas(layer);
+            // info.fCTM maps the layer's top/left to the origin.
+            layerCanvas.concat(info.fCTM);
+
+            SkPictureRangePlayback rangePlayback(picture,
+                                                 info.fSaveLayerOpID,
+                                                 info.fRestoreOpID);
+            rangePlayback.draw(&layerCanvas, NULL);
+
+            id = SkLayerCache::AddAndLock(picture->uniqueID(),
+                                          info.fSaveLayerOpID,
+                                          info.fRestoreOpID,
+                                          info.fCTM,
+                                          layer);
+        }
+        if (NULL != id) {
+            *locked.append() = id;
+        }
+
+        SkPictureReplacementPlayback::PlaybackReplacements::ReplacementInfo* replacement =
+                                                                    replacements.push();
+        replacement->fStart = info.fSaveLayerOpID;
+        replacement->fStop = info.fRestoreOpID;
+        replacement->fPos = info.fOffset;
+        replacement->fBM = SkNEW_ARGS(SkBitmap, (layer));  // fBM is allocated so ReplacementInfo can be POD
+        replacement->fPaint = info.fPaint;
+        replacement->fSrcRect = SkIRect::MakeWH(info.fSize.fWidth, info.fSize.fHeight);
+    }
+
+    // Render the entire picture using the cached layers
+    SkPictureReplacementPlayback playback(picture, &replacements, ops.get());
+
+    playback.draw(canvas, NULL);
+
+    for (int i = 0; i < locked.count(); ++i) {
+        SkLayerCache::Unlock(locked[i]);
+    }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool SkBitmapDevice::filterTextFlags(const SkPaint& paint, TextFlags* flags) {
     if (!paint.isLCDRenderText() || !paint.isAntiAlias()) {
         // we're cool with the paint as is
@@ -172,6 +172,12 @@ SkBitmapProcShader::BitmapProcShaderContext::BitmapProcShaderContext(
             break;
     }
 
+    // The state has no 16 bit procs for some bitmaps that only the 32 bit procs can sample
+    // (see SkBitmapProcState::canUseFloatCoords).
+    if (NULL == fState->getShaderProc16() && NULL == fState->getSampleProc16()) {
+        flags &= ~kHasSpan16_Flag;
+    }
+
     if (rec.fPaint->isDither() && bitmap.colorType() != kRGB_565_SkColorType) {
         // gradients can auto-dither in their 16bit sampler, but we don't so
         // we clear the flag here.
@@ -32,6 +32,7 @@ extern void  Clamp_SI8_opaque_D32_filter_DX_shaderproc_neon(const SkBitmapProcSt
 #define   NAME_WRAP(x)  x
 #include "SkBitmapProcState_filter.h"
 #include "SkBitmapProcState_procs.h"
+#include "SkBitmapProcState_shaderproc_template.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -487,10 +488,12 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
 
     if (SkPaint::kLow_FilterLevel == fFilterLevel) {
         // Only try bilerp if the matrix is "interesting" and
-        // the image has a suitable size.
+        // the image has a suitable size (or will be sampled with float
+        // coordinates, which have no such limit).
 
         if (fInvType <= SkMatrix::kTranslate_Mask ||
-                !valid_for_filtering(fBitmap->width() | fBitmap->height())) {
+                !(valid_for_filtering(fBitmap->width() | fBitmap->height()) ||
+                  this->canUseFloatCoords())) {
             fFilterLevel = SkPaint::kNone_FilterLevel;
         }
     }
@@ -647,6 +650,17 @@ bool SkBitmapProcState::chooseProcs(const SkMatrix& inv, const SkPaint& paint) {
         if (NULL == fShaderProc32) {
             fShaderProc32 = this->chooseShaderProc32();
         }
+        if (NULL == fShaderProc32) {
+            fShaderProc32 = this->chooseTileShaderProc32(trivialMatrix, clampClamp);
+        }
+
+        // Only the 32 bit shader procs sample with float coordinates, so
+        // leave no 16 bit procs to get the fixed point ones wrong.
+        if (fInvType > SkMatrix::kTranslate_Mask && this->canUseFloatCoords() &&
+            this->fixedPointOverflows()) {
+            fShaderProc16 = NULL;
+            fSampleProc16 = NULL;
+        }
     }
 
     // see if our platform has any accelerated overrides
@@ -882,6 +896,123 @@ static void S32_D32_constX_shaderproc(const SkBitmapProcState& s,
     sk_memset32(colors, color, count);
 }
 
+/*  The matrix procs step through the bitmap in 16.16 fixed point, which can't
+ *  address pixels past 32767 (16383 when filtering, as the filter procs pack
+ *  each coordinate into 14 bits), nor step more than 32767 pixels at a time.
+ *  These shader procs map each pixel with floats instead, for the N32 bitmaps
+ *  with scale+translate matrices and clamp tiling that run into those limits
+ *  (see fixedPointOverflows()). Each x is computed from the start of the span
+ *  rather than by stepping, so that errors don't accumulate along it.
+ */
+template <bool hasAlpha>
+static void Clamp_S32_D32_nofilter_scale_float(const SkBitmapProcState& s,
+                                               int x, int y,
+                                               SkPMColor* SK_RESTRICT colors,
+                                               int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(SkPaint::kNone_FilterLevel == s.fFilterLevel);
+    SkASSERT(hasAlpha == (s.fAlphaScale < 256));
+
+    const SkScalar maxX = SkIntToScalar(s.fBitmap->width() - 1);
+    const SkScalar maxY = SkIntToScalar(s.fBitmap->height() - 1);
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkScalar dx = s.fInvMatrix.getScaleX();
+    const unsigned alphaScale = s.fAlphaScale;
+
+    // Pinning first makes the truncation a floor, and keeps it in range.
+    const SkPMColor* SK_RESTRICT row =
+            s.fBitmap->getAddr32(0, (int)SkScalarPin(pt.fY, 0, maxY));
+    for (int i = 0; i < count; ++i) {
+        const SkPMColor c = row[(int)SkScalarPin(pt.fX + dx * i, 0, maxX)];
+        colors[i] = hasAlpha ? SkAlphaMulQ(c, alphaScale) : c;
+    }
+}
+
+// Returns the 4 bit subpixel weight of v, and the pixels on either side of it,
+// clamped to [0, max].
+static inline unsigned float_filter_coords(SkScalar v, SkScalar max,
+                                           int* v0, int* v1) {
+    // Pinning to [-1, max + 1] first keeps the floor in range, without
+    // changing which pixels are sampled.
+    v = SkScalarPin(v, -SK_Scalar1, max + SK_Scalar1);
+    const int i = SkScalarFloorToInt(v);
+    const int maxI = SkScalarFloorToInt(max);
+    *v0 = SkClampMax(i, maxI);
+    *v1 = SkClampMax(i + 1, maxI);
+    return (int)((v - i) * 16) & 0xF;
+}
+
+template <bool hasAlpha>
+static void Clamp_S32_D32_filter_scale_float(const SkBitmapProcState& s,
+                                             int x, int y,
+                                             SkPMColor* SK_RESTRICT colors,
+                                             int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(SkPaint::kNone_FilterLevel != s.fFilterLevel);
+    SkASSERT(hasAlpha == (s.fAlphaScale < 256));
+
+    const SkScalar maxX = SkIntToScalar(s.fBitmap->width() - 1);
+    const SkScalar maxY = SkIntToScalar(s.fBitmap->height() - 1);
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    // As in the matrix procs, sample the pixels around the point half a pixel
+    // up and to the left.
+    const SkScalar fx = pt.fX - SK_ScalarHalf;
+    const SkScalar dx = s.fInvMatrix.getScaleX();
+
+    int y0, y1;
+    const unsigned subY = float_filter_coords(pt.fY - SK_ScalarHalf, maxY,
+                                              &y0, &y1);
+    const SkPMColor* SK_RESTRICT row0 = s.fBitmap->getAddr32(0, y0);
+    const SkPMColor* SK_RESTRICT row1 = s.fBitmap->getAddr32(0, y1);
+    const unsigned alphaScale = s.fAlphaScale;
+
+    for (int i = 0; i < count; ++i) {
+        int x0, x1;
+        const unsigned subX = float_filter_coords(fx + dx * i, maxX, &x0, &x1);
+        if (hasAlpha) {
+            Filter_32_alpha(subX, subY, row0[x0], row0[x1], row1[x0], row1[x1],
+                            &colors[i], alphaScale);
+        } else {
+            Filter_32_opaque(subX, subY, row0[x0], row0[x1], row1[x0], row1[x1],
+                             &colors[i]);
+        }
+    }
+}
+
+// Referenced in opts_check_x86.cpp
+void Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                          int x, int y,
+                                                          SkPMColor* colors,
+                                                          int count) {
+    Clamp_S32_D32_nofilter_scale_float<false>(s, x, y, colors, count);
+}
+void Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                         int x, int y,
+                                                         SkPMColor* colors,
+                                                         int count) {
+    Clamp_S32_D32_nofilter_scale_float<true>(s, x, y, colors, count);
+}
+void Clamp_S32_opaque_D32_filter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                        int x, int y,
+                                                        SkPMColor* colors,
+                                                        int count) {
+    Clamp_S32_D32_filter_scale_float<false>(s, x, y, colors, count);
+}
+void Clamp_S32_alpha_D32_filter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                       int x, int y,
+                                                       SkPMColor* colors,
+                                                       int count) {
+    Clamp_S32_D32_filter_scale_float<true>(s, x, y, colors, count);
+}
+
 static void DoNothing_shaderproc(const SkBitmapProcState&, int x, int y,
                                  SkPMColor* SK_RESTRICT colors, int count) {
     // if we get called, the matrix is too tricky, so we just draw nothing
@@ -910,6 +1041,63 @@ bool SkBitmapProcState::setupForTranslate() {
     return true;
 }
 
+bool SkBitmapProcState::canUseFloatCoords() const {
+    static const unsigned kMask = SkMatrix::kTranslate_Mask | SkMatrix::kScale_Mask;
+
+    return kN32_SkColorType == fBitmap->colorType() &&
+           SkShader::kClamp_TileMode == fTileModeX &&
+           SkShader::kClamp_TileMode == fTileModeY &&
+           0 == (fInvType & ~kMask);
+}
+
+bool SkBitmapProcState::fixedPointOverflows() const {
+    if (SkPaint::kNone_FilterLevel != fFilterLevel &&
+        !valid_for_filtering(fBitmap->width() | fBitmap->height())) {
+        return true;
+    }
+    const SkScalar kMaxFixedInt = SkIntToScalar(SK_MaxS16);
+    return fBitmap->width() > SK_MaxS16 || fBitmap->height() > SK_MaxS16 ||
+           SkScalarAbs(fInvMatrix.getScaleX()) > kMaxFixedInt ||
+           SkScalarAbs(fInvMatrix.getScaleY()) > kMaxFixedInt ||
+           SkScalarAbs(fInvMatrix.getTranslateX()) > kMaxFixedInt ||
+           SkScalarAbs(fInvMatrix.getTranslateY()) > kMaxFixedInt;
+}
+
+SkBitmapProcState::ShaderProc32 SkBitmapProcState::chooseTileShaderProc32(bool trivialMatrix,
+                                                                          bool clampClamp) const {
+    // Only when fInvMatrix has been normalized to the unit square (which
+    // clamp/clamp and pure translates skip), and only for a scale, which
+    // the templates step through like the _scale matrix procs.
+    if (trivialMatrix || clampClamp ||
+        fInvType > (SkMatrix::kTranslate_Mask | SkMatrix::kScale_Mask) ||
+        fFilterLevel > SkPaint::kLow_FilterLevel) {
+        return NULL;
+    }
+
+    const bool filter = SkPaint::kNone_FilterLevel != fFilterLevel;
+    const bool hasAlpha = fAlphaScale < 256;
+    switch (fBitmap->colorType()) {
+        case kN32_SkColorType:
+            if (filter) {
+                // The platform's SIMD S32 filter sample procs beat filtering
+                // one pixel at a time here.
+                return NULL;
+            }
+            return choose_tile_shaderproc<S32_Source>(fTileModeX, fTileModeY, filter, hasAlpha);
+        case kRGB_565_SkColorType:
+            return choose_tile_shaderproc<S16_Source>(fTileModeX, fTileModeY, filter, hasAlpha);
+        case kIndex_8_SkColorType:
+            return choose_tile_shaderproc<SI8_Source>(fTileModeX, fTileModeY, filter, hasAlpha);
+        case kARGB_4444_SkColorType:
+            return choose_tile_shaderproc<S4444_Source>(fTileModeX, fTileModeY, filter, hasAlpha);
+        case kAlpha_8_SkColorType:
+            // fPaintPMColor already has the paint's alpha.
+            return choose_tile_shaderproc<SA8_Source>(fTileModeX, fTileModeY, filter, false);
+        default:
+            return NULL;
+    }
+}
+
 SkBitmapProcState::ShaderProc32 SkBitmapProcState::chooseShaderProc32() {
 
     if (kN32_SkColorType != fBitmap->colorType()) {
@@ -918,6 +1106,18 @@ SkBitmapProcState::ShaderProc32 SkBitmapProcState::chooseShaderProc32() {
 
     static const unsigned kMask = SkMatrix::kTranslate_Mask | SkMatrix::kScale_Mask;
 
+    // Translate-only matrices use integer coordinates below, so they only
+    // need this for a scale.
+    if (fInvType > SkMatrix::kTranslate_Mask && this->canUseFloatCoords() &&
+        this->fixedPointOverflows()) {
+        if (SkPaint::kNone_FilterLevel == fFilterLevel) {
+            return fAlphaScale < 256 ? Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc
+                                     : Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc;
+        }
+        return fAlphaScale < 256 ? Clamp_S32_alpha_D32_filter_scale_float_shaderproc
+                                 : Clamp_S32_opaque_D32_filter_scale_float_shaderproc;
+    }
+
     if (1 == fBitmap->width() && 0 == (fInvType & ~kMask)) {
         if (SkPaint::kNone_FilterLevel == fFilterLevel &&
             fInvType <= SkMatrix::kTranslate_Mask &&
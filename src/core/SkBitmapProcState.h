@@ -131,6 +131,7 @@ struct SkBitmapProcState {
 
 private:
     friend class SkBitmapProcShader;
+    friend class SkBitmapProcStateTester; // for unit testing
 
     ShaderProc32        fShaderProc32;      // chooseProcs
     ShaderProc16        fShaderProc16;      // chooseProcs
@@ -147,6 +148,15 @@ private:
     MatrixProc chooseMatrixProc(bool trivial_matrix);
     bool chooseProcs(const SkMatrix& inv, const SkPaint&);
     ShaderProc32 chooseShaderProc32();
+    // Picks one of the templated repeat/mirror shader procs (see
+    // SkBitmapProcState_shaderproc_template.h), or NULL.
+    ShaderProc32 chooseTileShaderProc32(bool trivialMatrix, bool clampClamp) const;
+
+    // Whether the float coordinate shader procs handle this bitmap and matrix
+    // (see chooseShaderProc32), and whether the matrix procs' 16.16 fixed
+    // point coordinates would overflow for them.
+    bool canUseFloatCoords() const;
+    bool fixedPointOverflows() const;
 
     // returns false if we did not try to scale the image. In that case, we
     // will need to "lock" its pixels some other way.
@@ -197,6 +207,22 @@ private:
 
 // These functions are generated via macros, but are exposed here so that
 // platformProcs may test for them by name.
+void S32_opaque_D32_nofilter_DX(const SkBitmapProcState& s, const uint32_t xy[],
+                                int count, SkPMColor colors[]);
+void S32_alpha_D32_nofilter_DX(const SkBitmapProcState& s, const uint32_t xy[],
+                               int count, SkPMColor colors[]);
+void Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                          int x, int y,
+                                                          SkPMColor colors[], int count);
+void Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                         int x, int y,
+                                                         SkPMColor colors[], int count);
+void Clamp_S32_opaque_D32_filter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                        int x, int y,
+                                                        SkPMColor colors[], int count);
+void Clamp_S32_alpha_D32_filter_scale_float_shaderproc(const SkBitmapProcState& s,
+                                                       int x, int y,
+                                                       SkPMColor colors[], int count);
 void S32_opaque_D32_filter_DX(const SkBitmapProcState& s, const uint32_t xy[],
                               int count, SkPMColor colors[]);
 void S32_alpha_D32_filter_DX(const SkBitmapProcState& s, const uint32_t xy[],
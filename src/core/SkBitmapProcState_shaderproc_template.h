@@ -0,0 +1,283 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapProcState_ShaderProcTemplate_DEFINED
+#define SkBitmapProcState_ShaderProcTemplate_DEFINED
+
+#include "SkBitmapProcState_utils.h"
+#include "SkColorPriv.h"
+#include "SkMathPriv.h"
+
+/*
+ *  Shader procs for scale+translate matrices with repeat or mirror tiling (in
+ *  either direction), generated for each source config from templates rather
+ *  than by re-including a header under different macros. They compute the
+ *  same colors as GeneralXY / RepeatX_RepeatY's matrix procs followed by the
+ *  sample procs, but in one pass, with the tile math inlined instead of called
+ *  through fTileProcX/Y for every pixel. SkBitmapProcState::
+ *  chooseTileShaderProc32() picks one by config, tile modes, filter and alpha.
+ *
+ *  This is included by SkBitmapProcState.cpp after SkBitmapProcState_procs.h,
+ *  whose filter helpers the source classes below use.
+ */
+
+// The tile modes, in the unit space that fInvMatrix maps to when the tiling is
+// not clamp/clamp. The same math as fixed_clamp/repeat/mirror and their low
+// bits procs in SkBitmapProcState_matrixProcs.cpp.
+struct ClampTileMode {
+    static unsigned Fixed(SkFixed x) {
+        if (x < 0) {
+            x = 0;
+        }
+        if (x >> 16) {
+            x = 0xFFFF;
+        }
+        return x;
+    }
+    static unsigned LowBits(SkFixed x, int) {
+        return (x >> 12) & 0xF;
+    }
+};
+
+struct RepeatTileMode {
+    static unsigned Fixed(SkFixed x) {
+        return x & 0xFFFF;
+    }
+    static unsigned LowBits(SkFixed x, int scale) {
+        return ((x * scale) >> 12) & 0xF;
+    }
+};
+
+struct MirrorTileMode {
+    static unsigned Fixed(SkFixed x) {
+        SkFixed s = x << 15 >> 31;
+        // s is FFFFFFFF if we're on an odd interval, or 0 if an even interval
+        return (x ^ s) & 0xFFFF;
+    }
+    static unsigned LowBits(SkFixed x, int scale) {
+        return ((x * scale) >> 12) & 0xF;
+    }
+};
+
+template <typename TileMode>
+static inline unsigned tile_fixed(SkFixed x, unsigned max) {
+    return SK_USHIFT16(TileMode::Fixed(x) * (max + 1));
+}
+
+// The source configs. Each one is constructed for a span, and turns one
+// source pixel, or four of them with their 4 bit subpixel weights, into an
+// SkPMColor (before the paint's alpha is applied). Like the PREAMBLE and
+// POSTAMBLE of SkBitmapProcState_procs.h, the constructor and destructor
+// take and release anything needed for the span.
+class S32_Source {
+public:
+    typedef SkPMColor Type;
+    explicit S32_Source(const SkBitmapProcState&) {}
+
+    SkPMColor sample(Type c) const { return c; }
+    SkPMColor filter(unsigned x, unsigned y, Type a00, Type a01, Type a10, Type a11) const {
+        SkPMColor c;
+        Filter_32_opaque(x, y, a00, a01, a10, a11, &c);
+        return c;
+    }
+};
+
+class S16_Source {
+public:
+    typedef uint16_t Type;
+    explicit S16_Source(const SkBitmapProcState&) {}
+
+    SkPMColor sample(Type c) const { return SkPixel16ToPixel32(c); }
+    SkPMColor filter(unsigned x, unsigned y, Type a00, Type a01, Type a10, Type a11) const {
+        return SkExpanded_565_To_PMColor(Filter_565_Expanded(x, y, a00, a01, a10, a11));
+    }
+};
+
+class SI8_Source {
+public:
+    typedef uint8_t Type;
+    explicit SI8_Source(const SkBitmapProcState& s)
+        : fColorTable(s.fBitmap->getColorTable())
+        , fColors(fColorTable->lockColors()) {}
+    ~SI8_Source() { fColorTable->unlockColors(); }
+
+    SkPMColor sample(Type c) const { return fColors[c]; }
+    SkPMColor filter(unsigned x, unsigned y, Type a00, Type a01, Type a10, Type a11) const {
+        SkPMColor c;
+        Filter_32_opaque(x, y, fColors[a00], fColors[a01], fColors[a10], fColors[a11], &c);
+        return c;
+    }
+
+private:
+    SkColorTable*               fColorTable;
+    const SkPMColor* SK_RESTRICT fColors;
+};
+
+class S4444_Source {
+public:
+    typedef SkPMColor16 Type;
+    explicit S4444_Source(const SkBitmapProcState&) {}
+
+    SkPMColor sample(Type c) const { return SkPixel4444ToPixel32(c); }
+    SkPMColor filter(unsigned x, unsigned y, Type a00, Type a01, Type a10, Type a11) const {
+        return Filter_4444_D32(x, y, a00, a01, a10, a11);
+    }
+};
+
+// The paint's alpha is already in fPaintPMColor, so A8 has no alpha variants.
+class SA8_Source {
+public:
+    typedef uint8_t Type;
+    explicit SA8_Source(const SkBitmapProcState& s) : fPMColor(s.fPaintPMColor) {}
+
+    SkPMColor sample(Type a) const { return SkAlphaMulQ(fPMColor, SkAlpha255To256(a)); }
+    SkPMColor filter(unsigned x, unsigned y, Type a00, Type a01, Type a10, Type a11) const {
+        return this->sample(Filter_8(x, y, a00, a01, a10, a11));
+    }
+
+private:
+    const SkPMColor fPMColor;
+};
+
+template <bool hasAlpha>
+static inline SkPMColor apply_alpha(SkPMColor c, unsigned alphaScale) {
+    return hasAlpha ? SkAlphaMulQ(c, alphaScale) : c;
+}
+
+template <typename Source, typename TileX, typename TileY, bool filter, bool hasAlpha>
+void Tile_D32_scale_shaderproc(const SkBitmapProcState& s, int x, int y,
+                               SkPMColor* SK_RESTRICT colors, int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(filter == (SkPaint::kNone_FilterLevel != s.fFilterLevel));
+    SkASSERT(!hasAlpha || s.fAlphaScale < 256);
+
+    typedef typename Source::Type SrcType;
+    const Source source(s);
+    const unsigned alphaScale = s.fAlphaScale;
+    const unsigned maxX = s.fBitmap->width() - 1;
+    const unsigned maxY = s.fBitmap->height() - 1;
+    const char* SK_RESTRICT srcAddr = (const char*)s.fBitmap->getPixels();
+    const size_t rb = s.fBitmap->rowBytes();
+    const SkFractionalInt dx = s.fInvSxFractionalInt;
+
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                             SkIntToScalar(y) + SK_ScalarHalf, &pt);
+
+    if (filter) {
+        // As in the _filter_scale matrix procs.
+        const SkFixed oneX = s.fFilterOneX;
+        const SkFixed oneY = s.fFilterOneY;
+        const SkFixed fy = SkScalarToFixed(pt.fY) - (oneY >> 1);
+        const unsigned subY = TileY::LowBits(fy, maxY + 1);
+        const SrcType* SK_RESTRICT row0 =
+                (const SrcType*)(srcAddr + tile_fixed<TileY>(fy, maxY) * rb);
+        const SrcType* SK_RESTRICT row1 =
+                (const SrcType*)(srcAddr + tile_fixed<TileY>(fy + oneY, maxY) * rb);
+        SkFractionalInt fx = SkScalarToFractionalInt(pt.fX) -
+                             (SkFixedToFractionalInt(oneX) >> 1);
+
+        for (int i = 0; i < count; ++i) {
+            const SkFixed fixedFx = SkFractionalIntToFixed(fx);
+            const unsigned subX = TileX::LowBits(fixedFx, maxX + 1);
+            const unsigned x0 = tile_fixed<TileX>(fixedFx, maxX);
+            const unsigned x1 = tile_fixed<TileX>(fixedFx + oneX, maxX);
+            const SkPMColor c = source.filter(subX, subY, row0[x0], row0[x1],
+                                              row1[x0], row1[x1]);
+            colors[i] = apply_alpha<hasAlpha>(c, alphaScale);
+            fx += dx;
+        }
+    } else {
+        // As in NoFilterProc_Scale.
+        const unsigned srcY = tile_fixed<TileY>(
+                SkFractionalIntToFixed(SkScalarToFractionalInt(pt.fY)), maxY);
+        const SrcType* SK_RESTRICT row = (const SrcType*)(srcAddr + srcY * rb);
+        SkFractionalInt fx = SkScalarToFractionalInt(pt.fX);
+
+        // Fetch four pixels before converting any of them, as the unrolled
+        // sample procs do, so the compiler can convert them together.
+        for (int i = count >> 2; i > 0; --i) {
+            const SrcType s0 = row[tile_fixed<TileX>(SkFractionalIntToFixed(fx), maxX)];
+            fx += dx;
+            const SrcType s1 = row[tile_fixed<TileX>(SkFractionalIntToFixed(fx), maxX)];
+            fx += dx;
+            const SrcType s2 = row[tile_fixed<TileX>(SkFractionalIntToFixed(fx), maxX)];
+            fx += dx;
+            const SrcType s3 = row[tile_fixed<TileX>(SkFractionalIntToFixed(fx), maxX)];
+            fx += dx;
+            colors[0] = apply_alpha<hasAlpha>(source.sample(s0), alphaScale);
+            colors[1] = apply_alpha<hasAlpha>(source.sample(s1), alphaScale);
+            colors[2] = apply_alpha<hasAlpha>(source.sample(s2), alphaScale);
+            colors[3] = apply_alpha<hasAlpha>(source.sample(s3), alphaScale);
+            colors += 4;
+        }
+        for (int i = count & 3; i > 0; --i) {
+            const SkPMColor c = source.sample(
+                    row[tile_fixed<TileX>(SkFractionalIntToFixed(fx), maxX)]);
+            *colors++ = apply_alpha<hasAlpha>(c, alphaScale);
+            fx += dx;
+        }
+    }
+}
+
+// The four filter x alpha variants for a source and pair of tile modes.
+template <typename Source, typename TileX, typename TileY>
+struct TileShaderProcs {
+    static SkBitmapProcState::ShaderProc32 Choose(bool filter, bool hasAlpha) {
+        static const SkBitmapProcState::ShaderProc32 gProcs[] = {
+            Tile_D32_scale_shaderproc<Source, TileX, TileY, false, false>,
+            Tile_D32_scale_shaderproc<Source, TileX, TileY, false, true>,
+            Tile_D32_scale_shaderproc<Source, TileX, TileY, true,  false>,
+            Tile_D32_scale_shaderproc<Source, TileX, TileY, true,  true>,
+        };
+        return gProcs[(filter ? 2 : 0) | (hasAlpha ? 1 : 0)];
+    }
+};
+
+// Clamp/clamp maps to pixel space rather than the unit square, and has its
+// own matrix procs, which find the spans that need no clamping.
+template <typename Source>
+struct TileShaderProcs<Source, ClampTileMode, ClampTileMode> {
+    static SkBitmapProcState::ShaderProc32 Choose(bool, bool) {
+        return NULL;
+    }
+};
+
+template <typename Source, typename TileX>
+static SkBitmapProcState::ShaderProc32 choose_tile_shaderproc_y(unsigned tileModeY,
+                                                                bool filter,
+                                                                bool hasAlpha) {
+    switch (tileModeY) {
+        case SkShader::kClamp_TileMode:
+            return TileShaderProcs<Source, TileX, ClampTileMode>::Choose(filter, hasAlpha);
+        case SkShader::kRepeat_TileMode:
+            return TileShaderProcs<Source, TileX, RepeatTileMode>::Choose(filter, hasAlpha);
+        case SkShader::kMirror_TileMode:
+            return TileShaderProcs<Source, TileX, MirrorTileMode>::Choose(filter, hasAlpha);
+    }
+    return NULL;
+}
+
+template <typename Source>
+static SkBitmapProcState::ShaderProc32 choose_tile_shaderproc(unsigned tileModeX,
+                                                              unsigned tileModeY,
+                                                              bool filter,
+                                                              bool hasAlpha) {
+    switch (tileModeX) {
+        case SkShader::kClamp_TileMode:
+            return choose_tile_shaderproc_y<Source, ClampTileMode>(tileModeY, filter, hasAlpha);
+        case SkShader::kRepeat_TileMode:
+            return choose_tile_shaderproc_y<Source, RepeatTileMode>(tileModeY, filter, hasAlpha);
+        case SkShader::kMirror_TileMode:
+            return choose_tile_shaderproc_y<Source, MirrorTileMode>(tileModeY, filter, hasAlpha);
+    }
+    return NULL;
+}
+
+#endif
@@ -25,6 +25,10 @@ bool SkColorFilter::asComponentTable(SkBitmap*) const {
     return false;
 }
 
+SkColorFilter* SkColorFilter::newComposed(const SkColorFilter*) const {
+    return NULL;
+}
+
 void SkColorFilter::filterSpan16(const uint16_t s[], int count, uint16_t d[]) const {
     SkASSERT(this->getFlags() & SkColorFilter::kHasFilter16_Flag);
     SkDEBUGFAIL("missing implementation of SkColorFilter::filterSpan16");
@@ -6,7 +6,10 @@
  */
 
 #include "SkDistanceFieldGen.h"
+#include "SkDistanceField_opts.h"
+#include "SkLazyFnPtr.h"
 #include "SkPoint.h"
+#include "SkTemplates.h"
 
 struct DFData {
     float   fAlpha;      // alpha value of source texel
@@ -312,6 +315,116 @@ static void B2(DFData* curr, int width) {
     }
 }
 
+// Exact Euclidean distance transform (Meijster, Roerdink and Hesselink 2000)
+
+// kFar is farther than any texel is from any other.
+static const int32_t kFar = 1 << 28;
+
+// For every texel, the row of the nearest edge texel in its column (see SkDistanceField_opts.h).
+static void nearest_edge_rows(const unsigned char* edges, int width, int height,
+                              int32_t* rows, int32_t* scratch) {
+    // down the columns: the nearest edge at or above
+    for (int j = 0; j < height; ++j) {
+        for (int i = 0; i < width; ++i) {
+            const int index = j*width + i;
+            rows[index] = edges[index] ? j : (j > 0 ? rows[index - width] : -kFar);
+        }
+    }
+
+    // up the columns: the nearest edge at or below, kept if it is closer
+    for (int i = 0; i < width; ++i) {
+        scratch[i] = kFar;
+    }
+    for (int j = height-1; j >= 0; --j) {
+        for (int i = 0; i < width; ++i) {
+            const int index = j*width + i;
+            if (edges[index]) {
+                scratch[i] = j;
+            }
+            if (scratch[i] - j < j - rows[index]) {
+                rows[index] = scratch[i];
+            }
+        }
+    }
+}
+
+namespace {
+// This technically needs external linkage to be passed as a template parameter.
+SkDistanceFieldColumnProc choose_column_proc() {
+    SkDistanceFieldColumnProc proc = SkDistanceFieldGetPlatformColumnProc();
+    return proc ? proc : nearest_edge_rows;
+}
+}  // namespace
+
+// Once the nearest edge texel in each column is known, the nearest one in each row is the
+// lowest of the parabolas (i - column)^2 + (j - rows[column])^2 at i (Felzenszwalb and
+// Huttenlocher 2004). Every texel then takes the distance vector to the edge through its
+// nearest edge texel, as the propagation passes would.
+static void exact_distance_transform(DFData* data, const unsigned char* edges,
+                                     int width, int height) {
+    SkAutoTMalloc<int32_t> rowStorage(width*height + width);
+    int32_t* rows = rowStorage.get();
+    SK_DECLARE_STATIC_LAZY_FN_PTR(SkDistanceFieldColumnProc, columnProc, choose_column_proc);
+    columnProc.get()(edges, width, height, rows, rows + width*height);
+
+    // the columns whose parabolas make up the lower envelope, each one's height at zero, and
+    // where each one takes over from the last
+    SkAutoTMalloc<int> envelope(width);
+    SkAutoTMalloc<double> heights(width);
+    SkAutoTMalloc<double> starts(width + 1);
+
+    for (int j = 0; j < height; ++j) {
+        const int32_t* row = rows + j*width;
+        int count = 0;
+        for (int i = 0; i < width; ++i) {
+            if (row[i] < 0 || row[i] >= height) {
+                // no edges in this column
+                continue;
+            }
+            const double dy = row[i] - j;
+            const double h = dy*dy + (double)i*i;
+            double start = -SK_ScalarInfinity;
+            while (count > 0) {
+                const int prev = envelope[count-1];
+                start = (h - heights[count-1]) / (2.0*(i - prev));
+                if (start > starts[count-1]) {
+                    break;
+                }
+                --count;
+                start = -SK_ScalarInfinity;
+            }
+            envelope[count] = i;
+            heights[count] = h;
+            starts[count] = start;
+            ++count;
+        }
+        if (0 == count) {
+            // no edges at all, so everything stays far away
+            return;
+        }
+        starts[count] = SK_ScalarInfinity;
+
+        int k = 0;
+        DFData* currData = data + j*width;
+        const unsigned char* currEdge = edges + j*width;
+        for (int i = 0; i < width; ++i, ++currData, ++currEdge) {
+            while (starts[k+1] < i) {
+                ++k;
+            }
+            // edge texels keep their own distance
+            if (*currEdge) {
+                continue;
+            }
+            const int edgeX = envelope[k];
+            const int edgeY = row[edgeX];
+            const DFData& edgeData = data[edgeY*width + edgeX];
+            currData->fDistVector.set(edgeX - i + edgeData.fDistVector.fX,
+                                      edgeY - j + edgeData.fDistVector.fY);
+            currData->fDistSq = currData->fDistVector.lengthSqd();
+        }
+    }
+}
+
 // enable this to output edge data rather than the distance field
 #define DUMP_EDGE 0
 
@@ -331,7 +444,8 @@ static unsigned char pack_distance_field_val(float dist, float distanceMagnitude
 // width and height are the original width and height of the image
 static bool generate_distance_field_from_image(unsigned char* distanceField,
                                                const unsigned char* copyPtr,
-                                               int width, int height) {
+                                               int width, int height,
+                                               SkDistanceFieldMethod method) {
     SkASSERT(NULL != distanceField);
     SkASSERT(NULL != copyPtr);
 
@@ -361,71 +475,75 @@ static bool generate_distance_field_from_image(unsigned char* distanceField,
     // create initial distance data, particularly at edges
     init_distances(dataPtr, edgePtr, dataWidth, dataHeight);
 
-    // now perform Euclidean distance transform to propagate distances
-
-    // forwards in y
-    DFData* currData = dataPtr+dataWidth+1; // skip outer buffer
-    unsigned char* currEdge = edgePtr+dataWidth+1;
-    for (int j = 1; j < dataHeight-1; ++j) {
-        // forwards in x
-        for (int i = 1; i < dataWidth-1; ++i) {
-            // don't need to calculate distance for edge pixels
-            if (!*currEdge) {
-                F1(currData, dataWidth);
+    if (kExact_SkDistanceFieldMethod == method) {
+        exact_distance_transform(dataPtr, edgePtr, dataWidth, dataHeight);
+    } else {
+        // now perform Euclidean distance transform to propagate distances
+
+        // forwards in y
+        DFData* currData = dataPtr+dataWidth+1; // skip outer buffer
+        unsigned char* currEdge = edgePtr+dataWidth+1;
+        for (int j = 1; j < dataHeight-1; ++j) {
+            // forwards in x
+            for (int i = 1; i < dataWidth-1; ++i) {
+                // don't need to calculate distance for edge pixels
+                if (!*currEdge) {
+                    F1(currData, dataWidth);
+                }
+                ++currData;
+                ++currEdge;
             }
-            ++currData;
-            ++currEdge;
-        }
 
-        // backwards in x
-        --currData; // reset to end
-        --currEdge;
-        for (int i = 1; i < dataWidth-1; ++i) {
-            // don't need to calculate distance for edge pixels
-            if (!*currEdge) {
-                F2(currData, dataWidth);
-            }
-            --currData;
+            // backwards in x
+            --currData; // reset to end
             --currEdge;
-        }
-
-        currData += dataWidth+1;
-        currEdge += dataWidth+1;
-    }
-
-    // backwards in y
-    currData = dataPtr+dataWidth*(dataHeight-2) - 1; // skip outer buffer
-    currEdge = edgePtr+dataWidth*(dataHeight-2) - 1;
-    for (int j = 1; j < dataHeight-1; ++j) {
-        // forwards in x
-        for (int i = 1; i < dataWidth-1; ++i) {
-            // don't need to calculate distance for edge pixels
-            if (!*currEdge) {
-                B1(currData, dataWidth);
+            for (int i = 1; i < dataWidth-1; ++i) {
+                // don't need to calculate distance for edge pixels
+                if (!*currEdge) {
+                    F2(currData, dataWidth);
+                }
+                --currData;
+                --currEdge;
             }
-            ++currData;
-            ++currEdge;
+
+            currData += dataWidth+1;
+            currEdge += dataWidth+1;
         }
 
-        // backwards in x
-        --currData; // reset to end
-        --currEdge;
-        for (int i = 1; i < dataWidth-1; ++i) {
-            // don't need to calculate distance for edge pixels
-            if (!*currEdge) {
-                B2(currData, dataWidth);
+        // backwards in y
+        currData = dataPtr+dataWidth*(dataHeight-2) - 1; // skip outer buffer
+        currEdge = edgePtr+dataWidth*(dataHeight-2) - 1;
+        for (int j = 1; j < dataHeight-1; ++j) {
+            // forwards in x
+            for (int i = 1; i < dataWidth-1; ++i) {
+                // don't need to calculate distance for edge pixels
+                if (!*currEdge) {
+                    B1(currData, dataWidth);
+                }
+                ++currData;
+                ++currEdge;
             }
-            --currData;
+
+            // backwards in x
+            --currData; // reset to end
             --currEdge;
-        }
+            for (int i = 1; i < dataWidth-1; ++i) {
+                // don't need to calculate distance for edge pixels
+                if (!*currEdge) {
+                    B2(currData, dataWidth);
+                }
+                --currData;
+                --currEdge;
+            }
 
-        currData -= dataWidth-1;
-        currEdge -= dataWidth-1;
+            currData -= dataWidth-1;
+            currEdge -= dataWidth-1;
+        }
     }
 
     // copy results to final distance field data
-    currData = dataPtr + dataWidth+1;
-    currEdge = edgePtr + dataWidth+1;
+    DFData* currData = dataPtr + dataWidth+1;
+    unsigned char* currEdge = edgePtr + dataWidth+1;
     unsigned char *dfPtr = distanceField;
     for (int j = 1; j < dataHeight-1; ++j) {
         for (int i = 1; i < dataWidth-1; ++i) {
@@ -461,7 +579,8 @@ static bool generate_distance_field_from_image(unsigned char* distanceField,
 // assumes an 8-bit image and distance field
 bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
                                         const unsigned char* image,
-                                        int width, int height, int rowBytes) {
+                                        int width, int height, int rowBytes,
+                                        SkDistanceFieldMethod method) {
     SkASSERT(NULL != distanceField);
     SkASSERT(NULL != image);
 
@@ -476,20 +595,21 @@ bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
     unsigned char* currDestPtr = copyPtr + width + 2;
     for (int i = 0; i < height; ++i) {
         *currDestPtr++ = 0;
-        memcpy(currDestPtr, currSrcScanLine, rowBytes);
+        memcpy(currDestPtr, currSrcScanLine, width);
         currSrcScanLine += rowBytes;
         currDestPtr += width;
         *currDestPtr++ = 0;
     }
     sk_bzero(currDestPtr, (width+2)*sizeof(char));
 
-    return generate_distance_field_from_image(distanceField, copyPtr, width, height);
+    return generate_distance_field_from_image(distanceField, copyPtr, width, height, method);
 }
 
 // assumes a 1-bit image and 8-bit distance field
 bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
                                         const unsigned char* image,
-                                        int width, int height, int rowBytes) {
+                                        int width, int height, int rowBytes,
+                                        SkDistanceFieldMethod method) {
     SkASSERT(NULL != distanceField);
     SkASSERT(NULL != image);
 
@@ -517,5 +637,5 @@ bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
     }
     sk_bzero(currDestPtr, (width+2)*sizeof(char));
 
-    return generate_distance_field_from_image(distanceField, copyPtr, width, height);
+    return generate_distance_field_from_image(distanceField, copyPtr, width, height, method);
 }
@@ -24,6 +24,20 @@
 #define SK_DistanceFieldMultiplier   "7.96875"
 #define SK_DistanceFieldThreshold    "0.50196078431"
 
+/** How the distances from each texel to the nearest edge are found.
+ */
+enum SkDistanceFieldMethod {
+    /** Danielsson's 8SSEDT: two raster scans that pass the vector to the nearest edge found so
+     *  far from neighbor to neighbor. Fast, but it can settle on an edge slightly farther away
+     *  than the nearest one.
+     */
+    kApproximate_SkDistanceFieldMethod,
+    /** An exact Euclidean distance transform (Meijster et al.) that finds the nearest edge texel
+     *  for every texel, then adds the same subpixel offset to the edge as the approximate method.
+     */
+    kExact_SkDistanceFieldMethod
+};
+
 /** Given 8-bit mask data, generate the associated distance field
 
  *  @param distanceField     The distance field to be generated. Should already be allocated
@@ -32,10 +46,13 @@
  *  @param w                 Width of the original image.
  *  @param h                 Height of the original image.
  *  @param rowBytes          Size of each row in the image, in bytes
+ *  @param method            How to find the distance to the nearest edge.
  */
 bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
                                         const unsigned char* image,
-                                        int w, int h, int rowBytes);
+                                        int w, int h, int rowBytes,
+                                        SkDistanceFieldMethod method =
+                                                kApproximate_SkDistanceFieldMethod);
 
 /** Given 1-bit mask data, generate the associated distance field
 
@@ -45,10 +62,13 @@ bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
  *  @param w                 Width of the original image.
  *  @param h                 Height of the original image.
  *  @param rowBytes          Size of each row in the image, in bytes
+ *  @param method            How to find the distance to the nearest edge.
  */
 bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
                                         const unsigned char* image,
-                                        int w, int h, int rowBytes);
+                                        int w, int h, int rowBytes,
+                                        SkDistanceFieldMethod method =
+                                                kApproximate_SkDistanceFieldMethod);
 
 /** Given width and height of original image, return size (in bytes) of distance field
  *  @param w                 Width of the original image.
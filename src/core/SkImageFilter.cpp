@@ -373,6 +373,10 @@ bool SkImageFilter::asColorFilter(SkColorFilter**) const {
     return false;
 }
 
+bool SkImageFilter::asOffset(SkVector*) const {
+    return false;
+}
+
 #if SK_SUPPORT_GPU
 
 void SkImageFilter::WrapTexture(GrTexture* texture, int width, int height, SkBitmap* result) {
@@ -82,13 +82,16 @@ int SkPathHeap::insert(const SkPath& path) {
     return newSlot;
 }
 
-void SkPathHeap::flatten(SkWriteBuffer& buffer) const {
+void SkPathHeap::flatten(SkWriteBuffer& buffer, SkTDArray<uint32_t>* offsets) const {
     int count = fPaths.count();
 
     buffer.writeInt(count);
     SkPath* const* iter = fPaths.begin();
     SkPath* const* stop = fPaths.end();
     while (iter < stop) {
+        if (NULL != offsets) {
+            *offsets->append() = SkToU32(buffer.bytesWritten());
+        }
         buffer.writePath(**iter);
         iter++;
     }
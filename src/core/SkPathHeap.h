@@ -40,8 +40,11 @@ public:
     const SkPath& operator[](int index) const {
         return *fPaths[index];
     }
+    // called when a picture unflattens its paths on demand
+    SkPath* writablePath(int index) { return fPaths[index]; }
 
-    void flatten(SkWriteBuffer&) const;
+    /** If offsets is not NULL, the offset in buffer of each path is appended to it. */
+    void flatten(SkWriteBuffer&, SkTDArray<uint32_t>* offsets = NULL) const;
 
 private:
     // we store the paths in the heap (placement new)
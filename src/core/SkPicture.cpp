@@ -277,10 +277,13 @@ SkPicture::SkPicture(int width, int height,
 
 // Create an SkPictureData-backed SkPicture from an SkRecord.
 // This for compatibility with serialization code only.  This is not cheap.
-static SkPicture* backport(const SkRecord& src, int width, int height) {
+// If withDrawIndex, the bounds of each draw are recorded too, so that they can be serialized.
+static SkPicture* backport(const SkRecord& src, int width, int height, bool withDrawIndex) {
     SkPictureRecorder recorder;
-    SkRecordDraw(src,
-                 recorder.DEPRECATED_beginRecording(width, height), NULL/*bbh*/, NULL/*callback*/);
+    SkRTreeFactory factory;
+    SkCanvas* canvas = recorder.DEPRECATED_beginRecording(width, height,
+                                                          withDrawIndex ? &factory : NULL);
+    SkRecordDraw(src, canvas, NULL/*bbh*/, NULL/*callback*/);
     return recorder.endRecording();
 }
 
@@ -435,6 +438,21 @@ SkPicture* SkPicture::Forwardport(const SkPicture& src) {
 
 // fRecord OK
 SkPicture* SkPicture::CreateFromStream(SkStream* stream, InstallPixelRefProc proc) {
+    return CreateFromStream(stream, proc, NULL);
+}
+
+// fRecord OK
+SkPicture* SkPicture::CreateFromData(SkData* data, InstallPixelRefProc proc) {
+    if (NULL == data) {
+        return NULL;
+    }
+    SkMemoryStream stream(data);
+    return CreateFromStream(&stream, proc, data);
+}
+
+// fRecord OK
+SkPicture* SkPicture::CreateFromStream(SkStream* stream, InstallPixelRefProc proc,
+                                       SkData* backing) {
     SkPictInfo info;
 
     if (!InternalOnly_StreamIsSKP(stream, &info)) {
@@ -443,10 +461,14 @@ SkPicture* SkPicture::CreateFromStream(SkStream* stream, InstallPixelRefProc pro
 
     // Check to see if there is a playback to recreate.
     if (stream->readBool()) {
-        SkPictureData* data = SkPictureData::CreateFromStream(stream, info, proc);
+        SkPictureData* data = SkPictureData::CreateFromStream(stream, info, proc, backing);
         if (NULL == data) {
             return NULL;
         }
+        if (NULL != backing) {
+            // Forwardporting would copy every op into an SkRecord, so play back in place.
+            return SkNEW_ARGS(SkPicture, (data, info.fWidth, info.fHeight));
+        }
         const SkPicture src(data, info.fWidth, info.fHeight);
         return Forwardport(src);
     }
@@ -497,12 +519,22 @@ void SkPicture::createHeader(SkPictInfo* info) const {
 
 // fRecord OK
 void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
+    this->serialize(stream, encoder, false);
+}
+
+// fRecord OK
+void SkPicture::serializeCompact(SkWStream* stream, EncodeBitmap encoder) const {
+    this->serialize(stream, encoder, true);
+}
+
+// fRecord OK
+void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder, bool compact) const {
     const SkPictureData* data = fData.get();
 
     // If we're a new-format picture, backport to old format for serialization.
     SkAutoTDelete<SkPicture> oldFormat;
     if (NULL == data && NULL != fRecord.get()) {
-        oldFormat.reset(backport(*fRecord, fWidth, fHeight));
+        oldFormat.reset(backport(*fRecord, fWidth, fHeight, NULL != fBBH.get()));
         data = oldFormat->fData.get();
         SkASSERT(NULL != data);
     }
@@ -513,7 +545,7 @@ void SkPicture::serialize(SkWStream* stream, EncodeBitmap encoder) const {
 
     if (NULL != data) {
         stream->writeBool(true);
-        data->serialize(stream, encoder);
+        data->serialize(stream, encoder, compact);
     } else {
         stream->writeBool(false);
     }
@@ -526,7 +558,7 @@ void SkPicture::flatten(SkWriteBuffer& buffer) const {
     // If we're a new-format picture, backport to old format for serialization.
     SkAutoTDelete<SkPicture> oldFormat;
     if (NULL == data && NULL != fRecord.get()) {
-        oldFormat.reset(backport(*fRecord, fWidth, fHeight));
+        oldFormat.reset(backport(*fRecord, fWidth, fHeight, false));
         data = oldFormat->fData.get();
         SkASSERT(NULL != data);
     }
@@ -0,0 +1,371 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPictureCompactCodec.h"
+#include "SkData.h"
+#include "SkEndian.h"
+#include "SkPictureRecord.h"  // for MASK_24 and PACK_8_24
+#include "SkStream.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+
+namespace {
+
+// Each type of record remembers this many words of its last record to take differences from.
+static const int kContextWords = 64;
+// One type per op, or one per resource type (plus one for the rest of the buffer).
+static const int kTypeCount = 256;
+
+enum Mode {
+    kRaw_Mode,
+    kDelta_Mode,
+    kSwappedDelta_Mode,
+
+    kLast_Mode = kSwappedDelta_Mode
+};
+
+// Maps small negative differences to small values.
+static inline uint32_t zigzag(uint32_t delta) {
+    return (delta << 1) ^ (uint32_t)((int32_t)delta >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t value) {
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+static size_t varint_size(uint32_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        ++size;
+    }
+    return size;
+}
+
+static void write_varint(SkWStream* stream, uint32_t value) {
+    uint8_t bytes[5];
+    size_t count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (uint8_t)value;
+    stream->write(bytes, count);
+}
+
+class Reader {
+public:
+    Reader(const void* data, size_t length)
+        : fCurr(static_cast<const uint8_t*>(data))
+        , fStop(fCurr + length)
+        , fValid(true) {
+    }
+
+    bool isValid() const { return fValid; }
+    bool eof() const { return fCurr >= fStop; }
+
+    uint32_t readU32() {
+        uint32_t value = 0;
+        this->readWords(&value, 1);
+        return value;
+    }
+
+    uint32_t readVarint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (fCurr >= fStop) {
+                break;
+            }
+            const uint8_t byte = *fCurr++;
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (0 == (byte & 0x80)) {
+                return value;
+            }
+        }
+        fValid = false;
+        return 0;
+    }
+
+    bool readWords(uint32_t dst[], size_t count) {
+        const size_t size = count * sizeof(uint32_t);
+        if (SkToSizeT(fStop - fCurr) < size) {
+            fValid = false;
+            return false;
+        }
+        memcpy(dst, fCurr, size);
+        fCurr += size;
+        return true;
+    }
+
+private:
+    const uint8_t* fCurr;
+    const uint8_t* fStop;
+    bool           fValid;
+};
+
+/**
+ *  Writes and reads one record at a time, keeping the start of the last record of each type
+ *  to take differences from. A record is varint(count << 2 | mode) followed by its words.
+ */
+class RecordCoder : SkNoncopyable {
+public:
+    void write(SkWStream* stream, int type, const uint32_t words[], int count) {
+        SkASSERT(type >= 0 && type < kTypeCount);
+        SkTDArray<uint32_t>& context = fContext[type];
+
+        size_t deltaSize = 0, swappedSize = 0;
+        for (int i = 0; i < count; ++i) {
+            const uint32_t delta = zigzag(words[i] - Previous(context, i));
+            deltaSize += varint_size(delta);
+            swappedSize += varint_size(SkEndianSwap32(delta));
+        }
+        const size_t rawSize = count * sizeof(uint32_t);
+
+        Mode mode = kRaw_Mode;
+        if (deltaSize < rawSize && deltaSize <= swappedSize) {
+            mode = kDelta_Mode;
+        } else if (swappedSize < rawSize) {
+            mode = kSwappedDelta_Mode;
+        }
+
+        write_varint(stream, (SkToU32(count) << 2) | mode);
+        if (kRaw_Mode == mode) {
+            stream->write(words, rawSize);
+        } else {
+            for (int i = 0; i < count; ++i) {
+                uint32_t delta = zigzag(words[i] - Previous(context, i));
+                if (kSwappedDelta_Mode == mode) {
+                    delta = SkEndianSwap32(delta);
+                }
+                write_varint(stream, delta);
+            }
+        }
+        Update(&context, words, count);
+    }
+
+    // Returns the number of words read into dst, or -1 if the record is invalid or would not
+    // fit in capacity words.
+    int read(Reader* reader, int type, uint32_t dst[], int capacity) {
+        SkASSERT(type >= 0 && type < kTypeCount);
+        const uint32_t header = reader->readVarint();
+        const uint32_t count = header >> 2;
+        const uint32_t mode = header & 3;
+        if (!reader->isValid() || count > SkToU32(capacity) || mode > kLast_Mode) {
+            return -1;
+        }
+
+        SkTDArray<uint32_t>& context = fContext[type];
+        if (kRaw_Mode == mode) {
+            if (!reader->readWords(dst, count)) {
+                return -1;
+            }
+        } else {
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t delta = reader->readVarint();
+                if (kSwappedDelta_Mode == mode) {
+                    delta = SkEndianSwap32(delta);
+                }
+                dst[i] = Previous(context, i) + unzigzag(delta);
+            }
+            if (!reader->isValid()) {
+                return -1;
+            }
+        }
+        Update(&context, dst, count);
+        return count;
+    }
+
+private:
+    static uint32_t Previous(const SkTDArray<uint32_t>& context, int i) {
+        return i < context.count() ? context[i] : 0;
+    }
+
+    static void Update(SkTDArray<uint32_t>* context, const uint32_t words[], int count) {
+        count = SkTMin(count, kContextWords);
+        context->setCount(count);
+        memcpy(context->begin(), words, count * sizeof(uint32_t));
+    }
+
+    SkTDArray<uint32_t> fContext[kTypeCount];
+};
+
+// Every decoded word costs at least one encoded byte (the header words of an op share the
+// op's two header bytes), which bounds how much a valid encoding can decode to.
+static bool decoded_size_is_plausible(uint32_t decodedSize, size_t length) {
+    return SkIsAlign4(decodedSize) && decodedSize / sizeof(uint32_t) <= length;
+}
+
+// Writes the words of buffer from offset start up to offset stop, if there are any.
+static void write_buffer_record(SkWStream* stream, RecordCoder* coder, int type,
+                                const uint32_t words[], uint32_t start, uint32_t stop) {
+    if (stop > start) {
+        write_varint(stream, type);
+        coder->write(stream, type, words + start / sizeof(uint32_t),
+                     SkToInt((stop - start) / sizeof(uint32_t)));
+    }
+}
+
+}  // namespace
+
+SkData* SkPictureCompactCodec::EncodeOps(const SkData* ops) {
+    if (!SkIsAlign4(ops->size())) {
+        return NULL;
+    }
+    const uint32_t* words = static_cast<const uint32_t*>(ops->data());
+    const size_t count = ops->size() / sizeof(uint32_t);
+
+    SkDynamicMemoryWStream stream;
+    stream.write32(SkToU32(ops->size()));
+
+    RecordCoder coder;
+    size_t i = 0;
+    while (i < count) {
+        // See SkPicturePlayback::ReadOpAndSize.
+        const uint32_t header = words[i];
+        if ((uint8_t)header == header) {
+            return NULL;    // old SKP, no size information
+        }
+        const uint32_t op = header >> 24;
+        uint32_t size = header & MASK_24;
+        const bool extended = MASK_24 == size;
+        size_t headerWords = 1;
+        if (extended) {
+            if (i + 1 >= count) {
+                return NULL;
+            }
+            size = words[i + 1];
+            headerWords = 2;
+        }
+        if (!SkIsAlign4(size) || size / sizeof(uint32_t) < headerWords ||
+            size / sizeof(uint32_t) > count - i) {
+            return NULL;
+        }
+
+        write_varint(&stream, (op << 1) | extended);
+        coder.write(&stream, op, words + i + headerWords,
+                    SkToInt(size / sizeof(uint32_t) - headerWords));
+        i += size / sizeof(uint32_t);
+    }
+    return stream.copyToData();
+}
+
+SkData* SkPictureCompactCodec::DecodeOps(const void* data, size_t length) {
+    Reader reader(data, length);
+    const uint32_t size = reader.readU32();
+    if (!reader.isValid() || !decoded_size_is_plausible(size, length)) {
+        return NULL;
+    }
+
+    SkAutoMalloc storage(size);
+    uint32_t* words = static_cast<uint32_t*>(storage.get());
+    const int count = SkToInt(size / sizeof(uint32_t));
+
+    RecordCoder coder;
+    int i = 0;
+    while (i < count) {
+        const uint32_t opAndFlag = reader.readVarint();
+        const uint32_t op = opAndFlag >> 1;
+        const bool extended = SkToBool(opAndFlag & 1);
+        const int headerWords = extended ? 2 : 1;
+        if (!reader.isValid() || op >= SkToU32(kTypeCount) || count - i < headerWords) {
+            return NULL;
+        }
+
+        const int payload = coder.read(&reader, op, words + i + headerWords,
+                                       count - i - headerWords);
+        if (payload < 0) {
+            return NULL;
+        }
+        const uint32_t opSize = SkToU32((headerWords + payload) * sizeof(uint32_t));
+        if (extended) {
+            words[i] = PACK_8_24(op, MASK_24);
+            words[i + 1] = opSize;
+        } else {
+            if (opSize >= MASK_24) {
+                return NULL;
+            }
+            words[i] = PACK_8_24(op, opSize);
+        }
+        i += headerWords + payload;
+    }
+    if (!reader.eof()) {
+        return NULL;
+    }
+    return SkData::NewFromMalloc(storage.detach(), size);
+}
+
+SkData* SkPictureCompactCodec::EncodeBuffer(const void* buffer, size_t size,
+                                            const uint32_t counts[], int typeCount,
+                                            const uint32_t offsets[]) {
+    if (!SkIsAlign4(size) || typeCount + 1 > kTypeCount) {
+        return NULL;
+    }
+    const uint32_t* words = static_cast<const uint32_t*>(buffer);
+
+    // Each resource starts a record of its type (type 0 is whatever precedes the first
+    // resource). If the offsets don't split the buffer up cleanly, it is one big record.
+    int resourceCount = 0;
+    for (int type = 0; type < typeCount; ++type) {
+        resourceCount += SkToInt(counts[type]);
+    }
+    uint32_t last = 0;
+    for (int i = 0; i < resourceCount; ++i) {
+        if (offsets[i] < last || offsets[i] > size || !SkIsAlign4(offsets[i])) {
+            resourceCount = 0;
+            break;
+        }
+        last = offsets[i];
+    }
+
+    SkDynamicMemoryWStream stream;
+    stream.write32(SkToU32(size));
+
+    RecordCoder coder;
+    uint32_t start = 0;
+    int recordType = 0;
+    int resource = 0;
+    for (int type = 0; type < typeCount && resource < resourceCount; ++type) {
+        for (uint32_t i = 0; i < counts[type] && resource < resourceCount; ++i, ++resource) {
+            write_buffer_record(&stream, &coder, recordType, words, start, offsets[resource]);
+            start = offsets[resource];
+            recordType = 1 + type;
+        }
+    }
+    write_buffer_record(&stream, &coder, recordType, words, start, SkToU32(size));
+    return stream.copyToData();
+}
+
+SkData* SkPictureCompactCodec::DecodeBuffer(const void* data, size_t length) {
+    Reader reader(data, length);
+    const uint32_t size = reader.readU32();
+    if (!reader.isValid() || !decoded_size_is_plausible(size, length)) {
+        return NULL;
+    }
+
+    SkAutoMalloc storage(size);
+    uint32_t* words = static_cast<uint32_t*>(storage.get());
+    const int count = SkToInt(size / sizeof(uint32_t));
+
+    RecordCoder coder;
+    int i = 0;
+    while (i < count) {
+        const uint32_t type = reader.readVarint();
+        if (!reader.isValid() || type >= SkToU32(kTypeCount)) {
+            return NULL;
+        }
+        const int read = coder.read(&reader, type, words + i, count - i);
+        // Empty records are never written, so one would mean the data is corrupt.
+        if (read <= 0) {
+            return NULL;
+        }
+        i += read;
+    }
+    if (!reader.eof()) {
+        return NULL;
+    }
+    return SkData::NewFromMalloc(storage.detach(), size);
+}
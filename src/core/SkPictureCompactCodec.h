@@ -0,0 +1,57 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPictureCompactCodec_DEFINED
+#define SkPictureCompactCodec_DEFINED
+
+#include "SkTypes.h"
+
+class SkData;
+
+/**
+ *  A denser, lossless encoding of the two big chunks of a serialized picture: the op stream
+ *  and the buffer of flattened bitmaps, paints and paths. Both are split into records (one
+ *  per op, or one per flattened resource), and each 32-bit word of a record is stored as a
+ *  varint of its difference from the word at the same position in the previous record of
+ *  the same type. Runs of similar ops (e.g. drawRects with the same paint, or concats that
+ *  only translate) then cost a byte or two per word instead of four.
+ *
+ *  Each record picks whichever of the raw words, the differences, or the byte swapped
+ *  differences (which suit floats, whose low mantissa bits tend to change least) is
+ *  smallest, so no record grows by more than its one or two bytes of header.
+ *
+ *  Encoded data starts with the size of the decoded data, as a 32-bit word.
+ */
+class SkPictureCompactCodec {
+public:
+    /**
+     *  Returns NULL if the ops can't be split into records, which is the case for ops from
+     *  SKPs old enough not to record each op's size.
+     */
+    static SkData* EncodeOps(const SkData* ops);
+
+    /**
+     *  Returns NULL if data is not a valid encoding.
+     */
+    static SkData* DecodeOps(const void* data, size_t length);
+
+    /**
+     *  Encode a flattened resource buffer, given where each resource starts within it and
+     *  how many resources of each type there are (see SK_PICT_RESOURCE_INDEX_TAG).
+     *  Returns NULL if buffer's size is not a multiple of 4.
+     */
+    static SkData* EncodeBuffer(const void* buffer, size_t size,
+                                const uint32_t counts[], int typeCount,
+                                const uint32_t offsets[]);
+
+    /**
+     *  Returns NULL if data is not a valid encoding.
+     */
+    static SkData* DecodeBuffer(const void* data, size_t length);
+};
+
+#endif
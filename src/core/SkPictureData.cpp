@@ -7,6 +7,9 @@
 #include <new>
 #include "SkBBoxHierarchy.h"
 #include "SkDrawPictureCallback.h"
+#include "SkOnce.h"
+#include "SkPath.h"
+#include "SkPictureCompactCodec.h"
 #include "SkPictureData.h"
 #include "SkPictureRecord.h"
 #include "SkReadBuffer.h"
@@ -22,6 +25,35 @@ template <typename T> int SafeCount(const T* obj) {
     return obj ? obj->count() : 0;
 }
 
+/**
+ *  Holds the flattened bitmaps, paints and paths of a picture loaded from an SKP with a
+ *  resource index, and unflattens each one into the picture's arrays the first time playback
+ *  asks for it. The same picture may be played back on several threads at once, so each
+ *  resource is unflattened under SkOnce.
+ */
+class SkPictureData::LazyResources : SkNoncopyable {
+public:
+    LazyResources(SkData* buffer, SkPicture::InstallPixelRefProc proc)
+        : fBuffer(SkRef(buffer))
+        , fProc(proc) {
+    }
+
+    struct Request {
+        const SkPictureData* fData;
+        LazyType             fType;
+        int                  fIndex;
+    };
+    static void Unflatten(Request);
+
+    SkAutoTUnref<SkData>            fBuffer;
+    SkPicture::InstallPixelRefProc  fProc;
+    // The same heap as the picture's fPathHeap, which only exposes it as const.
+    SkAutoTUnref<SkPathHeap>        fPaths;
+    SkTDArray<uint32_t>             fOffsets[kLazyTypeCount];
+    SkTDArray<bool>                 fDone[kLazyTypeCount];
+    SkMutex                         fMutex;
+};
+
 SkPictureData::SkPictureData(const SkPictInfo& info)
     : fInfo(info) {
     this->init();
@@ -52,6 +84,14 @@ SkPictureData::SkPictureData(const SkPictureRecord& record,
     SkSafeRef(fStateTree);
     fContentInfo.set(record.fContentInfo);
 
+    for (int i = 0; i < record.fDrawIndex.count(); ++i) {
+        // Draws rewound out of the op stream can't be at the end of the index.
+        if (record.fDrawIndex[i].fOffset >= fOpData->size()) {
+            break;
+        }
+        *fDrawIndex.append() = record.fDrawIndex[i];
+    }
+
     if (NULL != fBoundingHierarchy) {
         fBoundingHierarchy->flushDeferredInserts();
     }
@@ -83,6 +123,9 @@ SkPictureData::SkPictureData(const SkPictureData& src, SkPictCopyInfo* deepCopyI
     : fInfo(src.fInfo) {
     this->init();
 
+    // The copy shares src's resource arrays, so they have to be filled in first.
+    src.unflattenAllLazily();
+
     fBitmapHeap.reset(SkSafeRef(src.fBitmapHeap.get()));
     fPathHeap.reset(SkSafeRef(src.fPathHeap.get()));
 
@@ -91,6 +134,7 @@ SkPictureData::SkPictureData(const SkPictureData& src, SkPictCopyInfo* deepCopyI
     fBoundingHierarchy = src.fBoundingHierarchy;
     fStateTree = src.fStateTree;
     fContentInfo.set(src.fContentInfo);
+    fDrawIndex = src.fDrawIndex;
 
     SkSafeRef(fBoundingHierarchy);
     SkSafeRef(fStateTree);
@@ -143,6 +187,7 @@ void SkPictureData::init() {
     fFactoryPlayback = NULL;
     fBoundingHierarchy = NULL;
     fStateTree = NULL;
+    fLazyResources = NULL;
 }
 
 SkPictureData::~SkPictureData() {
@@ -159,6 +204,7 @@ SkPictureData::~SkPictureData() {
     SkDELETE_ARRAY(fPictureRefs);
 
     SkDELETE(fFactoryPlayback);
+    SkDELETE(fLazyResources);
 }
 
 bool SkPictureData::containsBitmaps() const {
@@ -205,6 +251,37 @@ static void write_tag_size(SkWStream* stream, uint32_t tag, size_t size) {
     stream->write32(SkToU32(size));
 }
 
+// As of V34 the op stream and buffer chunks start at a 4-byte aligned stream offset, so that
+// SkPicture::CreateFromData can use them in place. A byte giving the amount of padding
+// precedes the padding itself.
+static void write_chunk_padding(SkWStream* stream) {
+    static const uint8_t kZeros[3] = { 0, 0, 0 };
+    const size_t offset = stream->bytesWritten() + 1;
+    const size_t padding = SkAlign4(offset) - offset;
+    stream->write8(SkToU8(padding));
+    stream->write(kZeros, padding);
+}
+
+static bool skip_chunk_padding(SkStream* stream, const SkPictInfo& info) {
+    if (info.fVersion < SkReadBuffer::kAlignedPictureChunks_Version) {
+        return true;
+    }
+    const size_t padding = stream->readU8();
+    return padding < 4 && stream->skip(padding) == padding;
+}
+
+// Returns a pointer to the next size bytes of a stream that is reading from backing, and
+// skips past them. Returns NULL if there aren't that many bytes left.
+static const void* skip_in_place(SkStream* stream, SkData* backing, size_t size) {
+    SkASSERT(stream->getMemoryBase() == backing->data());
+    const size_t offset = stream->getPosition();
+    if (offset > backing->size() || size > backing->size() - offset ||
+        stream->skip(size) != size) {
+        return NULL;
+    }
+    return backing->bytes() + offset;
+}
+
 void SkPictureData::WriteFactories(SkWStream* stream, const SkFactorySet& rec) {
     int count = rec.count();
 
@@ -247,12 +324,21 @@ void SkPictureData::WriteTypefaces(SkWStream* stream, const SkRefCntSet& rec) {
     }
 }
 
-void SkPictureData::flattenToBuffer(SkWriteBuffer& buffer) const {
+static void append_offset(SkTDArray<uint32_t>* offsets, const SkWriteBuffer& buffer) {
+    if (NULL != offsets) {
+        *offsets->append() = SkToU32(buffer.bytesWritten());
+    }
+}
+
+void SkPictureData::flattenToBuffer(SkWriteBuffer& buffer, SkTDArray<uint32_t>* offsets) const {
     int i, n;
 
+    this->unflattenAllLazily();
+
     if ((n = SafeCount(fBitmaps)) > 0) {
         write_tag_size(buffer, SK_PICT_BITMAP_BUFFER_TAG, n);
         for (i = 0; i < n; i++) {
+            append_offset(offsets, buffer);
             buffer.writeBitmap((*fBitmaps)[i]);
         }
     }
@@ -260,25 +346,39 @@ void SkPictureData::flattenToBuffer(SkWriteBuffer& buffer) const {
     if ((n = SafeCount(fPaints)) > 0) {
         write_tag_size(buffer, SK_PICT_PAINT_BUFFER_TAG, n);
         for (i = 0; i < n; i++) {
+            append_offset(offsets, buffer);
             buffer.writePaint((*fPaints)[i]);
         }
     }
 
     if ((n = SafeCount(fPathHeap.get())) > 0) {
         write_tag_size(buffer, SK_PICT_PATH_BUFFER_TAG, n);
-        fPathHeap->flatten(buffer);
+        fPathHeap->flatten(buffer, offsets);
     }
 }
 
 void SkPictureData::serialize(SkWStream* stream,
-                                  SkPicture::EncodeBitmap encoder) const {
-    write_tag_size(stream, SK_PICT_READER_TAG, fOpData->size());
-    stream->write(fOpData->bytes(), fOpData->size());
+                              SkPicture::EncodeBitmap encoder,
+                              bool compact) const {
+    SkAutoTUnref<SkData> compactOps(compact ? SkPictureCompactCodec::EncodeOps(fOpData) : NULL);
+    if (NULL != compactOps.get()) {
+        write_tag_size(stream, SK_PICT_COMPACT_READER_TAG, compactOps->size());
+        stream->write(compactOps->data(), compactOps->size());
+    } else {
+        write_tag_size(stream, SK_PICT_READER_TAG, fOpData->size());
+        write_chunk_padding(stream);
+        stream->write(fOpData->bytes(), fOpData->size());
+    }
+
+    if (fDrawIndex.count() > 0) {
+        write_tag_size(stream, SK_PICT_DRAW_INDEX_TAG, fDrawIndex.count());
+        stream->write(fDrawIndex.begin(), fDrawIndex.bytes());
+    }
 
     if (fPictureCount > 0) {
         write_tag_size(stream, SK_PICT_PICTURE_TAG, fPictureCount);
         for (int i = 0; i < fPictureCount; i++) {
-            fPictureRefs[i]->serialize(stream, encoder);
+            fPictureRefs[i]->serialize(stream, encoder, compact);
         }
     }
 
@@ -293,7 +393,8 @@ void SkPictureData::serialize(SkWStream* stream,
         buffer.setFactoryRecorder(&factSet);
         buffer.setBitmapEncoder(encoder);
 
-        this->flattenToBuffer(buffer);
+        SkTDArray<uint32_t> offsets;
+        this->flattenToBuffer(buffer, &offsets);
 
         // We have to write these two sets into the stream *before* we write
         // the buffer, since parsing that buffer will require that we already
@@ -301,8 +402,32 @@ void SkPictureData::serialize(SkWStream* stream,
         WriteFactories(stream, factSet);
         WriteTypefaces(stream, typefaceSet);
 
-        write_tag_size(stream, SK_PICT_BUFFER_SIZE_TAG, buffer.bytesWritten());
-        buffer.writeToStream(stream);
+        const uint32_t counts[kLazyTypeCount] = {
+            SkToU32(SafeCount(fBitmaps)),
+            SkToU32(SafeCount(fPaints)),
+            SkToU32(SafeCount(fPathHeap.get())),
+        };
+        SkASSERT(counts[0] + counts[1] + counts[2] == SkToU32(offsets.count()));
+        write_tag_size(stream, SK_PICT_RESOURCE_INDEX_TAG, sizeof(counts) + offsets.bytes());
+        stream->write(counts, sizeof(counts));
+        stream->write(offsets.begin(), offsets.bytes());
+
+        SkAutoTUnref<SkData> compactBuffer;
+        if (compact) {
+            SkAutoMalloc storage(buffer.bytesWritten());
+            buffer.writeToMemory(storage.get());
+            compactBuffer.reset(SkPictureCompactCodec::EncodeBuffer(
+                    storage.get(), buffer.bytesWritten(), counts, kLazyTypeCount,
+                    offsets.begin()));
+        }
+        if (NULL != compactBuffer.get()) {
+            write_tag_size(stream, SK_PICT_COMPACT_BUFFER_TAG, compactBuffer->size());
+            stream->write(compactBuffer->data(), compactBuffer->size());
+        } else {
+            write_tag_size(stream, SK_PICT_BUFFER_SIZE_TAG, buffer.bytesWritten());
+            write_chunk_padding(stream);
+            buffer.writeToStream(stream);
+        }
     }
 
     stream->write32(SK_PICT_EOF_TAG);
@@ -352,7 +477,8 @@ static uint32_t pictInfoFlagsToReadBufferFlags(uint32_t pictInfoFlags) {
 bool SkPictureData::parseStreamTag(SkStream* stream,
                                    uint32_t tag,
                                    uint32_t size,
-                                   SkPicture::InstallPixelRefProc proc) {
+                                   SkPicture::InstallPixelRefProc proc,
+                                   SkData* backing) {
     /*
      *  By the time we encounter BUFFER_SIZE_TAG, we need to have already seen
      *  its dependents: FACTORY_TAG and TYPEFACE_TAG. These two are not required
@@ -366,13 +492,73 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
 
     switch (tag) {
         case SK_PICT_READER_TAG: {
+            if (!skip_chunk_padding(stream, fInfo)) {
+                return false;
+            }
+            SkASSERT(NULL == fOpData);
+            if (NULL != backing) {
+                const void* ops = skip_in_place(stream, backing, size);
+                if (NULL == ops) {
+                    return false;
+                }
+                // Playback reads the ops with SkReader32, which needs them 4-byte aligned.
+                fOpData = SkIsAlign4((intptr_t)ops)
+                        ? SkData::NewSubset(backing, (const uint8_t*)ops - backing->bytes(), size)
+                        : SkData::NewWithCopy(ops, size);
+                break;
+            }
             SkAutoMalloc storage(size);
             if (stream->read(storage.get(), size) != size) {
                 return false;
             }
-            SkASSERT(NULL == fOpData);
             fOpData = SkData::NewFromMalloc(storage.detach(), size);
         } break;
+        case SK_PICT_COMPACT_READER_TAG: {
+            SkASSERT(NULL == fOpData);
+            SkAutoMalloc storage;
+            const void* memory = NULL;
+            if (NULL != backing) {
+                memory = skip_in_place(stream, backing, size);
+            } else if (stream->read(storage.reset(size), size) == size) {
+                memory = storage.get();
+            }
+            if (NULL == memory) {
+                return false;
+            }
+            fOpData = SkPictureCompactCodec::DecodeOps(memory, size);
+            if (NULL == fOpData) {
+                return false;
+            }
+        } break;
+        case SK_PICT_DRAW_INDEX_TAG: {
+            SkASSERT(0 == fDrawIndex.count());
+            if (size > SK_MaxS32 / sizeof(SkPictDrawIndexEntry)) {
+                return false;
+            }
+            fDrawIndex.setCount(size);
+            if (stream->read(fDrawIndex.begin(), fDrawIndex.bytes()) != fDrawIndex.bytes()) {
+                return false;
+            }
+            // Playback walks the index in step with the op stream.
+            for (int i = 1; i < fDrawIndex.count(); ++i) {
+                if (fDrawIndex[i].fOffset <= fDrawIndex[i - 1].fOffset) {
+                    return false;
+                }
+            }
+        } break;
+        case SK_PICT_RESOURCE_INDEX_TAG: {
+            SkASSERT(!haveBuffer);
+            // Without backing data the resources are all unflattened up front anyway.
+            if (NULL == backing) {
+                if (stream->skip(size) != size) {
+                    return false;
+                }
+                break;
+            }
+            if (!this->parseResourceIndex(stream, size)) {
+                return false;
+            }
+        } break;
         case SK_PICT_FACTORY_TAG: {
             SkASSERT(!haveBuffer);
         // Remove this code when v21 and below are no longer supported. At the
@@ -417,7 +603,7 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             bool success = true;
             int i = 0;
             for ( ; i < fPictureCount; i++) {
-                fPictureRefs[i] = SkPicture::CreateFromStream(stream, proc);
+                fPictureRefs[i] = SkPicture::CreateFromStream(stream, proc, backing);
                 if (NULL == fPictureRefs[i]) {
                     success = false;
                     break;
@@ -435,25 +621,50 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
             }
         } break;
         case SK_PICT_BUFFER_SIZE_TAG: {
-            SkAutoMalloc storage(size);
-            if (stream->read(storage.get(), size) != size) {
+            if (!skip_chunk_padding(stream, fInfo)) {
                 return false;
             }
-
-            SkReadBuffer buffer(storage.get(), size);
-            buffer.setFlags(pictInfoFlagsToReadBufferFlags(fInfo.fFlags));
-            buffer.setVersion(fInfo.fVersion);
-
-            fFactoryPlayback->setupBuffer(buffer);
-            fTFPlayback.setupBuffer(buffer);
-            buffer.setBitmapDecoder(proc);
-
-            while (!buffer.eof()) {
-                tag = buffer.readUInt();
-                size = buffer.readUInt();
-                if (!this->parseBufferTag(buffer, tag, size)) {
+            SkAutoMalloc storage;
+            const void* memory = NULL;
+            bool inPlace = false;
+            if (NULL != backing) {
+                memory = skip_in_place(stream, backing, size);
+                if (NULL == memory) {
+                    return false;
+                }
+                inPlace = SkIsAlign4((intptr_t)memory);
+                if (!inPlace) {
+                    memory = memcpy(storage.reset(size), memory, size);
+                }
+            } else {
+                if (stream->read(storage.reset(size), size) != size) {
                     return false;
                 }
+                memory = storage.get();
+            }
+
+            SkAutoTUnref<SkData> chunk(inPlace
+                    ? SkData::NewSubset(backing, (const uint8_t*)memory - backing->bytes(), size)
+                    : SkData::NewFromMalloc(storage.detach(), size));
+            if (!this->parseBufferChunk(chunk, inPlace, proc)) {
+                return false;
+            }
+            SkDEBUGCODE(haveBuffer = true;)
+        } break;
+        case SK_PICT_COMPACT_BUFFER_TAG: {
+            SkAutoMalloc storage;
+            const void* memory = NULL;
+            if (NULL != backing) {
+                memory = skip_in_place(stream, backing, size);
+            } else if (stream->read(storage.reset(size), size) == size) {
+                memory = storage.get();
+            }
+            if (NULL == memory) {
+                return false;
+            }
+            SkAutoTUnref<SkData> chunk(SkPictureCompactCodec::DecodeBuffer(memory, size));
+            if (NULL == chunk.get() || !this->parseBufferChunk(chunk, false, proc)) {
+                return false;
             }
             SkDEBUGCODE(haveBuffer = true;)
         } break;
@@ -461,6 +672,33 @@ bool SkPictureData::parseStreamTag(SkStream* stream,
     return true;    // success
 }
 
+bool SkPictureData::parseBufferChunk(SkData* chunk, bool inPlace,
+                                     SkPicture::InstallPixelRefProc proc) {
+    if (fResourceOffsets.count() > 0) {
+        return this->setupLazyResources(chunk, proc);
+    }
+
+    SkReadBuffer buffer(chunk->data(), chunk->size());
+    if (inPlace) {
+        buffer.setBackingData(chunk);
+    }
+    buffer.setFlags(pictInfoFlagsToReadBufferFlags(fInfo.fFlags));
+    buffer.setVersion(fInfo.fVersion);
+
+    fFactoryPlayback->setupBuffer(buffer);
+    fTFPlayback.setupBuffer(buffer);
+    buffer.setBitmapDecoder(proc);
+
+    while (!buffer.eof()) {
+        const uint32_t tag = buffer.readUInt();
+        const uint32_t size = buffer.readUInt();
+        if (!this->parseBufferTag(buffer, tag, size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool SkPictureData::parseBufferTag(SkReadBuffer& buffer,
                                    uint32_t tag, uint32_t size) {
     switch (tag) {
@@ -529,10 +767,11 @@ bool SkPictureData::parseBufferTag(SkReadBuffer& buffer,
 
 SkPictureData* SkPictureData::CreateFromStream(SkStream* stream,
                                                const SkPictInfo& info,
-                                               SkPicture::InstallPixelRefProc proc) {
+                                               SkPicture::InstallPixelRefProc proc,
+                                               SkData* backing) {
     SkAutoTDelete<SkPictureData> data(SkNEW_ARGS(SkPictureData, (info)));
 
-    if (!data->parseStream(stream, proc)) {
+    if (!data->parseStream(stream, proc, backing)) {
         return NULL;
     }
     return data.detach();
@@ -550,7 +789,8 @@ SkPictureData* SkPictureData::CreateFromBuffer(SkReadBuffer& buffer,
 }
 
 bool SkPictureData::parseStream(SkStream* stream,
-                                SkPicture::InstallPixelRefProc proc) {
+                                SkPicture::InstallPixelRefProc proc,
+                                SkData* backing) {
     for (;;) {
         uint32_t tag = stream->readU32();
         if (SK_PICT_EOF_TAG == tag) {
@@ -558,7 +798,7 @@ bool SkPictureData::parseStream(SkStream* stream,
         }
 
         uint32_t size = stream->readU32();
-        if (!this->parseStreamTag(stream, tag, size, proc)) {
+        if (!this->parseStreamTag(stream, tag, size, proc, backing)) {
             return false; // we're invalid
         }
     }
@@ -580,6 +820,122 @@ bool SkPictureData::parseBuffer(SkReadBuffer& buffer) {
     return true;
 }
 
+bool SkPictureData::parseResourceIndex(SkStream* stream, uint32_t size) {
+    if (0 != size % sizeof(uint32_t) || size < kLazyTypeCount * sizeof(uint32_t) ||
+        size > SK_MaxS32) {
+        return false;
+    }
+    SkASSERT(0 == fResourceOffsets.count());
+    fResourceOffsets.setCount(size / sizeof(uint32_t));
+    if (stream->read(fResourceOffsets.begin(), size) != size) {
+        return false;
+    }
+    // The counts of each type come first, then the offsets of every resource.
+    uint64_t total = kLazyTypeCount;
+    for (int i = 0; i < kLazyTypeCount; ++i) {
+        total += fResourceOffsets[i];
+    }
+    return total == SkToU32(fResourceOffsets.count());
+}
+
+bool SkPictureData::setupLazyResources(SkData* buffer, SkPicture::InstallPixelRefProc proc) {
+    SkASSERT(NULL == fLazyResources);
+    SkASSERT(NULL == fBitmaps && NULL == fPaints && NULL == fPathHeap.get());
+
+    const uint32_t* counts = fResourceOffsets.begin();
+    const uint32_t* offsets = counts + kLazyTypeCount;
+    const uint32_t* stop = fResourceOffsets.end();
+    for (const uint32_t* offset = offsets; offset < stop; ++offset) {
+        // SkReadBuffer needs 4-byte aligned memory.
+        if (*offset >= buffer->size() || !SkIsAlign4(*offset)) {
+            return false;
+        }
+    }
+
+    fLazyResources = SkNEW_ARGS(LazyResources, (buffer, proc));
+    for (int type = 0; type < kLazyTypeCount; ++type) {
+        const int count = SkToInt(counts[type]);
+        fLazyResources->fOffsets[type].append(count, offsets);
+        fLazyResources->fDone[type].setCount(count);
+        sk_bzero(fLazyResources->fDone[type].begin(), fLazyResources->fDone[type].bytes());
+        offsets += count;
+    }
+
+    if (counts[kBitmap_LazyType] > 0) {
+        fBitmaps = SkTRefArray<SkBitmap>::Create(counts[kBitmap_LazyType]);
+    }
+    if (counts[kPaint_LazyType] > 0) {
+        fPaints = SkTRefArray<SkPaint>::Create(counts[kPaint_LazyType]);
+    }
+    if (counts[kPath_LazyType] > 0) {
+        SkPathHeap* paths = SkNEW(SkPathHeap);
+        for (uint32_t i = 0; i < counts[kPath_LazyType]; ++i) {
+            paths->append(SkPath());
+        }
+        fPathHeap.reset(paths);
+        fLazyResources->fPaths.reset(SkRef(paths));
+    }
+
+    fResourceOffsets.reset();
+    return true;
+}
+
+void SkPictureData::LazyResources::Unflatten(Request request) {
+    const SkPictureData* data = request.fData;
+    LazyResources* lazy = data->fLazyResources;
+    const uint32_t offset = lazy->fOffsets[request.fType][request.fIndex];
+
+    SkReadBuffer buffer(lazy->fBuffer->bytes() + offset, lazy->fBuffer->size() - offset);
+    buffer.setBackingData(lazy->fBuffer);
+    buffer.setFlags(pictInfoFlagsToReadBufferFlags(data->fInfo.fFlags));
+    buffer.setVersion(data->fInfo.fVersion);
+    if (NULL != data->fFactoryPlayback) {
+        data->fFactoryPlayback->setupBuffer(buffer);
+    }
+    data->fTFPlayback.setupBuffer(buffer);
+    buffer.setBitmapDecoder(lazy->fProc);
+
+    switch (request.fType) {
+        case kBitmap_LazyType: {
+            SkBitmap* bm = &data->fBitmaps->writableAt(request.fIndex);
+            buffer.readBitmap(bm);
+            bm->setImmutable();
+        } break;
+        case kPaint_LazyType:
+            buffer.readPaint(&data->fPaints->writableAt(request.fIndex));
+            break;
+        case kPath_LazyType: {
+            SkPath* path = lazy->fPaths->writablePath(request.fIndex);
+            buffer.readPath(path);
+            // see initForPlayback()
+            path->updateBoundsCache();
+        } break;
+        default:
+            SkASSERT(false);
+    }
+}
+
+void SkPictureData::unflattenLazily(LazyType type, int index) const {
+    SkASSERT(NULL != fLazyResources);
+    SkTDArray<bool>& done = fLazyResources->fDone[type];
+    if (index < 0 || index >= done.count()) {
+        return;
+    }
+    LazyResources::Request request = { this, type, index };
+    SkOnce(&done[index], &fLazyResources->fMutex, LazyResources::Unflatten, request);
+}
+
+void SkPictureData::unflattenAllLazily() const {
+    if (NULL == fLazyResources) {
+        return;
+    }
+    for (int type = 0; type < kLazyTypeCount; ++type) {
+        for (int i = 0; i < fLazyResources->fDone[type].count(); ++i) {
+            this->unflattenLazily((LazyType)type, i);
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -609,11 +965,12 @@ bool SkPictureData::suitableForGpuRasterization(GrContext* context, const char *
         return this->suitableForGpuRasterization(NULL, reason);
     }
 }
+#endif
 
 bool SkPictureData::suitableForLayerOptimization() const {
     return fContentInfo.numLayers() > 0;
 }
-#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
 
@@ -45,6 +45,15 @@ struct SkPictInfo {
 #define SK_PICT_FACTORY_TAG    SkSetFourByteTag('f', 'a', 'c', 't')
 #define SK_PICT_TYPEFACE_TAG   SkSetFourByteTag('t', 'p', 'f', 'c')
 #define SK_PICT_PICTURE_TAG    SkSetFourByteTag('p', 'c', 't', 'r')
+// As of V35 these two tags are optional. The draw index is written by pictures that were
+// recorded with a bounding box hierarchy, and the resource index locates each bitmap, paint
+// and path within the buffer so that they can be unflattened one at a time.
+#define SK_PICT_DRAW_INDEX_TAG      SkSetFourByteTag('d', 'i', 'd', 'x')
+#define SK_PICT_RESOURCE_INDEX_TAG  SkSetFourByteTag('r', 'i', 'd', 'x')
+// As of V36 the op stream and buffer may instead be written in these tags, encoded with
+// SkPictureCompactCodec. Their size is the size of the encoded data.
+#define SK_PICT_COMPACT_READER_TAG  SkSetFourByteTag('c', 'o', 'p', 's')
+#define SK_PICT_COMPACT_BUFFER_TAG  SkSetFourByteTag('c', 'b', 'u', 'f')
 
 // This tag specifies the size of the ReadBuffer, needed for the following tags
 #define SK_PICT_BUFFER_SIZE_TAG     SkSetFourByteTag('a', 'r', 'a', 'y')
@@ -56,6 +65,16 @@ struct SkPictInfo {
 // Always write this guy last (with no length field afterwards)
 #define SK_PICT_EOF_TAG     SkSetFourByteTag('e', 'o', 'f', ' ')
 
+/**
+ * One entry of a picture's draw index: the offset of a draw op in the op stream, and the
+ * device space bounds that the bounding box hierarchy was given for it at record time.
+ * Entries are sorted by offset.
+ */
+struct SkPictDrawIndexEntry {
+    uint32_t    fOffset;
+    SkIRect     fBounds;
+};
+
 #ifdef SK_SUPPORT_LEGACY_PICTURE_CLONE
 /**
  * Container for data that is needed to deep copy a SkPicture. The container
@@ -75,16 +94,22 @@ public:
     SkPictureData(const SkPictureData& src, SkPictCopyInfo* deepCopyInfo = NULL);
 #endif
     SkPictureData(const SkPictureRecord& record, const SkPictInfo&, bool deepCopyOps);
+    // If backing is not NULL, stream must be reading from it, and the op stream and bitmap
+    // pixels are referenced in place rather than copied (see SkPicture::CreateFromData).
+    // If the stream also has a resource index, bitmaps, paints and paths are not unflattened
+    // until playback first asks for them.
     static SkPictureData* CreateFromStream(SkStream*,
                                            const SkPictInfo&,
-                                           SkPicture::InstallPixelRefProc);
+                                           SkPicture::InstallPixelRefProc,
+                                           SkData* backing = NULL);
     static SkPictureData* CreateFromBuffer(SkReadBuffer&, const SkPictInfo&);
 
     virtual ~SkPictureData();
 
     const SkPicture::OperationList* getActiveOps(const SkIRect& queryRect) const;
 
-    void serialize(SkWStream*, SkPicture::EncodeBitmap) const;
+    // If compact, the op stream and buffer are written with SkPictureCompactCodec.
+    void serialize(SkWStream*, SkPicture::EncodeBitmap, bool compact) const;
     void flatten(SkWriteBuffer&) const;
 
     bool containsBitmaps() const;
@@ -95,10 +120,12 @@ public:
 
     const SkData* opData() const { return fOpData; }
 
+    const SkTDArray<SkPictDrawIndexEntry>& drawIndex() const { return fDrawIndex; }
+
 protected:
     explicit SkPictureData(const SkPictInfo& info);
 
-    bool parseStream(SkStream*, SkPicture::InstallPixelRefProc);
+    bool parseStream(SkStream*, SkPicture::InstallPixelRefProc, SkData* backing);
     bool parseBuffer(SkReadBuffer& buffer);
 
 public:
@@ -110,11 +137,17 @@ public:
 #endif
             return fBadBitmap;
         }
+        if (NULL != fLazyResources) {
+            this->unflattenLazily(kBitmap_LazyType, index);
+        }
         return (*fBitmaps)[index];
     }
 
     const SkPath& getPath(SkReader32* reader) const {
         int index = reader->readInt() - 1;
+        if (NULL != fLazyResources) {
+            this->unflattenLazily(kPath_LazyType, index);
+        }
         return (*fPathHeap.get())[index];
     }
 
@@ -129,6 +162,9 @@ public:
         if (index == 0) {
             return NULL;
         }
+        if (NULL != fLazyResources) {
+            this->unflattenLazily(kPaint_LazyType, index - 1);
+        }
         return &(*fPaints)[index - 1];
     }
 
@@ -154,9 +190,9 @@ public:
      */
     bool suitableForGpuRasterization(GrContext* context, const char **reason,
                                      GrPixelConfig config, SkScalar dpi) const;
+#endif
 
     bool suitableForLayerOptimization() const;
-#endif
 
 private:
     friend class SkPicture; // needed in SkPicture::clone (rm when it is removed)
@@ -164,9 +200,29 @@ private:
     void init();
 
     // these help us with reading/writing
-    bool parseStreamTag(SkStream*, uint32_t tag, uint32_t size, SkPicture::InstallPixelRefProc);
+    bool parseStreamTag(SkStream*, uint32_t tag, uint32_t size, SkPicture::InstallPixelRefProc,
+                        SkData* backing);
     bool parseBufferTag(SkReadBuffer&, uint32_t tag, uint32_t size);
-    void flattenToBuffer(SkWriteBuffer&) const;
+    // If offsets is not NULL, each resource's offset in the buffer is appended to it, in the
+    // order that SK_PICT_RESOURCE_INDEX_TAG stores them.
+    void flattenToBuffer(SkWriteBuffer&, SkTDArray<uint32_t>* offsets = NULL) const;
+
+    enum LazyType {
+        kBitmap_LazyType,
+        kPaint_LazyType,
+        kPath_LazyType,
+
+        kLazyTypeCount
+    };
+    class LazyResources;
+    friend class LazyResources;
+
+    bool parseResourceIndex(SkStream*, uint32_t size);
+    bool setupLazyResources(SkData* buffer, SkPicture::InstallPixelRefProc);
+    // If inPlace, chunk is a subset of the picture's backing data (see CreateFromStream).
+    bool parseBufferChunk(SkData* chunk, bool inPlace, SkPicture::InstallPixelRefProc);
+    void unflattenLazily(LazyType, int index) const;
+    void unflattenAllLazily() const;
 
     // Only used by getBitmap() if the passed in index is SkBitmapHeap::INVALID_SLOT. This empty
     // bitmap allows playback to draw nothing and move on.
@@ -187,6 +243,12 @@ private:
     SkBBoxHierarchy* fBoundingHierarchy;
     SkPictureStateTree* fStateTree;
 
+    SkTDArray<SkPictDrawIndexEntry> fDrawIndex;
+    // Only set while parsing a stream with a resource index.
+    SkTDArray<uint32_t> fResourceOffsets;
+    // Non-NULL if bitmaps, paints and paths are unflattened on demand.
+    LazyResources* fLazyResources;
+
     SkPictureContentInfo fContentInfo;
 
     SkTypefacePlayback fTFPlayback;
@@ -60,6 +60,14 @@ void get_text(SkReader32* reader, TextContainer* text) {
     text->fText = (const char*)reader->skip(length);
 }
 
+// Ops that only draw, leaving the matrix and clip alone, and so may be culled.
+static bool is_draw_op(DrawType op) {
+    return (op > CONCAT && op < RESTORE)
+            || DRAW_DRRECT == op
+            || DRAW_PATCH == op
+            || DRAW_PICTURE_MATRIX_PAINT == op;
+}
+
 // FIXME: SkBitmaps are stateful, so we need to copy them to play back in multiple threads.
 static SkBitmap shallow_copy(const SkBitmap& bitmap) {
     return bitmap;
@@ -146,6 +154,20 @@ void SkPicturePlayback::draw(SkCanvas* canvas, SkDrawPictureCallback* callback)
 
     StepIterator(&it, &reader);
 
+    // Without a BBH and state tree, a picture loaded with a draw index can still skip the
+    // draws that fall outside the clip. All other ops are played back, so the matrix and
+    // clip stay right, but the skipped draws' paints, paths and bitmaps are never touched.
+    const SkTDArray<SkPictDrawIndexEntry>& drawIndex = fPictureData->drawIndex();
+    int drawIndexCursor = drawIndex.count();
+    SkIRect query = SkIRect::MakeEmpty();
+    if (fUseBBH && !it.isValid() && drawIndex.count() > 0) {
+        SkRect clipBounds;
+        if (canvas->getClipBounds(&clipBounds)) {
+            clipBounds.roundOut(&query);
+            drawIndexCursor = 0;
+        }
+    }
+
     // Record this, so we can concat w/ it if we encounter a setMatrix()
     SkMatrix initialMatrix = canvas->getTotalMatrix();
 
@@ -165,6 +187,17 @@ void SkPicturePlayback::draw(SkCanvas* canvas, SkDrawPictureCallback* callback)
             continue;
         }
 
+        while (drawIndexCursor < drawIndex.count() &&
+               drawIndex[drawIndexCursor].fOffset < fCurOffset) {
+            ++drawIndexCursor;
+        }
+        if (drawIndexCursor < drawIndex.count() &&
+            drawIndex[drawIndexCursor].fOffset == fCurOffset && size > 0 && is_draw_op(op) &&
+            !SkIRect::Intersects(drawIndex[drawIndexCursor].fBounds, query)) {
+            reader.setOffset(fCurOffset + size);
+            continue;
+        }
+
         this->handleOp(&reader, op, size, canvas, initialMatrix);
 
         StepIterator(&it, &reader);
@@ -266,6 +266,9 @@ protected:
     // subclasses, in which case they will be SkSafeUnref'd in our destructor.
     SkBBoxHierarchy* fBoundingHierarchy;
     SkPictureStateTree* fStateTree;
+    // Filled in by subclasses that compute the bounds of each draw, and serialized as the
+    // picture's draw index.
+    SkTDArray<SkPictDrawIndexEntry> fDrawIndex;
 
     // Allocated in the constructor and managed by this class.
     SkBitmapHeap* fBitmapHeap;
@@ -25,6 +25,7 @@ SkReadBuffer::SkReadBuffer() {
     fFlags = default_flags();
     fVersion = 0;
     fMemoryPtr = NULL;
+    fBackingData = NULL;
 
     fBitmapStorage = NULL;
     fTFArray = NULL;
@@ -44,6 +45,7 @@ SkReadBuffer::SkReadBuffer(const void* data, size_t size) {
     fVersion = 0;
     fReader.setMemory(data, size);
     fMemoryPtr = NULL;
+    fBackingData = NULL;
 
     fBitmapStorage = NULL;
     fTFArray = NULL;
@@ -63,6 +65,7 @@ SkReadBuffer::SkReadBuffer(SkStream* stream) {
     fVersion = 0;
     const size_t length = stream->getLength();
     fMemoryPtr = sk_malloc_throw(length);
+    fBackingData = NULL;
     stream->read(fMemoryPtr, length);
     fReader.setMemory(fMemoryPtr, length);
 
@@ -81,6 +84,7 @@ SkReadBuffer::SkReadBuffer(SkStream* stream) {
 
 SkReadBuffer::~SkReadBuffer() {
     sk_free(fMemoryPtr);
+    SkSafeUnref(fBackingData);
     SkSafeUnref(fBitmapStorage);
 }
 
@@ -185,6 +189,26 @@ bool SkReadBuffer::readScalarArray(SkScalar* values, size_t size) {
     return readArray(values, size, sizeof(SkScalar));
 }
 
+SkData* SkReadBuffer::readByteArrayAsData() {
+    size_t len = this->getArrayCount();
+    if (!this->validateAvailable(len)) {
+        return SkData::NewEmpty();
+    }
+    if (NULL != fBackingData) {
+        (void)this->skip(sizeof(uint32_t)); // Skip array count
+        const uint8_t* bytes = (const uint8_t*)this->skip(SkAlign4(len));
+        const uint8_t* base = fBackingData->bytes();
+        if (!this->validate(bytes >= base && len <= fBackingData->size() &&
+                            SkToSizeT(bytes - base) <= fBackingData->size() - len)) {
+            return SkData::NewEmpty();
+        }
+        return SkData::NewSubset(fBackingData, bytes - base, len);
+    }
+    void* buffer = sk_malloc_throw(len);
+    this->readByteArray(buffer, len);
+    return SkData::NewFromMalloc(buffer, len);
+}
+
 uint32_t SkReadBuffer::getArrayCount() {
     return *(uint32_t*)fReader.peek();
 }
@@ -49,6 +49,7 @@ public:
         kImageFilterUniqueID_Version       = 31,
         kRemoveAndroidPaintOpts_Version    = 32,
         kFlattenCreateProc_Version         = 33,
+        kAlignedPictureChunks_Version      = 34,
     };
 
     /**
@@ -140,14 +141,19 @@ public:
     virtual bool readPointArray(SkPoint* points, size_t size);
     virtual bool readScalarArray(SkScalar* values, size_t size);
 
-    SkData* readByteArrayAsData() {
-        size_t len = this->getArrayCount();
-        if (!this->validateAvailable(len)) {
-            return SkData::NewEmpty();
-        }
-        void* buffer = sk_malloc_throw(len);
-        this->readByteArray(buffer, len);
-        return SkData::NewFromMalloc(buffer, len);
+    /**
+     *  Read a byte array written by SkWriteBuffer::writeByteArray. If this buffer's memory
+     *  belongs to an SkData given to setBackingData(), the result is a subset of that rather
+     *  than a copy.
+     */
+    SkData* readByteArrayAsData();
+
+    /**
+     *  Tell the buffer that the memory it is reading lies within data, so that it can hand out
+     *  subsets of data instead of copies (see readByteArrayAsData()). data is ref()ed.
+     */
+    void setBackingData(SkData* data) {
+        SkRefCnt_SafeAssign(fBackingData, data);
     }
 
     // helpers to get info about arrays and binary data
@@ -215,6 +221,7 @@ private:
     int fVersion;
 
     void* fMemoryPtr;
+    SkData* fBackingData;
 
     SkBitmapHeapReader* fBitmapStorage;
     SkTypeface** fTFArray;
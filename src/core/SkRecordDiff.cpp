@@ -0,0 +1,444 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRecordDiff.h"
+
+#include "SkRecordDraw.h"
+#include "SkRecords.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+
+using namespace SkRecords;
+
+namespace {
+
+// Exact equality between two ops of the same type.  No base case, so we'll be compile-time
+// checked that we compare all possibilities.
+template <typename T> bool equal(const T&, const T&);
+
+template <typename T> bool same(const T& a, const T& b) { return a == b; }
+
+template <typename T> bool same(const Optional<T>& a, const Optional<T>& b) {
+    const T* pa = a;
+    const T* pb = b;
+    if (NULL == pa || NULL == pb) {
+        return pa == pb;
+    }
+    return *pa == *pb;
+}
+
+// Pictures, text blobs and xfermodes are compared by identity.
+template <typename T> bool same(const RefBox<T>& a, const RefBox<T>& b) {
+    return (const T*)a == (const T*)b;
+}
+
+bool same(const ImmutableBitmap& a, const ImmutableBitmap& b) {
+    const SkBitmap& ba = a;
+    const SkBitmap& bb = b;
+    if (ba.getGenerationID() == bb.getGenerationID()) {
+        return true;
+    }
+    // Mutable bitmaps are copied each time they're recorded, so we fall back to the pixels.
+    if (ba.info() != bb.info()) {
+        return false;
+    }
+    SkAutoLockPixels alpa(ba);
+    SkAutoLockPixels alpb(bb);
+    if (NULL == ba.getPixels() || NULL == bb.getPixels()) {
+        return false;
+    }
+    const size_t rowBytes = ba.info().minRowBytes();
+    for (int y = 0; y < ba.height(); y++) {
+        if (0 != memcmp(ba.getAddr(0, y), bb.getAddr(0, y), rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Both NULL, or count equal elements.
+template <typename T> bool same(const T* a, const T* b, size_t count) {
+    if (NULL == a || NULL == b) {
+        return a == b;
+    }
+    return 0 == memcmp(a, b, count * sizeof(T));
+}
+
+// Text is the same if it's the same bytes.  Text positions are then the same if they match
+// for every glyph.
+bool same_text(const SkPaint& paint, const char* a, const char* b, size_t byteLength) {
+    return paint.countText(a, byteLength) == paint.countText(b, byteLength) &&
+           0 == memcmp(a, b, byteLength);
+}
+
+#define EQUAL(T, expr) template <> bool equal(const T& a, const T& b) { return expr; }
+EQUAL(NoOp, true);
+EQUAL(Save, true);
+EQUAL(PopCull, true);
+EQUAL(Restore, same(a.devBounds, b.devBounds) && same(a.matrix, b.matrix));
+EQUAL(SaveLayer, same(a.bounds, b.bounds) && same(a.paint, b.paint) && a.flags == b.flags);
+EQUAL(PushCull, same(a.rect, b.rect));
+EQUAL(SetMatrix, same(a.matrix, b.matrix));
+
+EQUAL(ClipPath, same(a.devBounds, b.devBounds) && same(a.path, b.path) &&
+                a.op == b.op && a.doAA == b.doAA);
+EQUAL(ClipRRect, same(a.devBounds, b.devBounds) && same(a.rrect, b.rrect) &&
+                 a.op == b.op && a.doAA == b.doAA);
+EQUAL(ClipRect, same(a.devBounds, b.devBounds) && same(a.rect, b.rect) &&
+                a.op == b.op && a.doAA == b.doAA);
+EQUAL(ClipRegion, same(a.devBounds, b.devBounds) && same(a.region, b.region) && a.op == b.op);
+
+EQUAL(Clear, a.color == b.color);
+EQUAL(DrawBitmap, same(a.paint, b.paint) && same(a.bitmap, b.bitmap) &&
+                  a.left == b.left && a.top == b.top);
+EQUAL(DrawBitmapMatrix, same(a.paint, b.paint) && same(a.bitmap, b.bitmap) &&
+                        same(a.matrix, b.matrix));
+EQUAL(DrawBitmapNine, same(a.paint, b.paint) && same(a.bitmap, b.bitmap) &&
+                      same(a.center, b.center) && same(a.dst, b.dst));
+EQUAL(DrawBitmapRectToRect, same(a.paint, b.paint) && same(a.bitmap, b.bitmap) &&
+                            same(a.src, b.src) && same(a.dst, b.dst) && a.flags == b.flags);
+EQUAL(DrawDRRect, same(a.paint, b.paint) && same(a.outer, b.outer) && same(a.inner, b.inner));
+EQUAL(DrawOval, same(a.paint, b.paint) && same(a.oval, b.oval));
+EQUAL(DrawPaint, same(a.paint, b.paint));
+EQUAL(DrawPath, same(a.paint, b.paint) && same(a.path, b.path));
+EQUAL(DrawPicture, same(a.paint, b.paint) && same(a.picture, b.picture) &&
+                   same(a.matrix, b.matrix));
+EQUAL(DrawPoints, same(a.paint, b.paint) && a.mode == b.mode && a.count == b.count &&
+                  same<SkPoint>(a.pts, b.pts, a.count));
+EQUAL(DrawPosText, same(a.paint, b.paint) && a.byteLength == b.byteLength &&
+                   same_text(a.paint, a.text, b.text, a.byteLength) &&
+                   same<SkPoint>(a.pos, b.pos, a.paint.countText(a.text, a.byteLength)));
+EQUAL(DrawPosTextH, same(a.paint, b.paint) && a.byteLength == b.byteLength &&
+                    same_text(a.paint, a.text, b.text, a.byteLength) &&
+                    same<SkScalar>(a.xpos, b.xpos, a.paint.countText(a.text, a.byteLength)) &&
+                    a.y == b.y);
+EQUAL(DrawRRect, same(a.paint, b.paint) && same(a.rrect, b.rrect));
+EQUAL(DrawRect, same(a.paint, b.paint) && same(a.rect, b.rect));
+EQUAL(DrawSprite, same(a.paint, b.paint) && same(a.bitmap, b.bitmap) &&
+                  a.left == b.left && a.top == b.top);
+EQUAL(DrawText, same(a.paint, b.paint) && a.byteLength == b.byteLength &&
+                same_text(a.paint, a.text, b.text, a.byteLength) && a.x == b.x && a.y == b.y);
+EQUAL(DrawTextBlob, same(a.paint, b.paint) && same(a.blob, b.blob) && a.x == b.x && a.y == b.y);
+EQUAL(DrawTextOnPath, same(a.paint, b.paint) && a.byteLength == b.byteLength &&
+                      same_text(a.paint, a.text, b.text, a.byteLength) &&
+                      same(a.path, b.path) && same(a.matrix, b.matrix));
+EQUAL(DrawVertices, same(a.paint, b.paint) && a.vmode == b.vmode &&
+                    a.vertexCount == b.vertexCount &&
+                    same<SkPoint>(a.vertices, b.vertices, a.vertexCount) &&
+                    same<SkPoint>(a.texs, b.texs, a.vertexCount) &&
+                    same<SkColor>(a.colors, b.colors, a.vertexCount) &&
+                    a.xmode.get() == b.xmode.get() && a.indexCount == b.indexCount &&
+                    same<uint16_t>(a.indices, b.indices, a.indexCount));
+EQUAL(DrawPatch, same(a.paint, b.paint) && same<SkPoint>(a.cubics, b.cubics, 12) &&
+                 same<SkColor>(a.colors, b.colors, 4) &&
+                 same<SkPoint>(a.texCoords, b.texCoords, 4) &&
+                 a.xmode.get() == b.xmode.get());
+#undef EQUAL
+
+// Visits the op in one record, then the op in the other, comparing them if they're the same type.
+template <typename T> class IsEqualTo {
+public:
+    explicit IsEqualTo(const T& a) : fA(a) {}
+
+    bool operator()(const T& b) { return equal(fA, b); }
+    template <typename U> bool operator()(const U&) { return false; }
+
+private:
+    const T& fA;
+};
+
+class Equal {
+public:
+    Equal(const SkRecord& other, unsigned index) : fOther(other), fIndex(index) {}
+
+    template <typename T> bool operator()(const T& a) {
+        IsEqualTo<T> isEqualTo(a);
+        return fOther.visit<bool>(fIndex, isEqualTo);
+    }
+
+private:
+    const SkRecord& fOther;
+    unsigned fIndex;
+};
+
+// Partial playback under a clip can only reproduce a full playback's pixels if no op reaches
+// outside the clip: an image filter reads pixels around the ones it writes, Clear ignores the clip,
+// and nested pictures may contain either.
+template <typename T> bool escapes_clip(const T&) { return false; }
+bool has_image_filter(const SkPaint* paint) {
+    return NULL != paint && NULL != paint->getImageFilter();
+}
+
+#define PAINT(T)      bool escapes_clip(const T& op) { return has_image_filter(&op.paint); }
+#define OPT_PAINT(T)  bool escapes_clip(const T& op) { return has_image_filter(op.paint); }
+OPT_PAINT(SaveLayer);
+OPT_PAINT(DrawBitmap);
+OPT_PAINT(DrawBitmapMatrix);
+OPT_PAINT(DrawBitmapNine);
+OPT_PAINT(DrawBitmapRectToRect);
+OPT_PAINT(DrawSprite);
+PAINT(DrawDRRect);
+PAINT(DrawOval);
+PAINT(DrawPaint);
+PAINT(DrawPath);
+PAINT(DrawPatch);
+PAINT(DrawPoints);
+PAINT(DrawPosText);
+PAINT(DrawPosTextH);
+PAINT(DrawRRect);
+PAINT(DrawRect);
+PAINT(DrawText);
+PAINT(DrawTextBlob);
+PAINT(DrawTextOnPath);
+PAINT(DrawVertices);
+#undef PAINT
+#undef OPT_PAINT
+
+bool escapes_clip(const Clear&) { return true; }
+bool escapes_clip(const DrawPicture&) { return true; }
+
+// This is an SkRecord visitor that finds, for each op, the drawing state (CTM, clips and layers)
+// it plays back with.  The state is a node in a tree of the control ops that change it, so the
+// states of ops in different records can be compared exactly by walking up to the root.
+class State : SkNoncopyable {
+public:
+    struct Node {
+        int parent;     // -1 for the root.
+        unsigned op;    // The op that set this state.
+        bool isMatrix;
+    };
+
+    explicit State(const SkRecord& record)
+        : fRecord(record)
+        , fStates(record.count())
+        , fCurrent(-1)
+        , fEscapesClip(false) {
+        for (fCurrentOp = 0; fCurrentOp < record.count(); fCurrentOp++) {
+            fStates[fCurrentOp] = fCurrent;
+            record.visit<void>(fCurrentOp, *this);
+        }
+        fMatches.setCount(fNodes.count());
+        for (int i = 0; i < fMatches.count(); i++) {
+            fMatches[i] = -1;
+        }
+    }
+
+    template <typename T> void operator()(const T& op) {
+        fEscapesClip |= escapes_clip(op);
+        this->update(op);
+    }
+
+    const SkRecord& record() const { return fRecord; }
+    int stateOf(unsigned op) const { return fStates[op]; }
+    bool escapesClip() const { return fEscapesClip; }
+
+    // Is state a, of this record, the same as state b, of other?
+    bool sameState(int a, const State& other, int b) {
+        const int startA = a, startB = b;
+        while (a >= 0 && b >= 0 && fMatches[a] != b) {
+            const Node& na = fNodes[a];
+            const Node& nb = other.fNodes[b];
+            Equal equalTo(other.fRecord, nb.op);
+            if (!fRecord.visit<bool>(na.op, equalTo)) {
+                return false;
+            }
+            a = na.parent;
+            b = nb.parent;
+        }
+        if ((a < 0 || b < 0) && a != b) {
+            return false;
+        }
+
+        // Remember the matches, so later walks through these states stop early.
+        for (a = startA, b = startB; a >= 0 && fMatches[a] != b; a = fNodes[a].parent) {
+            fMatches[a] = b;
+            b = other.fNodes[b].parent;
+        }
+        return true;
+    }
+
+private:
+    template <typename T> void update(const T&) { /* most ops don't change the state */ }
+    void update(const Save&) { *fSaveStack.append() = fCurrent; }
+    void update(const SaveLayer&) {
+        *fSaveStack.append() = fCurrent;
+        this->push(false);
+    }
+    void update(const Restore&) {
+        if (!fSaveStack.isEmpty()) {
+            fSaveStack.pop(&fCurrent);
+        }
+    }
+    void update(const SetMatrix&)  { this->push(true); }
+    void update(const ClipPath&)   { this->push(false); }
+    void update(const ClipRRect&)  { this->push(false); }
+    void update(const ClipRect&)   { this->push(false); }
+    void update(const ClipRegion&) { this->push(false); }
+
+    void push(bool isMatrix) {
+        int parent = fCurrent;
+        if (isMatrix) {
+            // A new matrix replaces any earlier one.  (Clips and layers keep depending on the
+            // matrix they were made with, which is still their parent.)
+            while (parent >= 0 && fNodes[parent].isMatrix) {
+                parent = fNodes[parent].parent;
+            }
+        }
+        Node node = { parent, fCurrentOp, isMatrix };
+        fCurrent = fNodes.count();
+        *fNodes.append() = node;
+    }
+
+    const SkRecord&     fRecord;
+    SkAutoTMalloc<int>  fStates;
+    SkTDArray<Node>     fNodes;
+    SkTDArray<int>      fMatches;    // For each node, a node known to be the same in the other
+                                     // record, or -1.
+    SkTDArray<int>      fSaveStack;
+    unsigned            fCurrentOp;
+    int                 fCurrent;
+    bool                fEscapesClip;
+};
+
+}  // namespace
+
+// Two ops match if they're equal and play back with the same state.
+class Matcher : SkNoncopyable {
+public:
+    Matcher(State* before, State* after) : fBefore(before), fAfter(after) {}
+
+    bool operator()(unsigned b, unsigned a) {
+        Equal equalTo(fAfter->record(), a);
+        return fBefore->record().visit<bool>(b, equalTo) &&
+               fBefore->sameState(fBefore->stateOf(b), *fAfter, fAfter->stateOf(a));
+    }
+
+private:
+    State* fBefore;
+    State* fAfter;
+};
+
+// Past this many inserted or deleted ops, we stop looking for a better alignment.
+static const int kMaxEdits = 512;
+
+// Find a longest common subsequence of before's ops [b0, b0+n) and after's ops [a0, a0+m)
+// with Myers' O(ND) algorithm, and mark the ops in it as matched.  Returns false, leaving
+// everything unmatched, if the two ranges differ by more than kMaxEdits ops.
+static bool align(Matcher* match, unsigned b0, int n, unsigned a0, int m,
+                  bool beforeMatched[], bool afterMatched[]) {
+    // V holds, for each d, the furthest reaching x on each diagonal k = x - y in [-d, d]
+    // after d edits.  Diagonal k of step d lives at V[d*d + d + k].
+    SkTDArray<int> V;
+    const int maxD = SkMin32(n + m, kMaxEdits);
+    int d;
+    bool done = false;
+    for (d = 0; d <= maxD && !done; d++) {
+        int* cur = V.append(2 * d + 1) + d;
+        const int* prev = V.begin() + (d - 1) * (d - 1) + (d - 1);  // Only used if d > 0.
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if (0 == d) {
+                x = 0;
+            } else if (k == -d || (k != d && prev[k - 1] < prev[k + 1])) {
+                x = prev[k + 1];       // Step down: insert an op from after.
+            } else {
+                x = prev[k - 1] + 1;   // Step right: delete an op from before.
+            }
+            int y = x - k;
+            while (x < n && y < m && (*match)(b0 + x, a0 + y)) {
+                x++;
+                y++;
+            }
+            cur[k] = x;
+            if (x >= n && y >= m) {
+                done = true;
+                break;
+            }
+        }
+    }
+    if (!done) {
+        return false;
+    }
+
+    // Walk back from (n, m), marking the diagonal runs of each step as matched.
+    int x = n, y = m;
+    for (d = d - 1; d > 0; d--) {
+        const int* prev = V.begin() + (d - 1) * (d - 1) + (d - 1);
+        const int k = x - y;
+        const bool down = k == -d || (k != d && prev[k - 1] < prev[k + 1]);
+        const int prevK = down ? k + 1 : k - 1;
+        const int prevX = prev[prevK];
+        const int prevY = prevX - prevK;
+        const int startX = down ? prevX : prevX + 1;
+        while (x > startX) {
+            x--;
+            y--;
+            beforeMatched[b0 + x] = afterMatched[a0 + y] = true;
+        }
+        x = prevX;
+        y = prevY;
+    }
+    while (x > 0) {
+        SkASSERT(x == y);
+        x--;
+        y--;
+        beforeMatched[b0 + x] = afterMatched[a0 + y] = true;
+    }
+    return true;
+}
+
+static void add_unmatched(const SkRecord& record, const bool matched[], const SkIRect& area,
+                          SkRegion* damage) {
+    SkAutoTMalloc<SkIRect> bounds(record.count());
+    SkRecordComputeBounds(record, bounds.get());
+    for (unsigned i = 0; i < record.count(); i++) {
+        SkIRect r = bounds[i];
+        if (!matched[i] && r.intersect(area)) {
+            damage->op(r, SkRegion::kUnion_Op);
+        }
+    }
+}
+
+void SkRecordDiff(const SkRecord& before, const SkRecord& after, const SkIRect& area,
+                  SkRegion* damage) {
+    SkASSERT(NULL != damage);
+    damage->setEmpty();
+
+    State beforeState(before), afterState(after);
+    Matcher match(&beforeState, &afterState);
+
+    SkAutoTMalloc<bool> beforeMatched(before.count()), afterMatched(after.count());
+    sk_bzero(beforeMatched.get(), before.count() * sizeof(bool));
+    sk_bzero(afterMatched.get(), after.count() * sizeof(bool));
+
+    // Most frames change little, so first match up the common prefix and suffix.
+    unsigned prefix = 0;
+    while (prefix < before.count() && prefix < after.count() && match(prefix, prefix)) {
+        beforeMatched[prefix] = afterMatched[prefix] = true;
+        prefix++;
+    }
+    unsigned suffix = 0;
+    while (prefix + suffix < before.count() && prefix + suffix < after.count() &&
+           match(before.count() - 1 - suffix, after.count() - 1 - suffix)) {
+        beforeMatched[before.count() - 1 - suffix] = afterMatched[after.count() - 1 - suffix] =
+            true;
+        suffix++;
+    }
+
+    // Then align whatever's left in the middle.
+    align(&match, prefix, before.count() - prefix - suffix,
+                  prefix, after.count() - prefix - suffix,
+          beforeMatched.get(), afterMatched.get());
+
+    add_unmatched(before, beforeMatched.get(), area, damage);
+    add_unmatched(after, afterMatched.get(), area, damage);
+
+    if (!damage->isEmpty() && afterState.escapesClip()) {
+        // We can't replay only part of after, so it'll all need to be drawn.
+        damage->setRect(area);
+    }
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRecordDiff_DEFINED
+#define SkRecordDiff_DEFINED
+
+#include "SkRecord.h"
+#include "SkRegion.h"
+
+// Compute the device-space area that may draw differently when after is played back in place of
+// before, clipped to area, and write it to damage.  Ops are matched up between the two records in
+// order; the bounds of every op that has no equal partner in the other record is damaged.
+//
+// The result is conservative: it may include pixels that end up unchanged, but never misses one
+// that changes.
+void SkRecordDiff(const SkRecord& before, const SkRecord& after, const SkIRect& area,
+                  SkRegion* damage);
+
+#endif//SkRecordDiff_DEFINED
@@ -116,9 +116,9 @@ DRAW(DrawVertices, drawVertices(r.vmode, r.vertexCount, r.vertices, r.texs, r.co
 // in for all the control ops we stashed away.
 class FillBounds : SkNoncopyable {
 public:
-    FillBounds(const SkRecord& record, SkBBoxHierarchy* bbh) : fBounds(record.count()) {
-        // Calculate bounds for all ops.  This won't go quite in order, so we'll need
-        // to store the bounds separately then feed them in to the BBH later in order.
+    FillBounds(const SkRecord& record, SkIRect bounds[]) : fBounds(bounds) {
+        // Calculate bounds for all ops.  This won't go quite in order, so we store
+        // the bounds separately for the caller to consume later in order.
         const SkIRect largest = SkIRect::MakeLargest();
         fCTM = &SkMatrix::I();
         fCurrentClipBounds = largest;
@@ -136,15 +136,6 @@ public:
         while (!fControlIndices.isEmpty()) {
             this->popControl(largest);
         }
-
-        // Finally feed all stored bounds into the BBH.  They'll be returned in this order.
-        SkASSERT(NULL != bbh);
-        for (uintptr_t i = 0; i < record.count(); i++) {
-            if (!fBounds[i].isEmpty()) {
-                bbh->insert((void*)i, fBounds[i], true/*ok to defer*/);
-            }
-        }
-        bbh->flushDeferredInserts();
     }
 
     template <typename T> void operator()(const T& op) {
@@ -377,8 +368,8 @@ private:
         return devRect;
     }
 
-    // Conservative device bounds for each op in the SkRecord.
-    SkAutoTMalloc<SkIRect> fBounds;
+    // Conservative device bounds for each op in the SkRecord.  Unowned.
+    SkIRect* fBounds;
 
     // We walk fCurrentOp through the SkRecord, as we go using updateCTM()
     // and updateClipBounds() to maintain the exact CTM (fCTM) and conservative
@@ -394,6 +385,20 @@ private:
 
 }  // namespace SkRecords
 
+void SkRecordComputeBounds(const SkRecord& record, SkIRect bounds[]) {
+    SkRecords::FillBounds(record, bounds);
+}
+
 void SkRecordFillBounds(const SkRecord& record, SkBBoxHierarchy* bbh) {
-    SkRecords::FillBounds(record, bbh);
+    SkAutoTMalloc<SkIRect> bounds(record.count());
+    SkRecordComputeBounds(record, bounds.get());
+
+    // Feed all the bounds into the BBH.  They'll be returned in this order.
+    SkASSERT(NULL != bbh);
+    for (uintptr_t i = 0; i < record.count(); i++) {
+        if (!bounds[i].isEmpty()) {
+            bbh->insert((void*)i, bounds[i], true/*ok to defer*/);
+        }
+    }
+    bbh->flushDeferredInserts();
 }
@@ -16,6 +16,10 @@
 // Fill a BBH to be used by SkRecordDraw to accelerate playback.
 void SkRecordFillBounds(const SkRecord&, SkBBoxHierarchy*);
 
+// Calculate conservative device bounds for each op in an SkRecord, the same bounds that
+// SkRecordFillBounds puts in the BBH.  bounds must have room for record.count() rects.
+void SkRecordComputeBounds(const SkRecord&, SkIRect bounds[]);
+
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
 void SkRecordDraw(const SkRecord&, SkCanvas*, const SkBBoxHierarchy*, SkDrawPictureCallback*);
 
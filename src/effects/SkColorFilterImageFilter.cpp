@@ -8,68 +8,21 @@
 #include "SkColorFilterImageFilter.h"
 #include "SkBitmap.h"
 #include "SkCanvas.h"
-#include "SkColorMatrixFilter.h"
 #include "SkDevice.h"
 #include "SkColorFilter.h"
+#include "SkColorMatrix.h"
 #include "SkReadBuffer.h"
+#include "SkTDArray.h"
 #include "SkWriteBuffer.h"
 
-namespace {
-
-void mult_color_matrix(SkScalar a[20], SkScalar b[20], SkScalar out[20]) {
-    for (int j = 0; j < 4; ++j) {
-        for (int i = 0; i < 5; ++i) {
-            out[i+j*5] = 4 == i ? a[4+j*5] : 0;
-            for (int k = 0; k < 4; ++k)
-                out[i+j*5] += SkScalarMul(a[k+j*5], b[i+k*5]);
-        }
-    }
-}
-
-// To detect if we need to apply clamping after applying a matrix, we check if
-// any output component might go outside of [0, 255] for any combination of
-// input components in [0..255].
-// Each output component is an affine transformation of the input component, so
-// the minimum and maximum values are for any combination of minimum or maximum
-// values of input components (i.e. 0 or 255).
-// E.g. if R' = x*R + y*G + z*B + w*A + t
-// Then the maximum value will be for R=255 if x>0 or R=0 if x<0, and the
-// minimum value will be for R=0 if x>0 or R=255 if x<0.
-// Same goes for all components.
-bool component_needs_clamping(SkScalar row[5]) {
-    SkScalar maxValue = row[4] / 255;
-    SkScalar minValue = row[4] / 255;
-    for (int i = 0; i < 4; ++i) {
-        if (row[i] > 0)
-            maxValue += row[i];
-        else
-            minValue += row[i];
-    }
-    return (maxValue > 1) || (minValue < 0);
-}
-
-bool matrix_needs_clamping(SkScalar matrix[20]) {
-    return component_needs_clamping(matrix)
-        || component_needs_clamping(matrix+5)
-        || component_needs_clamping(matrix+10)
-        || component_needs_clamping(matrix+15);
-}
-
-};
-
 SkColorFilterImageFilter* SkColorFilterImageFilter::Create(SkColorFilter* cf,
         SkImageFilter* input, const CropRect* cropRect) {
     SkASSERT(cf);
-    SkScalar colorMatrix[20], inputMatrix[20];
     SkColorFilter* inputColorFilter;
-    if (input && cf->asColorMatrix(colorMatrix)
-              && input->asColorFilter(&inputColorFilter)
-              && (NULL != inputColorFilter)) {
+    if (input && input->asColorFilter(&inputColorFilter) && (NULL != inputColorFilter)) {
         SkAutoUnref autoUnref(inputColorFilter);
-        if (inputColorFilter->asColorMatrix(inputMatrix) && !matrix_needs_clamping(inputMatrix)) {
-            SkScalar combinedMatrix[20];
-            mult_color_matrix(colorMatrix, inputMatrix, combinedMatrix);
-            SkAutoTUnref<SkColorFilter> newCF(SkColorMatrixFilter::Create(combinedMatrix));
+        SkAutoTUnref<SkColorFilter> newCF(cf->newComposed(inputColorFilter));
+        if (newCF) {
             return SkNEW_ARGS(SkColorFilterImageFilter, (newCF, input->getInput(0), cropRect));
         }
     }
@@ -105,30 +58,168 @@ SkColorFilterImageFilter::~SkColorFilterImageFilter() {
     SkSafeUnref(fColorFilter);
 }
 
+static bool is_identity(const SkColorFilter* cf) {
+    SkColorMatrix matrix, identity;
+    if (!cf->asColorMatrix(matrix.fMat)) {
+        return false;
+    }
+    identity.setIdentity();
+    return 0 == memcmp(matrix.fMat, identity.fMat, sizeof(matrix.fMat));
+}
+
+// Replaces src, placed at srcOffset, with the part of it within bounds, which must be inside it.
+static bool extract_subset(SkBitmap* src, SkIPoint* srcOffset, const SkIRect& bounds) {
+    SkIRect srcBounds;
+    src->getBounds(&srcBounds);
+    srcBounds.offset(*srcOffset);
+    if (bounds == srcBounds) {
+        return true;
+    }
+    SkIRect subset = bounds;
+    subset.offset(-srcOffset->fX, -srcOffset->fY);
+    SkBitmap subsetBitmap;
+    if (!src->extractSubset(&subsetBitmap, subset)) {
+        return false;
+    }
+    src->swap(subsetBitmap);
+    srcOffset->set(bounds.fLeft, bounds.fTop);
+    return true;
+}
+
+namespace {
+
+// Owns a ref on each color filter in it.
+class ColorFilterArray : SkNoncopyable {
+public:
+    ~ColorFilterArray() { fFilters.unrefAll(); }
+
+    SkTDArray<SkColorFilter*> fFilters;
+};
+
+}  // namespace
+
 bool SkColorFilterImageFilter::onFilterImage(Proxy* proxy, const SkBitmap& source,
                                              const Context& ctx,
                                              SkBitmap* result,
                                              SkIPoint* offset) const {
+    // Fuse the color filters of the uncropped color filter inputs into this pass, rather than
+    // drawing every one of them into an intermediate device. A color filter changes each pixel
+    // on its own, so the uncropped offsets in between only move the result. Each of those
+    // inputs would have clipped its result to the clip bounds, moved by the offsets outside of
+    // it, so innerClip gathers those clips where this pass places its input.
+    ColorFilterArray filters;  // outermost first
+    *filters.fFilters.append() = SkRef(fColorFilter);
+    SkIPoint translation = SkIPoint::Make(0, 0);
+    const bool clipIsLargest = SkIRect::MakeLargest() == ctx.clipBounds();
+    SkIRect innerClip = SkIRect::MakeLargest();
+    SkImageFilter* input = getInput(0);
+    while (input) {
+        SkColorFilter* inputColorFilter = NULL;
+        SkVector inputOffset;
+        if (input->asColorFilter(&inputColorFilter) && (NULL != inputColorFilter)) {
+            *filters.fFilters.append() = inputColorFilter;
+            if (!clipIsLargest) {
+                SkIRect clip = ctx.clipBounds();
+                clip.offset(translation);
+                if (!innerClip.intersect(clip)) {
+                    return false;
+                }
+            }
+        } else if (input->asOffset(&inputOffset)) {
+            // As SkOffsetImageFilter::onFilterImage() moves its result.
+            SkVector vec;
+            ctx.ctm().mapVectors(&vec, &inputOffset, 1);
+            translation.fX += SkScalarRoundToInt(vec.fX);
+            translation.fY += SkScalarRoundToInt(vec.fY);
+        } else {
+            break;
+        }
+        input = input->getInput(0);
+    }
+
     SkBitmap src = source;
     SkIPoint srcOffset = SkIPoint::Make(0, 0);
-    if (getInput(0) && !getInput(0)->filterImage(proxy, source, ctx, &src, &srcOffset)) {
+    if (input && !input->filterImage(proxy, source, ctx, &src, &srcOffset)) {
         return false;
     }
+    srcOffset += translation;
+
+    if (filters.fFilters.count() > 1) {
+        SkIRect srcBounds;
+        src.getBounds(&srcBounds);
+        srcBounds.offset(srcOffset);
+        if (!srcBounds.intersect(innerClip) ||
+            !extract_subset(&src, &srcOffset, srcBounds)) {
+            return false;
+        }
+    }
 
     SkIRect bounds;
     if (!this->applyCropRect(ctx, src, srcOffset, &bounds)) {
         return false;
     }
 
+    // Fold the filters, innermost first, into as few passes as possible.
+    ColorFilterArray passes;  // innermost first
+    for (int i = filters.fFilters.count() - 1; i >= 0; --i) {
+        SkColorFilter* composed = passes.fFilters.isEmpty()
+                                ? NULL
+                                : filters.fFilters[i]->newComposed(passes.fFilters.top());
+        if (composed) {
+            passes.fFilters.top()->unref();
+            passes.fFilters.top() = composed;
+        } else {
+            *passes.fFilters.append() = SkRef(filters.fFilters[i]);
+        }
+    }
+
+    // Without a crop rect, a pass of the identity is the part of the input within the clip.
+    if (1 == passes.fFilters.count() && !this->cropRectIsSet() &&
+        is_identity(passes.fFilters[0])) {
+        if (!extract_subset(&src, &srcOffset, bounds)) {
+            return false;
+        }
+        *result = src;
+        *offset = srcOffset;
+        return true;
+    }
+
     SkAutoTUnref<SkBaseDevice> device(proxy->createDevice(bounds.width(), bounds.height()));
     if (NULL == device.get()) {
         return false;
     }
-    SkCanvas canvas(device.get());
     SkPaint paint;
-
     paint.setXfermodeMode(SkXfermode::kSrc_Mode);
-    paint.setColorFilter(fColorFilter);
+
+    if (NULL == device->accessRenderTarget()) {
+        // Raster devices apply the filters of every pass in turn to each span.
+        SkColorFilter* chain = SkRef(passes.fFilters[0]);
+        for (int i = 1; i < passes.fFilters.count(); ++i) {
+            SkColorFilter* composed = SkColorFilter::CreateComposeFilter(passes.fFilters[i],
+                                                                         chain);
+            chain->unref();
+            chain = composed;
+        }
+        passes.fFilters.unrefAll();
+        passes.fFilters.reset();
+        *passes.fFilters.append() = chain;
+    } else {
+        // Other devices draw every pass but the last into a device of its own.
+        for (int i = 0; i < passes.fFilters.count() - 1; ++i) {
+            SkAutoTUnref<SkBaseDevice> passDevice(proxy->createDevice(src.width(),
+                                                                      src.height()));
+            if (NULL == passDevice.get()) {
+                return false;
+            }
+            SkCanvas passCanvas(passDevice.get());
+            paint.setColorFilter(passes.fFilters[i]);
+            passCanvas.drawSprite(src, 0, 0, &paint);
+            src = passDevice.get()->accessBitmap(false);
+        }
+    }
+
+    SkCanvas canvas(device.get());
+    paint.setColorFilter(passes.fFilters.top());
     canvas.drawSprite(src, srcOffset.fX - bounds.fLeft, srcOffset.fY - bounds.fTop, &paint);
 
     *result = device.get()->accessBitmap(false);
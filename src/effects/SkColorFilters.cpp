@@ -546,6 +546,94 @@ SkColorFilter* SkColorFilter::CreateLightingFilter(SkColor mul, SkColor add) {
     return SkColorMatrixFilter::Create(matrix);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+class SkComposeColorFilter : public SkColorFilter {
+public:
+    SkComposeColorFilter(SkColorFilter* outer, SkColorFilter* inner)
+        : fOuter(SkRef(outer))
+        , fInner(SkRef(inner)) {}
+
+    virtual ~SkComposeColorFilter() {
+        SkSafeUnref(fOuter);
+        SkSafeUnref(fInner);
+    }
+
+    virtual uint32_t getFlags() const SK_OVERRIDE {
+        return fOuter->getFlags() & fInner->getFlags();
+    }
+
+    virtual void filterSpan(const SkPMColor shader[], int count,
+                            SkPMColor result[]) const SK_OVERRIDE {
+        fInner->filterSpan(shader, count, result);
+        fOuter->filterSpan(result, count, result);
+    }
+
+    virtual void filterSpan16(const uint16_t shader[], int count,
+                              uint16_t result[]) const SK_OVERRIDE {
+        SkASSERT(this->getFlags() & kHasFilter16_Flag);
+        fInner->filterSpan16(shader, count, result);
+        fOuter->filterSpan16(result, count, result);
+    }
+
+#ifndef SK_IGNORE_TO_STRING
+    virtual void toString(SkString* str) const SK_OVERRIDE {
+        str->append("SkComposeColorFilter: outer(");
+        fOuter->toString(str);
+        str->append(") inner(");
+        fInner->toString(str);
+        str->append(")");
+    }
+#endif
+
+    SK_DECLARE_PUBLIC_FLATTENABLE_DESERIALIZATION_PROCS(SkComposeColorFilter)
+
+protected:
+    virtual void flatten(SkWriteBuffer& buffer) const SK_OVERRIDE {
+        buffer.writeFlattenable(fOuter);
+        buffer.writeFlattenable(fInner);
+    }
+
+#ifdef SK_SUPPORT_LEGACY_DEEPFLATTENING
+    SkComposeColorFilter(SkReadBuffer& buffer) : INHERITED(buffer) {
+        fOuter = buffer.readColorFilter();
+        fInner = buffer.readColorFilter();
+        buffer.validate(NULL != fOuter && NULL != fInner);
+    }
+#endif
+
+private:
+    SkColorFilter*  fOuter;
+    SkColorFilter*  fInner;
+
+    friend class SkColorFilter;
+
+    typedef SkColorFilter INHERITED;
+};
+
+SkFlattenable* SkComposeColorFilter::CreateProc(SkReadBuffer& buffer) {
+    SkAutoTUnref<SkColorFilter> outer(buffer.readColorFilter());
+    SkAutoTUnref<SkColorFilter> inner(buffer.readColorFilter());
+    return CreateComposeFilter(outer, inner);
+}
+
+SkColorFilter* SkColorFilter::CreateComposeFilter(SkColorFilter* outer, SkColorFilter* inner) {
+    if (NULL == outer) {
+        return SkSafeRef(inner);
+    }
+    if (NULL == inner) {
+        return SkRef(outer);
+    }
+
+    // Folding the filters together saves a pass over every span.
+    SkColorFilter* composition = outer->newComposed(inner);
+    if (composition) {
+        return composition;
+    }
+    return SkNEW_ARGS(SkComposeColorFilter, (outer, inner));
+}
+
 SK_DEFINE_FLATTENABLE_REGISTRAR_GROUP_START(SkColorFilter)
     SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkModeColorFilter)
+    SK_DEFINE_FLATTENABLE_REGISTRAR_ENTRY(SkComposeColorFilter)
 SK_DEFINE_FLATTENABLE_REGISTRAR_GROUP_END
@@ -7,6 +7,7 @@
  */
 #include "SkColorMatrixFilter.h"
 #include "SkColorMatrix.h"
+#include "SkColorMatrix_opts.h"
 #include "SkColorPriv.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
@@ -233,6 +234,13 @@ void SkColorMatrixFilter::filterSpan(const SkPMColor src[], int count,
         return;
     }
 
+    // Every proc computes the same as General() for the matrices it is chosen for.
+    SkColorMatrixSpanProc platformProc = SkColorMatrixGetPlatformSpanProc();
+    if (platformProc) {
+        platformProc(state.fArray, state.fShift, src, count, dst);
+        return;
+    }
+
     const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
 
     for (int i = 0; i < count; i++) {
@@ -331,6 +339,49 @@ bool SkColorMatrixFilter::asColorMatrix(SkScalar matrix[20]) const {
     return true;
 }
 
+// To detect if we need to apply clamping after applying a matrix, we check if
+// any output component might go outside of [0, 255] for any combination of
+// input components in [0..255].
+// Each output component is an affine transformation of the input component, so
+// the minimum and maximum values are for any combination of minimum or maximum
+// values of input components (i.e. 0 or 255).
+// E.g. if R' = x*R + y*G + z*B + w*A + t
+// Then the maximum value will be for R=255 if x>0 or R=0 if x<0, and the
+// minimum value will be for R=0 if x>0 or R=255 if x<0.
+// Same goes for all components.
+// Rows that add up to 1, like those of SkColorMatrix::setSaturation(), may add up to a little
+// more in floats; that moves the results by much less than a unit, so it is ignored.
+static bool component_needs_clamping(const SkScalar row[5]) {
+    SkScalar maxValue = row[4] / 255;
+    SkScalar minValue = row[4] / 255;
+    for (int i = 0; i < 4; ++i) {
+        if (row[i] > 0)
+            maxValue += row[i];
+        else
+            minValue += row[i];
+    }
+    return (maxValue > 1 + SK_ScalarNearlyZero) || (minValue < -SK_ScalarNearlyZero);
+}
+
+static bool matrix_needs_clamping(const SkScalar matrix[20]) {
+    return component_needs_clamping(matrix)
+        || component_needs_clamping(matrix+5)
+        || component_needs_clamping(matrix+10)
+        || component_needs_clamping(matrix+15);
+}
+
+SkColorFilter* SkColorMatrixFilter::newComposed(const SkColorFilter* inner) const {
+    // The output of inner is pinned before this filter sees it, so the matrices can only be
+    // concatenated when that does nothing.
+    SkColorMatrix innerMatrix;
+    if (inner->asColorMatrix(innerMatrix.fMat) && !matrix_needs_clamping(innerMatrix.fMat)) {
+        SkColorMatrix concat;
+        concat.setConcat(fMatrix, innerMatrix);
+        return SkColorMatrixFilter::Create(concat);
+    }
+    return NULL;
+}
+
 #if SK_SUPPORT_GPU
 #include "GrEffect.h"
 #include "GrTBackendEffectFactory.h"
@@ -6,7 +6,9 @@
  */
 
 #include "SkDisplacementMapEffect.h"
+#include "SkDisplacementMap_opts.h"
 #include "SkReadBuffer.h"
+#include "SkRowBandTask.h"
 #include "SkWriteBuffer.h"
 #include "SkUnPreMultiply.h"
 #include "SkColorPriv.h"
@@ -49,96 +51,231 @@ template<> uint32_t getValue<SkDisplacementMapEffect::kA_ChannelSelectorType>(
 }
 
 template<SkDisplacementMapEffect::ChannelSelectorType typeX,
-         SkDisplacementMapEffect::ChannelSelectorType typeY>
-void computeDisplacement(const SkVector& scale, SkBitmap* dst,
-                         SkBitmap* displ, const SkIPoint& offset,
-                         SkBitmap* src,
-                         const SkIRect& bounds)
+         SkDisplacementMapEffect::ChannelSelectorType typeY,
+         bool checkBounds>
+void displaceRow(const SkDisplacementMapParams& params, const SkPMColor* displPtr,
+                 int x, int y, SkPMColor* dstPtr, int count)
 {
-    static const SkScalar Inv8bit = SkScalarDiv(SK_Scalar1, 255.0f);
-    const int srcW = src->width();
-    const int srcH = src->height();
-    const SkVector scaleForColor = SkVector::Make(SkScalarMul(scale.fX, Inv8bit),
-                                                  SkScalarMul(scale.fY, Inv8bit));
-    const SkVector scaleAdj = SkVector::Make(SK_ScalarHalf - SkScalarMul(scale.fX, SK_ScalarHalf),
-                                             SK_ScalarHalf - SkScalarMul(scale.fY, SK_ScalarHalf));
     const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
-    SkPMColor* dstPtr = dst->getAddr32(0, 0);
-    for (int y = bounds.top(); y < bounds.bottom(); ++y) {
-        const SkPMColor* displPtr = displ->getAddr32(bounds.left() + offset.fX,
-                                                     y + offset.fY);
-        for (int x = bounds.left(); x < bounds.right(); ++x, ++displPtr) {
-            const SkScalar displX = SkScalarMul(scaleForColor.fX,
-                SkIntToScalar(getValue<typeX>(*displPtr, table))) + scaleAdj.fX;
-            const SkScalar displY = SkScalarMul(scaleForColor.fY,
-                SkIntToScalar(getValue<typeY>(*displPtr, table))) + scaleAdj.fY;
-            // Truncate the displacement values
-            const int srcX = x + SkScalarTruncToInt(displX);
-            const int srcY = y + SkScalarTruncToInt(displY);
-            *dstPtr++ = ((srcX < 0) || (srcX >= srcW) || (srcY < 0) || (srcY >= srcH)) ?
-                      0 : *(src->getAddr32(srcX, srcY));
-        }
+    for (int i = 0; i < count; ++i, ++displPtr) {
+        const SkScalar displX = SkScalarMul(params.fScaleX,
+            SkIntToScalar(getValue<typeX>(*displPtr, table))) + params.fOffsetX;
+        const SkScalar displY = SkScalarMul(params.fScaleY,
+            SkIntToScalar(getValue<typeY>(*displPtr, table))) + params.fOffsetY;
+        // Truncate the displacement values
+        const int srcX = x + i + SkScalarTruncToInt(displX);
+        const int srcY = y + SkScalarTruncToInt(displY);
+        *dstPtr++ = checkBounds && ((srcX < 0) || (srcX >= params.fColorWidth) ||
+                                    (srcY < 0) || (srcY >= params.fColorHeight)) ?
+                    0 : params.fColor[srcY * params.fColorStride + srcX];
+    }
+}
+
+// When no channel value can change the displacement, every pixel is displaced by the same
+// amount, that of a value of 0.
+template<bool checkBounds>
+void translateRow(const SkDisplacementMapParams& params, const SkPMColor*,
+                  int x, int y, SkPMColor* dstPtr, int count)
+{
+    const int srcX = x + SkScalarTruncToInt(SkScalarMul(params.fScaleX, 0) + params.fOffsetX);
+    const int srcY = y + SkScalarTruncToInt(SkScalarMul(params.fScaleY, 0) + params.fOffsetY);
+    const SkPMColor* srcPtr = params.fColor + srcY * params.fColorStride + srcX;
+    if (!checkBounds) {
+        memcpy(dstPtr, srcPtr, count * sizeof(SkPMColor));
+        return;
+    }
+    const bool insideY = (srcY >= 0) && (srcY < params.fColorHeight);
+    for (int i = 0; i < count; ++i) {
+        dstPtr[i] = insideY && (srcX + i >= 0) && (srcX + i < params.fColorWidth) ?
+                    srcPtr[i] : 0;
     }
 }
 
+template<SkDisplacementMapEffect::ChannelSelectorType typeX,
+         SkDisplacementMapEffect::ChannelSelectorType typeY>
+SkDisplacementMapRowProc chooseRowProc(bool checkBounds)
+{
+    return checkBounds ? displaceRow<typeX, typeY, true> : displaceRow<typeX, typeY, false>;
+}
+
 template<SkDisplacementMapEffect::ChannelSelectorType typeX>
-void computeDisplacement(SkDisplacementMapEffect::ChannelSelectorType yChannelSelector,
-                         const SkVector& scale, SkBitmap* dst,
-                         SkBitmap* displ, const SkIPoint& offset,
-                         SkBitmap* src,
-                         const SkIRect& bounds)
+SkDisplacementMapRowProc chooseRowProc(SkDisplacementMapEffect::ChannelSelectorType yChannelSelector,
+                                       bool checkBounds)
 {
     switch (yChannelSelector) {
       case SkDisplacementMapEffect::kR_ChannelSelectorType:
-        computeDisplacement<typeX, SkDisplacementMapEffect::kR_ChannelSelectorType>(
-            scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<typeX, SkDisplacementMapEffect::kR_ChannelSelectorType>(checkBounds);
       case SkDisplacementMapEffect::kG_ChannelSelectorType:
-        computeDisplacement<typeX, SkDisplacementMapEffect::kG_ChannelSelectorType>(
-            scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<typeX, SkDisplacementMapEffect::kG_ChannelSelectorType>(checkBounds);
       case SkDisplacementMapEffect::kB_ChannelSelectorType:
-        computeDisplacement<typeX, SkDisplacementMapEffect::kB_ChannelSelectorType>(
-            scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<typeX, SkDisplacementMapEffect::kB_ChannelSelectorType>(checkBounds);
       case SkDisplacementMapEffect::kA_ChannelSelectorType:
-        computeDisplacement<typeX, SkDisplacementMapEffect::kA_ChannelSelectorType>(
-            scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<typeX, SkDisplacementMapEffect::kA_ChannelSelectorType>(checkBounds);
       case SkDisplacementMapEffect::kUnknown_ChannelSelectorType:
       default:
         SkDEBUGFAIL("Unknown Y channel selector");
     }
+    return NULL;
 }
 
-void computeDisplacement(SkDisplacementMapEffect::ChannelSelectorType xChannelSelector,
-                         SkDisplacementMapEffect::ChannelSelectorType yChannelSelector,
-                         const SkVector& scale, SkBitmap* dst,
-                         SkBitmap* displ, const SkIPoint& offset,
-                         SkBitmap* src,
-                         const SkIRect& bounds)
+SkDisplacementMapRowProc chooseRowProc(SkDisplacementMapEffect::ChannelSelectorType xChannelSelector,
+                                       SkDisplacementMapEffect::ChannelSelectorType yChannelSelector,
+                                       bool checkBounds)
 {
     switch (xChannelSelector) {
       case SkDisplacementMapEffect::kR_ChannelSelectorType:
-        computeDisplacement<SkDisplacementMapEffect::kR_ChannelSelectorType>(
-            yChannelSelector, scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<SkDisplacementMapEffect::kR_ChannelSelectorType>(
+            yChannelSelector, checkBounds);
       case SkDisplacementMapEffect::kG_ChannelSelectorType:
-        computeDisplacement<SkDisplacementMapEffect::kG_ChannelSelectorType>(
-            yChannelSelector, scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<SkDisplacementMapEffect::kG_ChannelSelectorType>(
+            yChannelSelector, checkBounds);
       case SkDisplacementMapEffect::kB_ChannelSelectorType:
-        computeDisplacement<SkDisplacementMapEffect::kB_ChannelSelectorType>(
-            yChannelSelector, scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<SkDisplacementMapEffect::kB_ChannelSelectorType>(
+            yChannelSelector, checkBounds);
       case SkDisplacementMapEffect::kA_ChannelSelectorType:
-        computeDisplacement<SkDisplacementMapEffect::kA_ChannelSelectorType>(
-            yChannelSelector, scale, dst, displ, offset, src, bounds);
-        break;
+        return chooseRowProc<SkDisplacementMapEffect::kA_ChannelSelectorType>(
+            yChannelSelector, checkBounds);
       case SkDisplacementMapEffect::kUnknown_ChannelSelectorType:
       default:
         SkDEBUGFAIL("Unknown X channel selector");
     }
+    return NULL;
+}
+
+int channelShift(SkDisplacementMapEffect::ChannelSelectorType channelSelector) {
+    switch (channelSelector) {
+      case SkDisplacementMapEffect::kR_ChannelSelectorType:
+        return SK_R32_SHIFT;
+      case SkDisplacementMapEffect::kG_ChannelSelectorType:
+        return SK_G32_SHIFT;
+      case SkDisplacementMapEffect::kB_ChannelSelectorType:
+        return SK_B32_SHIFT;
+      case SkDisplacementMapEffect::kA_ChannelSelectorType:
+      default:
+        return SK_A32_SHIFT;
+    }
+}
+
+// The range of trunc(scale * value + offset) for the values 0 to 255 of a channel.
+void displacementRange(SkScalar scale, SkScalar offset, int* min, int* max) {
+    const int first = SkScalarTruncToInt(SkScalarMul(scale, SkIntToScalar(0)) + offset);
+    const int last = SkScalarTruncToInt(SkScalarMul(scale, SkIntToScalar(255)) + offset);
+    *min = SkMin32(first, last);
+    *max = SkMax32(first, last);
+}
+
+// Displaces the rows top to bottom of bounds. Pixels in interior are displaced to pixels of
+// the color bitmap whatever their displacement, so they skip the bounds checks.
+void displaceRows(const SkDisplacementMapParams& params, SkDisplacementMapRowProc checkedProc,
+                  SkDisplacementMapRowProc uncheckedProc, SkBitmap* dst, const SkBitmap& displ,
+                  const SkIPoint& offset, const SkIRect& bounds, const SkIRect& interior,
+                  int top, int bottom)
+{
+    for (int y = top; y < bottom; ++y) {
+        const SkPMColor* displPtr = displ.getAddr32(bounds.left() + offset.fX, y + offset.fY);
+        SkPMColor* dstPtr = dst->getAddr32(0, y - bounds.top());
+        if (y < interior.top() || y >= interior.bottom()) {
+            checkedProc(params, displPtr, bounds.left(), y, dstPtr, bounds.width());
+            continue;
+        }
+        const int left = interior.left() - bounds.left();
+        const int right = interior.right() - bounds.left();
+        checkedProc(params, displPtr, bounds.left(), y, dstPtr, left);
+        uncheckedProc(params, displPtr + left, interior.left(), y, dstPtr + left,
+                      right - left);
+        checkedProc(params, displPtr + right, interior.right(), y, dstPtr + right,
+                    bounds.width() - right);
+    }
+}
+
+// Displaces bands of rows for computeDisplacement.
+class DisplaceBandTask : public SkRowBandTask {
+public:
+    DisplaceBandTask(const SkDisplacementMapParams& params,
+                     SkDisplacementMapRowProc checkedProc,
+                     SkDisplacementMapRowProc uncheckedProc, SkBitmap* dst,
+                     const SkBitmap& displ, const SkIPoint& offset, const SkIRect& bounds,
+                     const SkIRect& interior)
+        : fParams(params)
+        , fCheckedProc(checkedProc)
+        , fUncheckedProc(uncheckedProc)
+        , fDst(dst)
+        , fDispl(displ)
+        , fOffset(offset)
+        , fBounds(bounds)
+        , fInterior(interior) {}
+
+    virtual void runBand(int top, int bottom) SK_OVERRIDE {
+        displaceRows(fParams, fCheckedProc, fUncheckedProc, fDst, fDispl, fOffset, fBounds,
+                     fInterior, top, bottom);
+    }
+
+private:
+    const SkDisplacementMapParams&  fParams;
+    const SkDisplacementMapRowProc  fCheckedProc;
+    const SkDisplacementMapRowProc  fUncheckedProc;
+    SkBitmap* const                 fDst;
+    const SkBitmap&                 fDispl;
+    const SkIPoint                  fOffset;
+    const SkIRect                   fBounds;
+    const SkIRect                   fInterior;
+};
+
+void computeDisplacement(SkDisplacementMapEffect::ChannelSelectorType xChannelSelector,
+                         SkDisplacementMapEffect::ChannelSelectorType yChannelSelector,
+                         const SkVector& scale, SkBitmap* dst,
+                         SkBitmap* displ, const SkIPoint& offset,
+                         SkBitmap* src,
+                         const SkIRect& bounds)
+{
+    static const SkScalar Inv8bit = SkScalarDiv(SK_Scalar1, 255.0f);
+    SkDisplacementMapParams params;
+    params.fXChannelShift = channelShift(xChannelSelector);
+    params.fYChannelShift = channelShift(yChannelSelector);
+    params.fScaleX = SkScalarMul(scale.fX, Inv8bit);
+    params.fScaleY = SkScalarMul(scale.fY, Inv8bit);
+    params.fOffsetX = SK_ScalarHalf - SkScalarMul(scale.fX, SK_ScalarHalf);
+    params.fOffsetY = SK_ScalarHalf - SkScalarMul(scale.fY, SK_ScalarHalf);
+    params.fColor = src->getAddr32(0, 0);
+    params.fColorStride = src->rowBytesAsPixels();
+    params.fColorWidth = src->width();
+    params.fColorHeight = src->height();
+
+    SkDisplacementMapRowProc checkedProc = chooseRowProc(xChannelSelector, yChannelSelector,
+                                                         true);
+    SkDisplacementMapRowProc uncheckedProc = chooseRowProc(xChannelSelector, yChannelSelector,
+                                                           false);
+    if (NULL == checkedProc || NULL == uncheckedProc) {
+        return;
+    }
+    if (SkDisplacementMapGetPlatformRowProc(true) && SkDisplacementMapGetPlatformRowProc(false)) {
+        checkedProc = SkDisplacementMapGetPlatformRowProc(true);
+        uncheckedProc = SkDisplacementMapGetPlatformRowProc(false);
+    }
+
+    int minX, maxX, minY, maxY;
+    displacementRange(params.fScaleX, params.fOffsetX, &minX, &maxX);
+    displacementRange(params.fScaleY, params.fOffsetY, &minY, &maxY);
+    if (minX == maxX && minY == maxY) {
+        checkedProc = translateRow<true>;
+        uncheckedProc = translateRow<false>;
+    }
+
+    // The pixels that no displacement can take out of the color bitmap.
+    SkIRect interior = SkIRect::MakeLTRB(
+        static_cast<int32_t>(SkTMax<int64_t>(bounds.left(), -static_cast<int64_t>(minX))),
+        static_cast<int32_t>(SkTMax<int64_t>(bounds.top(), -static_cast<int64_t>(minY))),
+        static_cast<int32_t>(SkTMin<int64_t>(bounds.right(),
+                                             static_cast<int64_t>(src->width()) - maxX)),
+        static_cast<int32_t>(SkTMin<int64_t>(bounds.bottom(),
+                                             static_cast<int64_t>(src->height()) - maxY)));
+    if (interior.isEmpty()) {
+        interior.setEmpty();
+    }
+
+    DisplaceBandTask task(params, checkedProc, uncheckedProc, dst, *displ, offset, bounds,
+                          interior);
+    task.run(bounds.width(), bounds.top(), bounds.bottom());
 }
 
 bool channel_selector_type_is_valid(SkDisplacementMapEffect::ChannelSelectorType cst) {
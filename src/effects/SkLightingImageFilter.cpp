@@ -8,10 +8,12 @@
 #include "SkLightingImageFilter.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
+#include "SkLighting_opts.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
+#include "SkRowBandTask.h"
 #include "SkTypes.h"
 
 #if SK_SUPPORT_GPU
@@ -69,6 +71,10 @@ public:
                             SkClampMax(SkScalarRoundToInt(color.fY), 255),
                             SkClampMax(SkScalarRoundToInt(color.fZ), 255));
     }
+    void initParams(SkLightingParams* params) const {
+        params->fSpecular = false;
+        params->fK = fKD;
+    }
 private:
     SkScalar fKD;
 };
@@ -90,6 +96,11 @@ public:
                             SkClampMax(SkScalarRoundToInt(color.fY), 255),
                             SkClampMax(SkScalarRoundToInt(color.fZ), 255));
     }
+    void initParams(SkLightingParams* params) const {
+        params->fSpecular = true;
+        params->fK = fKS;
+        params->fShininess = fShininess;
+    }
 private:
     SkScalar fKS;
     SkScalar fShininess;
@@ -162,14 +173,13 @@ inline SkPoint3 bottomRightNormal(int m[9], SkScalar surfaceScale) {
                          surfaceScale);
 }
 
-template <class LightingType, class LightType> void lightBitmap(const LightingType& lightingType, const SkLight* light, const SkBitmap& src, SkBitmap* dst, SkScalar surfaceScale, const SkIRect& bounds) {
-    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
-    const LightType* l = static_cast<const LightType*>(light);
+// Lights the rows [top, bottom) of bounds, into the same rows of dst. The interior pixels of the
+// interior rows are lit by proc, if there is one.
+template <class LightingType, class LightType> void lightRows(const LightingType& lightingType, const LightType* l, SkLightingRowProc proc, const SkLightingParams& params, const SkBitmap& src, SkBitmap* dst, SkScalar surfaceScale, const SkIRect& bounds, int top, int bottom) {
     int left = bounds.left(), right = bounds.right();
-    int bottom = bounds.bottom();
-    int y = bounds.top();
-    SkPMColor* dptr = dst->getAddr32(0, 0);
-    {
+    int y = top;
+    SkPMColor* dptr = dst->getAddr32(0, top - bounds.top());
+    if (y == bounds.top()) {
         int x = left;
         const SkPMColor* row1 = src.getAddr32(x, y);
         const SkPMColor* row2 = src.getAddr32(x, y + 1);
@@ -191,9 +201,10 @@ template <class LightingType, class LightType> void lightBitmap(const LightingTy
         shiftMatrixLeft(m);
         surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
         *dptr++ = lightingType.light(topRightNormal(m, surfaceScale), surfaceToLight, l->lightColor(surfaceToLight));
+        ++y;
     }
 
-    for (++y; y < bottom - 1; ++y) {
+    for (; y < bottom && y < bounds.bottom() - 1; ++y) {
         int x = left;
         const SkPMColor* row0 = src.getAddr32(x, y - 1);
         const SkPMColor* row1 = src.getAddr32(x, y);
@@ -207,20 +218,38 @@ template <class LightingType, class LightType> void lightBitmap(const LightingTy
         m[8] = SkGetPackedA32(*row2++);
         SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
         *dptr++ = lightingType.light(leftNormal(m, surfaceScale), surfaceToLight, l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x) {
-            shiftMatrixLeft(m);
-            m[2] = SkGetPackedA32(*row0++);
-            m[5] = SkGetPackedA32(*row1++);
-            m[8] = SkGetPackedA32(*row2++);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(interiorNormal(m, surfaceScale), surfaceToLight, l->lightColor(surfaceToLight));
+        if (proc) {
+            const SkPMColor* const rows[3] = { row0 - 2, row1 - 2, row2 - 2 };
+            const int count = right - left - 2;
+            proc(params, rows, x + 1, y, dptr, count);
+            x += count + 1;
+            dptr += count;
+            row0 += count;
+            row1 += count;
+            row2 += count;
+            // The last two columns, before shifting them in place for the right pixel.
+            m[1] = SkGetPackedA32(row0[-2]);
+            m[2] = SkGetPackedA32(row0[-1]);
+            m[4] = SkGetPackedA32(row1[-2]);
+            m[5] = SkGetPackedA32(row1[-1]);
+            m[7] = SkGetPackedA32(row2[-2]);
+            m[8] = SkGetPackedA32(row2[-1]);
+        } else {
+            for (++x; x < right - 1; ++x) {
+                shiftMatrixLeft(m);
+                m[2] = SkGetPackedA32(*row0++);
+                m[5] = SkGetPackedA32(*row1++);
+                m[8] = SkGetPackedA32(*row2++);
+                surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
+                *dptr++ = lightingType.light(interiorNormal(m, surfaceScale), surfaceToLight, l->lightColor(surfaceToLight));
+            }
         }
         shiftMatrixLeft(m);
         surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
         *dptr++ = lightingType.light(rightNormal(m, surfaceScale), surfaceToLight, l->lightColor(surfaceToLight));
     }
 
-    {
+    if (bottom == bounds.bottom()) {
         int x = left;
         const SkPMColor* row0 = src.getAddr32(x, bottom - 2);
         const SkPMColor* row1 = src.getAddr32(x, bottom - 1);
@@ -245,6 +274,53 @@ template <class LightingType, class LightType> void lightBitmap(const LightingTy
     }
 }
 
+// Lights bands of rows for lightBitmap.
+template <class LightingType, class LightType> class LightBandTask : public SkRowBandTask {
+public:
+    LightBandTask(const LightingType& lightingType, const LightType* light,
+                  SkLightingRowProc proc, const SkLightingParams& params,
+                  const SkBitmap& src, SkBitmap* dst, SkScalar surfaceScale,
+                  const SkIRect& bounds)
+        : fLightingType(lightingType)
+        , fLight(light)
+        , fProc(proc)
+        , fParams(params)
+        , fSrc(src)
+        , fDst(dst)
+        , fSurfaceScale(surfaceScale)
+        , fBounds(bounds) {}
+
+    virtual void runBand(int top, int bottom) SK_OVERRIDE {
+        lightRows(fLightingType, fLight, fProc, fParams, fSrc, fDst, fSurfaceScale, fBounds,
+                  top, bottom);
+    }
+
+private:
+    const LightingType&     fLightingType;
+    const LightType* const  fLight;
+    const SkLightingRowProc fProc;
+    const SkLightingParams& fParams;
+    const SkBitmap&         fSrc;
+    SkBitmap* const         fDst;
+    const SkScalar          fSurfaceScale;
+    const SkIRect           fBounds;
+};
+
+template <class LightingType, class LightType> void lightBitmap(const LightingType& lightingType, const SkLight* light, const SkBitmap& src, SkBitmap* dst, SkScalar surfaceScale, const SkIRect& bounds) {
+    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
+    const LightType* l = static_cast<const LightType*>(light);
+
+    SkLightingParams params;
+    params.fSurfaceScale = surfaceScale;
+    lightingType.initParams(&params);
+    l->initParams(&params);
+
+    // Every pixel is lit the same way in any band, so the bands only split the work.
+    LightBandTask<LightingType, LightType> task(lightingType, l, SkLightingGetPlatformRowProc(),
+                                                params, src, dst, surfaceScale, bounds);
+    task.run(bounds.width(), bounds.top(), bounds.bottom());
+}
+
 SkPoint3 readPoint3(SkReadBuffer& buffer) {
     SkPoint3 point;
     point.fX = buffer.readScalar();
@@ -256,6 +332,12 @@ SkPoint3 readPoint3(SkReadBuffer& buffer) {
     return point;
 };
 
+void copyPoint3(const SkPoint3& point, float dst[3]) {
+    dst[0] = point.fX;
+    dst[1] = point.fY;
+    dst[2] = point.fZ;
+}
+
 void writePoint3(const SkPoint3& point, SkWriteBuffer& buffer) {
     buffer.writeScalar(point.fX);
     buffer.writeScalar(point.fY);
@@ -576,6 +658,11 @@ public:
         return fDirection;
     };
     SkPoint3 lightColor(const SkPoint3&) const { return color(); }
+    void initParams(SkLightingParams* params) const {
+        params->fLightType = SkLightingParams::kDistant_LightType;
+        copyPoint3(color(), params->fColor);
+        copyPoint3(fDirection, params->fDirection);
+    }
     virtual LightType type() const { return kDistant_LightType; }
     const SkPoint3& direction() const { return fDirection; }
     virtual GrGLLight* createGLLight() const SK_OVERRIDE {
@@ -633,6 +720,11 @@ public:
         return direction;
     };
     SkPoint3 lightColor(const SkPoint3&) const { return color(); }
+    void initParams(SkLightingParams* params) const {
+        params->fLightType = SkLightingParams::kPoint_LightType;
+        copyPoint3(color(), params->fColor);
+        copyPoint3(fLocation, params->fLocation);
+    }
     virtual LightType type() const { return kPoint_LightType; }
     const SkPoint3& location() const { return fLocation; }
     virtual GrGLLight* createGLLight() const SK_OVERRIDE {
@@ -732,6 +824,16 @@ public:
         }
         return color() * scale;
     }
+    void initParams(SkLightingParams* params) const {
+        params->fLightType = SkLightingParams::kSpot_LightType;
+        copyPoint3(color(), params->fColor);
+        copyPoint3(fLocation, params->fLocation);
+        copyPoint3(fS, params->fS);
+        params->fSpecularExponent = fSpecularExponent;
+        params->fCosOuterConeAngle = fCosOuterConeAngle;
+        params->fCosInnerConeAngle = fCosInnerConeAngle;
+        params->fConeScale = fConeScale;
+    }
     virtual GrGLLight* createGLLight() const SK_OVERRIDE {
 #if SK_SUPPORT_GPU
         return SkNEW(GrGLSpotLight);
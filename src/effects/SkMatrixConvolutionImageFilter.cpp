@@ -8,9 +8,12 @@
 #include "SkMatrixConvolutionImageFilter.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
+#include "SkMatrixConvolution_opts.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkRect.h"
+#include "SkRowBandTask.h"
+#include "SkTemplates.h"
 #include "SkUnPreMultiply.h"
 
 #if SK_SUPPORT_GPU
@@ -132,13 +135,6 @@ SkMatrixConvolutionImageFilter::~SkMatrixConvolutionImageFilter() {
     delete[] fKernel;
 }
 
-class UncheckedPixelFetcher {
-public:
-    static inline SkPMColor fetch(const SkBitmap& src, int x, int y, const SkIRect& bounds) {
-        return *src.getAddr32(x, y);
-    }
-};
-
 class ClampPixelFetcher {
 public:
     static inline SkPMColor fetch(const SkBitmap& src, int x, int y, const SkIRect& bounds) {
@@ -174,6 +170,168 @@ public:
     }
 };
 
+// Applies the gain and the bias to the sums of the channels of a pixel, and packs it. Without
+// convolveAlpha, the pixel takes the alpha of the source pixel, srcA.
+template<bool convolveAlpha>
+static inline SkPMColor pack_pixel(SkScalar sumA, SkScalar sumR, SkScalar sumG, SkScalar sumB,
+                                   SkScalar gain, SkScalar bias, U8CPU srcA) {
+    int a = convolveAlpha
+          ? SkClampMax(SkScalarFloorToInt(SkScalarMul(sumA, gain) + bias), 255)
+          : 255;
+    int r = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumR, gain) + bias), a);
+    int g = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumG, gain) + bias), a);
+    int b = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumB, gain) + bias), a);
+    if (!convolveAlpha) {
+        return SkPreMultiplyARGB(srcA, r, g, b);
+    } else {
+        return SkPackARGB32(a, r, g, b);
+    }
+}
+
+static inline SkPMColor pack_pixel(const SkMatrixConvolutionParams& params, SkScalar sumA,
+                                   SkScalar sumR, SkScalar sumG, SkScalar sumB, SkPMColor src) {
+    if (params.fConvolveAlpha) {
+        return pack_pixel<true>(sumA, sumR, sumG, sumB, params.fGain, params.fBias, 0);
+    } else {
+        return pack_pixel<false>(sumA, sumR, sumG, sumB, params.fGain, params.fBias,
+                                 SkGetPackedA32(src));
+    }
+}
+
+// The portable SkMatrixConvolutionRowProc.
+static void convolve_row(const SkMatrixConvolutionParams& params,
+                         const SkPMColor* src, int srcStride,
+                         SkPMColor dst[], int count) {
+    const SkPMColor* center = src + params.fKernelOffsetY * srcStride + params.fKernelOffsetX;
+    for (int i = 0; i < count; ++i) {
+        SkScalar sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+        const SkScalar* kernel = params.fKernel;
+        const SkPMColor* row = src + i;
+        for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+            for (int cx = 0; cx < params.fKernelWidth; ++cx) {
+                const SkPMColor s = row[cx];
+                const SkScalar k = *kernel++;
+                sumA += SkScalarMul(SkIntToScalar(SkGetPackedA32(s)), k);
+                sumR += SkScalarMul(SkIntToScalar(SkGetPackedR32(s)), k);
+                sumG += SkScalarMul(SkIntToScalar(SkGetPackedG32(s)), k);
+                sumB += SkScalarMul(SkIntToScalar(SkGetPackedB32(s)), k);
+            }
+            row += srcStride;
+        }
+        dst[i] = pack_pixel(params, sumA, sumR, sumG, sumB, center[i]);
+    }
+}
+
+// The portable SkMatrixConvolutionSumRowProc.
+static void sum_row(const SkMatrixConvolutionParams& params,
+                    const SkPMColor* src, SkScalar dst[], int count) {
+    for (int i = 0; i < count; ++i) {
+        SkScalar sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+        for (int cx = 0; cx < params.fKernelWidth; ++cx) {
+            const SkPMColor s = src[i + cx];
+            const SkScalar k = params.fRowKernel[cx];
+            sumA += SkScalarMul(SkIntToScalar(SkGetPackedA32(s)), k);
+            sumR += SkScalarMul(SkIntToScalar(SkGetPackedR32(s)), k);
+            sumG += SkScalarMul(SkIntToScalar(SkGetPackedG32(s)), k);
+            sumB += SkScalarMul(SkIntToScalar(SkGetPackedB32(s)), k);
+        }
+        SkScalar* sums = dst + 4 * i;
+        sums[SK_A32_SHIFT / 8] = sumA;
+        sums[SK_R32_SHIFT / 8] = sumR;
+        sums[SK_G32_SHIFT / 8] = sumG;
+        sums[SK_B32_SHIFT / 8] = sumB;
+    }
+}
+
+// The portable SkMatrixConvolutionSumColumnProc.
+static void sum_column(const SkMatrixConvolutionParams& params,
+                       const SkScalar* const rows[], const SkPMColor* src,
+                       SkPMColor dst[], int count) {
+    for (int i = 0; i < count; ++i) {
+        SkScalar sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+        for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+            const SkScalar* sums = rows[cy] + 4 * i;
+            const SkScalar k = params.fColumnKernel[cy];
+            sumA += SkScalarMul(sums[SK_A32_SHIFT / 8], k);
+            sumR += SkScalarMul(sums[SK_R32_SHIFT / 8], k);
+            sumG += SkScalarMul(sums[SK_G32_SHIFT / 8], k);
+            sumB += SkScalarMul(sums[SK_B32_SHIFT / 8], k);
+        }
+        dst[i] = pack_pixel(params, sumA, sumR, sumG, sumB, src[i]);
+    }
+}
+
+void SkMatrixConvolutionGetPortableProcs(SkMatrixConvolutionRowProc* convolveRow,
+                                         SkMatrixConvolutionSumRowProc* sumRow,
+                                         SkMatrixConvolutionSumColumnProc* sumColumn) {
+    *convolveRow = convolve_row;
+    *sumRow = sum_row;
+    *sumColumn = sum_column;
+}
+
+// Returns the sum of the magnitudes of the values, in units of a power of two that every value
+// is a multiple of, or -1 if that unit would have to be finer than 2^-32.
+static double dyadic_weight(const SkScalar values[], int count) {
+    SkScalar scale = SK_Scalar1;
+    for (int i = 0; i < count; ++i) {
+        while (SkScalarFloorToScalar(values[i] * scale) != values[i] * scale) {
+            scale *= 2;
+            if (scale > SkIntToScalar(1 << 30) * 4) {
+                return -1;
+            }
+        }
+    }
+    double weight = 0;
+    for (int i = 0; i < count; ++i) {
+        weight += SkScalarAbs(values[i] * scale);
+    }
+    return weight;
+}
+
+// Whether the kernel is exactly the product of a column and a row, and has enough elements for
+// two passes to beat one. If so, returns its row and column factors.
+//
+// Both passes must give the very same pixels as one, so the factors must also be multiples of
+// powers of two small enough that no product or sum of 8-bit channels needs more than the 24
+// bits of a float. Then neither way of adding up the taps rounds.
+static bool factor_kernel(const SkScalar* kernel, int width, int height,
+                          SkScalar* row, SkScalar* column) {
+    if (width * height <= width + height + 1) {
+        return false;
+    }
+    // Dividing by the smallest element keeps integer and binomial kernels' factors whole.
+    int pivot = -1;
+    for (int i = 0; i < width * height; ++i) {
+        if (0 != kernel[i] &&
+            (pivot < 0 || SkScalarAbs(kernel[i]) < SkScalarAbs(kernel[pivot]))) {
+            pivot = i;
+        }
+    }
+    if (pivot < 0) {
+        return false;
+    }
+    const SkScalar pivotValue = kernel[pivot];
+    const int pivotX = pivot % width;
+    const int pivotY = pivot / width;
+    for (int cx = 0; cx < width; ++cx) {
+        row[cx] = kernel[pivotY * width + cx];
+    }
+    for (int cy = 0; cy < height; ++cy) {
+        column[cy] = kernel[cy * width + pivotX] / pivotValue;
+    }
+    for (int cy = 0; cy < height; ++cy) {
+        for (int cx = 0; cx < width; ++cx) {
+            if (kernel[cy * width + cx] != column[cy] * row[cx]) {
+                return false;
+            }
+        }
+    }
+    const double rowWeight = dyadic_weight(row, width);
+    const double columnWeight = dyadic_weight(column, height);
+    return rowWeight >= 0 && columnWeight >= 0 &&
+           255 * rowWeight * columnWeight < (1 << 24);
+}
+
 template<class PixelFetcher, bool convolveAlpha>
 void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
                                                   SkBitmap* result,
@@ -202,18 +360,10 @@ void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
                     sumB += SkScalarMul(SkIntToScalar(SkGetPackedB32(s)), k);
                 }
             }
-            int a = convolveAlpha
-                  ? SkClampMax(SkScalarFloorToInt(SkScalarMul(sumA, fGain) + fBias), 255)
-                  : 255;
-            int r = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumR, fGain) + fBias), a);
-            int g = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumG, fGain) + fBias), a);
-            int b = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumB, fGain) + fBias), a);
-            if (!convolveAlpha) {
-                a = SkGetPackedA32(PixelFetcher::fetch(src, x, y, bounds));
-                *dptr++ = SkPreMultiplyARGB(a, r, g, b);
-            } else {
-                *dptr++ = SkPackARGB32(a, r, g, b);
-            }
+            const U8CPU srcA = convolveAlpha
+                             ? 0
+                             : SkGetPackedA32(PixelFetcher::fetch(src, x, y, bounds));
+            *dptr++ = pack_pixel<convolveAlpha>(sumA, sumR, sumG, sumB, fGain, fBias, srcA);
         }
     }
 }
@@ -232,9 +382,65 @@ void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
 
 void SkMatrixConvolutionImageFilter::filterInteriorPixels(const SkBitmap& src,
                                                           SkBitmap* result,
-                                                          const SkIRect& rect,
+                                                          const SkIRect& r,
                                                           const SkIRect& bounds) const {
-    filterPixels<UncheckedPixelFetcher>(src, result, rect, bounds);
+    SkIRect rect(r);
+    if (!rect.intersect(bounds)) {
+        return;
+    }
+    SkMatrixConvolutionRowProc convolveRow;
+    SkMatrixConvolutionSumRowProc sumRow;
+    SkMatrixConvolutionSumColumnProc sumColumn;
+    if (!SkMatrixConvolutionGetPlatformProcs(&convolveRow, &sumRow, &sumColumn)) {
+        SkMatrixConvolutionGetPortableProcs(&convolveRow, &sumRow, &sumColumn);
+    }
+
+    const int kernelWidth = fKernelSize.width();
+    const int kernelHeight = fKernelSize.height();
+    SkAutoSTMalloc<16, SkScalar> factors(kernelWidth + kernelHeight);
+    SkMatrixConvolutionParams params;
+    params.fKernel = fKernel;
+    params.fRowKernel = factors.get();
+    params.fColumnKernel = factors.get() + kernelWidth;
+    params.fKernelWidth = kernelWidth;
+    params.fKernelHeight = kernelHeight;
+    params.fKernelOffsetX = fKernelOffset.fX;
+    params.fKernelOffsetY = fKernelOffset.fY;
+    params.fGain = fGain;
+    params.fBias = fBias;
+    params.fConvolveAlpha = fConvolveAlpha;
+
+    const int count = rect.width();
+    const int srcStride = src.rowBytesAsPixels();
+    const int left = rect.fLeft - fKernelOffset.fX;
+    const int top = rect.fTop - fKernelOffset.fY;
+    if (!factor_kernel(fKernel, kernelWidth, kernelHeight,
+                       factors.get(), factors.get() + kernelWidth)) {
+        for (int y = rect.fTop; y < rect.fBottom; ++y) {
+            convolveRow(params, src.getAddr32(left, y - fKernelOffset.fY), srcStride,
+                        result->getAddr32(rect.fLeft - bounds.fLeft, y - bounds.fTop), count);
+        }
+        return;
+    }
+
+    // The rows of sums under the kernel, kept in a ring: the sums of source row top + i are in
+    // slot i % kernelHeight.
+    SkAutoTMalloc<SkScalar> sums(4 * count * kernelHeight);
+    SkAutoSTMalloc<16, const SkScalar*> rows(kernelHeight);
+    for (int i = 0; i < kernelHeight - 1; ++i) {
+        sumRow(params, src.getAddr32(left, top + i), sums.get() + 4 * count * i, count);
+    }
+    for (int y = rect.fTop; y < rect.fBottom; ++y) {
+        const int first = y - rect.fTop;
+        const int last = first + kernelHeight - 1;
+        sumRow(params, src.getAddr32(left, top + last),
+               sums.get() + 4 * count * (last % kernelHeight), count);
+        for (int i = 0; i < kernelHeight; ++i) {
+            rows[i] = sums.get() + 4 * count * ((first + i) % kernelHeight);
+        }
+        sumColumn(params, rows.get(), src.getAddr32(rect.fLeft, y),
+                  result->getAddr32(rect.fLeft - bounds.fLeft, y - bounds.fTop), count);
+    }
 }
 
 void SkMatrixConvolutionImageFilter::filterBorderPixels(const SkBitmap& src,
@@ -254,6 +460,61 @@ void SkMatrixConvolutionImageFilter::filterBorderPixels(const SkBitmap& src,
     }
 }
 
+void SkMatrixConvolutionImageFilter::filterRows(const SkBitmap& src,
+                                                SkBitmap* result,
+                                                const SkIRect& bounds,
+                                                int bandTop, int bandBottom) const {
+    SkIRect interior = SkIRect::MakeXYWH(bounds.left() + fKernelOffset.fX,
+                                         bounds.top() + fKernelOffset.fY,
+                                         bounds.width() - fKernelSize.fWidth + 1,
+                                         bounds.height() - fKernelSize.fHeight + 1);
+    SkIRect top = SkIRect::MakeLTRB(bounds.left(), bounds.top(), bounds.right(), interior.top());
+    SkIRect bottom = SkIRect::MakeLTRB(bounds.left(), interior.bottom(),
+                                       bounds.right(), bounds.bottom());
+    SkIRect left = SkIRect::MakeLTRB(bounds.left(), interior.top(),
+                                     interior.left(), interior.bottom());
+    SkIRect right = SkIRect::MakeLTRB(interior.right(), interior.top(),
+                                      bounds.right(), interior.bottom());
+    const SkIRect band = SkIRect::MakeLTRB(bounds.left(), bandTop, bounds.right(), bandBottom);
+    SkIRect rect;
+    if (rect.intersect(top, band)) {
+        filterBorderPixels(src, result, rect, bounds);
+    }
+    if (rect.intersect(left, band)) {
+        filterBorderPixels(src, result, rect, bounds);
+    }
+    if (rect.intersect(interior, band)) {
+        filterInteriorPixels(src, result, rect, bounds);
+    }
+    if (rect.intersect(right, band)) {
+        filterBorderPixels(src, result, rect, bounds);
+    }
+    if (rect.intersect(bottom, band)) {
+        filterBorderPixels(src, result, rect, bounds);
+    }
+}
+
+// Filters bands of rows for onFilterImage().
+class SkMatrixConvolutionImageFilter::BandTask : public SkRowBandTask {
+public:
+    BandTask(const SkMatrixConvolutionImageFilter* filter, const SkBitmap& src,
+             SkBitmap* result, const SkIRect& bounds)
+        : fFilter(filter)
+        , fSrc(src)
+        , fResult(result)
+        , fBounds(bounds) {}
+
+    virtual void runBand(int top, int bottom) SK_OVERRIDE {
+        fFilter->filterRows(fSrc, fResult, fBounds, top, bottom);
+    }
+
+private:
+    const SkMatrixConvolutionImageFilter* const fFilter;
+    const SkBitmap&                             fSrc;
+    SkBitmap* const                             fResult;
+    const SkIRect                               fBounds;
+};
+
 // FIXME:  This should be refactored to SkImageFilterUtils for
 // use by other filters.  For now, we assume the input is always
 // premultiplied and unpremultiply it
@@ -313,22 +574,10 @@ bool SkMatrixConvolutionImageFilter::onFilterImage(Proxy* proxy,
     offset->fX = bounds.fLeft;
     offset->fY = bounds.fTop;
     bounds.offset(-srcOffset);
-    SkIRect interior = SkIRect::MakeXYWH(bounds.left() + fKernelOffset.fX,
-                                         bounds.top() + fKernelOffset.fY,
-                                         bounds.width() - fKernelSize.fWidth + 1,
-                                         bounds.height() - fKernelSize.fHeight + 1);
-    SkIRect top = SkIRect::MakeLTRB(bounds.left(), bounds.top(), bounds.right(), interior.top());
-    SkIRect bottom = SkIRect::MakeLTRB(bounds.left(), interior.bottom(),
-                                       bounds.right(), bounds.bottom());
-    SkIRect left = SkIRect::MakeLTRB(bounds.left(), interior.top(),
-                                     interior.left(), interior.bottom());
-    SkIRect right = SkIRect::MakeLTRB(interior.right(), interior.top(),
-                                      bounds.right(), interior.bottom());
-    filterBorderPixels(src, result, top, bounds);
-    filterBorderPixels(src, result, left, bounds);
-    filterInteriorPixels(src, result, interior, bounds);
-    filterBorderPixels(src, result, right, bounds);
-    filterBorderPixels(src, result, bottom, bounds);
+
+    // Large bitmaps are cut into bands of rows, which do not depend on each other.
+    BandTask task(this, src, result, bounds);
+    task.run(bounds.width(), bounds.top(), bounds.bottom());
     return true;
 }
 
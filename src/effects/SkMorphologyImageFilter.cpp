@@ -11,6 +11,7 @@
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkRect.h"
+#include "SkTemplates.h"
 #include "SkMorphology_opts.h"
 #if SK_SUPPORT_GPU
 #include "GrContext.h"
@@ -48,8 +49,28 @@ enum MorphDirection {
     kX, kY
 };
 
-template<MorphDirection direction>
-static void erode(const SkPMColor* src, SkPMColor* dst,
+enum MorphType {
+    kDilate, kErode
+};
+
+template<MorphType type>
+static inline SkPMColor morphPixels(SkPMColor a, SkPMColor b) {
+    if (type == kDilate) {
+        return SkPackARGB32(SkMax32(SkGetPackedA32(a), SkGetPackedA32(b)),
+                            SkMax32(SkGetPackedR32(a), SkGetPackedR32(b)),
+                            SkMax32(SkGetPackedG32(a), SkGetPackedG32(b)),
+                            SkMax32(SkGetPackedB32(a), SkGetPackedB32(b)));
+    } else {
+        return SkPackARGB32(SkMin32(SkGetPackedA32(a), SkGetPackedA32(b)),
+                            SkMin32(SkGetPackedR32(a), SkGetPackedR32(b)),
+                            SkMin32(SkGetPackedG32(a), SkGetPackedG32(b)),
+                            SkMin32(SkGetPackedB32(a), SkGetPackedB32(b)));
+    }
+}
+
+// The van Herk/Gil-Werman algorithm, whose cost per pixel does not depend on the radius.
+template<MorphType type, MorphDirection direction>
+static void morph(const SkPMColor* src, SkPMColor* dst,
                   int radius, int width, int height,
                   int srcStride, int dstStride)
 {
@@ -58,70 +79,55 @@ static void erode(const SkPMColor* src, SkPMColor* dst,
     const int srcStrideY = direction == kX ? srcStride : 1;
     const int dstStrideY = direction == kX ? dstStride : 1;
     radius = SkMin32(radius, width - 1);
-    const SkPMColor* upperSrc = src + radius * srcStrideX;
-    for (int x = 0; x < width; ++x) {
-        const SkPMColor* lp = src;
-        const SkPMColor* up = upperSrc;
-        SkPMColor* dptr = dst;
-        for (int y = 0; y < height; ++y) {
-            int minB = 255, minG = 255, minR = 255, minA = 255;
-            for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                int b = SkGetPackedB32(*p);
-                int g = SkGetPackedG32(*p);
-                int r = SkGetPackedR32(*p);
-                int a = SkGetPackedA32(*p);
-                if (b < minB) minB = b;
-                if (g < minG) minG = g;
-                if (r < minR) minR = r;
-                if (a < minA) minA = a;
+
+    // Each line is padded with radius pixels on both sides that do not change the result, and
+    // cut into blocks as long as the window. A window then covers the end of one block and the
+    // start of the next, so it is the min or max of a suffix and a prefix of blocks.
+    const int window = 2 * radius + 1;
+    const int padded = width + 2 * radius;
+    const SkPMColor identity = type == kDilate ? 0 : 0xFFFFFFFF;
+    SkAutoSTMalloc<512, SkPMColor> storage(2 * padded);
+    SkPMColor* prefix = storage.get();
+    SkPMColor* suffix = prefix + padded;
+
+    for (int y = 0; y < height; ++y) {
+        for (int p = 0; p < padded; ++p) {
+            const int x = p - radius;
+            suffix[p] = x < 0 || x >= width ? identity : src[x * srcStrideX];
+        }
+        for (int start = 0; start < padded; start += window) {
+            const int end = SkMin32(start + window, padded);
+            prefix[start] = suffix[start];
+            for (int p = start + 1; p < end; ++p) {
+                prefix[p] = morphPixels<type>(prefix[p - 1], suffix[p]);
+            }
+            for (int p = end - 2; p >= start; --p) {
+                suffix[p] = morphPixels<type>(suffix[p + 1], suffix[p]);
             }
-            *dptr = SkPackARGB32(minA, minR, minG, minB);
-            dptr += dstStrideY;
-            lp += srcStrideY;
-            up += srcStrideY;
         }
-        if (x >= radius) src += srcStrideX;
-        if (x + radius < width - 1) upperSrc += srcStrideX;
-        dst += dstStrideX;
+        SkPMColor* dptr = dst;
+        for (int x = 0; x < width; ++x) {
+            *dptr = morphPixels<type>(suffix[x], prefix[x + window - 1]);
+            dptr += dstStrideX;
+        }
+        src += srcStrideY;
+        dst += dstStrideY;
     }
 }
 
-template<MorphDirection direction>
-static void dilate(const SkPMColor* src, SkPMColor* dst,
-                   int radius, int width, int height,
-                   int srcStride, int dstStride)
-{
-    const int srcStrideX = direction == kX ? 1 : srcStride;
-    const int dstStrideX = direction == kX ? 1 : dstStride;
-    const int srcStrideY = direction == kX ? srcStride : 1;
-    const int dstStrideY = direction == kX ? dstStride : 1;
-    radius = SkMin32(radius, width - 1);
-    const SkPMColor* upperSrc = src + radius * srcStrideX;
-    for (int x = 0; x < width; ++x) {
-        const SkPMColor* lp = src;
-        const SkPMColor* up = upperSrc;
-        SkPMColor* dptr = dst;
-        for (int y = 0; y < height; ++y) {
-            int maxB = 0, maxG = 0, maxR = 0, maxA = 0;
-            for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                int b = SkGetPackedB32(*p);
-                int g = SkGetPackedG32(*p);
-                int r = SkGetPackedR32(*p);
-                int a = SkGetPackedA32(*p);
-                if (b > maxB) maxB = b;
-                if (g > maxG) maxG = g;
-                if (r > maxR) maxR = r;
-                if (a > maxA) maxA = a;
-            }
-            *dptr = SkPackARGB32(maxA, maxR, maxG, maxB);
-            dptr += dstStrideY;
-            lp += srcStrideY;
-            up += srcStrideY;
-        }
-        if (x >= radius) src += srcStrideX;
-        if (x + radius < width - 1) upperSrc += srcStrideX;
-        dst += dstStrideX;
+SkMorphologyImageFilter::Proc SkMorphologyGetPortableProc(SkMorphologyProcType type) {
+    switch (type) {
+        case kDilateX_SkMorphologyProcType:
+            return morph<kDilate, kX>;
+        case kDilateY_SkMorphologyProcType:
+            return morph<kDilate, kY>;
+        case kErodeX_SkMorphologyProcType:
+            return morph<kErode, kX>;
+        case kErodeY_SkMorphologyProcType:
+            return morph<kErode, kY>;
     }
+    SkASSERT(false);
+    return NULL;
 }
 
 static void callProcX(SkMorphologyImageFilter::Proc procX, const SkBitmap& src, SkBitmap* dst, int radiusX, const SkIRect& bounds)
@@ -213,11 +219,11 @@ bool SkErodeImageFilter::onFilterImage(Proxy* proxy,
                                        SkBitmap* dst, SkIPoint* offset) const {
     Proc erodeXProc = SkMorphologyGetPlatformProc(kErodeX_SkMorphologyProcType);
     if (!erodeXProc) {
-        erodeXProc = erode<kX>;
+        erodeXProc = SkMorphologyGetPortableProc(kErodeX_SkMorphologyProcType);
     }
     Proc erodeYProc = SkMorphologyGetPlatformProc(kErodeY_SkMorphologyProcType);
     if (!erodeYProc) {
-        erodeYProc = erode<kY>;
+        erodeYProc = SkMorphologyGetPortableProc(kErodeY_SkMorphologyProcType);
     }
     return this->filterImageGeneric(erodeXProc, erodeYProc, proxy, source, ctx, dst, offset);
 }
@@ -227,11 +233,11 @@ bool SkDilateImageFilter::onFilterImage(Proxy* proxy,
                                         SkBitmap* dst, SkIPoint* offset) const {
     Proc dilateXProc = SkMorphologyGetPlatformProc(kDilateX_SkMorphologyProcType);
     if (!dilateXProc) {
-        dilateXProc = dilate<kX>;
+        dilateXProc = SkMorphologyGetPortableProc(kDilateX_SkMorphologyProcType);
     }
     Proc dilateYProc = SkMorphologyGetPlatformProc(kDilateY_SkMorphologyProcType);
     if (!dilateYProc) {
-        dilateYProc = dilate<kY>;
+        dilateYProc = SkMorphologyGetPortableProc(kDilateY_SkMorphologyProcType);
     }
     return this->filterImageGeneric(dilateXProc, dilateYProc, proxy, source, ctx, dst, offset);
 }
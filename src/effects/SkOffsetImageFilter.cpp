@@ -65,6 +65,20 @@ bool SkOffsetImageFilter::onFilterImage(Proxy* proxy, const SkBitmap& source,
     return true;
 }
 
+bool SkOffsetImageFilter::asOffset(SkVector* offset) const {
+#ifdef SK_DISABLE_OFFSETIMAGEFILTER_OPTIMIZATION
+    return false;
+#else
+    if (this->cropRectIsSet()) {
+        return false;
+    }
+    if (offset) {
+        *offset = fOffset;
+    }
+    return true;
+#endif
+}
+
 void SkOffsetImageFilter::computeFastBounds(const SkRect& src, SkRect* dst) const {
     if (getInput(0)) {
         getInput(0)->computeFastBounds(src, dst);
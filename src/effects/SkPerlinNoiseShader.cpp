@@ -8,7 +8,10 @@
 #include "SkDither.h"
 #include "SkPerlinNoiseShader.h"
 #include "SkColorFilter.h"
+#include "SkMallocPixelRef.h"
+#include "SkPerlinNoise_opts.h"
 #include "SkReadBuffer.h"
+#include "SkScaledImageCache.h"
 #include "SkWriteBuffer.h"
 #include "SkShader.h"
 #include "SkUnPreMultiply.h"
@@ -111,6 +114,7 @@ struct SkPerlinNoiseShader::PaintingData {
     uint8_t     fLatticeSelector[kBlockSize];
     uint16_t    fNoise[4][kBlockSize][2];
     SkPoint     fGradient[4][kBlockSize];
+    SkPerlinNoiseLattice fLattice;  // fLatticeSelector and fGradient, for the span procs
     SkISize     fTileSize;
     SkVector    fBaseFrequency;
     StitchData  fStitchDataInit;
@@ -204,6 +208,20 @@ private:
                     fGradient[channel][i].fY + SK_Scalar1, gHalfMax16bits));
             }
         }
+
+        // The channels are red, green, blue and alpha, put them in the order of SkPMColor.
+        static const int gLanes[4] = {
+            SK_R32_SHIFT / 8, SK_G32_SHIFT / 8, SK_B32_SHIFT / 8, SK_A32_SHIFT / 8
+        };
+        SK_COMPILE_ASSERT(sizeof(fLattice.fSelector) == sizeof(fLatticeSelector),
+                          lattice_size_mismatch);
+        memcpy(fLattice.fSelector, fLatticeSelector, sizeof(fLatticeSelector));
+        for (int channel = 0; channel < 4; ++channel) {
+            for (int i = 0; i < kBlockSize; ++i) {
+                fLattice.fGradientX[i][gLanes[channel]] = fGradient[channel][i].fX;
+                fLattice.fGradientY[i][gLanes[channel]] = fGradient[channel][i].fY;
+            }
+        }
     }
 
     // Only called once. Could be part of the constructor.
@@ -336,120 +354,103 @@ void SkPerlinNoiseShader::flatten(SkWriteBuffer& buffer) const {
     buffer.writeInt(fTileSize.fHeight);
 }
 
-SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::noise2D(
-        int channel, const StitchData& stitchData, const SkPoint& noiseVector) const {
-    struct Noise {
-        int noisePositionIntegerValue;
-        int nextNoisePositionIntegerValue;
-        SkScalar noisePositionFractionValue;
-        Noise(SkScalar component)
-        {
-            SkScalar position = component + kPerlinNoise;
-            noisePositionIntegerValue = SkScalarFloorToInt(position);
-            noisePositionFractionValue = position - SkIntToScalar(noisePositionIntegerValue);
-            nextNoisePositionIntegerValue = noisePositionIntegerValue + 1;
-        }
-    };
-    Noise noiseX(noiseVector.x());
-    Noise noiseY(noiseVector.y());
-    SkScalar u, v;
-    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
-    // If stitching, adjust lattice points accordingly.
-    if (perlinNoiseShader.fStitchTiles) {
-        noiseX.noisePositionIntegerValue =
-            checkNoise(noiseX.noisePositionIntegerValue, stitchData.fWrapX, stitchData.fWidth);
-        noiseY.noisePositionIntegerValue =
-            checkNoise(noiseY.noisePositionIntegerValue, stitchData.fWrapY, stitchData.fHeight);
-        noiseX.nextNoisePositionIntegerValue =
-            checkNoise(noiseX.nextNoisePositionIntegerValue, stitchData.fWrapX, stitchData.fWidth);
-        noiseY.nextNoisePositionIntegerValue =
-            checkNoise(noiseY.nextNoisePositionIntegerValue, stitchData.fWrapY, stitchData.fHeight);
-    }
-    noiseX.noisePositionIntegerValue &= kBlockMask;
-    noiseY.noisePositionIntegerValue &= kBlockMask;
-    noiseX.nextNoisePositionIntegerValue &= kBlockMask;
-    noiseY.nextNoisePositionIntegerValue &= kBlockMask;
-    int i =
-        fPaintingData->fLatticeSelector[noiseX.noisePositionIntegerValue];
-    int j =
-        fPaintingData->fLatticeSelector[noiseX.nextNoisePositionIntegerValue];
-    int b00 = (i + noiseY.noisePositionIntegerValue) & kBlockMask;
-    int b10 = (j + noiseY.noisePositionIntegerValue) & kBlockMask;
-    int b01 = (i + noiseY.nextNoisePositionIntegerValue) & kBlockMask;
-    int b11 = (j + noiseY.nextNoisePositionIntegerValue) & kBlockMask;
-    SkScalar sx = smoothCurve(noiseX.noisePositionFractionValue);
-    SkScalar sy = smoothCurve(noiseY.noisePositionFractionValue);
-    // This is taken 1:1 from SVG spec: http://www.w3.org/TR/SVG11/filters.html#feTurbulenceElement
-    SkPoint fractionValue = SkPoint::Make(noiseX.noisePositionFractionValue,
-                                          noiseY.noisePositionFractionValue); // Offset (0,0)
-    u = fPaintingData->fGradient[channel][b00].dot(fractionValue);
-    fractionValue.fX -= SK_Scalar1; // Offset (-1,0)
-    v = fPaintingData->fGradient[channel][b10].dot(fractionValue);
-    SkScalar a = SkScalarInterp(u, v, sx);
-    fractionValue.fY -= SK_Scalar1; // Offset (-1,-1)
-    v = fPaintingData->fGradient[channel][b11].dot(fractionValue);
-    fractionValue.fX = noiseX.noisePositionFractionValue; // Offset (0,-1)
-    u = fPaintingData->fGradient[channel][b01].dot(fractionValue);
-    SkScalar b = SkScalarInterp(u, v, sx);
-    return SkScalarInterp(a, b, sy);
-}
+namespace {
 
-SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::calculateTurbulenceValueForPoint(
-        int channel, StitchData& stitchData, const SkPoint& point) const {
-    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
-    if (perlinNoiseShader.fStitchTiles) {
-        // Set up TurbulenceInitial stitch values.
-        stitchData = fPaintingData->fStitchDataInit;
-    }
-    SkScalar turbulenceFunctionResult = 0;
-    SkPoint noiseVector(SkPoint::Make(SkScalarMul(point.x(), fPaintingData->fBaseFrequency.fX),
-                                      SkScalarMul(point.y(), fPaintingData->fBaseFrequency.fY)));
-    SkScalar ratio = SK_Scalar1;
-    for (int octave = 0; octave < perlinNoiseShader.fNumOctaves; ++octave) {
-        SkScalar noise = noise2D(channel, stitchData, noiseVector);
-        turbulenceFunctionResult += SkScalarDiv(
-            (perlinNoiseShader.fType == kFractalNoise_Type) ? noise : SkScalarAbs(noise), ratio);
-        noiseVector.fX *= 2;
-        noiseVector.fY *= 2;
-        ratio *= 2;
-        if (perlinNoiseShader.fStitchTiles) {
-            // Update stitch values
-            stitchData.fWidth  *= 2;
-            stitchData.fWrapX   = stitchData.fWidth + kPerlinNoise;
-            stitchData.fHeight *= 2;
-            stitchData.fWrapY   = stitchData.fHeight + kPerlinNoise;
+// A coordinate's position on the lattice, for one octave.
+struct Noise {
+    int noisePositionIntegerValue;
+    int nextNoisePositionIntegerValue;
+    SkScalar noisePositionFractionValue;
+    Noise(SkScalar component, bool stitch, int stitchSize)
+    {
+        SkScalar position = component + kPerlinNoise;
+        noisePositionIntegerValue = SkScalarFloorToInt(position);
+        noisePositionFractionValue = position - SkIntToScalar(noisePositionIntegerValue);
+        nextNoisePositionIntegerValue = noisePositionIntegerValue + 1;
+        // If stitching, adjust lattice points accordingly.
+        if (stitch) {
+            const int limit = stitchSize + kPerlinNoise;
+            noisePositionIntegerValue =
+                checkNoise(noisePositionIntegerValue, limit, stitchSize);
+            nextNoisePositionIntegerValue =
+                checkNoise(nextNoisePositionIntegerValue, limit, stitchSize);
         }
+        noisePositionIntegerValue &= kBlockMask;
+        nextNoisePositionIntegerValue &= kBlockMask;
     }
+};
 
-    // The value of turbulenceFunctionResult comes from ((turbulenceFunctionResult) + 1) / 2
-    // by fractalNoise and (turbulenceFunctionResult) by turbulence.
-    if (perlinNoiseShader.fType == kFractalNoise_Type) {
-        turbulenceFunctionResult =
-            SkScalarMul(turbulenceFunctionResult, SK_ScalarHalf) + SK_ScalarHalf;
-    }
+} // end namespace
 
-    if (channel == 3) { // Scale alpha by paint value
-        turbulenceFunctionResult = SkScalarMul(turbulenceFunctionResult,
-            SkScalarDiv(SkIntToScalar(getPaintAlpha()), SkIntToScalar(255)));
-    }
+// The portable SkPerlinNoiseSpanProc. The noise of the four channels share their positions on
+// the lattice, so each octave finds those once for all of them.
+static void perlin_noise_span(const SkPerlinNoiseSpan& span, SkPMColor dst[], int count) {
+    const SkPerlinNoiseLattice& lattice = *span.fLattice;
+    for (int x = 0; x < count; ++x) {
+        SkPoint noiseVector = SkPoint::Make(
+                SkScalarMul(span.fX + SkIntToScalar(x), span.fFrequencyX),
+                SkScalarMul(span.fY, span.fFrequencyY));
+        int stitchWidth = span.fStitchWidth;
+        int stitchHeight = span.fStitchHeight;
+        SkScalar ratio = SK_Scalar1;
+        SkScalar turbulenceFunctionResult[4] = { 0, 0, 0, 0 };
+        for (int octave = 0; octave < span.fNumOctaves; ++octave) {
+            Noise noiseX(noiseVector.fX, span.fStitch, stitchWidth);
+            Noise noiseY(noiseVector.fY, span.fStitch, stitchHeight);
+            int i = lattice.fSelector[noiseX.noisePositionIntegerValue];
+            int j = lattice.fSelector[noiseX.nextNoisePositionIntegerValue];
+            int b00 = (i + noiseY.noisePositionIntegerValue) & kBlockMask;
+            int b10 = (j + noiseY.noisePositionIntegerValue) & kBlockMask;
+            int b01 = (i + noiseY.nextNoisePositionIntegerValue) & kBlockMask;
+            int b11 = (j + noiseY.nextNoisePositionIntegerValue) & kBlockMask;
+            SkScalar sx = smoothCurve(noiseX.noisePositionFractionValue);
+            SkScalar sy = smoothCurve(noiseY.noisePositionFractionValue);
+            SkScalar fx = noiseX.noisePositionFractionValue;
+            SkScalar fy = noiseY.noisePositionFractionValue;
+            // This is taken 1:1 from SVG spec: http://www.w3.org/TR/SVG11/filters.html#feTurbulenceElement
+            for (int lane = 0; lane < 4; ++lane) {
+                SkScalar u = lattice.fGradientX[b00][lane] * fx +
+                             lattice.fGradientY[b00][lane] * fy;                   // Offset (0,0)
+                SkScalar v = lattice.fGradientX[b10][lane] * (fx - SK_Scalar1) +
+                             lattice.fGradientY[b10][lane] * fy;                   // Offset (-1,0)
+                SkScalar a = SkScalarInterp(u, v, sx);
+                v = lattice.fGradientX[b11][lane] * (fx - SK_Scalar1) +
+                    lattice.fGradientY[b11][lane] * (fy - SK_Scalar1);           // Offset (-1,-1)
+                u = lattice.fGradientX[b01][lane] * fx +
+                    lattice.fGradientY[b01][lane] * (fy - SK_Scalar1);           // Offset (0,-1)
+                SkScalar b = SkScalarInterp(u, v, sx);
+                SkScalar noise = SkScalarInterp(a, b, sy);
+                turbulenceFunctionResult[lane] += SkScalarDiv(
+                    span.fFractalNoise ? noise : SkScalarAbs(noise), ratio);
+            }
+            noiseVector.fX *= 2;
+            noiseVector.fY *= 2;
+            ratio *= 2;
+            stitchWidth *= 2;
+            stitchHeight *= 2;
+        }
 
-    // Clamp result
-    return SkScalarPin(turbulenceFunctionResult, 0, SK_Scalar1);
+        U8CPU rgba[4];
+        for (int lane = 0; lane < 4; ++lane) {
+            SkScalar value = turbulenceFunctionResult[lane];
+            // The value of turbulenceFunctionResult comes from ((turbulenceFunctionResult) + 1) / 2
+            // by fractalNoise and (turbulenceFunctionResult) by turbulence.
+            if (span.fFractalNoise) {
+                value = SkScalarMul(value, SK_ScalarHalf) + SK_ScalarHalf;
+            }
+            if (SK_A32_SHIFT / 8 == lane) { // Scale alpha by paint value
+                value = SkScalarMul(value, span.fAlphaScale);
+            }
+            // Clamp result
+            rgba[lane] = SkScalarFloorToInt(255 * SkScalarPin(value, 0, SK_Scalar1));
+        }
+        dst[x] = SkPreMultiplyARGB(rgba[SK_A32_SHIFT / 8], rgba[SK_R32_SHIFT / 8],
+                                   rgba[SK_G32_SHIFT / 8], rgba[SK_B32_SHIFT / 8]);
+    }
 }
 
-SkPMColor SkPerlinNoiseShader::PerlinNoiseShaderContext::shade(
-        const SkPoint& point, StitchData& stitchData) const {
-    SkPoint newPoint;
-    fMatrix.mapPoints(&newPoint, &point, 1);
-    newPoint.fX = SkScalarRoundToScalar(newPoint.fX);
-    newPoint.fY = SkScalarRoundToScalar(newPoint.fY);
-
-    U8CPU rgba[4];
-    for (int channel = 3; channel >= 0; --channel) {
-        rgba[channel] = SkScalarFloorToInt(255 *
-            calculateTurbulenceValueForPoint(channel, stitchData, newPoint));
-    }
-    return SkPreMultiplyARGB(rgba[3], rgba[0], rgba[1], rgba[2]);
+SkPerlinNoiseSpanProc SkPerlinNoiseGetPortableSpanProc() {
+    return perlin_noise_span;
 }
 
 SkShader::Context* SkPerlinNoiseShader::onCreateContext(const ContextRec& rec,
@@ -464,6 +465,8 @@ size_t SkPerlinNoiseShader::contextSize() const {
 SkPerlinNoiseShader::PerlinNoiseShaderContext::PerlinNoiseShaderContext(
         const SkPerlinNoiseShader& shader, const ContextRec& rec)
     : INHERITED(shader, rec)
+    , fTilePixelRef(NULL)
+    , fTileInited(false)
 {
     SkMatrix newMatrix = *rec.fMatrix;
     newMatrix.preConcat(shader.getLocalMatrix());
@@ -474,32 +477,163 @@ SkPerlinNoiseShader::PerlinNoiseShaderContext::PerlinNoiseShaderContext(
     // (as opposed to 0 based, usually). The same adjustment is in the setData() function.
     fMatrix.setTranslate(-newMatrix.getTranslateX() + SK_Scalar1, -newMatrix.getTranslateY() + SK_Scalar1);
     fPaintingData = SkNEW_ARGS(PaintingData, (shader.fTileSize, shader.fSeed, shader.fBaseFrequencyX, shader.fBaseFrequencyY, newMatrix));
+
+    fSpanProc = SkPerlinNoiseGetPlatformSpanProc();
+    if (NULL == fSpanProc) {
+        fSpanProc = perlin_noise_span;
+    }
 }
 
 SkPerlinNoiseShader::PerlinNoiseShaderContext::~PerlinNoiseShaderContext() {
     SkDELETE(fPaintingData);
+    SkSafeUnref(fTilePixelRef);
+}
+
+void SkPerlinNoiseShader::PerlinNoiseShaderContext::initSpan(SkPerlinNoiseSpan* span) const {
+    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
+    span->fLattice = &fPaintingData->fLattice;
+    span->fFrequencyX = fPaintingData->fBaseFrequency.fX;
+    span->fFrequencyY = fPaintingData->fBaseFrequency.fY;
+    span->fNumOctaves = perlinNoiseShader.fNumOctaves;
+    span->fFractalNoise = kFractalNoise_Type == perlinNoiseShader.fType;
+    span->fStitch = perlinNoiseShader.fStitchTiles;
+    span->fStitchWidth = fPaintingData->fStitchDataInit.fWidth;
+    span->fStitchHeight = fPaintingData->fStitchDataInit.fHeight;
+    span->fAlphaScale = SkScalarDiv(SkIntToScalar(this->getPaintAlpha()), SkIntToScalar(255));
+}
+
+void SkPerlinNoiseShader::PerlinNoiseShaderContext::shadeNoise(
+        int x, int y, SkPMColor result[], int count) const {
+    SkPerlinNoiseSpan span;
+    this->initSpan(&span);
+    span.fX = SkIntToScalar(x);
+    span.fY = SkIntToScalar(y);
+    fSpanProc(span, result, count);
+}
+
+namespace {
+
+// Tiles larger than this are computed for every draw instead of taking over the cache.
+const int kMaxCachedTileArea = 256 * 256;
+
+/*
+ *  Identifies the colors of a tile of stitched noise in SkScaledImageCache. The lattice of the
+ *  noise depends only on the seed.
+ */
+struct PerlinNoiseTileKey : public SkScaledImageCache::Key {
+public:
+    PerlinNoiseTileKey(const SkPerlinNoiseSpan& span, SkScalar seed, const SkISize& tileSize)
+    : fTag(SkSetFourByteTag('p', 'e', 'r', 'l'))
+    , fSeed(seed)
+    , fFrequencyX(span.fFrequencyX)
+    , fFrequencyY(span.fFrequencyY)
+    , fNumOctaves(span.fNumOctaves)
+    , fFractalNoise(span.fFractalNoise)
+    , fStitchWidth(span.fStitchWidth)
+    , fStitchHeight(span.fStitchHeight)
+    , fAlphaScale(span.fAlphaScale)
+    , fTileSize(tileSize)
+    {
+        this->init(sizeof(fTag) + sizeof(fSeed) + sizeof(fFrequencyX) + sizeof(fFrequencyY) +
+                   sizeof(fNumOctaves) + sizeof(fFractalNoise) + sizeof(fStitchWidth) +
+                   sizeof(fStitchHeight) + sizeof(fAlphaScale) + sizeof(fTileSize));
+    }
+
+    uint32_t    fTag;
+    SkScalar    fSeed;
+    SkScalar    fFrequencyX;
+    SkScalar    fFrequencyY;
+    int32_t     fNumOctaves;
+    int32_t     fFractalNoise;
+    int32_t     fStitchWidth;
+    int32_t     fStitchHeight;
+    SkScalar    fAlphaScale;
+    SkISize     fTileSize;
+};
+
+} // end namespace
+
+const SkPMColor* SkPerlinNoiseShader::PerlinNoiseShaderContext::getTile() {
+    if (!fTileInited) {
+        fTileInited = true;
+
+        const SkPerlinNoiseShader& perlinNoiseShader =
+            static_cast<const SkPerlinNoiseShader&>(fShader);
+        const SkISize& tileSize = fPaintingData->fTileSize;
+        if (!perlinNoiseShader.fStitchTiles || tileSize.isEmpty() ||
+            sk_64_mul(tileSize.width(), tileSize.height()) > kMaxCachedTileArea) {
+            return NULL;
+        }
+
+        SkPerlinNoiseSpan span;
+        this->initSpan(&span);
+        const PerlinNoiseTileKey key(span, perlinNoiseShader.fSeed, tileSize);
+        SkBitmap tile;
+        SkScaledImageCache::ID* id = SkScaledImageCache::FindAndLock(key, &tile);
+        if (id) {
+            // Only stitched noise adds tiles under its keys, always in an immutable
+            // SkMallocPixelRef, whose pixels stay put while we hold a ref.
+            fTilePixelRef = static_cast<SkMallocPixelRef*>(tile.pixelRef());
+            SkASSERT(fTilePixelRef && fTilePixelRef->isImmutable());
+            fTilePixelRef->ref();
+            SkScaledImageCache::Unlock(id);
+        } else {
+            fTilePixelRef = SkMallocPixelRef::NewAllocate(SkImageInfo::MakeN32Premul(tileSize),
+                                                          0, NULL);
+            if (fTilePixelRef) {
+                SkPMColor* pixels = static_cast<SkPMColor*>(fTilePixelRef->getAddr());
+                for (int y = 0; y < tileSize.height(); ++y) {
+                    this->shadeNoise(1, y + 1, pixels + y * tileSize.width(), tileSize.width());
+                }
+                fTilePixelRef->setImmutable();
+                tile.setInfo(fTilePixelRef->info());
+                tile.setPixelRef(fTilePixelRef);
+                SkScaledImageCache::Unlock(SkScaledImageCache::AddAndLock(key, tile));
+            }
+        }
+    }
+    return fTilePixelRef ? static_cast<const SkPMColor*>(fTilePixelRef->getAddr()) : NULL;
 }
 
 void SkPerlinNoiseShader::PerlinNoiseShaderContext::shadeSpan(
         int x, int y, SkPMColor result[], int count) {
-    SkPoint point = SkPoint::Make(SkIntToScalar(x), SkIntToScalar(y));
-    StitchData stitchData;
-    for (int i = 0; i < count; ++i) {
-        result[i] = shade(point, stitchData);
-        point.fX += SK_Scalar1;
+    SkPoint point;
+    fMatrix.mapXY(SkIntToScalar(x), SkIntToScalar(y), &point);
+    const int noiseX = SkScalarRoundToInt(point.fX);
+    const int noiseY = SkScalarRoundToInt(point.fY);
+
+    // The tile starts at the noise point (1, 1), drawn by the shader's origin.
+    const SkISize& tileSize = fPaintingData->fTileSize;
+    const int row = noiseY - 1;
+    const int begin = SkTMax(1 - noiseX, 0);
+    const int end = SkTMin(tileSize.width() + 1 - noiseX, count);
+    if (row >= 0 && row < tileSize.height() && begin < end) {
+        const SkPMColor* tile = this->getTile();
+        if (tile) {
+            this->shadeNoise(noiseX, noiseY, result, begin);
+            memcpy(result + begin, tile + row * tileSize.width() + noiseX + begin - 1,
+                   (end - begin) * sizeof(SkPMColor));
+            this->shadeNoise(noiseX + end, noiseY, result + end, count - end);
+            return;
+        }
     }
+    this->shadeNoise(noiseX, noiseY, result, count);
 }
 
 void SkPerlinNoiseShader::PerlinNoiseShaderContext::shadeSpan16(
         int x, int y, uint16_t result[], int count) {
-    SkPoint point = SkPoint::Make(SkIntToScalar(x), SkIntToScalar(y));
-    StitchData stitchData;
+    SkPMColor colors[64];
     DITHER_565_SCAN(y);
-    for (int i = 0; i < count; ++i) {
-        unsigned dither = DITHER_VALUE(x);
-        result[i] = SkDitherRGB32To565(shade(point, stitchData), dither);
-        DITHER_INC_X(x);
-        point.fX += SK_Scalar1;
+    while (count > 0) {
+        const int n = SkTMin(count, (int)SK_ARRAY_COUNT(colors));
+        this->shadeSpan(x, y, colors, n);
+        for (int i = 0; i < n; ++i) {
+            unsigned dither = DITHER_VALUE(x);
+            result[i] = SkDitherRGB32To565(colors[i], dither);
+            DITHER_INC_X(x);
+        }
+        result += n;
+        count -= n;
     }
 }
 
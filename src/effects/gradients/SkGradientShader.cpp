@@ -8,6 +8,7 @@
 #include "SkGradientShaderPriv.h"
 #include "SkLinearGradient.h"
 #include "SkRadialGradient.h"
+#include "SkScaledImageCache.h"
 #include "SkTwoPointRadialGradient.h"
 #include "SkTwoPointConicalGradient.h"
 #include "SkSweepGradient.h"
@@ -348,10 +349,82 @@ bool SkGradientShaderBase::onAsLuminanceColor(SkColor* lum) const {
     return true;
 }
 
+// The portable SkGradientInterpolateProc.
+static void interpolate_span(const SkGradientStop stops[], int stopCount, bool premultiply,
+                             const float t[], const float dither[2], SkPMColor dstC[],
+                             int count) {
+    const int kA = SK_A32_SHIFT / 8;
+    const int lastSegment = stopCount - 2;
+    int index = 0;
+    for (int n = 0; n < count; ++n) {
+        const float pos = t[n];
+        if (SkScalarIsNaN(pos)) {
+            dstC[n] = 0;
+            continue;
+        }
+        // Positions are mostly coherent, so walk from the previous pixel's stop.
+        while (index > 0 && pos < stops[index].fPos) {
+            --index;
+        }
+        while (index < lastSegment && pos >= stops[index + 1].fPos) {
+            ++index;
+        }
+
+        const SkGradientStop& stop = stops[index];
+        const float dt = pos - stop.fPos;
+        const float bias = dither[n & 1];
+        int c[4];
+        for (int k = 0; k < 4; ++k) {
+            c[k] = SkPin32((int)(stop.fColor[k] + dt * stop.fSlope[k] + bias), 0, 255);
+        }
+        if (premultiply) {
+            for (int k = 0; k < 4; ++k) {
+                if (k != kA) {
+                    c[k] = SkMulDiv255Round(c[k], c[kA]);
+                }
+            }
+        }
+        dstC[n] = c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+    }
+}
+
+// Tiles gradient positions in float, like gTileProcs do in SkFixed. NaN stays NaN.
+static void tile_positions(SkShader::TileMode tileMode, float t[], int count) {
+    switch (tileMode) {
+        case SkShader::kClamp_TileMode:
+            for (int i = 0; i < count; ++i) {
+                if (t[i] < 0) {
+                    t[i] = 0;
+                } else if (t[i] > 1) {
+                    t[i] = 1;
+                }
+            }
+            break;
+        case SkShader::kRepeat_TileMode:
+            for (int i = 0; i < count; ++i) {
+                t[i] -= sk_float_floor(t[i]);
+            }
+            break;
+        case SkShader::kMirror_TileMode:
+            for (int i = 0; i < count; ++i) {
+                const float m = t[i] - 2 * sk_float_floor(t[i] * 0.5f);
+                t[i] = m > 1 ? 2 - m : m;
+            }
+            break;
+        default:
+            SkDEBUGFAIL("unknown tile mode");
+            break;
+    }
+}
+
 SkGradientShaderBase::GradientShaderBaseContext::GradientShaderBaseContext(
         const SkGradientShaderBase& shader, const ContextRec& rec)
     : INHERITED(shader, rec)
     , fCache(shader.refCache(getPaintAlpha()))
+    , fTileMode(shader.fTileMode)
+    , fStopCount(0)
+    , fPremultiplyStops(false)
+    , fInterpolateProc(NULL)
 {
     const SkMatrix& inverse = this->getTotalInverse();
 
@@ -372,6 +445,101 @@ SkGradientShaderBase::GradientShaderBaseContext::GradientShaderBaseContext(
     if (shader.fColorsAreOpaque) {
         fFlags |= kHasSpan16_Flag;
     }
+
+    if (SkGradientShader::kInterpolateColorsPerPixel_Flag & shader.fGradFlags) {
+        this->initStops(shader);
+    }
+}
+
+void SkGradientShaderBase::GradientShaderBaseContext::initStops(
+        const SkGradientShaderBase& shader) {
+    const bool interpInPremul = SkToBool(SkGradientShader::kInterpolateColorsInPremul_Flag &
+                                         shader.fGradFlags);
+    const float paintAlpha = (float)this->getPaintAlpha();
+    const int count = shader.fColorCount;
+
+    SkGradientStop* stops = fStops.reset(count);
+    float prevPos = 0;
+    for (int i = 0; i < count; ++i) {
+        const SkColor c = shader.fOrigColors[i];
+        const float a = SkColorGetA(c) * paintAlpha / 255;
+        const float scale = interpInPremul ? a / 255 : 1;
+        stops[i].fColor[SK_A32_SHIFT / 8] = a;
+        stops[i].fColor[SK_R32_SHIFT / 8] = SkColorGetR(c) * scale;
+        stops[i].fColor[SK_G32_SHIFT / 8] = SkColorGetG(c) * scale;
+        stops[i].fColor[SK_B32_SHIFT / 8] = SkColorGetB(c) * scale;
+
+        // Like the caches, which skip segments that are out of order.
+        const float pos = shader.fOrigPos ? SkScalarToFloat(shader.fOrigPos[i])
+                                          : (float)i / (count - 1);
+        stops[i].fPos = prevPos = SkTMax(pos, prevPos);
+    }
+    for (int i = 0; i < count; ++i) {
+        const float width = i < count - 1 ? stops[i + 1].fPos - stops[i].fPos : 0;
+        for (int k = 0; k < 4; ++k) {
+            stops[i].fSlope[k] = width > 0 ? (stops[i + 1].fColor[k] - stops[i].fColor[k]) / width
+                                           : 0;
+        }
+    }
+
+    fStopCount = count;
+    // Opaque colors need no premultiplying.
+    fPremultiplyStops = !interpInPremul && !(fFlags & kOpaqueAlpha_Flag);
+    fInterpolateProc = SkGradientGetPlatformInterpolateProc();
+    if (NULL == fInterpolateProc) {
+        fInterpolateProc = interpolate_span;
+    }
+}
+
+void SkGradientShaderBase::GradientShaderBaseContext::interpolateSpan(int x, int y,
+                                                                      SkPMColor dstC[],
+                                                                      int count) {
+    // The biases of the cache's four dither rows, see Build32bitCache().
+    static const float gDitherBias[4] = { 1/8.f, 5/8.f, 7/8.f, 3/8.f };
+    enum { kBatchCount = 64 };
+
+    SkASSERT(fInterpolateProc);
+    SkPoint pts[kBatchCount];
+    float t[kBatchCount];
+    const SkScalar fy = SkIntToScalar(y) + SK_ScalarHalf;
+    while (count > 0) {
+        const int n = SkMin32(count, kBatchCount);
+        const SkScalar fx = SkIntToScalar(x) + SK_ScalarHalf;
+        if (kLinear_MatrixClass == fDstToIndexClass) {
+            SkPoint start;
+            fDstToIndexProc(fDstToIndex, fx, fy, &start);
+            const SkScalar dx = fDstToIndex.getScaleX();
+            const SkScalar dy = fDstToIndex.getSkewY();
+            for (int i = 0; i < n; ++i) {
+                pts[i].set(start.fX + i * dx, start.fY + i * dy);
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                pts[i].set(fx + i, fy);
+            }
+            fDstToIndex.mapPoints(pts, n);
+        }
+        this->mapToPositions(pts, t, n);
+        tile_positions(fTileMode, t, n);
+
+        const float dither[2] = {
+            gDitherBias[(x & 1) | ((y & 1) << 1)],
+            gDitherBias[((x + 1) & 1) | ((y & 1) << 1)],
+        };
+        fInterpolateProc(fStops.get(), fStopCount, fPremultiplyStops, t, dither, dstC, n);
+
+        x += n;
+        dstC += n;
+        count -= n;
+    }
+}
+
+void SkGradientShaderBase::GradientShaderBaseContext::mapToPositions(const SkPoint[], float t[],
+                                                                     int count) const {
+    SkDEBUGFAIL("this gradient does not interpolate per pixel");
+    for (int i = 0; i < count; ++i) {
+        t[i] = SK_FloatNaN;
+    }
 }
 
 SkGradientShaderBase::GradientShaderCache::GradientShaderCache(
@@ -384,15 +552,82 @@ SkGradientShaderBase::GradientShaderCache::GradientShaderCache(
     // Only initialize the cache in getCache16/32.
     fCache16 = NULL;
     fCache32 = NULL;
-    fCache16Storage = NULL;
+    fCache16PixelRef = NULL;
     fCache32PixelRef = NULL;
 }
 
 SkGradientShaderBase::GradientShaderCache::~GradientShaderCache() {
-    sk_free(fCache16Storage);
+    SkSafeUnref(fCache16PixelRef);
     SkSafeUnref(fCache32PixelRef);
 }
 
+class SkGradientShaderBase::GradientShaderCache::TableKey : ::SkNoncopyable {
+public:
+    TableKey(const SkGradientShaderBase& shader, SkFourByteTag tag, U8CPU alpha,
+             uint32_t gradFlags) {
+        const int colorCount = shader.fColorCount;
+        // With 2 colors the positions are always 0 and 1, and fRecs is not used.
+        const int posCount = colorCount > 2 ? colorCount - 1 : 0;
+        const int contentCount32 = 4 + colorCount + posCount;
+
+        SK_COMPILE_ASSERT(SkAlign4(sizeof(SkScaledImageCache::Key)) ==
+                          sizeof(SkScaledImageCache::Key), key_header_is_not_aligned);
+        fStorage.reset(sizeof(SkScaledImageCache::Key) / sizeof(uint32_t) + contentCount32);
+
+        SkScaledImageCache::Key* key = this->writableKey();
+        uint32_t* contents = static_cast<uint32_t*>(key->writableContents());
+        *contents++ = tag;
+        *contents++ = alpha;
+        *contents++ = gradFlags;
+        *contents++ = colorCount;
+        for (int i = 0; i < colorCount; ++i) {
+            *contents++ = shader.fOrigColors[i];
+        }
+        for (int i = 1; i <= posCount; ++i) {
+            *contents++ = shader.fRecs[i].fPos;
+        }
+        key->init(contentCount32 * sizeof(uint32_t));
+    }
+
+    const SkScaledImageCache::Key& get() const {
+        return *reinterpret_cast<const SkScaledImageCache::Key*>(fStorage.get());
+    }
+
+private:
+    SkAutoSTMalloc<16, uint32_t> fStorage;
+
+    SkScaledImageCache::Key* writableKey() {
+        return reinterpret_cast<SkScaledImageCache::Key*>(fStorage.get());
+    }
+};
+
+/*
+ *  Returns a ref to the table cached under key, or NULL. Only gradients add tables under their
+ *  keys, always in an immutable SkMallocPixelRef whose pixels stay put for as long as we hold
+ *  the ref, so the cache entry does not need to stay locked.
+ */
+static SkMallocPixelRef* find_table(const SkScaledImageCache::Key& key) {
+    SkBitmap table;
+    SkScaledImageCache::ID* id = SkScaledImageCache::FindAndLock(key, &table);
+    if (NULL == id) {
+        return NULL;
+    }
+    SkMallocPixelRef* pixelRef = static_cast<SkMallocPixelRef*>(table.pixelRef());
+    SkASSERT(pixelRef && pixelRef->isImmutable());
+    pixelRef->ref();
+    SkScaledImageCache::Unlock(id);
+    return pixelRef;
+}
+
+static void add_table(const SkScaledImageCache::Key& key, SkMallocPixelRef* pixelRef) {
+    pixelRef->setImmutable();
+
+    SkBitmap table;
+    table.setInfo(pixelRef->info());
+    table.setPixelRef(pixelRef);
+    SkScaledImageCache::Unlock(SkScaledImageCache::AddAndLock(key, table));
+}
+
 #define Fixed_To_Dot8(x)        (((x) + 0x80) >> 8)
 
 /** We take the original colors, not our premultiplied PMColors, since we can
@@ -589,13 +824,24 @@ const uint16_t* SkGradientShaderBase::GradientShaderCache::getCache16() {
 }
 
 void SkGradientShaderBase::GradientShaderCache::initCache16(GradientShaderCache* cache) {
-    // double the count for dither entries
-    const int entryCount = kCache16Count * 2;
-    const size_t allocSize = sizeof(uint16_t) * entryCount;
+    // The 16bit table ignores alpha and the flags.
+    const TableKey key(cache->fShader, SkSetFourByteTag('g', 'r', '1', '6'), 0, 0);
+
+    SkASSERT(NULL == cache->fCache16PixelRef);
+    cache->fCache16PixelRef = find_table(key.get());
+    if (cache->fCache16PixelRef) {
+        cache->fCache16 = (uint16_t*)cache->fCache16PixelRef->getAddr();
+        return;
+    }
+
+    SkImageInfo info;
+    info.fWidth = kCache16Count;
+    info.fHeight = 2;   // double the count for dither entries
+    info.fAlphaType = kOpaque_SkAlphaType;
+    info.fColorType = kRGB_565_SkColorType;
 
-    SkASSERT(NULL == cache->fCache16Storage);
-    cache->fCache16Storage = (uint16_t*)sk_malloc_throw(allocSize);
-    cache->fCache16 = cache->fCache16Storage;
+    cache->fCache16PixelRef = SkMallocPixelRef::NewAllocate(info, 0, NULL);
+    cache->fCache16 = (uint16_t*)cache->fCache16PixelRef->getAddr();
     if (cache->fShader.fColorCount == 2) {
         Build16bitCache(cache->fCache16, cache->fShader.fOrigColors[0],
                         cache->fShader.fOrigColors[1], kCache16Count);
@@ -612,6 +858,7 @@ void SkGradientShaderBase::GradientShaderCache::initCache16(GradientShaderCache*
             prevIndex = nextIndex;
         }
     }
+    add_table(key.get(), cache->fCache16PixelRef);
 }
 
 const SkPMColor* SkGradientShaderBase::GradientShaderCache::getCache32() {
@@ -622,13 +869,22 @@ const SkPMColor* SkGradientShaderBase::GradientShaderCache::getCache32() {
 }
 
 void SkGradientShaderBase::GradientShaderCache::initCache32(GradientShaderCache* cache) {
+    const TableKey key(cache->fShader, SkSetFourByteTag('g', 'r', '3', '2'), cache->fCacheAlpha,
+                       cache->fShader.fGradFlags);
+
+    SkASSERT(NULL == cache->fCache32PixelRef);
+    cache->fCache32PixelRef = find_table(key.get());
+    if (cache->fCache32PixelRef) {
+        cache->fCache32 = (SkPMColor*)cache->fCache32PixelRef->getAddr();
+        return;
+    }
+
     SkImageInfo info;
     info.fWidth = kCache32Count;
     info.fHeight = 4;   // for our 4 dither rows
     info.fAlphaType = kPremul_SkAlphaType;
     info.fColorType = kN32_SkColorType;
 
-    SkASSERT(NULL == cache->fCache32PixelRef);
     cache->fCache32PixelRef = SkMallocPixelRef::NewAllocate(info, 0, NULL);
     cache->fCache32 = (SkPMColor*)cache->fCache32PixelRef->getAddr();
     if (cache->fShader.fColorCount == 2) {
@@ -649,6 +905,7 @@ void SkGradientShaderBase::GradientShaderCache::initCache32(GradientShaderCache*
             prevIndex = nextIndex;
         }
     }
+    add_table(key.get(), cache->fCache32PixelRef);
 }
 
 /*
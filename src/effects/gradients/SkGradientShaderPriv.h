@@ -10,6 +10,7 @@
 
 #include "SkGradientBitmapCache.h"
 #include "SkGradientShader.h"
+#include "SkGradient_opts.h"
 #include "SkClampRange.h"
 #include "SkColorPriv.h"
 #include "SkReadBuffer.h"
@@ -142,7 +143,7 @@ public:
         uint16_t*   fCache16;
         SkPMColor*  fCache32;
 
-        uint16_t*         fCache16Storage;    // Storage for fCache16, allocated on demand.
+        SkMallocPixelRef* fCache16PixelRef;   // Storage for fCache16, allocated on demand.
         SkMallocPixelRef* fCache32PixelRef;
         const unsigned    fCacheAlpha;        // The alpha value we used when we computed the cache.
                                               // Larger than 8bits so we can store uninitialized
@@ -157,6 +158,10 @@ public:
         static void initCache16(GradientShaderCache* cache);
         static void initCache32(GradientShaderCache* cache);
 
+        // Identifies a table in the global SkScaledImageCache, so that gradients with the same
+        // colors, positions, flags and alpha share one table across shaders and threads.
+        class TableKey;
+
         static void Build16bitCache(uint16_t[], SkColor c0, SkColor c1, int count);
         static void Build32bitCache(SkPMColor[], SkColor c0, SkColor c1, int count,
                                     U8CPU alpha, uint32_t gradFlags);
@@ -176,7 +181,24 @@ public:
 
         SkAutoTUnref<GradientShaderCache> fCache;
 
+        // With SkGradientShader::kInterpolateColorsPerPixel_Flag, shadeSpan() calls
+        // interpolateSpan() instead of reading fCache.
+        bool interpolatesPerPixel() const { return NULL != fInterpolateProc; }
+        void interpolateSpan(int x, int y, SkPMColor dstC[], int count);
+
+        // Writes the untiled gradient positions of count points in fDstToIndex space, or NaN
+        // where the gradient is not drawn. Only called from interpolateSpan().
+        virtual void mapToPositions(const SkPoint pts[], float t[], int count) const;
+
     private:
+        SkShader::TileMode                  fTileMode;
+        SkAutoSTMalloc<4, SkGradientStop>   fStops;
+        int                                 fStopCount;
+        bool                                fPremultiplyStops;
+        SkGradientInterpolateProc           fInterpolateProc;   // NULL when reading fCache
+
+        void initStops(const SkGradientShaderBase& shader);
+
         typedef SkShader::Context INHERITED;
     };
 
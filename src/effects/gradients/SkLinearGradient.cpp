@@ -97,6 +97,7 @@ SkShader::Context* SkLinearGradient::onCreateContext(const ContextRec& rec, void
 SkLinearGradient::LinearGradientContext::LinearGradientContext(
         const SkLinearGradient& shader, const ContextRec& rec)
     : INHERITED(shader, rec)
+    , fSpanProc(SkLinearGradientGetPlatformSpanProc(shader.fTileMode))
 {
     unsigned mask = SkMatrix::kTranslate_Mask | SkMatrix::kScale_Mask;
     if ((fDstToIndex.getType() & ~mask) == 0) {
@@ -121,14 +122,16 @@ SkLinearGradient::LinearGradientContext::LinearGradientContext(
 
 namespace {
 
-typedef void (*LinearShadeProc)(TileProc proc, SkFixed dx, SkFixed fx,
+typedef void (*LinearShadeProc)(TileProc proc, SkLinearGradientSpanProc spanProc,
+                                SkFixed dx, SkFixed fx,
                                 SkPMColor* dstC, const SkPMColor* cache,
                                 int toggle, int count);
 
 // Linear interpolation (lerp) is unnecessary if there are no sharp
 // discontinuities in the gradient - which must be true if there are
 // only 2 colors - but it's cheap.
-void shadeSpan_linear_vertical_lerp(TileProc proc, SkFixed dx, SkFixed fx,
+void shadeSpan_linear_vertical_lerp(TileProc proc, SkLinearGradientSpanProc spanProc,
+                                    SkFixed dx, SkFixed fx,
                                     SkPMColor* SK_RESTRICT dstC,
                                     const SkPMColor* SK_RESTRICT cache,
                                     int toggle, int count) {
@@ -151,7 +154,8 @@ void shadeSpan_linear_vertical_lerp(TileProc proc, SkFixed dx, SkFixed fx,
     sk_memset32_dither(dstC, lerp, dlerp, count);
 }
 
-void shadeSpan_linear_clamp(TileProc proc, SkFixed dx, SkFixed fx,
+void shadeSpan_linear_clamp(TileProc proc, SkLinearGradientSpanProc spanProc,
+                            SkFixed dx, SkFixed fx,
                             SkPMColor* SK_RESTRICT dstC,
                             const SkPMColor* SK_RESTRICT cache,
                             int toggle, int count) {
@@ -188,10 +192,15 @@ void shadeSpan_linear_clamp(TileProc proc, SkFixed dx, SkFixed fx,
     }
 }
 
-void shadeSpan_linear_mirror(TileProc proc, SkFixed dx, SkFixed fx,
+void shadeSpan_linear_mirror(TileProc proc, SkLinearGradientSpanProc spanProc,
+                             SkFixed dx, SkFixed fx,
                              SkPMColor* SK_RESTRICT dstC,
                              const SkPMColor* SK_RESTRICT cache,
                              int toggle, int count) {
+    if (spanProc) {
+        spanProc(fx, dx, dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
+        return;
+    }
     do {
         unsigned fi = mirror_8bits(fx >> 8);
         SkASSERT(fi <= 0xFF);
@@ -201,10 +210,15 @@ void shadeSpan_linear_mirror(TileProc proc, SkFixed dx, SkFixed fx,
     } while (--count != 0);
 }
 
-void shadeSpan_linear_repeat(TileProc proc, SkFixed dx, SkFixed fx,
+void shadeSpan_linear_repeat(TileProc proc, SkLinearGradientSpanProc spanProc,
+                             SkFixed dx, SkFixed fx,
         SkPMColor* SK_RESTRICT dstC,
         const SkPMColor* SK_RESTRICT cache,
         int toggle, int count) {
+    if (spanProc) {
+        spanProc(fx, dx, dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
+        return;
+    }
     do {
         unsigned fi = repeat_8bits(fx >> 8);
         SkASSERT(fi <= 0xFF);
@@ -220,6 +234,11 @@ void SkLinearGradient::LinearGradientContext::shadeSpan(int x, int y, SkPMColor*
                                                         int count) {
     SkASSERT(count > 0);
 
+    if (this->interpolatesPerPixel()) {
+        this->interpolateSpan(x, y, dstC, count);
+        return;
+    }
+
     const SkLinearGradient& linearGradient = static_cast<const SkLinearGradient&>(fShader);
 
     SkPoint             srcPt;
@@ -252,7 +271,7 @@ void SkLinearGradient::LinearGradientContext::shadeSpan(int x, int y, SkPMColor*
         } else {
             SkASSERT(SkShader::kRepeat_TileMode == linearGradient.fTileMode);
         }
-        (*shadeProc)(proc, dx, fx, dstC, cache, toggle, count);
+        (*shadeProc)(proc, fSpanProc, dx, fx, dstC, cache, toggle, count);
     } else {
         SkScalar    dstX = SkIntToScalar(x);
         SkScalar    dstY = SkIntToScalar(y);
@@ -267,6 +286,13 @@ void SkLinearGradient::LinearGradientContext::shadeSpan(int x, int y, SkPMColor*
     }
 }
 
+void SkLinearGradient::LinearGradientContext::mapToPositions(const SkPoint pts[], float t[],
+                                                             int count) const {
+    for (int i = 0; i < count; ++i) {
+        t[i] = SkScalarToFloat(pts[i].fX);
+    }
+}
+
 SkShader::BitmapType SkLinearGradient::asABitmap(SkBitmap* bitmap,
                                                 SkMatrix* matrix,
                                                 TileMode xy[]) const {
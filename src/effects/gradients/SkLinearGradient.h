@@ -9,6 +9,7 @@
 #define SkLinearGradient_DEFINED
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradient_opts.h"
 
 class SkLinearGradient : public SkGradientShaderBase {
 public:
@@ -24,7 +25,13 @@ public:
         virtual void shadeSpan(int x, int y, SkPMColor dstC[], int count) SK_OVERRIDE;
         virtual void shadeSpan16(int x, int y, uint16_t dstC[], int count) SK_OVERRIDE;
 
+    protected:
+        virtual void mapToPositions(const SkPoint pts[], float t[], int count) const SK_OVERRIDE;
+
     private:
+        // The platform's version of the span loop for the tile mode, or NULL.
+        const SkLinearGradientSpanProc fSpanProc;
+
         typedef SkGradientShaderBase::GradientShaderBaseContext INHERITED;
     };
 
@@ -166,7 +166,8 @@ SkShader::Context* SkRadialGradient::onCreateContext(const ContextRec& rec, void
 
 SkRadialGradient::RadialGradientContext::RadialGradientContext(
         const SkRadialGradient& shader, const ContextRec& rec)
-    : INHERITED(shader, rec) {}
+    : INHERITED(shader, rec)
+    , fSpanProc(SkRadialGradientGetPlatformSpanProc(shader.fTileMode)) {}
 
 void SkRadialGradient::RadialGradientContext::shadeSpan16(int x, int y, uint16_t* dstCParam,
                                                           int count) {
@@ -318,13 +319,15 @@ inline bool no_need_for_radial_pin(int fx, int dx,
     fx += dx; \
     fy += dy;
 
-typedef void (* RadialShadeProc)(SkScalar sfx, SkScalar sdx,
+typedef void (* RadialShadeProc)(SkRadialGradientSpanProc spanProc,
+        SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* dstC, const SkPMColor* cache,
         int count, int toggle);
 
 // On Linux, this is faster with SkPMColor[] params than SkPMColor* SK_RESTRICT
-void shadeSpan_radial_clamp(SkScalar sfx, SkScalar sdx,
+void shadeSpan_radial_clamp(SkRadialGradientSpanProc spanProc,
+        SkScalar sfx, SkScalar sdx,
         SkScalar sfy, SkScalar sdy,
         SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
         int count, int toggle) {
@@ -401,15 +404,29 @@ void shadeSpan_radial(SkScalar fx, SkScalar dx, SkScalar fy, SkScalar dy,
     } while (--count != 0);
 }
 
-void shadeSpan_radial_mirror(SkScalar fx, SkScalar dx, SkScalar fy, SkScalar dy,
+void shadeSpan_radial_mirror(SkRadialGradientSpanProc spanProc,
+                             SkScalar fx, SkScalar dx, SkScalar fy, SkScalar dy,
                              SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
                              int count, int toggle) {
+    if (spanProc) {
+        spanProc(SkScalarToFloat(fx), SkScalarToFloat(dx), SkScalarToFloat(fy),
+                 SkScalarToFloat(dy), dstC, cache + toggle, cache + next_dither_toggle(toggle),
+                 count);
+        return;
+    }
     shadeSpan_radial<mirror_tileproc_nonstatic>(fx, dx, fy, dy, dstC, cache, count, toggle);
 }
 
-void shadeSpan_radial_repeat(SkScalar fx, SkScalar dx, SkScalar fy, SkScalar dy,
+void shadeSpan_radial_repeat(SkRadialGradientSpanProc spanProc,
+                             SkScalar fx, SkScalar dx, SkScalar fy, SkScalar dy,
                              SkPMColor* SK_RESTRICT dstC, const SkPMColor* SK_RESTRICT cache,
                              int count, int toggle) {
+    if (spanProc) {
+        spanProc(SkScalarToFloat(fx), SkScalarToFloat(dx), SkScalarToFloat(fy),
+                 SkScalarToFloat(dy), dstC, cache + toggle, cache + next_dither_toggle(toggle),
+                 count);
+        return;
+    }
     shadeSpan_radial<repeat_tileproc_nonstatic>(fx, dx, fy, dy, dstC, cache, count, toggle);
 }
 
@@ -419,6 +436,11 @@ void SkRadialGradient::RadialGradientContext::shadeSpan(int x, int y,
                                                         SkPMColor* SK_RESTRICT dstC, int count) {
     SkASSERT(count > 0);
 
+    if (this->interpolatesPerPixel()) {
+        this->interpolateSpan(x, y, dstC, count);
+        return;
+    }
+
     const SkRadialGradient& radialGradient = static_cast<const SkRadialGradient&>(fShader);
 
     SkPoint             srcPt;
@@ -451,7 +473,7 @@ void SkRadialGradient::RadialGradientContext::shadeSpan(int x, int y,
         } else {
             SkASSERT(SkShader::kRepeat_TileMode == radialGradient.fTileMode);
         }
-        (*shadeProc)(srcPt.fX, sdx, srcPt.fY, sdy, dstC, cache, count, toggle);
+        (*shadeProc)(fSpanProc, srcPt.fX, sdx, srcPt.fY, sdy, dstC, cache, count, toggle);
     } else {    // perspective case
         SkScalar dstX = SkIntToScalar(x);
         SkScalar dstY = SkIntToScalar(y);
@@ -465,6 +487,15 @@ void SkRadialGradient::RadialGradientContext::shadeSpan(int x, int y,
     }
 }
 
+void SkRadialGradient::RadialGradientContext::mapToPositions(const SkPoint pts[], float t[],
+                                                             int count) const {
+    for (int i = 0; i < count; ++i) {
+        const float x = SkScalarToFloat(pts[i].fX);
+        const float y = SkScalarToFloat(pts[i].fY);
+        t[i] = sk_float_sqrt(x * x + y * y);
+    }
+}
+
 /////////////////////////////////////////////////////////////////////
 
 #if SK_SUPPORT_GPU
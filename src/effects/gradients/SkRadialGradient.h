@@ -10,6 +10,7 @@
 #define SkRadialGradient_DEFINED
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradient_opts.h"
 
 class SkRadialGradient : public SkGradientShaderBase {
 public:
@@ -24,7 +25,13 @@ public:
         virtual void shadeSpan(int x, int y, SkPMColor dstC[], int count) SK_OVERRIDE;
         virtual void shadeSpan16(int x, int y, uint16_t dstC[], int count) SK_OVERRIDE;
 
+    protected:
+        virtual void mapToPositions(const SkPoint pts[], float t[], int count) const SK_OVERRIDE;
+
     private:
+        // The platform's version of the span loop for the tile mode, or NULL.
+        const SkRadialGradientSpanProc fSpanProc;
+
         typedef SkGradientShaderBase::GradientShaderBaseContext INHERITED;
     };
 
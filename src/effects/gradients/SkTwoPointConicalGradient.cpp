@@ -18,6 +18,9 @@ struct TwoPtRadialContext {
     TwoPtRadialContext(const TwoPtRadial& rec, SkScalar fx, SkScalar fy,
                        SkScalar dfx, SkScalar dfy);
     SkFixed nextT();
+    // Like nextT(), but returns false where the gradient is not drawn.
+    bool nextFloatT(float* t);
+    void getSpan(SkTwoPointConicalSpan* span) const;
 };
 
 static int valid_divide(float numer, float denom, float* ratio) {
@@ -104,7 +107,7 @@ TwoPtRadialContext::TwoPtRadialContext(const TwoPtRadial& rec, SkScalar fx, SkSc
     , fB(-2 * (rec.fDCenterX * fRelX + rec.fDCenterY * fRelY + rec.fRDR))
     , fDB(-2 * (rec.fDCenterX * fIncX + rec.fDCenterY * fIncY)) {}
 
-SkFixed TwoPtRadialContext::nextT() {
+bool TwoPtRadialContext::nextFloatT(float* result) {
     float roots[2];
 
     float C = sqr(fRelX) + sqr(fRelY) - fRec.fRadius2;
@@ -115,7 +118,7 @@ SkFixed TwoPtRadialContext::nextT() {
     fB += fDB;
 
     if (0 == countRoots) {
-        return TwoPtRadial::kDontDrawT;
+        return false;
     }
 
     // Prefer the bigger t value if both give a radius(t) > 0
@@ -126,12 +129,35 @@ SkFixed TwoPtRadialContext::nextT() {
         t = roots[0];   // might be the same as roots[countRoots-1]
         r = lerp(fRec.fRadius, fRec.fDRadius, t);
         if (r <= 0) {
-            return TwoPtRadial::kDontDrawT;
+            return false;
         }
     }
+    *result = t;
+    return true;
+}
+
+SkFixed TwoPtRadialContext::nextT() {
+    float t;
+    if (!this->nextFloatT(&t)) {
+        return TwoPtRadial::kDontDrawT;
+    }
     return SkFloatToFixed(t);
 }
 
+void TwoPtRadialContext::getSpan(SkTwoPointConicalSpan* span) const {
+    span->fRelX = fRelX;
+    span->fRelY = fRelY;
+    span->fIncX = fIncX;
+    span->fIncY = fIncY;
+    span->fB = fB;
+    span->fDB = fDB;
+    span->fA = fRec.fA;
+    span->fRadius2 = fRec.fRadius2;
+    span->fRadius = fRec.fRadius;
+    span->fDRadius = fRec.fDRadius;
+    span->fFlipped = fRec.fFlipped;
+}
+
 typedef void (*TwoPointConicalProc)(TwoPtRadialContext* rec, SkPMColor* dstC,
                                     const SkPMColor* cache, int toggle, int count);
 
@@ -228,6 +254,7 @@ SkShader::Context* SkTwoPointConicalGradient::onCreateContext(const ContextRec&
 SkTwoPointConicalGradient::TwoPointConicalGradientContext::TwoPointConicalGradientContext(
         const SkTwoPointConicalGradient& shader, const ContextRec& rec)
     : INHERITED(shader, rec)
+    , fSpanProc(SkTwoPointConicalGetPlatformSpanProc(shader.fTileMode))
 {
     // we don't have a span16 proc
     fFlags &= ~kHasSpan16_Flag;
@@ -242,10 +269,15 @@ void SkTwoPointConicalGradient::TwoPointConicalGradientContext::shadeSpan(
     const SkTwoPointConicalGradient& twoPointConicalGradient =
             static_cast<const SkTwoPointConicalGradient&>(fShader);
 
-    int toggle = init_dither_toggle(x, y);
-
     SkASSERT(count > 0);
 
+    if (this->interpolatesPerPixel()) {
+        this->interpolateSpan(x, y, dstCParam, count);
+        return;
+    }
+
+    int toggle = init_dither_toggle(x, y);
+
     SkPMColor* SK_RESTRICT dstC = dstCParam;
 
     SkMatrix::MapXYProc dstProc = fDstToIndexProc;
@@ -280,6 +312,12 @@ void SkTwoPointConicalGradient::TwoPointConicalGradientContext::shadeSpan(
         }
 
         TwoPtRadialContext rec(twoPointConicalGradient.fRec, fx, fy, dx, dy);
+        if (fSpanProc) {
+            SkTwoPointConicalSpan span;
+            rec.getSpan(&span);
+            fSpanProc(span, dstC, cache + toggle, cache + next_dither_toggle(toggle), count);
+            return;
+        }
         (*shadeProc)(&rec, dstC, cache, toggle, count);
     } else {    // perspective case
         SkScalar dstX = SkIntToScalar(x) + SK_ScalarHalf;
@@ -297,6 +335,19 @@ void SkTwoPointConicalGradient::TwoPointConicalGradientContext::shadeSpan(
     }
 }
 
+void SkTwoPointConicalGradient::TwoPointConicalGradientContext::mapToPositions(
+        const SkPoint pts[], float t[], int count) const {
+    const SkTwoPointConicalGradient& twoPointConicalGradient =
+            static_cast<const SkTwoPointConicalGradient&>(fShader);
+
+    for (int i = 0; i < count; ++i) {
+        TwoPtRadialContext rec(twoPointConicalGradient.fRec, pts[i].fX, pts[i].fY, 0, 0);
+        if (!rec.nextFloatT(&t[i])) {
+            t[i] = SK_FloatNaN;
+        }
+    }
+}
+
 SkShader::BitmapType SkTwoPointConicalGradient::asABitmap(
     SkBitmap* bitmap, SkMatrix* matrix, SkShader::TileMode* xy) const {
     SkPoint diff = fCenter2 - fCenter1;
@@ -10,6 +10,7 @@
 #define SkTwoPointConicalGradient_DEFINED
 
 #include "SkGradientShaderPriv.h"
+#include "SkGradient_opts.h"
 
 // TODO(dominikg): Worth making it truly immutable (i.e. set values in constructor)?
 // Should only be initialized once via init(). Immutable afterwards.
@@ -56,7 +57,13 @@ public:
 
         virtual void shadeSpan(int x, int y, SkPMColor dstC[], int count) SK_OVERRIDE;
 
+    protected:
+        virtual void mapToPositions(const SkPoint pts[], float t[], int count) const SK_OVERRIDE;
+
     private:
+        // The platform's version of the span loop for the tile mode, or NULL.
+        const SkTwoPointConicalSpanProc fSpanProc;
+
         typedef SkGradientShaderBase::GradientShaderBaseContext INHERITED;
     };
 
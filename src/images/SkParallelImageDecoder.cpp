@@ -0,0 +1,181 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkParallelImageDecoder.h"
+#include "SkBitmap.h"
+#include "SkData.h"
+#include "SkImageDecoder.h"
+#include "SkRect.h"
+#include "SkStream.h"
+#include "SkTDArray.h"
+#include "SkTemplates.h"
+#include "SkThreadPool.h"
+
+SK_COMPILE_ASSERT(SkParallelImageDecoder::kThreadPerCore == SkThreadPool::kThreadPerCore,
+                  thread_per_core_mismatch);
+
+namespace {
+
+// Bands are aligned to 16 rows, the tallest JPEG iMCU row (4:2:0 subsampling), so that
+// no two bands have to decode the same compressed rows.
+static const int kBandAlignment = 16;
+// Aim for this many bands, so that work stays balanced as threads finish at different times.
+static const int kTargetBandCount = 32;
+
+static int band_height(int imageHeight) {
+    int height = SkTMax(imageHeight / kTargetBandCount, 1);
+    return (height + kBandAlignment - 1) & ~(kBandAlignment - 1);
+}
+
+/**
+ *  SkImageDecoder is not thread safe, so each thread owns one of these, which holds a
+ *  decoder and tile index of its own. It is built lazily the first time the thread
+ *  decodes a band, and reused for every other band that thread decodes.
+ */
+class BandDecoder : SkNoncopyable {
+public:
+    BandDecoder() : fFailed(false) {}
+
+    bool init(SkData* data, int* width, int* height) {
+        SkASSERT(NULL == fDecoder.get());
+        fStream.reset(SkNEW_ARGS(SkMemoryStream, (data)));
+        fDecoder.reset(SkImageDecoder::Factory(fStream));
+        if (NULL == fDecoder.get() || !fDecoder->buildTileIndex(fStream, width, height)) {
+            fDecoder.free();
+            fFailed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool decode(SkData* data, SkBitmap* dst, const SkIRect& rect, SkColorType pref) {
+        if (fFailed) {
+            return false;
+        }
+        if (NULL == fDecoder.get()) {
+            int width, height;
+            if (!this->init(data, &width, &height)) {
+                return false;
+            }
+        }
+        return fDecoder->decodeSubset(dst, rect, pref);
+    }
+
+    /**
+     *  Whether the tile index can start decoding at any row. Only JPEG's can: the other
+     *  formats decode every row above a band to reach it.
+     */
+    bool canSeekRows() const {
+        SkASSERT(fDecoder.get());
+        return SkImageDecoder::kJPEG_Format == fDecoder->getFormat();
+    }
+
+private:
+    SkAutoTUnref<SkStreamRewindable>  fStream;
+    SkAutoTDelete<SkImageDecoder>     fDecoder;
+    bool                              fFailed;
+};
+
+/**
+ *  Decodes one band of the image into its slice of the destination bitmap. fDst shares
+ *  its pixelRef with the final bitmap, so the decoder writes (or crops) straight into it.
+ */
+class BandRunnable : public SkTRunnable<BandDecoder> {
+public:
+    BandRunnable(SkData* data, const SkBitmap& dst, const SkIRect& rect, SkColorType pref)
+        : fData(data)
+        , fDst(dst)
+        , fRect(rect)
+        , fPref(pref)
+        , fSuccess(false) {}
+
+    virtual void run(BandDecoder& decoder) SK_OVERRIDE {
+        fSuccess = decoder.decode(fData, &fDst, fRect, fPref);
+    }
+
+    bool success() const { return fSuccess; }
+
+private:
+    SkData*           fData;
+    SkBitmap          fDst;
+    const SkIRect     fRect;
+    const SkColorType fPref;
+    bool              fSuccess;
+};
+
+}  // namespace
+
+bool SkParallelImageDecoder::Decode(SkData* data, SkBitmap* bitmap, SkColorType pref,
+                                    int threadCount) {
+    SkASSERT(data);
+    SkASSERT(bitmap);
+
+    if (kUnknown_SkColorType == pref) {
+        pref = kN32_SkColorType;
+    }
+    if (kN32_SkColorType != pref && kRGB_565_SkColorType != pref) {
+        return false;
+    }
+
+    // Build the first index on the calling thread. This tells us whether the format
+    // supports tile based decoding at all, and how big the image is. This decoder is
+    // then used to decode bands on the calling thread while the pool works.
+    BandDecoder callerDecoder;
+    int width, height;
+    if (!callerDecoder.init(data, &width, &height)) {
+        return false;
+    }
+
+    // Decode into a temporary bitmap, so that if we return false, we are assured of
+    // leaving the caller's bitmap untouched.
+    SkBitmap tmp;
+    const SkAlphaType alphaType = kRGB_565_SkColorType == pref ? kOpaque_SkAlphaType
+                                                               : kPremul_SkAlphaType;
+    if (!tmp.allocPixels(SkImageInfo::Make(width, height, pref, alphaType))) {
+        return false;
+    }
+    SkAutoLockPixels alp(tmp);
+
+    // Without row seeking, every band would decode the rows above it again, so the image
+    // is decoded as a single band.
+    SkTDArray<BandRunnable*> bands;
+    const int bandHeight = callerDecoder.canSeekRows() ? band_height(height) : height;
+    for (int top = 0; top < height; top += bandHeight) {
+        const SkIRect rect = SkIRect::MakeLTRB(0, top, width, SkTMin(top + bandHeight, height));
+        SkBitmap band;
+        if (!tmp.extractSubset(&band, rect)) {
+            bands.deleteAll();
+            return false;
+        }
+        *bands.append() = SkNEW_ARGS(BandRunnable, (data, band, rect, pref));
+    }
+
+    if (0 == threadCount || 1 == bands.count()) {
+        for (int i = 0; i < bands.count(); ++i) {
+            bands[i]->run(callerDecoder);
+        }
+    } else {
+        SkTThreadPool<BandDecoder> pool(threadCount);
+        for (int i = 1; i < bands.count(); ++i) {
+            pool.add(bands[i]);
+        }
+        bands[0]->run(callerDecoder);
+        pool.wait();
+    }
+
+    bool success = true;
+    for (int i = 0; i < bands.count(); ++i) {
+        success &= bands[i]->success();
+    }
+    bands.deleteAll();
+
+    if (!success) {
+        return false;
+    }
+    bitmap->swap(tmp);
+    return true;
+}
@@ -7,6 +7,7 @@
 
 #include <emmintrin.h>
 #include "SkBitmapProcState_opts_SSE2.h"
+#include "SkBitmapProcState_filter.h"
 #include "SkColorPriv.h"
 #include "SkPaint.h"
 #include "SkUtils.h"
@@ -438,8 +439,8 @@ void ClampX_ClampY_nofilter_scale_SSE2(const SkBitmapProcState& s,
         // than max 16bit interger in the real world.
         if ((count >= 8) && (maxX <= 0xFFFF)) {
             while (((size_t)xy & 0x0F) != 0) {
-                *xy++ = pack_two_shorts(SkClampMax((fx + dx) >> 16, maxX),
-                                        SkClampMax(fx >> 16, maxX));
+                *xy++ = pack_two_shorts(SkClampMax(fx >> 16, maxX),
+                                        SkClampMax((fx + dx) >> 16, maxX));
                 fx += 2 * dx;
                 count -= 2;
             }
@@ -484,6 +485,273 @@ void ClampX_ClampY_nofilter_scale_SSE2(const SkBitmapProcState& s,
     }
 }
 
+// Pixels per call of the matrix and sample procs, for spans that the nofilter
+// shader proc hands to them.
+static const int kNoFilterShaderProcChunk = 256;
+
+template <bool hasAlpha>
+static inline SkPMColor nofilter_sample(SkPMColor c, unsigned alphaScale) {
+    return hasAlpha ? SkAlphaMulQ(c, alphaScale) : c;
+}
+
+/*  ClampX_ClampY_nofilter_scale_SSE2() and S32_{opaque,alpha}_D32_nofilter_DX
+ *  fused into one shader proc, which computes the same colors. When no pixel
+ *  of the span needs clamping (the decal case of the matrix proc, and nearly
+ *  every span of a scaled drawBitmapRect), each x is used to fetch its pixel
+ *  as soon as it is stepped to, instead of going through a buffer for the
+ *  whole span, and the row that the next scanline down samples is prefetched,
+ *  one cache line ahead of use. Other spans go through the two procs.
+ */
+template <bool hasAlpha>
+static void Clamp_S32_generic_D32_nofilter_DX_shaderproc_SSE2(
+        const SkBitmapProcState& s, int x, int y,
+        uint32_t* SK_RESTRICT colors, int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(SkPaint::kNone_FilterLevel == s.fFilterLevel);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    SkASSERT(hasAlpha == (s.fAlphaScale < 256));
+
+    const unsigned maxX = s.fBitmap->width() - 1;
+    const unsigned maxY = s.fBitmap->height() - 1;
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                             SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkFixed fy = SkScalarToFixed(pt.fY);
+    SkFixed fx = SkScalarToFixed(pt.fX);
+    const SkFixed dx = s.fInvSx;
+
+    // Same test as ClampX_ClampY_nofilter_scale_SSE2().
+    if ((unsigned)(fx >> 16) > maxX ||
+        (unsigned)((fx + dx * (count - 1)) >> 16) > maxX) {
+        uint32_t xy[1 + kNoFilterShaderProcChunk / 2];
+        do {
+            const int n = SkMin32(count, kNoFilterShaderProcChunk);
+            ClampX_ClampY_nofilter_scale_SSE2(s, xy, n, x, y);
+            if (hasAlpha) {
+                S32_alpha_D32_nofilter_DX(s, xy, n, colors);
+            } else {
+                S32_opaque_D32_nofilter_DX(s, xy, n, colors);
+            }
+            x += n;
+            colors += n;
+            count -= n;
+        } while (count > 0);
+        return;
+    }
+
+    const char* srcAddr = static_cast<const char*>(s.fBitmap->getPixels());
+    const size_t rb = s.fBitmap->rowBytes();
+    const unsigned srcY = SkClampMax(fy >> 16, maxY);
+    const SkPMColor* SK_RESTRICT row =
+            reinterpret_cast<const SkPMColor*>(srcAddr + srcY * rb);
+    const unsigned alphaScale = s.fAlphaScale;
+
+    // When scaling down, the next scanline samples a row that is not in the
+    // cache yet, so fetch the part of it that this span samples while this
+    // row is being read. Otherwise point the prefetches at this row, which is
+    // cheaper than testing for them in the loop.
+    const SkFixed nextFy = fy + SkScalarToFixed(s.fInvMatrix.getScaleY());
+    const unsigned nextY = SkClampMax(nextFy >> 16, maxY);
+    const char* prefetchRow = srcAddr + nextY * rb;
+
+    while (count >= 4) {
+        _mm_prefetch(prefetchRow + ((fx >> 16) << 2) + 64, _MM_HINT_T0);
+        colors[0] = nofilter_sample<hasAlpha>(row[fx >> 16], alphaScale);
+        colors[1] = nofilter_sample<hasAlpha>(row[(fx + dx) >> 16], alphaScale);
+        colors[2] = nofilter_sample<hasAlpha>(row[(fx + dx * 2) >> 16], alphaScale);
+        colors[3] = nofilter_sample<hasAlpha>(row[(fx + dx * 3) >> 16], alphaScale);
+        fx += dx * 4;
+        colors += 4;
+        count -= 4;
+    }
+    while (count-- > 0) {
+        *colors++ = nofilter_sample<hasAlpha>(row[fx >> 16], alphaScale);
+        fx += dx;
+    }
+}
+
+void Clamp_S32_opaque_D32_nofilter_DX_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                      int x, int y,
+                                                      uint32_t* colors, int count) {
+    Clamp_S32_generic_D32_nofilter_DX_shaderproc_SSE2<false>(s, x, y, colors, count);
+}
+
+void Clamp_S32_alpha_D32_nofilter_DX_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                     int x, int y,
+                                                     uint32_t* colors, int count) {
+    Clamp_S32_generic_D32_nofilter_DX_shaderproc_SSE2<true>(s, x, y, colors, count);
+}
+
+/*  SSE versions of the Clamp_S32_D32_{nofilter,filter}_scale_float shader
+ *  procs in core/SkBitmapProcState.cpp, which map four pixels at a time and
+ *  compute the same colors.
+ */
+template <bool hasAlpha>
+static void Clamp_S32_D32_nofilter_scale_float_SSE2(const SkBitmapProcState& s,
+                                                    int x, int y,
+                                                    uint32_t* SK_RESTRICT colors,
+                                                    int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(SkPaint::kNone_FilterLevel == s.fFilterLevel);
+    SkASSERT(hasAlpha == (s.fAlphaScale < 256));
+
+    const SkScalar maxX = SkIntToScalar(s.fBitmap->width() - 1);
+    const SkScalar maxY = SkIntToScalar(s.fBitmap->height() - 1);
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkScalar dx = s.fInvMatrix.getScaleX();
+    const unsigned alphaScale = s.fAlphaScale;
+
+    const SkPMColor* SK_RESTRICT row =
+            s.fBitmap->getAddr32(0, (int)SkScalarPin(pt.fY, 0, maxY));
+
+    const __m128 wideX = _mm_set1_ps(pt.fX);
+    const __m128 wideDx = _mm_set1_ps(dx);
+    const __m128 wideMaxX = _mm_set1_ps(maxX);
+    const __m128 four = _mm_set1_ps(4.0f);
+    __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 fx = _mm_add_ps(wideX, _mm_mul_ps(wideDx, index));
+        fx = _mm_min_ps(_mm_max_ps(fx, _mm_setzero_ps()), wideMaxX);
+        index = _mm_add_ps(index, four);
+
+        int ix[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ix), _mm_cvttps_epi32(fx));
+        for (int j = 0; j < 4; ++j) {
+            const SkPMColor c = row[ix[j]];
+            colors[i + j] = hasAlpha ? SkAlphaMulQ(c, alphaScale) : c;
+        }
+    }
+    for (; i < count; ++i) {
+        const SkPMColor c = row[(int)SkScalarPin(pt.fX + dx * i, 0, maxX)];
+        colors[i] = hasAlpha ? SkAlphaMulQ(c, alphaScale) : c;
+    }
+}
+
+template <bool hasAlpha>
+static void Clamp_S32_D32_filter_scale_float_SSE2(const SkBitmapProcState& s,
+                                                  int x, int y,
+                                                  uint32_t* SK_RESTRICT colors,
+                                                  int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(SkPaint::kNone_FilterLevel != s.fFilterLevel);
+    SkASSERT(hasAlpha == (s.fAlphaScale < 256));
+
+    const SkScalar maxX = SkIntToScalar(s.fBitmap->width() - 1);
+    const SkScalar maxY = SkIntToScalar(s.fBitmap->height() - 1);
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkScalar fx = pt.fX - SK_ScalarHalf;
+    const SkScalar dx = s.fInvMatrix.getScaleX();
+
+    // Same as float_filter_coords() in core/SkBitmapProcState.cpp.
+    const SkScalar fy = SkScalarPin(pt.fY - SK_ScalarHalf, -SK_Scalar1, maxY + SK_Scalar1);
+    const int iy = SkScalarFloorToInt(fy);
+    const int maxIY = s.fBitmap->height() - 1;
+    const SkPMColor* SK_RESTRICT row0 = s.fBitmap->getAddr32(0, SkClampMax(iy, maxIY));
+    const SkPMColor* SK_RESTRICT row1 = s.fBitmap->getAddr32(0, SkClampMax(iy + 1, maxIY));
+    const unsigned subY = (int)((fy - iy) * 16) & 0xF;
+    const unsigned alphaScale = s.fAlphaScale;
+
+    const __m128 wideX = _mm_set1_ps(fx);
+    const __m128 wideDx = _mm_set1_ps(dx);
+    const __m128 wideMaxX = _mm_set1_ps(maxX);
+    const __m128 wideMinusOne = _mm_set1_ps(-SK_Scalar1);
+    const __m128 wideMaxXPlusOne = _mm_set1_ps(maxX + SK_Scalar1);
+    const __m128 one = _mm_set1_ps(SK_Scalar1);
+    const __m128 sixteen = _mm_set1_ps(16.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128i mask_000F = _mm_set1_epi32(0xF);
+    __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 v = _mm_add_ps(wideX, _mm_mul_ps(wideDx, index));
+        v = _mm_min_ps(_mm_max_ps(v, wideMinusOne), wideMaxXPlusOne);
+        index = _mm_add_ps(index, four);
+
+        // floor(v): truncate, then subtract 1 where that rounded up.
+        __m128 floorV = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        floorV = _mm_sub_ps(floorV, _mm_and_ps(_mm_cmpgt_ps(floorV, v), one));
+
+        int x0[4], x1[4], subX[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(subX),
+                         _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_sub_ps(v, floorV),
+                                                                   sixteen)),
+                                       mask_000F));
+        const __m128 zero = _mm_setzero_ps();
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(x0), _mm_cvttps_epi32(
+                _mm_min_ps(_mm_max_ps(floorV, zero), wideMaxX)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(x1), _mm_cvttps_epi32(
+                _mm_min_ps(_mm_max_ps(_mm_add_ps(floorV, one), zero), wideMaxX)));
+
+        for (int j = 0; j < 4; ++j) {
+            if (hasAlpha) {
+                Filter_32_alpha(subX[j], subY,
+                                row0[x0[j]], row0[x1[j]], row1[x0[j]], row1[x1[j]],
+                                &colors[i + j], alphaScale);
+            } else {
+                Filter_32_opaque(subX[j], subY,
+                                 row0[x0[j]], row0[x1[j]], row1[x0[j]], row1[x1[j]],
+                                 &colors[i + j]);
+            }
+        }
+    }
+    const int maxIX = s.fBitmap->width() - 1;
+    for (; i < count; ++i) {
+        const SkScalar v = SkScalarPin(fx + dx * i, -SK_Scalar1, maxX + SK_Scalar1);
+        const int ix = SkScalarFloorToInt(v);
+        const unsigned subX = (int)((v - ix) * 16) & 0xF;
+        const int x0 = SkClampMax(ix, maxIX);
+        const int x1 = SkClampMax(ix + 1, maxIX);
+        if (hasAlpha) {
+            Filter_32_alpha(subX, subY, row0[x0], row0[x1], row1[x0], row1[x1],
+                            &colors[i], alphaScale);
+        } else {
+            Filter_32_opaque(subX, subY, row0[x0], row0[x1], row1[x0], row1[x1],
+                             &colors[i]);
+        }
+    }
+}
+
+void Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                               int x, int y,
+                                                               uint32_t* colors,
+                                                               int count) {
+    Clamp_S32_D32_nofilter_scale_float_SSE2<false>(s, x, y, colors, count);
+}
+
+void Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                              int x, int y,
+                                                              uint32_t* colors,
+                                                              int count) {
+    Clamp_S32_D32_nofilter_scale_float_SSE2<true>(s, x, y, colors, count);
+}
+
+void Clamp_S32_opaque_D32_filter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                             int x, int y,
+                                                             uint32_t* colors,
+                                                             int count) {
+    Clamp_S32_D32_filter_scale_float_SSE2<false>(s, x, y, colors, count);
+}
+
+void Clamp_S32_alpha_D32_filter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                            int x, int y,
+                                                            uint32_t* colors,
+                                                            int count) {
+    Clamp_S32_D32_filter_scale_float_SSE2<true>(s, x, y, colors, count);
+}
+
 /*  SSE version of ClampX_ClampY_filter_affine()
  *  portable version is in core/SkBitmapProcState_matrix.h
  */
@@ -22,6 +22,28 @@ void ClampX_ClampY_filter_scale_SSE2(const SkBitmapProcState& s, uint32_t xy[],
                                      int count, int x, int y);
 void ClampX_ClampY_nofilter_scale_SSE2(const SkBitmapProcState& s,
                                        uint32_t xy[], int count, int x, int y);
+void Clamp_S32_opaque_D32_nofilter_DX_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                      int x, int y,
+                                                      uint32_t* colors, int count);
+void Clamp_S32_alpha_D32_nofilter_DX_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                     int x, int y,
+                                                     uint32_t* colors, int count);
+void Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                               int x, int y,
+                                                               uint32_t* colors,
+                                                               int count);
+void Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                              int x, int y,
+                                                              uint32_t* colors,
+                                                              int count);
+void Clamp_S32_opaque_D32_filter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                             int x, int y,
+                                                             uint32_t* colors,
+                                                             int count);
+void Clamp_S32_alpha_D32_filter_scale_float_shaderproc_SSE2(const SkBitmapProcState& s,
+                                                            int x, int y,
+                                                            uint32_t* colors,
+                                                            int count);
 void ClampX_ClampY_filter_affine_SSE2(const SkBitmapProcState& s,
                                       uint32_t xy[], int count, int x, int y);
 void ClampX_ClampY_nofilter_affine_SSE2(const SkBitmapProcState& s,
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "SkBitmapProcState_opts_SSE2.h"
 #include "SkBitmapProcState_opts_SSSE3.h"
 #include "SkPaint.h"
 #include "SkUtils.h"
@@ -705,6 +706,203 @@ void S32_generic_D32_filter_DXDY_SSSE3(const SkBitmapProcState& s,
         *colors++ = _mm_cvtsi128_si32(sum0);
     }
 }
+
+// Pixels per call of the matrix and sample procs, for spans that
+// Clamp_S32_generic_D32_filter_DX_shaderproc_SSSE3 hands to them.
+const int kFilterShaderProcChunk = 256;
+
+// The loop of Clamp_S32_generic_D32_filter_DX_shaderproc_SSSE3, for one of the
+// two cases of sub_y, for a span where no x needs clamping.
+// @param prefetch_row0..1 rows to prefetch the sampled part of, one cache line
+//        ahead of use.
+template<bool has_alpha, bool zero_sub_y>
+inline void DecalFilterScaleSpan(const uint32_t* row0, const uint32_t* row1,
+                                 const char* prefetch_row0,
+                                 const char* prefetch_row1,
+                                 SkFixed fx, SkFixed dx, unsigned sub_y,
+                                 const __m128i& alpha,
+                                 uint32_t* colors, int count) {
+    // vector constants
+    const __m128i mask_dist_select = _mm_set_epi8(12, 12, 12, 12,
+                                                  8,  8,  8,  8,
+                                                  4,  4,  4,  4,
+                                                  0,  0,  0,  0);
+    const __m128i mask_000F = _mm_set1_epi32(0x000F);
+    const __m128i sixteen_8bit = _mm_set1_epi8(16);
+    const __m128i wide_dx4 = _mm_set1_epi32(dx * 4);
+    // 8x (y)
+    const __m128i all_y = _mm_set1_epi16(sub_y);
+    // 8x (16-y)
+    const __m128i neg_y = _mm_sub_epi16(_mm_set1_epi16(16), all_y);
+
+    __m128i wide_fx = _mm_set_epi32(fx + dx * 3, fx + dx * 2, fx + dx, fx);
+
+    while (count > 3) {
+        count -= 4;
+
+        // The same coordinates decal_filter_scale packs into xy.
+        int x0[4];
+        int x1[4];
+        for (int i = 0; i < 4; ++i) {
+            x0[i] = (fx + dx * i) >> 16;
+            x1[i] = x0[i] + 1;
+        }
+        _mm_prefetch(prefetch_row0 + x0[0] * 4 + 64, _MM_HINT_T0);
+        if (!zero_sub_y) {
+            _mm_prefetch(prefetch_row1 + x0[0] * 4 + 64, _MM_HINT_T0);
+        }
+        fx += dx * 4;
+
+        // (4x(x3), 4x(x2), 4x(x1), 4x(x0))
+        const __m128i all_x = _mm_shuffle_epi8(
+                _mm_and_si128(_mm_srli_epi32(wide_fx, 12), mask_000F),
+                mask_dist_select);
+        // (4x(16-x3), 4x(16-x2), 4x(16-x1), 4x(16-x0))
+        const __m128i sixteen_minus_x = _mm_sub_epi8(sixteen_8bit, all_x);
+        wide_fx = _mm_add_epi32(wide_fx, wide_dx4);
+
+        // (4x(x1, 16-x1), 4x(x0, 16-x0))
+        __m128i scale_x = _mm_unpacklo_epi8(sixteen_minus_x, all_x);
+        __m128i sum0, sum1;
+        if (zero_sub_y) {
+            sum0 = ProcessPixelPairZeroSubY<has_alpha>(
+                row0[x0[0]], row0[x1[0]], row0[x0[1]], row0[x1[1]],
+                scale_x, alpha);
+            // (4x (x3, 16-x3), 4x (16-x2, x2))
+            scale_x = _mm_unpackhi_epi8(sixteen_minus_x, all_x);
+            sum1 = ProcessPixelPairZeroSubY<has_alpha>(
+                row0[x0[2]], row0[x1[2]], row0[x0[3]], row0[x1[3]],
+                scale_x, alpha);
+        } else {
+            sum0 = ProcessTwoPixelPairs<has_alpha>(
+                row0, row1, x0, x1,
+                scale_x, all_y, neg_y, alpha);
+            // (4x (x3, 16-x3), 4x (16-x2, x2))
+            scale_x = _mm_unpackhi_epi8(sixteen_minus_x, all_x);
+            sum1 = ProcessTwoPixelPairs<has_alpha>(
+                row0, row1, x0 + 2, x1 + 2,
+                scale_x, all_y, neg_y, alpha);
+        }
+
+        // Pack lower 4 16 bit values of sum into lower 4 bytes.
+        sum0 = _mm_packus_epi16(sum0, sum1);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(colors), sum0);
+        colors += 4;
+    }
+
+    // Left over.
+    while (count-- > 0) {
+        const int x0 = fx >> 16;
+
+        // 16x(x)
+        const __m128i all_x = _mm_set1_epi8((fx >> 12) & 0x0F);
+        // (8x (x, 16-x))
+        const __m128i scale_x =
+                _mm_unpacklo_epi8(_mm_sub_epi8(sixteen_8bit, all_x), all_x);
+        fx += dx;
+
+        __m128i sum;
+        if (zero_sub_y) {
+            sum = ProcessOnePixelZeroSubY<has_alpha>(row0[x0], row0[x0 + 1],
+                                                     scale_x, alpha);
+        } else {
+            sum = _mm_add_epi16(
+                    ProcessOnePixel(row0[x0], row0[x0 + 1], scale_x, neg_y),
+                    ProcessOnePixel(row1[x0], row1[x0 + 1], scale_x, all_y));
+            sum = ScaleFourPixels<has_alpha, 8>(&sum, alpha);
+        }
+
+        // Pack lower 4 16 bit values of sum into lower 4 bytes.
+        sum = _mm_packus_epi16(sum, _mm_setzero_si128());
+
+        // Extract low int and store.
+        *colors++ = _mm_cvtsi128_si32(sum);
+    }
+}
+
+// ClampX_ClampY_filter_scale_SSE2 and S32_generic_D32_filter_DX_SSSE3 fused
+// into one shader proc, which computes the same colors. When no x of the span
+// needs clamping (nearly every span of a scaled drawBitmapRect), the pixels
+// are fetched as each x is stepped to, instead of going through a buffer for
+// the whole span, and the rows that the next scanline down samples are
+// prefetched. Other spans go through the two procs.
+template<bool has_alpha>
+void Clamp_S32_generic_D32_filter_DX_shaderproc_SSSE3(
+        const SkBitmapProcState& s, int x, int y, uint32_t* colors, int count) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(s.fFilterLevel != SkPaint::kNone_FilterLevel);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    if (has_alpha) {
+        SkASSERT(s.fAlphaScale < 256);
+    } else {
+        SkASSERT(s.fAlphaScale == 256);
+    }
+
+    const unsigned max_x = s.fBitmap->width() - 1;
+    const unsigned max_y = s.fBitmap->height() - 1;
+    const SkFixed one_y = s.fFilterOneY;
+    const SkFixed dx = s.fInvSx;
+
+    SkPoint pt;
+    s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &pt);
+    const SkFixed fy = SkScalarToFixed(pt.fY) - (one_y >> 1);
+    const SkFixed fx = SkScalarToFixed(pt.fX) - (s.fFilterOneX >> 1);
+
+    // Same test as ClampX_ClampY_filter_scale_SSE2.
+    if (!(dx > 0 && (unsigned)(fx >> 16) <= max_x &&
+          (unsigned)((fx + dx * (count - 1)) >> 16) < max_x)) {
+        uint32_t xy[1 + kFilterShaderProcChunk];
+        do {
+            const int n = SkMin32(count, kFilterShaderProcChunk);
+            ClampX_ClampY_filter_scale_SSE2(s, xy, n, x, y);
+            S32_generic_D32_filter_DX_SSSE3<has_alpha>(s, xy, n, colors);
+            x += n;
+            colors += n;
+            count -= n;
+        } while (count > 0);
+        return;
+    }
+
+    const char* src_addr = static_cast<const char*>(s.fBitmap->getPixels());
+    const size_t rb = s.fBitmap->rowBytes();
+    const unsigned y0 = SkClampMax(fy >> 16, max_y);
+    const unsigned y1 = SkClampMax((fy + one_y) >> 16, max_y);
+    const uint32_t* row0 =
+            reinterpret_cast<const uint32_t*>(src_addr + y0 * rb);
+    const uint32_t* row1 =
+            reinterpret_cast<const uint32_t*>(src_addr + y1 * rb);
+    const unsigned sub_y = (fy >> 12) & 0xF;
+
+    // When scaling down, the next scanline samples rows that are not in the
+    // cache yet. Otherwise the prefetches point at these rows, which is
+    // cheaper than testing for them in the loop.
+    const SkFixed next_fy = fy + SkScalarToFixed(s.fInvMatrix.getScaleY());
+    const char* prefetch_row0 =
+            src_addr + SkClampMax(next_fy >> 16, max_y) * rb;
+    const char* prefetch_row1 =
+            src_addr + SkClampMax((next_fy + one_y) >> 16, max_y) * rb;
+
+    __m128i alpha = _mm_setzero_si128();
+    if (has_alpha) {
+        // 8x(alpha)
+        alpha = _mm_set1_epi16(s.fAlphaScale);
+    }
+
+    if (sub_y == 0) {
+        DecalFilterScaleSpan<has_alpha, true>(
+                row0, row1, prefetch_row0, prefetch_row1, fx, dx, sub_y,
+                alpha, colors, count);
+    } else {
+        DecalFilterScaleSpan<has_alpha, false>(
+                row0, row1, prefetch_row0, prefetch_row1, fx, dx, sub_y,
+                alpha, colors, count);
+    }
+}
+
 }  // namespace
 
 void S32_opaque_D32_filter_DX_SSSE3(const SkBitmapProcState& s,
@@ -731,6 +929,18 @@ void S32_alpha_D32_filter_DXDY_SSSE3(const SkBitmapProcState& s,
     S32_generic_D32_filter_DXDY_SSSE3<true>(s, xy, count, colors);
 }
 
+void Clamp_S32_opaque_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                    int x, int y,
+                                                    uint32_t* colors, int count) {
+    Clamp_S32_generic_D32_filter_DX_shaderproc_SSSE3<false>(s, x, y, colors, count);
+}
+
+void Clamp_S32_alpha_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                   int x, int y,
+                                                   uint32_t* colors, int count) {
+    Clamp_S32_generic_D32_filter_DX_shaderproc_SSSE3<true>(s, x, y, colors, count);
+}
+
 #else // SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSSE3
 
 void S32_opaque_D32_filter_DX_SSSE3(const SkBitmapProcState& s,
@@ -757,4 +967,16 @@ void S32_alpha_D32_filter_DXDY_SSSE3(const SkBitmapProcState& s,
     sk_throw();
 }
 
+void Clamp_S32_opaque_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                    int x, int y,
+                                                    uint32_t* colors, int count) {
+    sk_throw();
+}
+
+void Clamp_S32_alpha_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                   int x, int y,
+                                                   uint32_t* colors, int count) {
+    sk_throw();
+}
+
 #endif
@@ -23,4 +23,13 @@ void S32_alpha_D32_filter_DXDY_SSSE3(const SkBitmapProcState& s,
                                    const uint32_t* xy,
                                    int count, uint32_t* colors);
 
+// Shader procs for scale+translate matrices with clamp tiling, which don't
+// need a matrix proc.
+void Clamp_S32_opaque_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                    int x, int y,
+                                                    uint32_t* colors, int count);
+void Clamp_S32_alpha_D32_filter_DX_shaderproc_SSSE3(const SkBitmapProcState& s,
+                                                   int x, int y,
+                                                   uint32_t* colors, int count);
+
 #endif
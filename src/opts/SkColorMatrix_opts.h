@@ -0,0 +1,24 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkColorMatrix_opts_DEFINED
+#define SkColorMatrix_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  Applies the fixed point color matrix of SkColorMatrixFilter to count pixels. Each pixel is
+ *  unpremultiplied, each of its channels becomes (row * [r g b a] + translate) >> shift, pinned
+ *  to [0, 255], and the result is premultiplied again. The translates of matrix already hold
+ *  the rounding of the shift. src and dst may be the same.
+ */
+typedef void (*SkColorMatrixSpanProc)(const int32_t matrix[20], int shift,
+                                      const SkPMColor src[], int count, SkPMColor dst[]);
+
+SkColorMatrixSpanProc SkColorMatrixGetPlatformSpanProc();
+
+#endif
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorMatrix_opts_SSE2.h"
+#include "SkColorPriv.h"
+#include "SkColor_opts_SSE2.h"
+#include "SkUnPreMultiply.h"
+
+/* SSE2 version of SkColorMatrixFilter::filterSpan(). Four pixels are filtered together, one
+ * channel per register, with the same integer arithmetic as the portable code, so the results
+ * are identical.
+ *
+ * The matrix entries have up to 24 bits, too many for _mm_madd_epi16(), so each one is split
+ * into a high part and 15 low bits, c == (hi << 15) + lo, and the two halves of every row are
+ * multiplied separately. The sums wrap around exactly as the 32 bit sums of the portable code.
+ */
+
+namespace {
+
+struct Row {
+    __m128i fHiRG, fHiBA;   // the high parts of the coefficients of r and g, b and a
+    __m128i fLoRG, fLoBA;   // their low 15 bits
+    __m128i fTranslate;
+};
+
+inline __m128i pair(int32_t lo, int32_t hi) {
+    return _mm_set1_epi32((static_cast<uint32_t>(hi) << 16) | (lo & 0xFFFF));
+}
+
+void init_row(const int32_t row[5], Row* result) {
+    result->fHiRG = pair(row[0] >> 15, row[1] >> 15);
+    result->fHiBA = pair(row[2] >> 15, row[3] >> 15);
+    result->fLoRG = pair(row[0] & 0x7FFF, row[1] & 0x7FFF);
+    result->fLoBA = pair(row[2] & 0x7FFF, row[3] & 0x7FFF);
+    result->fTranslate = _mm_set1_epi32(row[4]);
+}
+
+// rg and ba hold the channels as pairs of 16 bit values.
+inline __m128i apply_row(const Row& row, __m128i rg, __m128i ba, __m128i shift) {
+    const __m128i hi = _mm_add_epi32(_mm_madd_epi16(rg, row.fHiRG),
+                                     _mm_madd_epi16(ba, row.fHiBA));
+    const __m128i lo = _mm_add_epi32(_mm_madd_epi16(rg, row.fLoRG),
+                                     _mm_madd_epi16(ba, row.fLoBA));
+    const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(hi, 15), lo),
+                                      row.fTranslate);
+    return _mm_sra_epi32(sum, shift);
+}
+
+template <int shift>
+inline __m128i get_channel(__m128i pixels) {
+    return _mm_and_si128(_mm_srli_epi32(pixels, shift), _mm_set1_epi32(0xFF));
+}
+
+// As SkUnPreMultiply::ApplyScale().
+inline __m128i unpremultiply(__m128i scales, __m128i channel) {
+    return _mm_srli_epi32(_mm_add_epi32(Multiply32_SSE2(scales, channel),
+                                        _mm_set1_epi32(1 << 23)), 24);
+}
+
+// As SkMulDiv255Round(), for 16 bit values.
+inline __m128i mul_div_255_round(__m128i a, __m128i b) {
+    const __m128i prod = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(prod, _mm_srli_epi16(prod, 8)), 8);
+}
+
+inline __m128i filter4(const Row rows[4], __m128i shift, const SkUnPreMultiply::Scale* table,
+                       const SkPMColor src[4]) {
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i r = get_channel<SK_R32_SHIFT>(pixels);
+    __m128i g = get_channel<SK_G32_SHIFT>(pixels);
+    __m128i b = get_channel<SK_B32_SHIFT>(pixels);
+    const __m128i a = get_channel<SK_A32_SHIFT>(pixels);
+
+    // Unpremultiplying does not change opaque pixels.
+    if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi32(a, _mm_set1_epi32(0xFF)))) {
+        const __m128i scales = _mm_setr_epi32(table[SkGetPackedA32(src[0])],
+                                              table[SkGetPackedA32(src[1])],
+                                              table[SkGetPackedA32(src[2])],
+                                              table[SkGetPackedA32(src[3])]);
+        r = unpremultiply(scales, r);
+        g = unpremultiply(scales, g);
+        b = unpremultiply(scales, b);
+    }
+
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi32(g, 16));
+    const __m128i ba = _mm_or_si128(b, _mm_slli_epi32(a, 16));
+
+    // Pin the results to [0, 255], holding four of them per half register.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    __m128i resultRG = _mm_packs_epi32(apply_row(rows[0], rg, ba, shift),
+                                       apply_row(rows[1], rg, ba, shift));
+    __m128i resultBA = _mm_packs_epi32(apply_row(rows[2], rg, ba, shift),
+                                       apply_row(rows[3], rg, ba, shift));
+    resultRG = _mm_min_epi16(_mm_max_epi16(resultRG, zero), max);
+    resultBA = _mm_min_epi16(_mm_max_epi16(resultBA, zero), max);
+
+    // Premultiply, leaving alpha alone.
+    resultRG = mul_div_255_round(resultRG, _mm_unpackhi_epi64(resultBA, resultBA));
+    resultBA = mul_div_255_round(resultBA, _mm_unpackhi_epi64(resultBA, max));
+
+    return _mm_or_si128(
+            _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(resultRG, zero), SK_R32_SHIFT),
+                         _mm_slli_epi32(_mm_unpackhi_epi16(resultRG, zero), SK_G32_SHIFT)),
+            _mm_or_si128(_mm_slli_epi32(_mm_unpacklo_epi16(resultBA, zero), SK_B32_SHIFT),
+                         _mm_slli_epi32(_mm_unpackhi_epi16(resultBA, zero), SK_A32_SHIFT)));
+}
+
+}  // namespace
+
+void SkColorMatrixSpan_SSE2(const int32_t matrix[20], int shift,
+                            const SkPMColor src[], int count, SkPMColor dst[]) {
+    Row rows[4];
+    for (int i = 0; i < 4; ++i) {
+        init_row(&matrix[5 * i], &rows[i]);
+    }
+    const __m128i shiftCount = _mm_cvtsi32_si128(shift);
+    const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         filter4(rows, shiftCount, table, src + i));
+    }
+    if (i < count) {
+        SkPMColor last[4] = { 0, 0, 0, 0 };
+        memcpy(last, src + i, (count - i) * sizeof(SkPMColor));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(last),
+                         filter4(rows, shiftCount, table, last));
+        memcpy(dst + i, last, (count - i) * sizeof(SkPMColor));
+    }
+}
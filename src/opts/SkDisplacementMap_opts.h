@@ -0,0 +1,46 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDisplacementMap_opts_DEFINED
+#define SkDisplacementMap_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  The displacement of SkDisplacementMapEffect. The pixel (x, y) takes the color of the pixel
+ *  (x + trunc(fScaleX * dx + fOffsetX), y + trunc(fScaleY * dy + fOffsetY)), where dx and dy are
+ *  the unpremultiplied channels of its displacement pixel selected by fXChannelShift and
+ *  fYChannelShift, or transparent black if that pixel is outside the color bitmap.
+ */
+struct SkDisplacementMapParams {
+    int                 fXChannelShift;     // SK_A32_SHIFT, SK_R32_SHIFT, ...
+    int                 fYChannelShift;
+    float               fScaleX;
+    float               fScaleY;
+    float               fOffsetX;
+    float               fOffsetY;
+    const SkPMColor*    fColor;
+    int                 fColorStride;       // in pixels
+    int                 fColorWidth;
+    int                 fColorHeight;
+};
+
+/**
+ *  Displaces count pixels (x, y), (x + 1, y), ... displ points to the displacement pixel of the
+ *  first one.
+ */
+typedef void (*SkDisplacementMapRowProc)(const SkDisplacementMapParams& params,
+                                         const SkPMColor* displ, int x, int y,
+                                         SkPMColor dst[], int count);
+
+/**
+ *  Returns a proc that checks whether each pixel is displaced outside the color bitmap if
+ *  checkBounds, or one for pixels that cannot be otherwise, or NULL.
+ */
+SkDisplacementMapRowProc SkDisplacementMapGetPlatformRowProc(bool checkBounds);
+
+#endif
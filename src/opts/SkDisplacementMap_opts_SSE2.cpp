@@ -0,0 +1,105 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorPriv.h"
+#include "SkColor_opts_SSE2.h"
+#include "SkDisplacementMap_opts_SSE2.h"
+#include "SkUnPreMultiply.h"
+
+/* SSE2 version of the displacement of SkDisplacementMapEffect. The channels of four displacement
+ * pixels are unpremultiplied and turned into source positions together, with the same integer and
+ * float operations as SkDisplacementMapEffect.cpp; only the fetches of the colors are scalar.
+ */
+
+union Ints {
+    __m128i v;
+    int32_t i[4];
+};
+
+// The selected channel of four displacement pixels, unpremultiplied by scales unless it is alpha
+// or the pixels are opaque.
+static inline __m128i channel(__m128i pixels, int shift, bool opaque, __m128i scales) {
+    const __m128i values = _mm_and_si128(_mm_srl_epi32(pixels, _mm_cvtsi32_si128(shift)),
+                                         _mm_set1_epi32(0xFF));
+    if (SK_A32_SHIFT == shift || opaque) {
+        return values;
+    }
+    // As SkUnPreMultiply::ApplyScale().
+    return _mm_srli_epi32(_mm_add_epi32(Multiply32_SSE2(scales, values),
+                                        _mm_set1_epi32(1 << 23)), 24);
+}
+
+// Displaces the four pixels (x, y) ... (x + 3, y) whose displacement pixels are displ[0..3].
+template <bool checkBounds>
+static inline void displace4(const SkDisplacementMapParams& params,
+                             const SkUnPreMultiply::Scale* table, const SkPMColor* displ,
+                             int x, int y, SkPMColor dst[4]) {
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(displ));
+    // Unpremultiplying does not change the channels of opaque pixels.
+    const __m128i alphaMask = _mm_set1_epi32(0xFF << SK_A32_SHIFT);
+    const bool opaque = 0xFFFF == _mm_movemask_epi8(
+            _mm_cmpeq_epi32(_mm_and_si128(pixels, alphaMask), alphaMask));
+    __m128i scales = _mm_setzero_si128();
+    if (!opaque &&
+        (SK_A32_SHIFT != params.fXChannelShift || SK_A32_SHIFT != params.fYChannelShift)) {
+        scales = _mm_setr_epi32(table[SkGetPackedA32(displ[0])], table[SkGetPackedA32(displ[1])],
+                                table[SkGetPackedA32(displ[2])], table[SkGetPackedA32(displ[3])]);
+    }
+    const __m128 dx = _mm_cvtepi32_ps(channel(pixels, params.fXChannelShift, opaque, scales));
+    const __m128 dy = _mm_cvtepi32_ps(channel(pixels, params.fYChannelShift, opaque, scales));
+    const __m128i srcX = _mm_add_epi32(_mm_setr_epi32(x, x + 1, x + 2, x + 3), _mm_cvttps_epi32(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(params.fScaleX), dx),
+                       _mm_set1_ps(params.fOffsetX))));
+    const __m128i srcY = _mm_add_epi32(_mm_set1_epi32(y), _mm_cvttps_epi32(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(params.fScaleY), dy),
+                       _mm_set1_ps(params.fOffsetY))));
+    Ints index;
+    index.v = _mm_add_epi32(Multiply32_SSE2(srcY, _mm_set1_epi32(params.fColorStride)), srcX);
+
+    int inside = 0xF;
+    if (checkBounds) {
+        const __m128i minusOne = _mm_set1_epi32(-1);
+        const __m128i insideX = _mm_and_si128(
+                _mm_cmpgt_epi32(srcX, minusOne),
+                _mm_cmplt_epi32(srcX, _mm_set1_epi32(params.fColorWidth)));
+        const __m128i insideY = _mm_and_si128(
+                _mm_cmpgt_epi32(srcY, minusOne),
+                _mm_cmplt_epi32(srcY, _mm_set1_epi32(params.fColorHeight)));
+        inside = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(insideX, insideY)));
+    }
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = (inside & (1 << i)) ? params.fColor[index.i[i]] : 0;
+    }
+}
+
+template <bool checkBounds>
+static void displace_row_SSE2(const SkDisplacementMapParams& params,
+                              const SkPMColor* displ, int x, int y,
+                              SkPMColor dst[], int count) {
+    const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        displace4<checkBounds>(params, table, displ + i, x + i, y, dst + i);
+    }
+    if (i < count) {
+        // The pixels past the end of the row may be displaced anywhere, so check them all.
+        SkPMColor lastDispl[4] = { 0, 0, 0, 0 };
+        SkPMColor lastDst[4];
+        for (int p = 0; i + p < count; ++p) {
+            lastDispl[p] = displ[i + p];
+        }
+        displace4<true>(params, table, lastDispl, x + i, y, lastDst);
+        for (int p = 0; i + p < count; ++p) {
+            dst[i + p] = lastDst[p];
+        }
+    }
+}
+
+SkDisplacementMapRowProc SkDisplacementMapGetRowProc_SSE2(bool checkBounds) {
+    return checkBounds ? displace_row_SSE2<true> : displace_row_SSE2<false>;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDistanceField_opts_DEFINED
+#define SkDistanceField_opts_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  The column pass of the exact distance transform in SkDistanceFieldGen.cpp.
+ *  For every texel of the width x height grid of edges (non-zero for edge
+ *  texels), stores in rows the row of the nearest edge texel in the same
+ *  column, or a row outside [0, height) if the column has none. scratch holds
+ *  width values.
+ */
+typedef void (*SkDistanceFieldColumnProc)(const unsigned char* edges, int width, int height,
+                                          int32_t* rows, int32_t* scratch);
+
+SkDistanceFieldColumnProc SkDistanceFieldGetPlatformColumnProc();
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkDistanceField_opts_SSE2.h"
+
+/* SSE2 version of nearest_edge_rows(), working on four columns at a time.
+ * The portable version is in src/core/SkDistanceFieldGen.cpp.
+ */
+
+static const int32_t kFar = 1 << 28;
+
+// 0xFFFFFFFF for each of the next four texels that is not an edge.
+static inline __m128i not_edge_mask(const unsigned char* edges) {
+    int32_t four;
+    memcpy(&four, edges, sizeof(four));
+    __m128i e = _mm_cvtsi32_si128(four);
+    e = _mm_unpacklo_epi8(e, _mm_setzero_si128());
+    e = _mm_unpacklo_epi16(e, _mm_setzero_si128());
+    return _mm_cmpeq_epi32(e, _mm_setzero_si128());
+}
+
+static inline __m128i select(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+void SkDistanceFieldColumns_SSE2(const unsigned char* edges, int width, int height,
+                                 int32_t* rows, int32_t* scratch) {
+    const int simdWidth = width & ~3;
+
+    // Down the columns: the nearest edge at or above each texel.
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* edgeRow = edges + y * width;
+        int32_t* row = rows + y * width;
+        const int32_t* above = y > 0 ? row - width : NULL;
+        const __m128i ys = _mm_set1_epi32(y);
+        const __m128i none = _mm_set1_epi32(-kFar);
+        int x = 0;
+        for (; x < simdWidth; x += 4) {
+            const __m128i prev = y > 0 ? _mm_loadu_si128((const __m128i*)(above + x)) : none;
+            _mm_storeu_si128((__m128i*)(row + x), select(not_edge_mask(edgeRow + x), prev, ys));
+        }
+        for (; x < width; ++x) {
+            row[x] = edgeRow[x] ? y : (y > 0 ? above[x] : -kFar);
+        }
+    }
+
+    // Up the columns: the nearest edge at or below, kept if it is closer.
+    for (int x = 0; x < width; ++x) {
+        scratch[x] = kFar;
+    }
+    for (int y = height - 1; y >= 0; --y) {
+        const unsigned char* edgeRow = edges + y * width;
+        int32_t* row = rows + y * width;
+        const __m128i ys = _mm_set1_epi32(y);
+        int x = 0;
+        for (; x < simdWidth; x += 4) {
+            __m128i below = _mm_loadu_si128((const __m128i*)(scratch + x));
+            below = select(not_edge_mask(edgeRow + x), below, ys);
+            _mm_storeu_si128((__m128i*)(scratch + x), below);
+
+            const __m128i above = _mm_loadu_si128((const __m128i*)(row + x));
+            const __m128i closer = _mm_cmplt_epi32(_mm_sub_epi32(below, ys),
+                                                   _mm_sub_epi32(ys, above));
+            _mm_storeu_si128((__m128i*)(row + x), select(closer, below, above));
+        }
+        for (; x < width; ++x) {
+            if (edgeRow[x]) {
+                scratch[x] = y;
+            }
+            if (scratch[x] - y < y - row[x]) {
+                row[x] = scratch[x];
+            }
+        }
+    }
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDistanceField_opts_SSE2_DEFINED
+#define SkDistanceField_opts_SSE2_DEFINED
+
+#include "SkTypes.h"
+
+void SkDistanceFieldColumns_SSE2(const unsigned char* edges, int width, int height,
+                                 int32_t* rows, int32_t* scratch);
+
+#endif
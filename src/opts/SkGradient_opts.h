@@ -0,0 +1,81 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_DEFINED
+#define SkGradient_opts_DEFINED
+
+#include "SkShader.h"
+
+/**
+ *  Platform versions of the shadeSpan loops of the 32-bit gradient shaders. Each one
+ *  writes count colors looked up in a gradient's cache of 256 colors, tiled with the tile
+ *  mode it was returned for. To dither, even pixels of the span read the row at cache0 and
+ *  odd pixels the row at cache1.
+ */
+
+/**
+ *  SkLinearGradient: the positions fx, fx + dx, fx + 2 * dx, ... in SkFixed.
+ */
+typedef void (*SkLinearGradientSpanProc)(SkFixed fx, SkFixed dx, SkPMColor dstC[],
+                                         const SkPMColor* cache0, const SkPMColor* cache1,
+                                         int count);
+
+/**
+ *  SkRadialGradient: the distances from the origin of (fx, fy), (fx + dx, fy + dy), ...
+ *  There is none for kClamp_TileMode, which looks up its distances in a table.
+ */
+typedef void (*SkRadialGradientSpanProc)(float fx, float dx, float fy, float dy,
+                                         SkPMColor dstC[], const SkPMColor* cache0,
+                                         const SkPMColor* cache1, int count);
+
+/**
+ *  SkTwoPointConicalGradient: the state of the span's first point, see TwoPtRadial and
+ *  TwoPtRadialContext in SkTwoPointConicalGradient.cpp. Points where the gradient is not
+ *  drawn get 0.
+ */
+struct SkTwoPointConicalSpan {
+    float   fRelX, fRelY;   // the point, relative to the start center
+    float   fIncX, fIncY;   // the step from one point to the next
+    float   fB, fDB;        // the linear coefficient of the point's quadratic, and its step
+    float   fA;             // the quadratic coefficient, the same for every point
+    float   fRadius2;       // the start radius squared
+    float   fRadius;
+    float   fDRadius;       // the end radius minus the start radius
+    bool    fFlipped;
+};
+
+typedef void (*SkTwoPointConicalSpanProc)(const SkTwoPointConicalSpan& span, SkPMColor dstC[],
+                                          const SkPMColor* cache0, const SkPMColor* cache1,
+                                          int count);
+
+SkLinearGradientSpanProc SkLinearGradientGetPlatformSpanProc(SkShader::TileMode);
+SkRadialGradientSpanProc SkRadialGradientGetPlatformSpanProc(SkShader::TileMode);
+SkTwoPointConicalSpanProc SkTwoPointConicalGetPlatformSpanProc(SkShader::TileMode);
+
+/**
+ *  SkGradientShader::kInterpolateColorsPerPixel_Flag: instead of reading a cache, the colors
+ *  are interpolated between the gradient's stops for each pixel.
+ */
+struct SkGradientStop {
+    float   fColor[4];  // the channels in [0, 255], in the byte order of SkPMColor
+    float   fSlope[4];  // the change of each channel per unit of position up to the next stop
+    float   fPos;       // in [0, 1], never less than the previous stop's
+};
+
+/**
+ *  Writes the colors at the tiled positions t[], each in [0, 1] or NaN for pixels that are not
+ *  drawn, which get 0. Before truncating the channels, dither[0] is added to those of even
+ *  pixels and dither[1] to those of odd pixels. If premultiply is true, the stops hold unpremul
+ *  colors and each result is premultiplied by its alpha after truncation.
+ */
+typedef void (*SkGradientInterpolateProc)(const SkGradientStop stops[], int stopCount,
+                                          bool premultiply, const float t[],
+                                          const float dither[2], SkPMColor dstC[], int count);
+
+SkGradientInterpolateProc SkGradientGetPlatformInterpolateProc();
+
+#endif
@@ -0,0 +1,427 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkGradient_opts_SSE2.h"
+
+/* SSE2 versions of the 32-bit shadeSpan loops of SkLinearGradient, SkRadialGradient and
+ * SkTwoPointConicalGradient. Each step positions, tiles and looks up four pixels; SSE2 has
+ * no gather, so only the cache reads are done one pixel at a time. They read the same cache
+ * entries as the portable loops.
+ */
+
+// The tile procs of SkGradientShaderPriv.h, on four SkFixed.
+template <SkShader::TileMode kTileMode>
+static inline __m128i tile(__m128i x) {
+    switch (kTileMode) {
+        case SkShader::kClamp_TileMode: {
+            x = _mm_andnot_si128(_mm_srai_epi32(x, 31), x);
+            const __m128i max = _mm_set1_epi32(0xFFFF);
+            const __m128i over = _mm_cmpgt_epi32(x, max);
+            return _mm_or_si128(_mm_and_si128(over, max), _mm_andnot_si128(over, x));
+        }
+        case SkShader::kRepeat_TileMode:
+            return _mm_and_si128(x, _mm_set1_epi32(0xFFFF));
+        default: {
+            const __m128i s = _mm_srai_epi32(_mm_slli_epi32(x, 15), 31);
+            return _mm_and_si128(_mm_xor_si128(x, s), _mm_set1_epi32(0xFFFF));
+        }
+    }
+}
+
+// Turns four tiled SkFixed into offsets from cache0, see dither_offsets().
+static inline __m128i cache_indices(__m128i x, __m128i ditherOffsets) {
+    return _mm_add_epi32(_mm_srli_epi32(x, 8), ditherOffsets);
+}
+
+// The odd pixels of a span read cache1, as far from cache0 as this.
+static inline __m128i dither_offsets(const SkPMColor* cache0, const SkPMColor* cache1) {
+    const int odd = SkToInt(cache1 - cache0);
+    return _mm_set_epi32(odd, 0, odd, 0);
+}
+
+static inline void lookup_colors(SkPMColor dst[], __m128i indices, const SkPMColor* cache) {
+    int32_t i[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(i), indices);
+    dst[0] = cache[i[0]];
+    dst[1] = cache[i[1]];
+    dst[2] = cache[i[2]];
+    dst[3] = cache[i[3]];
+}
+
+// Like lookup_colors(), for the last count < 4 pixels of a span.
+static inline void lookup_colors(SkPMColor dst[], __m128i indices, const SkPMColor* cache,
+                                 int count) {
+    SkPMColor colors[4];
+    lookup_colors(colors, indices, cache);
+    memcpy(dst, colors, count * sizeof(SkPMColor));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+template <SkShader::TileMode kTileMode>
+static void linear_span(SkFixed fx, SkFixed dx, SkPMColor dstC[],
+                        const SkPMColor* cache0, const SkPMColor* cache1, int count) {
+    const __m128i ditherOffsets = dither_offsets(cache0, cache1);
+
+    // SkFixed wraps around like the portable loop's fx += dx.
+    const uint32_t udx = dx;
+    __m128i x = _mm_add_epi32(_mm_set1_epi32(fx), _mm_set_epi32(3 * udx, 2 * udx, udx, 0));
+    const __m128i step = _mm_set1_epi32(4 * udx);
+
+    for (; count >= 4; count -= 4) {
+        lookup_colors(dstC, cache_indices(tile<kTileMode>(x), ditherOffsets), cache0);
+        x = _mm_add_epi32(x, step);
+        dstC += 4;
+    }
+    if (count > 0) {
+        lookup_colors(dstC, cache_indices(tile<kTileMode>(x), ditherOffsets), cache0, count);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// SkFloatToFixed() on four floats. Like the scalar conversion on x86, values out of range
+// become 0x80000000.
+static inline __m128i float_to_fixed(__m128 x) {
+    return _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(SK_Fixed1)));
+}
+
+// The next four positions from *x. Like the portable loops, this adds dx once per pixel, so
+// that the positions round the same way.
+static inline __m128 next_positions(float* x, float dx) {
+    const float x0 = *x;
+    const float x1 = x0 + dx;
+    const float x2 = x1 + dx;
+    const float x3 = x2 + dx;
+    *x = x3 + dx;
+    return _mm_setr_ps(x0, x1, x2, x3);
+}
+
+template <SkShader::TileMode kTileMode>
+static void radial_span(float fx, float dx, float fy, float dy, SkPMColor dstC[],
+                        const SkPMColor* cache0, const SkPMColor* cache1, int count) {
+    const __m128i ditherOffsets = dither_offsets(cache0, cache1);
+
+    for (;;) {
+        const __m128 x = next_positions(&fx, dx);
+        const __m128 y = next_positions(&fy, dy);
+        const __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+        const __m128i indices = cache_indices(tile<kTileMode>(float_to_fixed(dist)),
+                                              ditherOffsets);
+        if (count < 4) {
+            lookup_colors(dstC, indices, cache0, count);
+            return;
+        }
+        lookup_colors(dstC, indices, cache0);
+        if (0 == (count -= 4)) {
+            return;
+        }
+        dstC += 4;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// TwoPtRadialContext::nextT() on four points, with find_quad_roots() and the choice of root
+// done on all four at once. Sets skip to all ones where the gradient is not drawn.
+static inline __m128i two_point_conical_t(const SkTwoPointConicalSpan& span,
+                                          __m128 relX, __m128 relY, __m128 b, __m128i* skip) {
+    const __m128 radius = _mm_set1_ps(span.fRadius);
+    const __m128 dRadius = _mm_set1_ps(span.fDRadius);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(relX, relX), _mm_mul_ps(relY, relY)),
+                                _mm_set1_ps(span.fRadius2));
+
+    __m128 t, invalid;
+    if (0 == span.fA) {
+        // One root, if b is not zero.
+        t = _mm_div_ps(_mm_xor_ps(c, _mm_set1_ps(-0.0f)), b);
+        invalid = _mm_or_ps(_mm_cmpeq_ps(b, zero),
+                            _mm_cmple_ps(_mm_add_ps(radius, _mm_mul_ps(t, dRadius)), zero));
+    } else {
+        const __m128 a = _mm_set1_ps(span.fA);
+        const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b),
+                                               _mm_mul_ps(_mm_set1_ps(4 * span.fA), c));
+        const __m128 noRoots = _mm_cmplt_ps(discriminant, zero);
+        const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+
+        // q = -(b - root) where b < 0, and -(b + root) elsewhere, halved.
+        const __m128 negative = _mm_cmplt_ps(b, zero);
+        const __m128 signedRoot = _mm_xor_ps(root, _mm_and_ps(negative, _mm_set1_ps(-0.0f)));
+        const __m128 q = _mm_mul_ps(_mm_add_ps(b, signedRoot), _mm_set1_ps(-0.5f));
+
+        // Where q is zero, so is the only root.
+        const __m128 qZero = _mm_cmpeq_ps(q, zero);
+        const __m128 r0 = _mm_div_ps(q, a);
+        const __m128 r1 = _mm_div_ps(c, q);
+        const __m128 lo = _mm_andnot_ps(qZero, _mm_min_ps(r0, r1));
+        const __m128 hi = _mm_andnot_ps(qZero, _mm_max_ps(r0, r1));
+
+        // Prefer the bigger t (the smaller, if flipped) if both give a radius > 0.
+        const __m128 first = span.fFlipped ? lo : hi;
+        const __m128 second = span.fFlipped ? hi : lo;
+        const __m128 useSecond = _mm_cmple_ps(_mm_add_ps(radius, _mm_mul_ps(first, dRadius)),
+                                              zero);
+        const __m128 secondBad = _mm_cmple_ps(_mm_add_ps(radius, _mm_mul_ps(second, dRadius)),
+                                              zero);
+        t = select(useSecond, second, first);
+        invalid = _mm_or_ps(noRoots, _mm_and_ps(useSecond, secondBad));
+    }
+
+    const __m128i fixedT = float_to_fixed(t);
+    *skip = _mm_or_si128(_mm_castps_si128(invalid),
+                         _mm_cmpeq_epi32(fixedT, _mm_set1_epi32(0x80000000)));
+    return fixedT;
+}
+
+template <SkShader::TileMode kTileMode>
+static void two_point_conical_span(const SkTwoPointConicalSpan& span, SkPMColor dstC[],
+                                   const SkPMColor* cache0, const SkPMColor* cache1,
+                                   int count) {
+    const __m128i ditherOffsets = dither_offsets(cache0, cache1);
+
+    float relX = span.fRelX;
+    float relY = span.fRelY;
+    float b = span.fB;
+    for (;;) {
+        const __m128 relX4 = next_positions(&relX, span.fIncX);
+        const __m128 relY4 = next_positions(&relY, span.fIncY);
+        const __m128 b4 = next_positions(&b, span.fDB);
+        __m128i skip;
+        const __m128i t = two_point_conical_t(span, relX4, relY4, b4, &skip);
+        const __m128i indices = cache_indices(tile<kTileMode>(t), ditherOffsets);
+
+        SkPMColor colors[4];
+        lookup_colors(colors, indices, cache0);
+        const __m128i result = _mm_andnot_si128(
+            skip, _mm_loadu_si128(reinterpret_cast<const __m128i*>(colors)));
+        if (count < 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(colors), result);
+            memcpy(dstC, colors, count * sizeof(SkPMColor));
+            return;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstC), result);
+        if (0 == (count -= 4)) {
+            return;
+        }
+        dstC += 4;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// The channels of the color at t, plus bias, truncated. Walks *index from the previous pixel's
+// stop to the last stop at or before t.
+static inline __m128i interpolate(const SkGradientStop stops[], int lastSegment, int* index,
+                                  float t, __m128 bias) {
+    if (t != t) {
+        return _mm_setzero_si128();
+    }
+    int i = *index;
+    while (i > 0 && t < stops[i].fPos) {
+        --i;
+    }
+    while (i < lastSegment && t >= stops[i + 1].fPos) {
+        ++i;
+    }
+    *index = i;
+
+    const SkGradientStop& stop = stops[i];
+    const __m128 color = _mm_add_ps(_mm_loadu_ps(stop.fColor),
+                                    _mm_mul_ps(_mm_set1_ps(t - stop.fPos),
+                                               _mm_loadu_ps(stop.fSlope)));
+    return _mm_cvttps_epi32(_mm_add_ps(color, bias));
+}
+
+// SkMulDiv255Round() of each channel of two pixels, in 16 bits, by their alpha.
+static inline __m128i premultiply_pair(__m128i c) {
+    const int kA = SK_A32_SHIFT / 8;
+    c = _mm_min_epi16(_mm_max_epi16(c, _mm_setzero_si128()), _mm_set1_epi16(255));
+
+    __m128i alpha = _mm_shufflelo_epi16(c, _MM_SHUFFLE(kA, kA, kA, kA));
+    alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(kA, kA, kA, kA));
+    // Alpha itself is scaled by 255, which leaves it as it is.
+    const __m128i alphaLanes = _mm_set_epi16(3 == kA ? -1 : 0, 2 == kA ? -1 : 0,
+                                             1 == kA ? -1 : 0, 0 == kA ? -1 : 0,
+                                             3 == kA ? -1 : 0, 2 == kA ? -1 : 0,
+                                             1 == kA ? -1 : 0, 0 == kA ? -1 : 0);
+    alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha),
+                         _mm_and_si128(alphaLanes, _mm_set1_epi16(255)));
+
+    const __m128i prod = _mm_add_epi16(_mm_mullo_epi16(c, alpha), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(prod, _mm_srli_epi16(prod, 8)), 8);
+}
+
+// SkMulDiv255Round() of a channel of four pixels, in 32 bits, by their alpha.
+static inline __m128i premultiply_channel(__m128i c, __m128i alpha) {
+    const __m128i prod = _mm_add_epi32(_mm_mullo_epi16(c, alpha), _mm_set1_epi32(128));
+    return _mm_srli_epi32(_mm_add_epi32(prod, _mm_srli_epi32(prod, 8)), 8);
+}
+
+// A stop, broadcast for interpolate4().
+struct Stop4 {
+    __m128  fColor0, fColor1, fColor2, fColor3;
+    __m128  fSlope0, fSlope1, fSlope2, fSlope3;
+    __m128  fPos;
+
+    explicit Stop4(const SkGradientStop& stop)
+        : fColor0(_mm_set1_ps(stop.fColor[0]))
+        , fColor1(_mm_set1_ps(stop.fColor[1]))
+        , fColor2(_mm_set1_ps(stop.fColor[2]))
+        , fColor3(_mm_set1_ps(stop.fColor[3]))
+        , fSlope0(_mm_set1_ps(stop.fSlope[0]))
+        , fSlope1(_mm_set1_ps(stop.fSlope[1]))
+        , fSlope2(_mm_set1_ps(stop.fSlope[2]))
+        , fSlope3(_mm_set1_ps(stop.fSlope[3]))
+        , fPos(_mm_set1_ps(stop.fPos)) {}
+};
+
+static inline __m128i interpolate_channel(__m128 color, __m128 slope, __m128 dt, __m128 bias) {
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_add_ps(color, _mm_mul_ps(dt, slope)), bias));
+}
+
+// The colors of four pixels whose positions t all lie between stop and the next one, a
+// channel at a time. Rounds exactly like interpolate().
+static inline __m128i interpolate4(const Stop4& stop, __m128 t, __m128 bias, bool premultiply) {
+    const __m128 dt = _mm_sub_ps(t, stop.fPos);
+    __m128i c0 = interpolate_channel(stop.fColor0, stop.fSlope0, dt, bias);
+    __m128i c1 = interpolate_channel(stop.fColor1, stop.fSlope1, dt, bias);
+    __m128i c2 = interpolate_channel(stop.fColor2, stop.fSlope2, dt, bias);
+    __m128i c3 = interpolate_channel(stop.fColor3, stop.fSlope3, dt, bias);
+    if (premultiply) {
+        // The channels are small enough for 16-bit clamping and multiplies.
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i max = _mm_set1_epi32(255);
+        c0 = _mm_min_epi16(_mm_max_epi16(c0, zero), max);
+        c1 = _mm_min_epi16(_mm_max_epi16(c1, zero), max);
+        c2 = _mm_min_epi16(_mm_max_epi16(c2, zero), max);
+        c3 = _mm_min_epi16(_mm_max_epi16(c3, zero), max);
+        const __m128i alpha = 0 == SK_A32_SHIFT ? c0 : c3;
+        SkASSERT(0 == SK_A32_SHIFT || 24 == SK_A32_SHIFT);
+        if (0 == SK_A32_SHIFT) {
+            c1 = premultiply_channel(c1, alpha);
+            c2 = premultiply_channel(c2, alpha);
+            c3 = premultiply_channel(c3, alpha);
+        } else {
+            c0 = premultiply_channel(c0, alpha);
+            c1 = premultiply_channel(c1, alpha);
+            c2 = premultiply_channel(c2, alpha);
+        }
+    }
+
+    // Pack to the bytes of channels 0, 2, 1, 3, each for pixels 0..3, then interleave.
+    const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(c0, c2), _mm_packs_epi32(c1, c3));
+    const __m128i pairs = _mm_unpacklo_epi8(bytes, _mm_srli_si128(bytes, 8));
+    return _mm_unpacklo_epi16(pairs, _mm_srli_si128(pairs, 8));
+}
+
+static void interpolate_span(const SkGradientStop stops[], int stopCount, bool premultiply,
+                             const float t[], const float dither[2], SkPMColor dstC[],
+                             int count) {
+    const __m128 bias0 = _mm_set1_ps(dither[0]);
+    const __m128 bias1 = _mm_set1_ps(dither[1]);
+    const __m128 bias = _mm_setr_ps(dither[0], dither[1], dither[0], dither[1]);
+    const int lastSegment = stopCount - 2;
+    int index = 0;
+
+    while (count >= 4) {
+        // Most runs of four pixels stay between the same two stops. NaN never does.
+        const Stop4 stop(stops[index]);
+        const __m128 lo = _mm_set1_ps(index > 0 ? stops[index].fPos : -SK_FloatInfinity);
+        const __m128 hi = _mm_set1_ps(index < lastSegment ? stops[index + 1].fPos
+                                                          : SK_FloatInfinity);
+        for (;;) {
+            const __m128 t4 = _mm_loadu_ps(t);
+            if (0xF != _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(t4, lo), _mm_cmplt_ps(t4, hi)))) {
+                break;
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstC),
+                             interpolate4(stop, t4, bias, premultiply));
+            t += 4;
+            dstC += 4;
+            if ((count -= 4) < 4) {
+                break;
+            }
+        }
+        if (count < 4) {
+            break;
+        }
+
+        const __m128i c0 = interpolate(stops, lastSegment, &index, t[0], bias0);
+        const __m128i c1 = interpolate(stops, lastSegment, &index, t[1], bias1);
+        const __m128i c2 = interpolate(stops, lastSegment, &index, t[2], bias0);
+        const __m128i c3 = interpolate(stops, lastSegment, &index, t[3], bias1);
+        __m128i c01 = _mm_packs_epi32(c0, c1);
+        __m128i c23 = _mm_packs_epi32(c2, c3);
+        if (premultiply) {
+            c01 = premultiply_pair(c01);
+            c23 = premultiply_pair(c23);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstC), _mm_packus_epi16(c01, c23));
+        t += 4;
+        dstC += 4;
+        count -= 4;
+    }
+    for (int i = 0; i < count; ++i) {
+        const __m128i c = interpolate(stops, lastSegment, &index, t[i], (i & 1) ? bias1 : bias0);
+        __m128i c16 = _mm_packs_epi32(c, c);
+        if (premultiply) {
+            c16 = premultiply_pair(c16);
+        }
+        dstC[i] = _mm_cvtsi128_si32(_mm_packus_epi16(c16, c16));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkLinearGradientSpanProc SkLinearGradientGetSpanProc_SSE2(SkShader::TileMode tileMode) {
+    // SkLinearGradient splits clamped spans with SkClampRange, and what is left of the loop
+    // is already a shift and a load per pixel.
+    switch (tileMode) {
+        case SkShader::kRepeat_TileMode:
+            return linear_span<SkShader::kRepeat_TileMode>;
+        case SkShader::kMirror_TileMode:
+            return linear_span<SkShader::kMirror_TileMode>;
+        default:
+            return NULL;
+    }
+}
+
+SkRadialGradientSpanProc SkRadialGradientGetSpanProc_SSE2(SkShader::TileMode tileMode) {
+    // SkRadialGradient looks up clamped distances in its 8-bit sqrt table, which a float
+    // sqrt does not match.
+    switch (tileMode) {
+        case SkShader::kRepeat_TileMode:
+            return radial_span<SkShader::kRepeat_TileMode>;
+        case SkShader::kMirror_TileMode:
+            return radial_span<SkShader::kMirror_TileMode>;
+        default:
+            return NULL;
+    }
+}
+
+SkTwoPointConicalSpanProc SkTwoPointConicalGetSpanProc_SSE2(SkShader::TileMode tileMode) {
+    switch (tileMode) {
+        case SkShader::kClamp_TileMode:
+            return two_point_conical_span<SkShader::kClamp_TileMode>;
+        case SkShader::kRepeat_TileMode:
+            return two_point_conical_span<SkShader::kRepeat_TileMode>;
+        case SkShader::kMirror_TileMode:
+            return two_point_conical_span<SkShader::kMirror_TileMode>;
+        default:
+            return NULL;
+    }
+}
+
+SkGradientInterpolateProc SkGradientGetInterpolateProc_SSE2() {
+    return interpolate_span;
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGradient_opts_SSE2_DEFINED
+#define SkGradient_opts_SSE2_DEFINED
+
+#include "SkGradient_opts.h"
+
+SkLinearGradientSpanProc SkLinearGradientGetSpanProc_SSE2(SkShader::TileMode);
+SkRadialGradientSpanProc SkRadialGradientGetSpanProc_SSE2(SkShader::TileMode);
+SkTwoPointConicalSpanProc SkTwoPointConicalGetSpanProc_SSE2(SkShader::TileMode);
+SkGradientInterpolateProc SkGradientGetInterpolateProc_SSE2();
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGradient_opts.h"
+
+SkLinearGradientSpanProc SkLinearGradientGetPlatformSpanProc(SkShader::TileMode) {
+    return NULL;
+}
+
+SkRadialGradientSpanProc SkRadialGradientGetPlatformSpanProc(SkShader::TileMode) {
+    return NULL;
+}
+
+SkTwoPointConicalSpanProc SkTwoPointConicalGetPlatformSpanProc(SkShader::TileMode) {
+    return NULL;
+}
+
+SkGradientInterpolateProc SkGradientGetPlatformInterpolateProc() {
+    return NULL;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkLighting_opts_DEFINED
+#define SkLighting_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  The light and the lighting of SkLightingImageFilter, see
+ *  http://www.w3.org/TR/SVG/filters.html#feDiffuseLightingElement
+ *  http://www.w3.org/TR/SVG/filters.html#feSpecularLightingElement
+ */
+struct SkLightingParams {
+    enum LightType {
+        kDistant_LightType,
+        kPoint_LightType,
+        kSpot_LightType,
+    };
+
+    LightType   fLightType;
+    float       fColor[3];
+    float       fDirection[3];          // distant: from the surface to the light
+    float       fLocation[3];           // point and spot
+    float       fS[3];                  // spot: from the light to its target, normalized
+    float       fSpecularExponent;      // spot
+    float       fCosOuterConeAngle;     // spot
+    float       fCosInnerConeAngle;     // spot
+    float       fConeScale;             // spot
+
+    bool        fSpecular;              // otherwise diffuse
+    float       fK;                     // kd if diffuse, ks if specular
+    float       fShininess;             // specular
+    float       fSurfaceScale;
+};
+
+/**
+ *  Lights count pixels (x, y), (x + 1, y), ..., none of them on the edge of the bitmap. src[0],
+ *  src[1] and src[2] point to the pixels left of the first one in the rows y - 1, y and y + 1.
+ */
+typedef void (*SkLightingRowProc)(const SkLightingParams& params, const SkPMColor* const src[3],
+                                  int x, int y, SkPMColor dst[], int count);
+
+SkLightingRowProc SkLightingGetPlatformRowProc();
+
+#endif
@@ -0,0 +1,311 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorPriv.h"
+#include "SkLighting_opts_SSE2.h"
+#include "SkMath_opts_SSE2.h"
+#include "SkScalar.h"
+
+/* SSE2 version of the lighting of SkLightingImageFilter, for pixels away from the edges of the
+ * bitmap. Four pixels are lit at a time, with their vectors kept one component per register.
+ * There is no SSE2 pow, so SkScalarPow() is still called once per pixel.
+ */
+
+namespace {
+
+// A vector of each of four pixels.
+struct Vector4 {
+    __m128 fX, fY, fZ;
+
+    __m128 dot(const Vector4& other) const {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(fX, other.fX), _mm_mul_ps(fY, other.fY)),
+                          _mm_mul_ps(fZ, other.fZ));
+    }
+
+    // As SkPoint3::normalize().
+    void normalize() {
+        const __m128 length = _mm_add_ps(_mm_sqrt_ps(this->dot(*this)),
+                                         _mm_set1_ps(SK_ScalarNearlyZero));
+        const __m128 scale = _mm_div_ps(_mm_set1_ps(SK_Scalar1), length);
+        fX = _mm_mul_ps(fX, scale);
+        fY = _mm_mul_ps(fY, scale);
+        fZ = _mm_mul_ps(fZ, scale);
+    }
+
+    Vector4 operator*(__m128 scale) const {
+        Vector4 v = { _mm_mul_ps(fX, scale), _mm_mul_ps(fY, scale), _mm_mul_ps(fZ, scale) };
+        return v;
+    }
+};
+
+union Floats {
+    __m128  v;
+    float   f[4];
+};
+
+// The alphas of the pixels around four pixels, as the m[9] of SkLightingImageFilter.cpp.
+struct Neighborhood {
+    __m128i m[9];
+};
+
+}  // namespace
+
+static inline Vector4 splat(const float v[3]) {
+    Vector4 result = { _mm_set1_ps(v[0]), _mm_set1_ps(v[1]), _mm_set1_ps(v[2]) };
+    return result;
+}
+
+static inline __m128i load_alphas(const SkPMColor* src) {
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    return _mm_and_si128(_mm_srli_epi32(pixels, SK_A32_SHIFT), _mm_set1_epi32(0xFF));
+}
+
+static inline void load_neighborhood(const SkPMColor* const src[3], int i, Neighborhood* n) {
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            n->m[3 * row + column] = load_alphas(src[row] + i + column);
+        }
+    }
+}
+
+// -a + b - 2 * c + 2 * d - e + f, times scale.
+static inline __m128 sobel(__m128i a, __m128i b, __m128i c, __m128i d, __m128i e, __m128i f,
+                           float scale) {
+    const __m128i sum = _mm_add_epi32(_mm_sub_epi32(b, a), _mm_sub_epi32(f, e));
+    const __m128i twice = _mm_slli_epi32(_mm_sub_epi32(d, c), 1);
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(sum, twice)), _mm_set1_ps(scale));
+}
+
+// As interiorNormal().
+static inline Vector4 interior_normal(const Neighborhood& n, float surfaceScale) {
+    const __m128i* m = n.m;
+    const __m128 negativeScale = _mm_set1_ps(-surfaceScale);
+    const float oneQuarter = 0.25f;
+    // -(x) * s is x * -s, negating is exact.
+    Vector4 normal = {
+        _mm_mul_ps(sobel(m[0], m[2], m[3], m[5], m[6], m[8], oneQuarter), negativeScale),
+        _mm_mul_ps(sobel(m[0], m[6], m[1], m[7], m[2], m[8], oneQuarter), negativeScale),
+        _mm_set1_ps(SK_Scalar1)
+    };
+    normal.normalize();
+    return normal;
+}
+
+// x < 0 ? 0 : x > max ? max : x, keeping NaN as SkScalarClampMax() does.
+static inline __m128 clamp_max(__m128 x, __m128 max) {
+    return _mm_min_ps(max, _mm_max_ps(_mm_setzero_ps(), x));
+}
+
+// floor(x + 0.5) pinned to [0, 255]. Like a float to int cast, NaN and overflow go to 0.
+static inline __m128i round_to_byte(__m128 x) {
+    __m128i i = SkScalarFloorToInt_SSE2(_mm_add_ps(x, _mm_set1_ps(0.5f)));
+    i = _mm_and_si128(i, _mm_cmpgt_epi32(i, _mm_setzero_si128()));
+    const __m128i max = _mm_set1_epi32(255);
+    const __m128i over = _mm_cmpgt_epi32(i, max);
+    return _mm_or_si128(_mm_and_si128(over, max), _mm_andnot_si128(over, i));
+}
+
+static inline __m128i pack_argb(__m128i a, __m128i r, __m128i g, __m128i b) {
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(a, SK_A32_SHIFT),
+                                     _mm_slli_epi32(r, SK_R32_SHIFT)),
+                        _mm_or_si128(_mm_slli_epi32(g, SK_G32_SHIFT),
+                                     _mm_slli_epi32(b, SK_B32_SHIFT)));
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+namespace {
+
+class DistantLight {
+public:
+    DistantLight(const SkLightingParams& params)
+        : fSurfaceToLight(splat(params.fDirection))
+        , fColor(splat(params.fColor)) {}
+
+    Vector4 surfaceToLight(int, int, __m128i) const { return fSurfaceToLight; }
+    Vector4 lightColor(const Vector4&) const { return fColor; }
+
+private:
+    const Vector4 fSurfaceToLight;
+    const Vector4 fColor;
+};
+
+class PointLight {
+public:
+    PointLight(const SkLightingParams& params)
+        : fParams(params)
+        , fColor(splat(params.fColor)) {}
+
+    Vector4 surfaceToLight(int x, int y, __m128i z) const {
+        const __m128 xs = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x),
+                                                        _mm_setr_epi32(0, 1, 2, 3)));
+        Vector4 direction = {
+            _mm_sub_ps(_mm_set1_ps(fParams.fLocation[0]), xs),
+            _mm_set1_ps(fParams.fLocation[1] - SkIntToScalar(y)),
+            _mm_sub_ps(_mm_set1_ps(fParams.fLocation[2]),
+                       _mm_mul_ps(_mm_cvtepi32_ps(z), _mm_set1_ps(fParams.fSurfaceScale)))
+        };
+        direction.normalize();
+        return direction;
+    }
+
+    Vector4 lightColor(const Vector4&) const { return fColor; }
+
+protected:
+    const SkLightingParams& fParams;
+    const Vector4 fColor;
+};
+
+class SpotLight : public PointLight {
+public:
+    SpotLight(const SkLightingParams& params)
+        : PointLight(params)
+        , fS(splat(params.fS)) {}
+
+    Vector4 lightColor(const Vector4& surfaceToLight) const {
+        Floats cosAngle, scale;
+        cosAngle.v = _mm_xor_ps(surfaceToLight.dot(fS), _mm_set1_ps(-0.0f));
+        for (int i = 0; i < 4; ++i) {
+            const float c = cosAngle.f[i];
+            if (c < fParams.fCosOuterConeAngle) {
+                scale.f[i] = 0;
+                continue;
+            }
+            scale.f[i] = SkScalarPow(c, fParams.fSpecularExponent);
+            if (c < fParams.fCosInnerConeAngle) {
+                scale.f[i] = scale.f[i] * (c - fParams.fCosOuterConeAngle) * fParams.fConeScale;
+            }
+        }
+        return fColor * scale.v;
+    }
+
+private:
+    const Vector4 fS;
+};
+
+class DiffuseLighting {
+public:
+    DiffuseLighting(const SkLightingParams& params) : fKD(_mm_set1_ps(params.fK)) {}
+
+    __m128i light(const Vector4& normal, const Vector4& surfaceToLight,
+                  const Vector4& lightColor) const {
+        const __m128 colorScale = clamp_max(_mm_mul_ps(fKD, normal.dot(surfaceToLight)),
+                                            _mm_set1_ps(SK_Scalar1));
+        const Vector4 color = lightColor * colorScale;
+        return pack_argb(_mm_set1_epi32(255), round_to_byte(color.fX),
+                         round_to_byte(color.fY), round_to_byte(color.fZ));
+    }
+
+private:
+    const __m128 fKD;
+};
+
+class SpecularLighting {
+public:
+    SpecularLighting(const SkLightingParams& params)
+        : fKS(_mm_set1_ps(params.fK))
+        , fShininess(params.fShininess) {}
+
+    __m128i light(const Vector4& normal, const Vector4& surfaceToLight,
+                  const Vector4& lightColor) const {
+        Vector4 halfDir = surfaceToLight;
+        halfDir.fZ = _mm_add_ps(halfDir.fZ, _mm_set1_ps(SK_Scalar1));
+        halfDir.normalize();
+        Floats power;
+        power.v = normal.dot(halfDir);
+        for (int i = 0; i < 4; ++i) {
+            power.f[i] = SkScalarPow(power.f[i], fShininess);
+        }
+        const __m128 colorScale = clamp_max(_mm_mul_ps(fKS, power.v), _mm_set1_ps(SK_Scalar1));
+        const Vector4 color = lightColor * colorScale;
+        // As SkPoint3::maxComponent().
+        const __m128 maxXZ = select(_mm_cmpgt_ps(color.fX, color.fZ), color.fX, color.fZ);
+        const __m128 maxYZ = select(_mm_cmpgt_ps(color.fY, color.fZ), color.fY, color.fZ);
+        const __m128 max = select(_mm_cmpgt_ps(color.fX, color.fY), maxXZ, maxYZ);
+        return pack_argb(round_to_byte(max), round_to_byte(color.fX),
+                         round_to_byte(color.fY), round_to_byte(color.fZ));
+    }
+
+private:
+    const __m128 fKS;
+    const float  fShininess;
+};
+
+}  // namespace
+
+template <typename Lighting, typename Light>
+static inline __m128i light_pixels(const Lighting& lighting, const Light& light,
+                                   const Neighborhood& n, int x, int y, float surfaceScale) {
+    const Vector4 surfaceToLight = light.surfaceToLight(x, y, n.m[4]);
+    return lighting.light(interior_normal(n, surfaceScale), surfaceToLight,
+                          light.lightColor(surfaceToLight));
+}
+
+template <typename Lighting, typename Light>
+static void light_row(const SkLightingParams& params, const SkPMColor* const src[3],
+                      int x, int y, SkPMColor dst[], int count) {
+    const Lighting lighting(params);
+    const Light light(params);
+    const float surfaceScale = params.fSurfaceScale;
+    Neighborhood n;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        load_neighborhood(src, i, &n);
+        const __m128i colors = light_pixels(lighting, light, n, x + i, y, surfaceScale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), colors);
+    }
+
+    if (i < count) {
+        // The last pixels and their neighbors, with room to load four at a time.
+        SkPMColor tail[3][6];
+        const int neighbors = count - i + 2;
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 6; ++column) {
+                tail[row][column] = column < neighbors ? src[row][i + column] : 0;
+            }
+        }
+        const SkPMColor* const tailRows[3] = { tail[0], tail[1], tail[2] };
+        load_neighborhood(tailRows, 0, &n);
+        union {
+            __m128i   v;
+            SkPMColor c[4];
+        } colors;
+        colors.v = light_pixels(lighting, light, n, x + i, y, surfaceScale);
+        for (int p = 0; i + p < count; ++p) {
+            dst[i + p] = colors.c[p];
+        }
+    }
+}
+
+template <typename Lighting>
+static SkLightingRowProc choose_row_proc(SkLightingParams::LightType lightType) {
+    switch (lightType) {
+        case SkLightingParams::kDistant_LightType:
+            return light_row<Lighting, DistantLight>;
+        case SkLightingParams::kPoint_LightType:
+            return light_row<Lighting, PointLight>;
+        case SkLightingParams::kSpot_LightType:
+            return light_row<Lighting, SpotLight>;
+    }
+    return NULL;
+}
+
+static void light_row_SSE2(const SkLightingParams& params, const SkPMColor* const src[3],
+                           int x, int y, SkPMColor dst[], int count) {
+    const SkLightingRowProc proc = params.fSpecular ?
+            choose_row_proc<SpecularLighting>(params.fLightType) :
+            choose_row_proc<DiffuseLighting>(params.fLightType);
+    proc(params, src, x, y, dst, count);
+}
+
+SkLightingRowProc SkLightingGetRowProc_SSE2() {
+    return light_row_SSE2;
+}
@@ -0,0 +1,15 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkLighting_opts_SSE2_DEFINED
+#define SkLighting_opts_SSE2_DEFINED
+
+#include "SkLighting_opts.h"
+
+SkLightingRowProc SkLightingGetRowProc_SSE2();
+
+#endif
@@ -18,6 +18,15 @@ static inline __m128i shim_mm_div_epi32(const __m128i& a, const __m128i& b) {
     return _mm_cvttps_epi32(_mm_div_ps(x, y));
 }
 
+// SSE2 version of SkScalarFloorToInt(), which is (int)floorf(). Truncating rounds negative
+// values up, so 1 is subtracted from those that truncate above themselves. Out of range and
+// NaN lanes give 0x80000000, as the cast does on x86.
+static inline __m128i SkScalarFloorToInt_SSE2(const __m128& x) {
+    __m128 floored = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    floored = _mm_sub_ps(floored, _mm_and_ps(_mm_cmpgt_ps(floored, x), _mm_set1_ps(1.0f)));
+    return _mm_cvttps_epi32(floored);
+}
+
 // Portable version of SkSqrtBits is in SkMath.cpp.
 static inline __m128i SkSqrtBits_SSE2(const __m128i& x, int count) {
     __m128i root =  _mm_setzero_si128();
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMatrixConvolution_opts_DEFINED
+#define SkMatrixConvolution_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  The kernel of SkMatrixConvolutionImageFilter. The sums of the channels are multiplied by
+ *  fGain and offset by fBias, then floored and clamped as in SkMatrixConvolutionImageFilter.
+ */
+struct SkMatrixConvolutionParams {
+    const float*    fKernel;            // fKernelHeight rows of fKernelWidth
+    const float*    fRowKernel;         // separable kernels: fKernelWidth factors
+    const float*    fColumnKernel;      // separable kernels: fKernelHeight factors
+    int             fKernelWidth;
+    int             fKernelHeight;
+    int             fKernelOffsetX;
+    int             fKernelOffsetY;
+    float           fGain;
+    float           fBias;
+    bool            fConvolveAlpha;     // otherwise alpha is copied, and the colors premultiplied
+};
+
+/**
+ *  Convolves count pixels of a row, for none of which the kernel leaves the bitmap. src points to
+ *  the pixel under the top left of the kernel for the first pixel, and its rows are srcStride
+ *  pixels apart.
+ */
+typedef void (*SkMatrixConvolutionRowProc)(const SkMatrixConvolutionParams& params,
+                                           const SkPMColor* src, int srcStride,
+                                           SkPMColor dst[], int count);
+
+/**
+ *  Separable kernels, first pass: convolves count pixels of a row with fRowKernel, into four
+ *  floats per pixel in the order of the bytes of an SkPMColor. src points to the pixel under the
+ *  left of the kernel for the first pixel.
+ */
+typedef void (*SkMatrixConvolutionSumRowProc)(const SkMatrixConvolutionParams& params,
+                                              const SkPMColor* src, float dst[], int count);
+
+/**
+ *  Separable kernels, second pass: convolves the fKernelHeight rows of sums with fColumnKernel
+ *  into count pixels. src points to the first of the pixels themselves, whose alphas are copied
+ *  unless fConvolveAlpha.
+ */
+typedef void (*SkMatrixConvolutionSumColumnProc)(const SkMatrixConvolutionParams& params,
+                                                 const float* const rows[],
+                                                 const SkPMColor* src,
+                                                 SkPMColor dst[], int count);
+
+bool SkMatrixConvolutionGetPlatformProcs(SkMatrixConvolutionRowProc* convolveRow,
+                                         SkMatrixConvolutionSumRowProc* sumRow,
+                                         SkMatrixConvolutionSumColumnProc* sumColumn);
+
+/**
+ *  The procs SkMatrixConvolutionImageFilter uses when there are no platform ones. They are
+ *  defined in SkMatrixConvolutionImageFilter.cpp.
+ */
+void SkMatrixConvolutionGetPortableProcs(SkMatrixConvolutionRowProc* convolveRow,
+                                         SkMatrixConvolutionSumRowProc* sumRow,
+                                         SkMatrixConvolutionSumColumnProc* sumColumn);
+
+#endif
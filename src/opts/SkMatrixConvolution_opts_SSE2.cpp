@@ -0,0 +1,149 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorPriv.h"
+#include "SkMath_opts_SSE2.h"
+#include "SkMatrixConvolution_opts_SSE2.h"
+
+/* SSE2 version of the convolution of SkMatrixConvolutionImageFilter, for pixels whose kernel stays
+ * inside the bitmap. The four channels of a pixel are summed in one register, four pixels at a
+ * time, adding up the taps in the same order as SkMatrixConvolutionImageFilter.cpp.
+ */
+
+static const int kAlphaLane = SK_A32_SHIFT / 8;
+
+// The channels of a pixel as four floats, in the order of its bytes.
+static inline __m128 unpack(SkPMColor c) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(c);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+}
+
+// Adds the channels of four consecutive pixels times k to sums[0..3].
+static inline void accumulate4(const SkPMColor* src, __m128 k, __m128 sums[4]) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+    const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+    sums[0] = _mm_add_ps(sums[0], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), k));
+    sums[1] = _mm_add_ps(sums[1], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), k));
+    sums[2] = _mm_add_ps(sums[2], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), k));
+    sums[3] = _mm_add_ps(sums[3], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), k));
+}
+
+// Applies the gain and the bias to the sums of a pixel and packs it, as filterPixels() does.
+static inline SkPMColor pack(const SkMatrixConvolutionParams& params, __m128 sum,
+                             const SkPMColor* src) {
+    const __m128 scaled = _mm_add_ps(_mm_mul_ps(sum, _mm_set1_ps(params.fGain)),
+                                     _mm_set1_ps(params.fBias));
+    // 16 bits are plenty: every channel ends up in [0, 255].
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alphaMask = _mm_set_epi16(0, 0, 0, 0,
+                                            3 == kAlphaLane ? -1 : 0, 2 == kAlphaLane ? -1 : 0,
+                                            1 == kAlphaLane ? -1 : 0, 0 == kAlphaLane ? -1 : 0);
+    const __m128i max255 = _mm_set1_epi16(255);
+    __m128i channels = _mm_max_epi16(_mm_packs_epi32(SkScalarFloorToInt_SSE2(scaled), zero), zero);
+    channels = _mm_min_epi16(channels, max255);
+    if (params.fConvolveAlpha) {
+        // The colors can be no more than the alpha.
+        const __m128i alpha = _mm_shufflelo_epi16(channels, _MM_SHUFFLE(kAlphaLane, kAlphaLane,
+                                                                       kAlphaLane, kAlphaLane));
+        channels = _mm_min_epi16(channels, _mm_or_si128(alpha, _mm_and_si128(alphaMask, max255)));
+    } else {
+        // As SkPreMultiplyARGB() with the alpha of the source pixel.
+        const __m128i alpha = _mm_set1_epi16(SkGetPackedA32(*src));
+        __m128i product = _mm_add_epi16(_mm_mullo_epi16(channels, alpha), _mm_set1_epi16(128));
+        product = _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+        channels = _mm_or_si128(_mm_andnot_si128(alphaMask, product),
+                                _mm_and_si128(alphaMask, alpha));
+    }
+    return _mm_cvtsi128_si32(_mm_packus_epi16(channels, zero));
+}
+
+static void convolve_row_SSE2(const SkMatrixConvolutionParams& params,
+                              const SkPMColor* src, int srcStride,
+                              SkPMColor dst[], int count) {
+    const int kernelWidth = params.fKernelWidth;
+    const int kernelHeight = params.fKernelHeight;
+    const SkPMColor* center = src + params.fKernelOffsetY * srcStride + params.fKernelOffsetX;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sums[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+                           _mm_setzero_ps() };
+        const float* kernel = params.fKernel;
+        const SkPMColor* row = src + i;
+        for (int cy = 0; cy < kernelHeight; ++cy) {
+            for (int cx = 0; cx < kernelWidth; ++cx) {
+                accumulate4(row + cx, _mm_set1_ps(*kernel++), sums);
+            }
+            row += srcStride;
+        }
+        for (int p = 0; p < 4; ++p) {
+            dst[i + p] = pack(params, sums[p], center + i + p);
+        }
+    }
+    for (; i < count; ++i) {
+        __m128 sum = _mm_setzero_ps();
+        const float* kernel = params.fKernel;
+        const SkPMColor* row = src + i;
+        for (int cy = 0; cy < kernelHeight; ++cy) {
+            for (int cx = 0; cx < kernelWidth; ++cx) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(unpack(row[cx]), _mm_set1_ps(*kernel++)));
+            }
+            row += srcStride;
+        }
+        dst[i] = pack(params, sum, center + i);
+    }
+}
+
+static void sum_row_SSE2(const SkMatrixConvolutionParams& params,
+                         const SkPMColor* src, float dst[], int count) {
+    const int kernelWidth = params.fKernelWidth;
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sums[4] = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(),
+                           _mm_setzero_ps() };
+        for (int cx = 0; cx < kernelWidth; ++cx) {
+            accumulate4(src + i + cx, _mm_set1_ps(params.fRowKernel[cx]), sums);
+        }
+        for (int p = 0; p < 4; ++p) {
+            _mm_storeu_ps(dst + 4 * (i + p), sums[p]);
+        }
+    }
+    for (; i < count; ++i) {
+        __m128 sum = _mm_setzero_ps();
+        for (int cx = 0; cx < kernelWidth; ++cx) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(unpack(src[i + cx]),
+                                             _mm_set1_ps(params.fRowKernel[cx])));
+        }
+        _mm_storeu_ps(dst + 4 * i, sum);
+    }
+}
+
+static void sum_column_SSE2(const SkMatrixConvolutionParams& params,
+                            const float* const rows[], const SkPMColor* src,
+                            SkPMColor dst[], int count) {
+    const int kernelHeight = params.fKernelHeight;
+    for (int i = 0; i < count; ++i) {
+        __m128 sum = _mm_setzero_ps();
+        for (int cy = 0; cy < kernelHeight; ++cy) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[cy] + 4 * i),
+                                             _mm_set1_ps(params.fColumnKernel[cy])));
+        }
+        dst[i] = pack(params, sum, src + i);
+    }
+}
+
+bool SkMatrixConvolutionGetPlatformProcs_SSE2(SkMatrixConvolutionRowProc* convolveRow,
+                                              SkMatrixConvolutionSumRowProc* sumRow,
+                                              SkMatrixConvolutionSumColumnProc* sumColumn) {
+    *convolveRow = convolve_row_SSE2;
+    *sumRow = sum_row_SSE2;
+    *sumColumn = sum_column_SSE2;
+    return true;
+}
@@ -0,0 +1,17 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkMatrixConvolution_opts_SSE2_DEFINED
+#define SkMatrixConvolution_opts_SSE2_DEFINED
+
+#include "SkMatrixConvolution_opts.h"
+
+bool SkMatrixConvolutionGetPlatformProcs_SSE2(SkMatrixConvolutionRowProc* convolveRow,
+                                              SkMatrixConvolutionSumRowProc* sumRow,
+                                              SkMatrixConvolutionSumColumnProc* sumColumn);
+
+#endif
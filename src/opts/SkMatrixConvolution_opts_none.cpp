@@ -0,0 +1,14 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkMatrixConvolution_opts.h"
+
+bool SkMatrixConvolutionGetPlatformProcs(SkMatrixConvolutionRowProc* convolveRow,
+                                         SkMatrixConvolutionSumRowProc* sumRow,
+                                         SkMatrixConvolutionSumColumnProc* sumColumn) {
+    return false;
+}
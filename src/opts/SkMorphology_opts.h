@@ -19,4 +19,10 @@ enum SkMorphologyProcType {
 
 SkMorphologyImageFilter::Proc SkMorphologyGetPlatformProc(SkMorphologyProcType type);
 
+/**
+ *  The procs SkDilateImageFilter and SkErodeImageFilter use when there are no platform ones.
+ *  They are defined in SkMorphologyImageFilter.cpp.
+ */
+SkMorphologyImageFilter::Proc SkMorphologyGetPortableProc(SkMorphologyProcType type);
+
 #endif
@@ -8,9 +8,13 @@
 #include <emmintrin.h>
 #include "SkColorPriv.h"
 #include "SkMorphology_opts_SSE2.h"
+#include "SkTemplates.h"
 
 /* SSE2 version of dilateX, dilateY, erodeX, erodeY.
  * portable versions are in src/effects/SkMorphologyImageFilter.cpp.
+ *
+ * Both use the van Herk/Gil-Werman algorithm, so the cost per pixel does not depend on the
+ * radius. Here four lines are processed at a time, one per lane.
  */
 
 enum MorphType {
@@ -21,6 +25,19 @@ enum MorphDirection {
     kX, kY
 };
 
+template<MorphType type>
+static inline __m128i morph_pixels(__m128i a, __m128i b) {
+    return type == kDilate ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+}
+
+static inline __m128i load(const SkPMColor* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+static inline void store(SkPMColor* p, __m128i pixels) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), pixels);
+}
+
 template<MorphType type, MorphDirection direction>
 static void SkMorph_SSE2(const SkPMColor* src, SkPMColor* dst, int radius,
                          int width, int height, int srcStride, int dstStride)
@@ -30,29 +47,69 @@ static void SkMorph_SSE2(const SkPMColor* src, SkPMColor* dst, int radius,
     const int srcStrideY = direction == kX ? srcStride : 1;
     const int dstStrideY = direction == kX ? dstStride : 1;
     radius = SkMin32(radius, width - 1);
-    const SkPMColor* upperSrc = src + radius * srcStrideX;
-    for (int x = 0; x < width; ++x) {
-        const SkPMColor* lp = src;
-        const SkPMColor* up = upperSrc;
-        SkPMColor* dptr = dst;
-        for (int y = 0; y < height; ++y) {
-            __m128i max = type == kDilate ? _mm_setzero_si128() : _mm_set1_epi32(0xFFFFFFFF);
-            for (const SkPMColor* p = lp; p <= up; p += srcStrideX) {
-                __m128i src_pixel = _mm_cvtsi32_si128(*p);
-                max = type == kDilate ? _mm_max_epu8(src_pixel, max) : _mm_min_epu8(src_pixel, max);
+
+    // Each line is padded with radius pixels on both sides that do not change the result, and
+    // cut into blocks as long as the window. A window then covers the end of one block and the
+    // start of the next, so it is the min or max of a suffix and a prefix of blocks.
+    const int window = 2 * radius + 1;
+    const int padded = width + 2 * radius;
+    const SkPMColor identity = type == kDilate ? 0 : 0xFFFFFFFF;
+    SkAutoSTMalloc<1024, SkPMColor> storage(2 * 4 * padded);
+    SkPMColor* prefix = storage.get();
+    SkPMColor* suffix = prefix + 4 * padded;
+
+    for (int y = 0; y < height; y += 4) {
+        const int lines = SkMin32(4, height - y);
+        const SkPMColor* sptr = src + y * srcStrideY;
+        SkPMColor* dptr = dst + y * dstStrideY;
+
+        // The padded lines, side by side, in suffix.
+        for (int p = 0; p < padded; ++p) {
+            SkPMColor* pixels = suffix + 4 * p;
+            const int x = p - radius;
+            if (x < 0 || x >= width) {
+                pixels[0] = pixels[1] = pixels[2] = pixels[3] = identity;
+            } else if (direction == kY && 4 == lines) {
+                store(pixels, load(sptr + x * srcStrideX));
+            } else {
+                for (int line = 0; line < 4; ++line) {
+                    pixels[line] = sptr[x * srcStrideX + SkMin32(line, lines - 1) * srcStrideY];
+                }
             }
-            *dptr = _mm_cvtsi128_si32(max);
-            dptr += dstStrideY;
-            lp += srcStrideY;
-            up += srcStrideY;
         }
-        if (x >= radius) {
-            src += srcStrideX;
+
+        for (int start = 0; start < padded; start += window) {
+            const int end = SkMin32(start + window, padded);
+            __m128i run = load(suffix + 4 * start);
+            store(prefix + 4 * start, run);
+            for (int p = start + 1; p < end; ++p) {
+                run = morph_pixels<type>(run, load(suffix + 4 * p));
+                store(prefix + 4 * p, run);
+            }
+            run = load(suffix + 4 * (end - 1));
+            for (int p = end - 2; p >= start; --p) {
+                run = morph_pixels<type>(run, load(suffix + 4 * p));
+                store(suffix + 4 * p, run);
+            }
         }
-        if (x + radius < width - 1) {
-            upperSrc += srcStrideX;
+
+        for (int x = 0; x < width; ++x) {
+            const __m128i result = morph_pixels<type>(load(suffix + 4 * x),
+                                                      load(prefix + 4 * (x + window - 1)));
+            if (direction == kY && 4 == lines) {
+                store(dptr, result);
+            } else {
+                union {
+                    __m128i   v;
+                    SkPMColor c[4];
+                } pixels;
+                pixels.v = result;
+                for (int line = 0; line < lines; ++line) {
+                    dptr[line * dstStrideY] = pixels.c[line];
+                }
+            }
+            dptr += dstStrideX;
         }
-        dst += dstStrideX;
     }
 }
 
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPerlinNoise_opts_DEFINED
+#define SkPerlinNoise_opts_DEFINED
+
+#include "SkColor.h"
+
+/**
+ *  The lattice of SkPerlinNoiseShader. The gradients of the four channels of each lattice point
+ *  are side by side, in the byte order of SkPMColor, so one lookup finds all four.
+ */
+struct SkPerlinNoiseLattice {
+    uint8_t fSelector[256];
+    float   fGradientX[256][4];
+    float   fGradientY[256][4];
+};
+
+/**
+ *  A span of noise points (fX, fY), (fX + 1, fY), ..., see
+ *  http://www.w3.org/TR/SVG/filters.html#feTurbulenceElement
+ */
+struct SkPerlinNoiseSpan {
+    const SkPerlinNoiseLattice* fLattice;
+    float   fX, fY;
+    float   fFrequencyX, fFrequencyY;
+    int     fNumOctaves;
+    bool    fFractalNoise;                  // otherwise turbulence
+    bool    fStitch;
+    int     fStitchWidth, fStitchHeight;    // of the first octave, doubled for each next one
+    float   fAlphaScale;                    // the paint's alpha / 255
+};
+
+/**
+ *  Writes the premultiplied colors of count noise points of the span.
+ */
+typedef void (*SkPerlinNoiseSpanProc)(const SkPerlinNoiseSpan& span, SkPMColor dst[], int count);
+
+SkPerlinNoiseSpanProc SkPerlinNoiseGetPlatformSpanProc();
+
+/**
+ *  The span proc SkPerlinNoiseShader uses when there is no platform one. It is defined in
+ *  SkPerlinNoiseShader.cpp.
+ */
+SkPerlinNoiseSpanProc SkPerlinNoiseGetPortableSpanProc();
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkColorPriv.h"
+#include "SkMath_opts_SSE2.h"
+#include "SkPerlinNoise_opts_SSE2.h"
+#include "SkScalar.h"
+#include "SkTemplates.h"
+
+/* SSE2 version of the noise of SkPerlinNoiseShader. The four channels of a pixel are computed
+ * together, one per lane, and the lattice positions of four pixels at a time.
+ */
+
+static const int kPerlinNoise = 4096;
+static const int kBlockMask = 255;
+
+// The lane of alpha in an SkPMColor.
+static const int kA = SK_A32_SHIFT / 8;
+
+namespace {
+
+// A coordinate's position on the lattice, for one octave.
+struct LatticeRow {
+    int     fIndex, fNextIndex;
+    float   fFraction;
+    float   fSmooth;
+};
+
+}  // namespace
+
+static inline float smooth_curve(float t) {
+    return (t * t) * (3.0f - 2 * t);
+}
+
+// If stitching, wraps the lattice indices at least limit back by size.
+static inline __m128i check_noise(__m128i index, int limit, int size) {
+    const __m128i wrap = _mm_cmpgt_epi32(index, _mm_set1_epi32(limit - 1));
+    return _mm_sub_epi32(index, _mm_and_si128(wrap, _mm_set1_epi32(size)));
+}
+
+static inline __m128 gradient_dot(const float gradientX[4], const float gradientY[4],
+                                  __m128 fractionX, __m128 fractionY) {
+    return _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(gradientX), fractionX),
+                      _mm_mul_ps(_mm_loadu_ps(gradientY), fractionY));
+}
+
+static inline __m128 interp(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+// Clamps four pixels of noise to colors, and premultiplies and packs them.
+static inline __m128i pack_colors(const __m128 sum[4], const SkPerlinNoiseSpan& span) {
+    float scale[4] = { 1, 1, 1, 1 };
+    scale[kA] = span.fAlphaScale;
+    const __m128 alphaScale = _mm_loadu_ps(scale);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1);
+    const __m128 max = _mm_set1_ps(255);
+
+    __m128i c[4];
+    for (int p = 0; p < 4; ++p) {
+        __m128 value = sum[p];
+        if (span.fFractalNoise) {
+            value = _mm_add_ps(_mm_mul_ps(value, half), half);
+        }
+        value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, alphaScale), zero), one);
+        c[p] = _mm_cvttps_epi32(_mm_mul_ps(value, max));
+    }
+
+    // SkMulDiv255Round() of each channel but alpha, by alpha.
+    const __m128i alphaMask = _mm_slli_epi64(_mm_srli_epi64(_mm_set1_epi32(-1), 48), 16 * kA);
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i pairs[2];
+    for (int i = 0; i < 2; ++i) {
+        const __m128i pair = _mm_packs_epi32(c[2 * i], c[2 * i + 1]);
+        __m128i alpha = _mm_shufflelo_epi16(pair, _MM_SHUFFLE(kA, kA, kA, kA));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(kA, kA, kA, kA));
+        __m128i prod = _mm_add_epi16(_mm_mullo_epi16(pair, alpha), round);
+        prod = _mm_srli_epi16(_mm_add_epi16(prod, _mm_srli_epi16(prod, 8)), 8);
+        pairs[i] = _mm_or_si128(_mm_and_si128(alphaMask, pair), _mm_andnot_si128(alphaMask, prod));
+    }
+    return _mm_packus_epi16(pairs[0], pairs[1]);
+}
+
+static void perlin_noise_span_SSE2(const SkPerlinNoiseSpan& span, SkPMColor dst[], int count) {
+    const SkPerlinNoiseLattice& lattice = *span.fLattice;
+    const int numOctaves = span.fNumOctaves;
+
+    // The rows are the same for every pixel of the span.
+    SkAutoSTMalloc<8, LatticeRow> rows(numOctaves);
+    float noiseY = span.fY * span.fFrequencyY;
+    int stitchHeight = span.fStitchHeight;
+    for (int octave = 0; octave < numOctaves; ++octave) {
+        const float position = noiseY + kPerlinNoise;
+        LatticeRow& row = rows[octave];
+        row.fIndex = SkScalarFloorToInt(position);
+        row.fFraction = position - SkIntToScalar(row.fIndex);
+        row.fNextIndex = row.fIndex + 1;
+        if (span.fStitch) {
+            const int limit = stitchHeight + kPerlinNoise;
+            if (row.fIndex >= limit) {
+                row.fIndex -= stitchHeight;
+            }
+            if (row.fNextIndex >= limit) {
+                row.fNextIndex -= stitchHeight;
+            }
+        }
+        row.fIndex &= kBlockMask;
+        row.fNextIndex &= kBlockMask;
+        row.fSmooth = smooth_curve(row.fFraction);
+        noiseY *= 2;
+        stitchHeight *= 2;
+    }
+
+    const __m128 one = _mm_set1_ps(1);
+    const __m128i blockMask = _mm_set1_epi32(kBlockMask);
+    const __m128i absMask = _mm_set1_epi32(0x7FFFFFFF);
+
+    for (int x = 0; x < count; x += 4) {
+        const __m128 points = _mm_add_ps(_mm_set1_ps(span.fX),
+                                         _mm_cvtepi32_ps(_mm_setr_epi32(x, x + 1, x + 2, x + 3)));
+        __m128 noiseX = _mm_mul_ps(points, _mm_set1_ps(span.fFrequencyX));
+        __m128 ratio = one;
+        int stitchWidth = span.fStitchWidth;
+
+        __m128 sum[4];
+        for (int p = 0; p < 4; ++p) {
+            sum[p] = _mm_setzero_ps();
+        }
+
+        for (int octave = 0; octave < numOctaves; ++octave) {
+            const __m128 position = _mm_add_ps(noiseX, _mm_set1_ps(kPerlinNoise));
+            __m128i index = SkScalarFloorToInt_SSE2(position);
+            union {
+                __m128  v;
+                float   f[4];
+            } fraction, smooth;
+            fraction.v = _mm_sub_ps(position, _mm_cvtepi32_ps(index));
+            smooth.v = _mm_mul_ps(_mm_mul_ps(fraction.v, fraction.v),
+                                  _mm_sub_ps(_mm_set1_ps(3),
+                                             _mm_mul_ps(_mm_set1_ps(2), fraction.v)));
+            __m128i nextIndex = _mm_add_epi32(index, _mm_set1_epi32(1));
+            if (span.fStitch) {
+                const int limit = stitchWidth + kPerlinNoise;
+                index = check_noise(index, limit, stitchWidth);
+                nextIndex = check_noise(nextIndex, limit, stitchWidth);
+            }
+            union {
+                __m128i v;
+                int32_t i[4];
+            } columns, nextColumns;
+            columns.v = _mm_and_si128(index, blockMask);
+            nextColumns.v = _mm_and_si128(nextIndex, blockMask);
+
+            const LatticeRow& row = rows[octave];
+            const __m128 fractionY = _mm_set1_ps(row.fFraction);
+            const __m128 fractionY1 = _mm_sub_ps(fractionY, one);
+            const __m128 smoothY = _mm_set1_ps(row.fSmooth);
+
+            for (int p = 0; p < 4; ++p) {
+                const int i = lattice.fSelector[columns.i[p]];
+                const int j = lattice.fSelector[nextColumns.i[p]];
+                const int b00 = (i + row.fIndex) & kBlockMask;
+                const int b10 = (j + row.fIndex) & kBlockMask;
+                const int b01 = (i + row.fNextIndex) & kBlockMask;
+                const int b11 = (j + row.fNextIndex) & kBlockMask;
+
+                const __m128 fractionX = _mm_set1_ps(fraction.f[p]);
+                const __m128 fractionX1 = _mm_sub_ps(fractionX, one);
+                const __m128 smoothX = _mm_set1_ps(smooth.f[p]);
+
+                __m128 u = gradient_dot(lattice.fGradientX[b00], lattice.fGradientY[b00],
+                                        fractionX, fractionY);
+                __m128 v = gradient_dot(lattice.fGradientX[b10], lattice.fGradientY[b10],
+                                        fractionX1, fractionY);
+                const __m128 a = interp(u, v, smoothX);
+                v = gradient_dot(lattice.fGradientX[b11], lattice.fGradientY[b11],
+                                 fractionX1, fractionY1);
+                u = gradient_dot(lattice.fGradientX[b01], lattice.fGradientY[b01],
+                                 fractionX, fractionY1);
+                const __m128 b = interp(u, v, smoothX);
+                __m128 noise = interp(a, b, smoothY);
+                if (!span.fFractalNoise) {
+                    noise = _mm_and_ps(noise, _mm_castsi128_ps(absMask));
+                }
+                sum[p] = _mm_add_ps(sum[p], _mm_div_ps(noise, ratio));
+            }
+
+            noiseX = _mm_add_ps(noiseX, noiseX);
+            ratio = _mm_add_ps(ratio, ratio);
+            stitchWidth *= 2;
+        }
+
+        const __m128i colors = pack_colors(sum, span);
+        if (count - x >= 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), colors);
+        } else {
+            union {
+                __m128i  v;
+                SkPMColor c[4];
+            } tail;
+            tail.v = colors;
+            for (int p = 0; p < count - x; ++p) {
+                dst[x + p] = tail.c[p];
+            }
+        }
+    }
+}
+
+SkPerlinNoiseSpanProc SkPerlinNoiseGetSpanProc_SSE2() {
+    return perlin_noise_span_SSE2;
+}
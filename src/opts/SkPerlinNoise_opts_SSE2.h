@@ -0,0 +1,15 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkPerlinNoise_opts_SSE2_DEFINED
+#define SkPerlinNoise_opts_SSE2_DEFINED
+
+#include "SkPerlinNoise_opts.h"
+
+SkPerlinNoiseSpanProc SkPerlinNoiseGetSpanProc_SSE2();
+
+#endif
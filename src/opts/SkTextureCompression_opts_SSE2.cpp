@@ -0,0 +1,197 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <emmintrin.h>
+#include "SkTextureCompression_opts_SSE2.h"
+#include "SkTextureCompressor.h"
+
+/* SSE2 versions of the fast A8 encoders in src/utils/SkTextureCompressor_LATC.cpp and
+ * src/utils/SkTextureCompressor_R11EAC.cpp. Each step encodes a 16x4 run of pixels, i.e.
+ * four blocks, and produces exactly the same bits as the portable code.
+ */
+
+// The top three bits of each byte.
+static inline __m128i top_three_bits(__m128i x) {
+    return _mm_and_si128(_mm_srli_epi16(x, 5), _mm_set1_epi8(7));
+}
+
+// Reverses the bytes of each 64-bit lane.
+static inline __m128i swap_bytes64(__m128i x) {
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// R11 EAC indices are the top three bits of alpha mapped from
+// 0 1 2 3 4 5 6 7
+// to
+// 3 2 1 0 4 5 6 7
+static inline __m128i r11eac_indices(__m128i alpha) {
+    const __m128i t = top_three_bits(alpha);
+    const __m128i low = _mm_cmplt_epi8(t, _mm_set1_epi8(4));
+    return _mm_xor_si128(t, _mm_and_si128(low, _mm_set1_epi8(3)));
+}
+
+// Takes the 12-bit columns c0 c1 c2 c3 of two blocks, one per 16-bit lane, and packs
+// each block's into c0 c1 c2 c3 in the low 48 bits of its 64-bit lane, c0 most significant.
+static inline __m128i r11eac_pack_columns(__m128i columns) {
+    // c0*4096 + c1 and c2*4096 + c3 in each 32-bit lane.
+    const __m128i pairs = _mm_madd_epi16(columns, _mm_set1_epi32(0x00011000));
+    const __m128i high = _mm_and_si128(_mm_slli_epi64(pairs, 24),
+                                       _mm_set_epi32(0x0000FFFF, 0xFF000000,
+                                                     0x0000FFFF, 0xFF000000));
+    const __m128i packed = _mm_or_si128(high, _mm_srli_epi64(pairs, 32));
+
+    // The same magic header as the portable encoder, stored big endian.
+    const __m128i header = _mm_set_epi32(0x84900000, 0, 0x84900000, 0);
+    return swap_bytes64(_mm_or_si128(packed, header));
+}
+
+static void compress_r11eac_blocks(uint64_t* dst, const uint8_t* src, int rowBytes) {
+    const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    const __m128i row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + rowBytes));
+    const __m128i row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*rowBytes));
+    const __m128i row4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*rowBytes));
+
+    // Each block is four bits of these masks: all set if the block is solid.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8(-1);
+    const int transparent = _mm_movemask_epi8(
+        _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(row1, zero), _mm_cmpeq_epi8(row2, zero)),
+                      _mm_and_si128(_mm_cmpeq_epi8(row3, zero), _mm_cmpeq_epi8(row4, zero))));
+    const int opaque = _mm_movemask_epi8(
+        _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(row1, ones), _mm_cmpeq_epi8(row2, ones)),
+                      _mm_and_si128(_mm_cmpeq_epi8(row3, ones), _mm_cmpeq_epi8(row4, ones))));
+
+    // Indices are three bits, so two of them fit in each byte...
+    const __m128i top = _mm_or_si128(_mm_slli_epi16(r11eac_indices(row1), 3),
+                                     r11eac_indices(row2));
+    const __m128i bottom = _mm_or_si128(_mm_slli_epi16(r11eac_indices(row3), 3),
+                                        r11eac_indices(row4));
+
+    // ... and a whole column in twelve bits of a 16-bit lane.
+    const __m128i lowBits = _mm_set1_epi16(0x3F);
+    const __m128i highBits = _mm_set1_epi16(0xFC0);
+    __m128i columns = _mm_unpacklo_epi8(bottom, top);
+    columns = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(columns, 2), highBits),
+                           _mm_and_si128(columns, lowBits));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), r11eac_pack_columns(columns));
+
+    columns = _mm_unpackhi_epi8(bottom, top);
+    columns = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(columns, 2), highBits),
+                           _mm_and_si128(columns, lowBits));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2), r11eac_pack_columns(columns));
+
+    // Solid blocks have their own encodings, see compress_r11eac_block_fast().
+    if (transparent | opaque) {
+        for (int i = 0; i < 4; ++i) {
+            if (0xF == ((transparent >> 4*i) & 0xF)) {
+                dst[i] = 0x0020000000002000ULL;
+            } else if (0xF == ((opaque >> 4*i) & 0xF)) {
+                dst[i] = 0xFFFFFFFFFFFFFFFFULL;
+            }
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// LATC indices are the top three bits of alpha mapped from
+// 0 1 2 3 4 5 6 7
+// to
+// 1 7 6 5 4 3 2 0
+static inline __m128i latc_indices(__m128i alpha) {
+    const __m128i x = _mm_and_si128(_mm_sub_epi8(_mm_set1_epi8(8), top_three_bits(alpha)),
+                                    _mm_set1_epi8(7));
+
+    // x is now 0 7 6 5 4 3 2 1, so swap 0 and 1.
+    const __m128i small = _mm_cmpeq_epi8(_mm_and_si128(x, _mm_set1_epi8(6)),
+                                         _mm_setzero_si128());
+    return _mm_xor_si128(x, _mm_and_si128(small, _mm_set1_epi8(1)));
+}
+
+// Packs the four indices of each block's row into the low 12 bits of a 32-bit lane.
+static inline __m128i latc_pack_row(__m128i alpha) {
+    __m128i x = latc_indices(alpha);
+    x = _mm_or_si128(_mm_and_si128(x, _mm_set1_epi16(0x7)),
+                     _mm_and_si128(_mm_srli_epi16(x, 5), _mm_set1_epi16(0x38)));
+    return _mm_or_si128(_mm_and_si128(x, _mm_set1_epi32(0x3F)),
+                        _mm_and_si128(_mm_srli_epi32(x, 10), _mm_set1_epi32(0xFC0)));
+}
+
+// Takes two blocks' top and bottom 24 bits of indices, interleaved as 32-bit lanes, and
+// returns the blocks with the LUM0 = 255, LUM1 = 0 header of the portable encoder.
+static inline __m128i latc_pack_blocks(__m128i halves) {
+    const __m128i low = _mm_set_epi32(0, 0xFFFFFF, 0, 0xFFFFFF);
+    const __m128i packed = _mm_or_si128(_mm_and_si128(halves, low),
+                                        _mm_andnot_si128(low, _mm_srli_epi64(halves, 8)));
+    return _mm_or_si128(_mm_slli_epi64(packed, 16), _mm_set_epi32(0, 0xFF, 0, 0xFF));
+}
+
+static void compress_latc_blocks(uint64_t* dst, const uint8_t* src, int rowBytes) {
+    const __m128i row1 = latc_pack_row(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src)));
+    const __m128i row2 = latc_pack_row(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + rowBytes)));
+    const __m128i row3 = latc_pack_row(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2*rowBytes)));
+    const __m128i row4 = latc_pack_row(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3*rowBytes)));
+
+    const __m128i top = _mm_or_si128(row1, _mm_slli_epi32(row2, 12));
+    const __m128i bottom = _mm_or_si128(row3, _mm_slli_epi32(row4, 12));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                     latc_pack_blocks(_mm_unpacklo_epi32(top, bottom)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2),
+                     latc_pack_blocks(_mm_unpackhi_epi32(top, bottom)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+typedef void (*CompressBlocksProc)(uint64_t* dst, const uint8_t* src, int rowBytes);
+
+// Encodes sixteen columns at a time, and hands any leftover blocks at the end of each
+// row of blocks to the portable encoder.
+static bool compress_a8(uint8_t* dst, const uint8_t* src, int width, int height, int rowBytes,
+                        CompressBlocksProc compressBlocks, SkTextureCompressor::Format format) {
+    if (0 == width || 0 == height || (width % 4) != 0 || (height % 4) != 0) {
+        return SkTextureCompressor::CompressBufferToFormat(
+            dst, src, kAlpha_8_SkColorType, width, height, rowBytes, format, false);
+    }
+
+    const int simdWidth = width & ~15;
+    uint64_t* encPtr = reinterpret_cast<uint64_t*>(dst);
+    for (int y = 0; y < height; y += 4) {
+        for (int x = 0; x < simdWidth; x += 16) {
+            compressBlocks(encPtr, src + x, rowBytes);
+            encPtr += 4;
+        }
+        if (simdWidth < width) {
+            SkTextureCompressor::CompressBufferToFormat(
+                reinterpret_cast<uint8_t*>(encPtr), src + simdWidth, kAlpha_8_SkColorType,
+                width - simdWidth, 4, rowBytes, format, false);
+            encPtr += (width - simdWidth) >> 2;
+        }
+        src += 4 * rowBytes;
+    }
+    return true;
+}
+
+bool CompressA8toR11EAC_SSE2(uint8_t* dst, const uint8_t* src,
+                             int width, int height, int rowBytes) {
+    return compress_a8(dst, src, width, height, rowBytes,
+                       compress_r11eac_blocks, SkTextureCompressor::kR11_EAC_Format);
+}
+
+bool CompressA8toLATC_SSE2(uint8_t* dst, const uint8_t* src,
+                           int width, int height, int rowBytes) {
+    return compress_a8(dst, src, width, height, rowBytes,
+                       compress_latc_blocks, SkTextureCompressor::kLATC_Format);
+}
@@ -16,9 +16,25 @@
 #include "SkBlitRow_opts_SSE4.h"
 #include "SkBlurImage_opts_SSE2.h"
 #include "SkBlurImage_opts_SSE4.h"
+#include "SkColorMatrix_opts.h"
+#include "SkColorMatrix_opts_SSE2.h"
+#include "SkDisplacementMap_opts.h"
+#include "SkDisplacementMap_opts_SSE2.h"
+#include "SkDistanceField_opts.h"
+#include "SkDistanceField_opts_SSE2.h"
+#include "SkGradient_opts.h"
+#include "SkGradient_opts_SSE2.h"
+#include "SkLighting_opts.h"
+#include "SkLighting_opts_SSE2.h"
+#include "SkMatrixConvolution_opts.h"
+#include "SkMatrixConvolution_opts_SSE2.h"
 #include "SkMorphology_opts.h"
 #include "SkMorphology_opts_SSE2.h"
+#include "SkPerlinNoise_opts.h"
+#include "SkPerlinNoise_opts_SSE2.h"
 #include "SkRTConf.h"
+#include "SkTextureCompression_opts.h"
+#include "SkTextureCompression_opts_SSE2.h"
 #include "SkUtils.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkXfermode.h"
@@ -143,6 +159,36 @@ void SkBitmapProcState::platformProcs() {
         return;
     }
 
+    /* Check for scale+translate with clamping, which has fused shader procs
+       that don't need the matrix and sample procs below. */
+    if (NULL == fShaderProc32) {
+        if (fMatrixProc == ClampX_ClampY_filter_scale &&
+            supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
+            if (fSampleProc32 == S32_opaque_D32_filter_DX) {
+                fShaderProc32 = Clamp_S32_opaque_D32_filter_DX_shaderproc_SSSE3;
+            } else if (fSampleProc32 == S32_alpha_D32_filter_DX) {
+                fShaderProc32 = Clamp_S32_alpha_D32_filter_DX_shaderproc_SSSE3;
+            }
+        } else if (fMatrixProc == ClampX_ClampY_nofilter_scale) {
+            if (fSampleProc32 == S32_opaque_D32_nofilter_DX) {
+                fShaderProc32 = Clamp_S32_opaque_D32_nofilter_DX_shaderproc_SSE2;
+            } else if (fSampleProc32 == S32_alpha_D32_nofilter_DX) {
+                fShaderProc32 = Clamp_S32_alpha_D32_nofilter_DX_shaderproc_SSE2;
+            }
+        }
+    }
+
+    /* Check for the shader procs that sample with float coordinates. */
+    if (fShaderProc32 == Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc) {
+        fShaderProc32 = Clamp_S32_opaque_D32_nofilter_scale_float_shaderproc_SSE2;
+    } else if (fShaderProc32 == Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc) {
+        fShaderProc32 = Clamp_S32_alpha_D32_nofilter_scale_float_shaderproc_SSE2;
+    } else if (fShaderProc32 == Clamp_S32_opaque_D32_filter_scale_float_shaderproc) {
+        fShaderProc32 = Clamp_S32_opaque_D32_filter_scale_float_shaderproc_SSE2;
+    } else if (fShaderProc32 == Clamp_S32_alpha_D32_filter_scale_float_shaderproc) {
+        fShaderProc32 = Clamp_S32_alpha_D32_filter_scale_float_shaderproc_SSE2;
+    }
+
     /* Check fSampleProc32 */
     if (fSampleProc32 == S32_opaque_D32_filter_DX) {
         if (supports_simd(SK_CPU_SSE_LEVEL_SSSE3)) {
@@ -352,6 +398,134 @@ SkMorphologyImageFilter::Proc SkMorphologyGetPlatformProc(SkMorphologyProcType t
 
 ////////////////////////////////////////////////////////////////////////////////
 
+SkDistanceFieldColumnProc SkDistanceFieldGetPlatformColumnProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkDistanceFieldColumns_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkLinearGradientSpanProc SkLinearGradientGetPlatformSpanProc(SkShader::TileMode tileMode) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkLinearGradientGetSpanProc_SSE2(tileMode);
+    } else {
+        return NULL;
+    }
+}
+
+SkRadialGradientSpanProc SkRadialGradientGetPlatformSpanProc(SkShader::TileMode tileMode) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkRadialGradientGetSpanProc_SSE2(tileMode);
+    } else {
+        return NULL;
+    }
+}
+
+SkTwoPointConicalSpanProc SkTwoPointConicalGetPlatformSpanProc(SkShader::TileMode tileMode) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkTwoPointConicalGetSpanProc_SSE2(tileMode);
+    } else {
+        return NULL;
+    }
+}
+
+SkGradientInterpolateProc SkGradientGetPlatformInterpolateProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkGradientGetInterpolateProc_SSE2();
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkPerlinNoiseSpanProc SkPerlinNoiseGetPlatformSpanProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkPerlinNoiseGetSpanProc_SSE2();
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkLightingRowProc SkLightingGetPlatformRowProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkLightingGetRowProc_SSE2();
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool SkMatrixConvolutionGetPlatformProcs(SkMatrixConvolutionRowProc* convolveRow,
+                                         SkMatrixConvolutionSumRowProc* sumRow,
+                                         SkMatrixConvolutionSumColumnProc* sumColumn) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkMatrixConvolutionGetPlatformProcs_SSE2(convolveRow, sumRow, sumColumn);
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkColorMatrixSpanProc SkColorMatrixGetPlatformSpanProc() {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkColorMatrixSpan_SSE2;
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkDisplacementMapRowProc SkDisplacementMapGetPlatformRowProc(bool checkBounds) {
+    if (supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return SkDisplacementMapGetRowProc_SSE2(checkBounds);
+    } else {
+        return NULL;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+SkTextureCompressor::CompressionProc
+SkTextureCompressorGetPlatformProc(SkColorType colorType, SkTextureCompressor::Format fmt) {
+    if (!supports_simd(SK_CPU_SSE_LEVEL_SSE2) || kAlpha_8_SkColorType != colorType) {
+        return NULL;
+    }
+    switch (fmt) {
+        case SkTextureCompressor::kLATC_Format:
+            return CompressA8toLATC_SSE2;
+        case SkTextureCompressor::kR11_EAC_Format:
+            return CompressA8toR11EAC_SSE2;
+        default:
+            return NULL;
+    }
+}
+
+bool SkTextureCompressorGetPlatformDims(SkTextureCompressor::Format fmt, int* dimX, int* dimY) {
+    if (!supports_simd(SK_CPU_SSE_LEVEL_SSE2)) {
+        return false;
+    }
+    // Both SSE2 encoders take any multiple of four, but R11 EAC is fastest sixteen at a time,
+    // as it is on NEON.
+    switch (fmt) {
+        case SkTextureCompressor::kR11_EAC_Format:
+            *dimX = 16;
+            *dimY = 4;
+            return true;
+        default:
+            return false;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
                                SkBoxBlurProc* boxBlurY,
                                SkBoxBlurProc* boxBlurXY,
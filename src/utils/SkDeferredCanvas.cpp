@@ -11,6 +11,7 @@
 #include "SkBitmapDevice.h"
 #include "SkChunkAlloc.h"
 #include "SkColorFilter.h"
+#include "SkCondVar.h"
 #include "SkDrawFilter.h"
 #include "SkGPipe.h"
 #include "SkPaint.h"
@@ -18,6 +19,7 @@
 #include "SkRRect.h"
 #include "SkShader.h"
 #include "SkSurface.h"
+#include "SkThreadUtils.h"
 
 enum {
     // Deferred canvas will auto-flush when recording reaches this limit
@@ -66,6 +68,8 @@ public:
     virtual void* requestBlock(size_t minRequest, size_t* actual) SK_OVERRIDE;
     virtual void notifyWritten(size_t bytes) SK_OVERRIDE;
     void playback(bool silent);
+    // Drops any pending commands, and readies the reader for a new stream.
+    void reset();
     bool hasPendingCommands() const { return fAllocator.blockCount() != 0; }
     size_t storageAllocatedForRecording() const { return fAllocator.totalCapacity(); }
 private:
@@ -81,11 +85,14 @@ private:
     size_t fBytesWritten;
     SkChunkAlloc fAllocator;
     SkTDArray<PipeBlock> fBlockList;
-    SkGPipeReader fReader;
+    SkCanvas* fPlaybackCanvas;
+    SkAutoTDelete<SkGPipeReader> fReader;
 };
 
 DeferredPipeController::DeferredPipeController() :
-    fAllocator(kMinBlockSize) {
+    fAllocator(kMinBlockSize),
+    fPlaybackCanvas(NULL),
+    fReader(SkNEW(SkGPipeReader)) {
     fBlock = NULL;
     fBytesWritten = 0;
 }
@@ -95,7 +102,8 @@ DeferredPipeController::~DeferredPipeController() {
 }
 
 void DeferredPipeController::setPlaybackCanvas(SkCanvas* canvas) {
-    fReader.setCanvas(canvas);
+    fPlaybackCanvas = canvas;
+    fReader->setCanvas(canvas);
 }
 
 void* DeferredPipeController::requestBlock(size_t minRequest, size_t *actual) {
@@ -118,13 +126,13 @@ void DeferredPipeController::notifyWritten(size_t bytes) {
 void DeferredPipeController::playback(bool silent) {
     uint32_t flags = silent ? SkGPipeReader::kSilent_PlaybackFlag : 0;
     for (int currentBlock = 0; currentBlock < fBlockList.count(); currentBlock++ ) {
-        fReader.playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
-                         flags);
+        fReader->playback(fBlockList[currentBlock].fBlock, fBlockList[currentBlock].fSize,
+                          flags);
     }
     fBlockList.reset();
 
     if (fBlock) {
-        fReader.playback(fBlock, fBytesWritten, flags);
+        fReader->playback(fBlock, fBytesWritten, flags);
         fBlock = NULL;
     }
 
@@ -132,6 +140,13 @@ void DeferredPipeController::playback(bool silent) {
     fAllocator.reset();
 }
 
+void DeferredPipeController::reset() {
+    fBlockList.reset();
+    fBlock = NULL;
+    fAllocator.reset();
+    fReader.reset(SkNEW_ARGS(SkGPipeReader, (fPlaybackCanvas)));
+}
+
 //-----------------------------------------------------------------------------
 // SkDeferredDevice
 //-----------------------------------------------------------------------------
@@ -154,6 +169,8 @@ public:
     void skipPendingCommands();
     void setMaxRecordingStorage(size_t);
     void recordedDrawCommand();
+    void setPipelinedFlushing(bool);
+    void waitForPipelinedFlush();
 
     virtual SkImageInfo imageInfo() const SK_OVERRIDE;
 
@@ -254,10 +271,35 @@ private:
     void init();
     void aboutToDraw();
     void prepareForImmediatePixelWrite();
-
-    DeferredPipeController fPipeController;
-    SkGPipeWriter  fPipeWriter;
+    bool canSubmitFrame() const;
+    void submitFrame();
+    void playbackSubmittedFrame();
+    bool startRasterThread();
+    void stopRasterThread();
+    static void RasterThreadMain(void* device);
+
+    // With pipelined flushing, the next frame is recorded into one of these pairs while the
+    // raster thread plays back the other. Otherwise only the first pair is used.
+    DeferredPipeController fPipeControllers[2];
+    SkGPipeWriter fPipeWriters[2];
+    DeferredPipeController* fPipeController;
+    SkGPipeWriter* fPipeWriter;
+    // Set from when a frame is submitted until waitForPipelinedFlush() returns.
+    DeferredPipeController* fSubmittedController;
+    SkGPipeWriter* fSubmittedWriter;
+    // Started by the first submitted frame, and kept until pipelined flushing is turned off.
+    // fFrameCond guards fFrameInFlight and fStopRasterThread.
+    SkThread* fRasterThread;
+    SkCondVar fFrameCond;
+    bool fFrameInFlight;
+    bool fStopRasterThread;
+    bool fPipelinedFlushing;
     SkCanvas* fImmediateCanvas;
+    // The immediate device's info, so that recording never has to look at fImmediateCanvas
+    // while the raster thread draws into it.
+    SkImageInfo fImmediateInfo;
+    // Only raster devices are drawn to from the raster thread: a GrContext is not thread safe.
+    bool fImmediateIsRaster;
     SkCanvas* fRecordingCanvas;
     SkSurface* fSurface;
     SkDeferredCanvas::NotificationClient* fNotificationClient;
@@ -268,6 +310,14 @@ private:
 };
 
 SkDeferredDevice::SkDeferredDevice(SkSurface* surface) {
+    fPipeController = &fPipeControllers[0];
+    fPipeWriter = &fPipeWriters[0];
+    fSubmittedController = NULL;
+    fSubmittedWriter = NULL;
+    fRasterThread = NULL;
+    fFrameInFlight = false;
+    fStopRasterThread = false;
+    fPipelinedFlushing = false;
     fMaxRecordingStorageBytes = kDefaultMaxRecordingStorageBytes;
     fNotificationClient = NULL;
     fImmediateCanvas = NULL;
@@ -277,9 +327,14 @@ SkDeferredDevice::SkDeferredDevice(SkSurface* surface) {
 }
 
 void SkDeferredDevice::setSurface(SkSurface* surface) {
+    this->waitForPipelinedFlush();
     SkRefCnt_SafeAssign(fImmediateCanvas, surface->getCanvas());
     SkRefCnt_SafeAssign(fSurface, surface);
-    fPipeController.setPlaybackCanvas(fImmediateCanvas);
+    fImmediateInfo = immediateDevice()->imageInfo();
+    fImmediateIsRaster = NULL == immediateDevice()->accessRenderTarget();
+    for (size_t i = 0; i < SK_ARRAY_COUNT(fPipeControllers); ++i) {
+        fPipeControllers[i].setPlaybackCanvas(fImmediateCanvas);
+    }
 }
 
 void SkDeferredDevice::init() {
@@ -294,6 +349,7 @@ void SkDeferredDevice::init() {
 
 SkDeferredDevice::~SkDeferredDevice() {
     this->flushPendingCommands(kSilent_PlaybackMode);
+    this->stopRasterThread();
     SkSafeUnref(fImmediateCanvas);
     SkSafeUnref(fSurface);
 }
@@ -305,8 +361,8 @@ void SkDeferredDevice::setMaxRecordingStorage(size_t maxStorage) {
 
 void SkDeferredDevice::beginRecording() {
     SkASSERT(NULL == fRecordingCanvas);
-    fRecordingCanvas = fPipeWriter.startRecording(&fPipeController, 0,
-        immediateDevice()->width(), immediateDevice()->height());
+    fRecordingCanvas = fPipeWriter->startRecording(fPipeController, 0,
+        fImmediateInfo.width(), fImmediateInfo.height());
 }
 
 void SkDeferredDevice::setNotificationClient(
@@ -317,7 +373,7 @@ void SkDeferredDevice::setNotificationClient(
 void SkDeferredDevice::skipPendingCommands() {
     if (!fRecordingCanvas->isDrawingToLayer()) {
         fCanDiscardCanvasContents = true;
-        if (fPipeController.hasPendingCommands()) {
+        if (fPipeController->hasPendingCommands()) {
             fFreshFrame = true;
             flushPendingCommands(kSilent_PlaybackMode);
         }
@@ -331,7 +387,7 @@ bool SkDeferredDevice::isFreshFrame() {
 }
 
 bool SkDeferredDevice::hasPendingCommands() {
-    return fPipeController.hasPendingCommands();
+    return fPipeController->hasPendingCommands();
 }
 
 void SkDeferredDevice::aboutToDraw()
@@ -348,14 +404,16 @@ void SkDeferredDevice::aboutToDraw()
 }
 
 void SkDeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
-    if (!fPipeController.hasPendingCommands()) {
+    // Whatever is done next with the surface must come after the frame being drawn.
+    this->waitForPipelinedFlush();
+    if (!fPipeController->hasPendingCommands()) {
         return;
     }
     if (playbackMode == kNormal_PlaybackMode) {
         aboutToDraw();
     }
-    fPipeWriter.flushRecording(true);
-    fPipeController.playback(kSilent_PlaybackMode == playbackMode);
+    fPipeWriter->flushRecording(true);
+    fPipeController->playback(kSilent_PlaybackMode == playbackMode);
     if (fNotificationClient) {
         if (playbackMode == kSilent_PlaybackMode) {
             fNotificationClient->skippedPendingDrawCommands();
@@ -368,19 +426,146 @@ void SkDeferredDevice::flushPendingCommands(PlaybackMode playbackMode) {
 }
 
 void SkDeferredDevice::flush() {
+    if (this->canSubmitFrame()) {
+        // The raster thread flushes fImmediateCanvas when it is done.
+        this->submitFrame();
+        return;
+    }
     this->flushPendingCommands(kNormal_PlaybackMode);
     fImmediateCanvas->flush();
 }
 
+void SkDeferredDevice::setPipelinedFlushing(bool pipelined) {
+    fPipelinedFlushing = pipelined;
+    if (!pipelined) {
+        this->stopRasterThread();
+    }
+}
+
+bool SkDeferredDevice::canSubmitFrame() const {
+    // A new recording starts with an empty save stack, so it can only take over from the
+    // current one if nothing is left to restore.
+    return fPipelinedFlushing && fImmediateIsRaster && fPipeController->hasPendingCommands() &&
+           1 == fRecordingCanvas->getSaveCount();
+}
+
+void SkDeferredDevice::submitFrame() {
+    SkASSERT(this->canSubmitFrame());
+    // Backpressure: only one frame is drawn at a time, and this frees the other pair.
+    this->waitForPipelinedFlush();
+    this->aboutToDraw();
+
+    fPipeWriter->flushRecording(true);
+    fSubmittedController = fPipeController;
+    fSubmittedWriter = fPipeWriter;
+
+    // Record the next frame with the other pair, keeping any draw filter. This is set up
+    // before the frame is handed off, since it plays back into fImmediateCanvas too.
+    SkDrawFilter* filter = fRecordingCanvas->getDrawFilter();
+    const int next = fPipeController == &fPipeControllers[0] ? 1 : 0;
+    fPipeController = &fPipeControllers[next];
+    fPipeWriter = &fPipeWriters[next];
+    fRecordingCanvas = NULL;
+    this->beginRecording();
+    fRecordingCanvas->setDrawFilter(filter);
+    // Consume the new recording's setup commands, which don't touch the canvas, so the frame
+    // only counts as pending once something is drawn (and a full frame clear won't have to
+    // wait for the raster thread to skip them).
+    fPipeWriter->flushRecording(true);
+    fPipeController->playback(true);
+
+    if (this->startRasterThread()) {
+        fFrameCond.lock();
+        fFrameInFlight = true;
+        fFrameCond.signal();
+        fFrameCond.unlock();
+    } else {
+        this->playbackSubmittedFrame();
+    }
+    if (fNotificationClient) {
+        fNotificationClient->flushedDrawCommands();
+    }
+
+    fPreviousStorageAllocated = storageAllocatedForRecording();
+}
+
+void SkDeferredDevice::playbackSubmittedFrame() {
+    fSubmittedController->playback(false);
+    fImmediateCanvas->flush();
+}
+
+bool SkDeferredDevice::startRasterThread() {
+    if (NULL == fRasterThread) {
+        fRasterThread = SkNEW_ARGS(SkThread, (&SkDeferredDevice::RasterThreadMain, this));
+        if (!fRasterThread->start()) {
+            SkDELETE(fRasterThread);
+            fRasterThread = NULL;
+            return false;
+        }
+    }
+    return true;
+}
+
+void SkDeferredDevice::stopRasterThread() {
+    this->waitForPipelinedFlush();
+    if (NULL != fRasterThread) {
+        fFrameCond.lock();
+        fStopRasterThread = true;
+        fFrameCond.signal();
+        fFrameCond.unlock();
+        fRasterThread->join();
+        SkDELETE(fRasterThread);
+        fRasterThread = NULL;
+        fStopRasterThread = false;
+    }
+}
+
+void SkDeferredDevice::RasterThreadMain(void* data) {
+    SkDeferredDevice* device = static_cast<SkDeferredDevice*>(data);
+    device->fFrameCond.lock();
+    for (;;) {
+        while (!device->fFrameInFlight && !device->fStopRasterThread) {
+            device->fFrameCond.wait();
+        }
+        if (!device->fFrameInFlight) {
+            break;
+        }
+        device->fFrameCond.unlock();
+        device->playbackSubmittedFrame();
+        device->fFrameCond.lock();
+        device->fFrameInFlight = false;
+        device->fFrameCond.broadcast();
+    }
+    device->fFrameCond.unlock();
+}
+
+void SkDeferredDevice::waitForPipelinedFlush() {
+    if (NULL != fRasterThread) {
+        fFrameCond.lock();
+        while (fFrameInFlight) {
+            fFrameCond.wait();
+        }
+        fFrameCond.unlock();
+    }
+    if (NULL != fSubmittedWriter) {
+        // The writer was kept recording so the bitmaps it shares with the reader stay alive
+        // until the frame is drawn. Ending it writes one last command, which nothing reads.
+        fSubmittedWriter->endRecording();
+        fSubmittedController->reset();
+        fSubmittedController = NULL;
+        fSubmittedWriter = NULL;
+    }
+}
+
 size_t SkDeferredDevice::freeMemoryIfPossible(size_t bytesToFree) {
-    size_t val = fPipeWriter.freeMemoryIfPossible(bytesToFree);
+    size_t val = fPipeWriter->freeMemoryIfPossible(bytesToFree);
     fPreviousStorageAllocated = storageAllocatedForRecording();
     return val;
 }
 
 size_t SkDeferredDevice::storageAllocatedForRecording() const {
-    return (fPipeController.storageAllocatedForRecording()
-            + fPipeWriter.storageAllocatedForRecording());
+    return (fPipeController->storageAllocatedForRecording()
+            + fPipeWriter->storageAllocatedForRecording());
 }
 
 void SkDeferredDevice::recordedDrawCommand() {
@@ -390,8 +575,13 @@ void SkDeferredDevice::recordedDrawCommand() {
         // First, attempt to reduce cache without flushing
         size_t tryFree = storageAllocated - fMaxRecordingStorageBytes;
         if (this->freeMemoryIfPossible(tryFree) < tryFree) {
-            // Flush is necessary to free more space.
-            this->flushPendingCommands(kNormal_PlaybackMode);
+            // Flush is necessary to free more space. If the frame can go to the raster thread,
+            // this only waits for the one before it.
+            if (this->canSubmitFrame()) {
+                this->submitFrame();
+            } else {
+                this->flushPendingCommands(kNormal_PlaybackMode);
+            }
             // Free as much as possible to avoid oscillating around fMaxRecordingStorageBytes
             // which could cause a high flushing frequency.
             this->freeMemoryIfPossible(~0U);
@@ -411,12 +601,14 @@ SkCanvas* SkDeferredDevice::recordingCanvas() {
 }
 
 SkImage* SkDeferredDevice::newImageSnapshot() {
-    this->flush();
+    // Not flush(), which may leave the frame drawing on the raster thread.
+    this->flushPendingCommands(kNormal_PlaybackMode);
+    fImmediateCanvas->flush();
     return fSurface ? fSurface->newImageSnapshot() : NULL;
 }
 
 SkImageInfo SkDeferredDevice::imageInfo() const {
-    return immediateDevice()->imageInfo();
+    return fImmediateInfo;
 }
 
 GrRenderTarget* SkDeferredDevice::accessRenderTarget() {
@@ -425,10 +617,11 @@ GrRenderTarget* SkDeferredDevice::accessRenderTarget() {
 }
 
 void SkDeferredDevice::prepareForImmediatePixelWrite() {
+    this->waitForPipelinedFlush();
     // The purpose of the following code is to make sure commands are flushed, that
     // aboutToDraw() is called and that notifyContentWillChange is called, without
     // calling anything redundantly.
-    if (fPipeController.hasPendingCommands()) {
+    if (fPipeController->hasPendingCommands()) {
         this->flushPendingCommands(kNormal_PlaybackMode);
     } else {
         bool mustNotifyDirectly = !fCanDiscardCanvasContents;
@@ -471,10 +664,12 @@ SkBaseDevice* SkDeferredDevice::onCreateDevice(const SkImageInfo& info, Usage us
     // will not be used with a deferred canvas (there is no API for that).
     // And connecting a SkDeferredDevice to non-deferred canvas can result
     // in unpredictable behavior.
+    this->waitForPipelinedFlush();
     return immediateDevice()->createCompatibleDevice(info);
 }
 
 SkSurface* SkDeferredDevice::newSurface(const SkImageInfo& info) {
+    this->waitForPipelinedFlush();
     return this->immediateDevice()->newSurface(info);
 }
 
@@ -541,6 +736,15 @@ size_t SkDeferredCanvas::freeMemoryIfPossible(size_t bytesToFree) {
     return this->getDeferredDevice()->freeMemoryIfPossible(bytesToFree);
 }
 
+void SkDeferredCanvas::setPipelinedFlushing(bool pipelined) {
+    this->validate();
+    this->getDeferredDevice()->setPipelinedFlushing(pipelined);
+}
+
+void SkDeferredCanvas::waitForPipelinedFlush() {
+    this->getDeferredDevice()->waitForPipelinedFlush();
+}
+
 void SkDeferredCanvas::setBitmapSizeThreshold(size_t sizeThreshold) {
     fBitmapSizeThreshold = sizeThreshold;
 }
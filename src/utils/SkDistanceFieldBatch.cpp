@@ -0,0 +1,108 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkDistanceFieldBatch.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
+
+namespace {
+
+// Small images are grouped until a task has at least this many texels, so that the cost
+// of queueing a task stays small next to the work in it.
+static const int kMinTexelsPerTask = 64 * 1024;
+
+static int64_t texel_count(const SkDistanceFieldRequest& request) {
+    return sk_64_mul(request.fWidth, request.fHeight);
+}
+
+struct LargerRequest {
+    bool operator()(const SkDistanceFieldRequest* a, const SkDistanceFieldRequest* b) const {
+        return texel_count(*a) > texel_count(*b);
+    }
+};
+
+/**
+ *  Generates the distance fields of a run of requests.
+ */
+class DistanceFieldRunnable : public SkRunnable {
+public:
+    DistanceFieldRunnable(const SkDistanceFieldRequest* const* requests, int count,
+                          SkDistanceFieldMethod method)
+        : fRequests(requests)
+        , fCount(count)
+        , fMethod(method)
+        , fSuccess(false) {}
+
+    virtual void run() SK_OVERRIDE {
+        bool success = true;
+        for (int i = 0; i < fCount; ++i) {
+            const SkDistanceFieldRequest& request = *fRequests[i];
+            success &= SkGenerateDistanceFieldFromA8Image(request.fDistanceField, request.fImage,
+                                                          request.fWidth, request.fHeight,
+                                                          request.fRowBytes, fMethod);
+        }
+        fSuccess = success;
+    }
+
+    bool success() const { return fSuccess; }
+
+private:
+    const SkDistanceFieldRequest* const* fRequests;
+    const int                            fCount;
+    const SkDistanceFieldMethod          fMethod;
+    bool                                 fSuccess;
+};
+
+}  // namespace
+
+bool SkDistanceFieldBatch::GenerateFromA8Images(const SkDistanceFieldRequest requests[],
+                                                int count, SkDistanceFieldMethod method,
+                                                int threadCount) {
+    SkASSERT(count >= 0);
+    if (0 == count) {
+        return true;
+    }
+    SkASSERT(requests);
+
+    SkTDArray<const SkDistanceFieldRequest*> sorted;
+    sorted.setCount(count);
+    for (int i = 0; i < count; ++i) {
+        sorted[i] = &requests[i];
+    }
+    SkTQSort(sorted.begin(), sorted.end() - 1, LargerRequest());
+
+    SkTDArray<DistanceFieldRunnable*> tasks;
+    for (int start = 0; start < count;) {
+        int64_t texels = 0;
+        int end = start;
+        while (end < count && texels < kMinTexelsPerTask) {
+            texels += texel_count(*sorted[end]);
+            ++end;
+        }
+        *tasks.append() = SkNEW_ARGS(DistanceFieldRunnable,
+                                     (sorted.begin() + start, end - start, method));
+        start = end;
+    }
+
+    {
+        if (SkThreadPool::kThreadPerCore == threadCount) {
+            threadCount = num_cores();
+        }
+        SkThreadPool pool(SkTMin(threadCount, tasks.count()));
+        for (int i = 0; i < tasks.count(); ++i) {
+            pool.add(tasks[i]);
+        }
+        pool.wait();
+    }
+
+    bool success = true;
+    for (int i = 0; i < tasks.count(); ++i) {
+        success &= tasks[i]->success();
+    }
+    tasks.deleteAll();
+    return success;
+}
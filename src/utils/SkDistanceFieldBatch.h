@@ -0,0 +1,48 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkDistanceFieldBatch_DEFINED
+#define SkDistanceFieldBatch_DEFINED
+
+#include "SkDistanceFieldGen.h"
+#include "SkThreadPool.h"
+
+/**
+ *  One image for SkDistanceFieldBatch::GenerateFromA8Images(), with the same
+ *  meaning as the arguments of SkGenerateDistanceFieldFromA8Image().
+ */
+struct SkDistanceFieldRequest {
+    unsigned char*       fDistanceField;  // SkComputeDistanceFieldSize(fWidth, fHeight) bytes
+    const unsigned char* fImage;
+    int                  fWidth;
+    int                  fHeight;
+    int                  fRowBytes;
+};
+
+/**
+ *  Generates distance fields for many images (e.g. every glyph of an atlas)
+ *  on a pool of threads.
+ */
+namespace SkDistanceFieldBatch {
+    /**
+     *  Generate the distance field of every request, as
+     *  SkGenerateDistanceFieldFromA8Image() would.
+     *
+     *  The largest images are started first, and small ones are grouped
+     *  so that each task is worth handing to another thread. The results do
+     *  not depend on threadCount.
+     *
+     *  @param threadCount Number of worker threads, or SkThreadPool::kThreadPerCore. If 0,
+     *         every request is generated serially on the calling thread.
+     *
+     *  @return true if every distance field was generated.
+     */
+    bool GenerateFromA8Images(const SkDistanceFieldRequest requests[], int count,
+                              SkDistanceFieldMethod method, int threadCount);
+}
+
+#endif  // SkDistanceFieldBatch_DEFINED
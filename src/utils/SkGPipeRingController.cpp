@@ -0,0 +1,229 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGPipeRingController.h"
+#include "SkCondVar.h"
+#include "SkThread.h"
+#include "SkThreadUtils.h"
+
+// Unused space between the writer and the reader, so a full ring (fHead just behind fTail)
+// can't be mistaken for an empty one (fHead == fTail).
+static const size_t kGap = 4;
+
+SkGPipeRingController::SkGPipeRingController(size_t capacity)
+    : fCapacity(SkAlign4(SkTMax<size_t>(capacity, 2 * kGap)))
+    , fHead(0)
+    , fWrap(0)
+    , fWriterDone(false)
+    , fCursor(0)
+    , fMinRequest(0)
+    , fTail(0)
+    , fReaderClosed(false)
+    , fCond(SkNEW(SkCondVar))
+    , fReaderWaiting(0)
+    , fWriterWaiting(0) {
+    fBuffer = (char*)sk_malloc_throw(fCapacity);
+}
+
+SkGPipeRingController::~SkGPipeRingController() {
+    SkDELETE(fCond);
+    sk_free(fBuffer);
+}
+
+/*
+ *  The data runs from fTail to fHead, unless the writer has wrapped around to the start of
+ *  the ring, in which case it runs from fTail to fWrap and then from 0 to fHead.
+ */
+bool SkGPipeRingController::findBlock(size_t minRequest, size_t* start, size_t* size) const {
+    const size_t tail = sk_acquire_load(&fTail);
+    if (fCursor >= tail) {
+        // Leave the gap at the end of the ring if the reader is at its start.
+        const size_t reserve = (0 == tail) ? kGap : 0;
+        if (fCapacity >= fCursor + reserve + minRequest) {
+            *start = fCursor;
+            *size = fCapacity - fCursor - reserve;
+            return true;
+        }
+        if (tail >= kGap + minRequest) {
+            *start = 0;
+            *size = tail - kGap;
+            return true;
+        }
+    } else if (tail >= fCursor + kGap + minRequest) {
+        *start = fCursor;
+        *size = tail - fCursor - kGap;
+        return true;
+    }
+    return false;
+}
+
+void* SkGPipeRingController::requestBlock(size_t minRequest, size_t* actual) {
+    SkASSERT(SkIsAlign4(minRequest));
+    for (;;) {
+        if (sk_acquire_load(&fReaderClosed)) {
+            return NULL;
+        }
+
+        size_t start, size;
+        if (this->findBlock(minRequest, &start, &size)) {
+            if (start != fCursor) {
+                // Published to the reader along with the first bytes written at the start.
+                fWrap = fCursor;
+                fCursor = start;
+            }
+            *actual = size;
+            return fBuffer + start;
+        }
+
+        if (sk_acquire_load(&fTail) == fHead) {
+            // The reader has caught up, so the whole ring is free.
+            if (fCursor != fHead) {
+                // Nothing was written after wrapping around, so stay put instead.
+                fCursor = fHead;
+                continue;
+            }
+            // Even an empty ring is too small, so make it big enough. Nothing is left to
+            // copy, and the reader won't look at the buffer until fHead moves.
+            fCapacity = SkTMax(2 * fCapacity, fCursor + minRequest + kGap);
+            sk_free(fBuffer);
+            fBuffer = (char*)sk_malloc_throw(fCapacity);
+            continue;
+        }
+
+        fMinRequest = minRequest;
+        this->waitWhile(&WriterMustWait, &fWriterWaiting);
+    }
+}
+
+void SkGPipeRingController::notifyWritten(size_t bytes) {
+    if (0 == bytes) {
+        sk_release_store(&fWriterDone, true);
+    } else {
+        fCursor += bytes;
+        SkASSERT(fCursor <= fCapacity);
+        sk_release_store(&fHead, fCursor);
+    }
+    this->wake(&fReaderWaiting);
+}
+
+const void* SkGPipeRingController::beginRead(size_t* bytes) {
+    for (;;) {
+        const size_t head = sk_acquire_load(&fHead);
+        if (head > fTail) {
+            *bytes = head - fTail;
+            return fBuffer + fTail;
+        }
+        if (head < fTail) {
+            if (fTail < fWrap) {
+                *bytes = fWrap - fTail;
+                return fBuffer + fTail;
+            }
+            // Everything before the wrap has been read, so follow the writer to the start.
+            sk_release_store<size_t>(&fTail, 0);
+            continue;
+        }
+        if (sk_acquire_load(&fWriterDone)) {
+            return NULL;
+        }
+        this->waitWhile(&ReaderMustWait, &fReaderWaiting);
+    }
+}
+
+void SkGPipeRingController::endRead(size_t bytes) {
+    sk_release_store(&fTail, fTail + bytes);
+    this->wake(&fWriterWaiting);
+}
+
+void SkGPipeRingController::close() {
+    sk_release_store(&fReaderClosed, true);
+    this->wake(&fWriterWaiting);
+}
+
+bool SkGPipeRingController::ReaderMustWait(const SkGPipeRingController* ring) {
+    return sk_acquire_load(&ring->fHead) == ring->fTail && !sk_acquire_load(&ring->fWriterDone);
+}
+
+bool SkGPipeRingController::WriterMustWait(const SkGPipeRingController* ring) {
+    size_t start, size;
+    return !sk_acquire_load(&ring->fReaderClosed) &&
+           sk_acquire_load(&ring->fTail) != ring->fHead &&
+           !ring->findBlock(ring->fMinRequest, &start, &size);
+}
+
+void SkGPipeRingController::waitWhile(bool (*mustWait)(const SkGPipeRingController*),
+                                      int32_t* waiting) {
+    fCond->lock();
+    // sk_atomic_inc is a full barrier, so mustWait() can't see the state from before the
+    // other side last changed it unless the other side then sees *waiting incremented.
+    sk_atomic_inc(waiting);
+    while (mustWait(this)) {
+        fCond->wait();
+    }
+    sk_atomic_dec(waiting);
+    fCond->unlock();
+}
+
+void SkGPipeRingController::wake(int32_t* waiting) {
+    // Also a full barrier, so this can't be read before the change it is announcing is written.
+    if (sk_atomic_add(waiting, 0) > 0) {
+        fCond->lock();
+        fCond->broadcast();
+        fCond->unlock();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkGPipeReaderThread::SkGPipeReaderThread(SkGPipeRingController* controller, SkCanvas* target)
+    : fController(controller)
+    , fReader(target)
+    , fThread(NULL)
+    , fStatus(SkGPipeReader::kEOF_Status) {
+}
+
+SkGPipeReaderThread::~SkGPipeReaderThread() {
+    this->join();
+}
+
+bool SkGPipeReaderThread::start() {
+    SkASSERT(NULL == fThread);
+    fThread = SkNEW_ARGS(SkThread, (&SkGPipeReaderThread::Run, this));
+    if (!fThread->start()) {
+        SkDELETE(fThread);
+        fThread = NULL;
+        return false;
+    }
+    return true;
+}
+
+SkGPipeReader::Status SkGPipeReaderThread::join() {
+    if (NULL != fThread) {
+        fThread->join();
+        SkDELETE(fThread);
+        fThread = NULL;
+    }
+    return fStatus;
+}
+
+void SkGPipeReaderThread::Run(void* data) {
+    SkGPipeReaderThread* self = static_cast<SkGPipeReaderThread*>(data);
+    SkGPipeRingController* controller = self->fController;
+
+    SkGPipeReader::Status status = SkGPipeReader::kEOF_Status;
+    size_t bytes;
+    const void* commands;
+    while (NULL != (commands = controller->beginRead(&bytes))) {
+        status = self->fReader.playback(commands, bytes);
+        controller->endRead(bytes);
+        if (SkGPipeReader::kEOF_Status != status) {
+            break;
+        }
+    }
+    // In case we stopped early, don't leave the writer waiting for room.
+    controller->close();
+    self->fStatus = status;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkIncrementalRaster.h"
+#include "SkCanvas.h"
+#include "SkPictureUtils.h"
+
+static const int kMaxRedrawRects = 4;
+
+SkIncrementalRaster::SkIncrementalRaster(const SkImageInfo& info) {
+    fBitmap.allocPixels(info);
+    fBitmap.eraseColor(SK_ColorTRANSPARENT);
+}
+
+void SkIncrementalRaster::draw(const SkPicture* picture, SkRegion* damage) {
+    SkASSERT(NULL != picture);
+
+    const SkIRect area = SkIRect::MakeWH(fBitmap.width(), fBitmap.height());
+    SkRegion dirty;
+    if (NULL == fPrevious.get()) {
+        dirty.setRect(area);
+    } else {
+        SkPictureUtils::ComputeDamage(fPrevious, picture, area, &dirty);
+    }
+
+    // Redraw one rectangle at a time.  Under a complex clip the scan converter clips edges
+    // before rasterizing them, which can move their pixels, so that drawing under the whole
+    // region would not always match a full redraw.  Each rectangle replays the whole picture,
+    // so past a few of them it is cheaper to redraw their bounds once.
+    int rectCount = 0;
+    for (SkRegion::Iterator iter(dirty); !iter.done() && rectCount <= kMaxRedrawRects; iter.next()) {
+        rectCount++;
+    }
+    if (rectCount > kMaxRedrawRects) {
+        dirty.setRect(dirty.getBounds());
+    }
+
+    SkCanvas canvas(fBitmap);
+    for (SkRegion::Iterator iter(dirty); !iter.done(); iter.next()) {
+        SkAutoCanvasRestore acr(&canvas, true);
+        canvas.clipRect(SkRect::Make(iter.rect()));
+        // Unlike clear(), drawColor() respects the clip.
+        canvas.drawColor(SK_ColorTRANSPARENT, SkXfermode::kSrc_Mode);
+        canvas.drawPicture(picture);
+    }
+
+    fPrevious.reset(SkRef(picture));
+    if (NULL != damage) {
+        damage->swap(dirty);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkPicturePrefetcher.h"
+#include "SkData.h"
+#include "SkPicture.h"
+#include "SkPictureUtils.h"
+#include "SkPixelRef.h"
+#include "SkRunnable.h"
+#include "SkThreadPool.h"
+
+/**
+ *  Locking the pixel ref is what triggers its decode. The lock is held until the task is
+ *  deleted, so the decoded pixels can't be purged before playback gets to them. The pixel
+ *  ref's own mutex makes the raster thread wait on (rather than repeat) a decode that is
+ *  still in flight.
+ */
+class SkPicturePrefetcher::PrefetchTask : public SkRunnable {
+public:
+    explicit PrefetchTask(SkPixelRef* pr) : fPixelRef(SkRef(pr)), fLocked(false) {}
+
+    virtual ~PrefetchTask() {
+        if (fLocked) {
+            fPixelRef->unlockPixels();
+        }
+        fPixelRef->unref();
+    }
+
+    virtual void run() SK_OVERRIDE {
+        fLocked = fPixelRef->lockPixels();
+    }
+
+private:
+    SkPixelRef* fPixelRef;
+    bool        fLocked;
+};
+
+SkPicturePrefetcher::SkPicturePrefetcher(int threadCount)
+    : fThreadCount(threadCount)
+    , fPool(NULL) {
+}
+
+SkPicturePrefetcher::~SkPicturePrefetcher() {
+    this->reset();
+}
+
+int SkPicturePrefetcher::prefetch(const SkPicture* pict, const SkRect& area) {
+    if (NULL == pict || !pict->willPlayBackBitmaps()) {
+        return 0;
+    }
+
+    SkAutoDataUnref data(SkPictureUtils::GatherPixelRefs(pict, area));
+    if (NULL == data.get()) {
+        return 0;
+    }
+
+    SkPixelRef** refs = (SkPixelRef**)data->data();
+    const int count = static_cast<int>(data->size() / sizeof(SkPixelRef*));
+
+    int scheduled = 0;
+    for (int i = 0; i < count; ++i) {
+        if (fPixelRefs.find(refs[i]) >= 0) {
+            continue;
+        }
+        *fPixelRefs.append() = refs[i];
+
+        PrefetchTask* task = SkNEW_ARGS(PrefetchTask, (refs[i]));
+        *fTasks.append() = task;
+        if (NULL == fPool) {
+            fPool = SkNEW_ARGS(SkThreadPool, (fThreadCount));
+        }
+        fPool->add(task);
+        ++scheduled;
+    }
+    return scheduled;
+}
+
+void SkPicturePrefetcher::wait() {
+    // SkThreadPool can't take more work once waited on, so the next prefetch() makes a new one.
+    SkDELETE(fPool);
+    fPool = NULL;
+}
+
+void SkPicturePrefetcher::reset() {
+    this->wait();
+    fTasks.deleteAll();
+    fPixelRefs.reset();
+}
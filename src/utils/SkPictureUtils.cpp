@@ -11,6 +11,7 @@
 #include "SkNoSaveLayerCanvas.h"
 #include "SkPictureUtils.h"
 #include "SkPixelRef.h"
+#include "SkRecordDiff.h"
 #include "SkRRect.h"
 #include "SkShader.h"
 
@@ -218,3 +219,18 @@ SkData* SkPictureUtils::GatherPixelRefs(const SkPicture* pict, const SkRect& are
     }
     return data;
 }
+
+void SkPictureUtils::ComputeDamage(const SkPicture* before, const SkPicture* after,
+                                   const SkIRect& area, SkRegion* damage) {
+    SkASSERT(NULL != damage);
+    if (before == after) {
+        damage->setEmpty();
+        return;
+    }
+    if (NULL == before || NULL == after ||
+        NULL == before->fRecord.get() || NULL == after->fRecord.get()) {
+        damage->setRect(area);
+        return;
+    }
+    SkRecordDiff(*before->fRecord, *after->fRecord, area, damage);
+}
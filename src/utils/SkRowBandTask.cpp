@@ -0,0 +1,70 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRowBandTask.h"
+#include "SkRunnable.h"
+#include "SkTDArray.h"
+#include "SkThreadPool.h"
+
+namespace {
+
+// Bands hold about this many pixels, so that the cost of queueing one stays small next to
+// the work in it.
+static const int kPixelsPerBand = 64 * 1024;
+
+class BandRunnable : public SkRunnable {
+public:
+    BandRunnable(SkRowBandTask* task, int top, int bottom)
+        : fTask(task)
+        , fTop(top)
+        , fBottom(bottom) {}
+
+    virtual void run() SK_OVERRIDE {
+        fTask->runBand(fTop, fBottom);
+    }
+
+private:
+    SkRowBandTask* const fTask;
+    const int            fTop;
+    const int            fBottom;
+};
+
+}  // namespace
+
+void SkRowBandTask::run(int width, int top, int bottom, int threadCount, int rowMultiple) {
+    SkASSERT(rowMultiple > 0);
+    if (top >= bottom) {
+        return;
+    }
+
+    const int bandHeight = rowMultiple * SkTMax(1, kPixelsPerBand / SkTMax(1, width * rowMultiple));
+    const int bandCount = (bottom - top + bandHeight - 1) / bandHeight;
+    if (SkThreadPool::kThreadPerCore == threadCount) {
+        threadCount = num_cores();
+    }
+    threadCount = SkTMin(threadCount, bandCount);
+
+    if (threadCount <= 1) {
+        for (int y = top; y < bottom; y += bandHeight) {
+            this->runBand(y, SkTMin(y + bandHeight, bottom));
+        }
+        return;
+    }
+
+    SkTDArray<BandRunnable*> bands;
+    for (int y = top; y < bottom; y += bandHeight) {
+        *bands.append() = SkNEW_ARGS(BandRunnable, (this, y, SkTMin(y + bandHeight, bottom)));
+    }
+    {
+        SkThreadPool pool(threadCount);
+        for (int i = 0; i < bands.count(); ++i) {
+            pool.add(bands[i]);
+        }
+        pool.wait();
+    }
+    bands.deleteAll();
+}
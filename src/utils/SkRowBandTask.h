@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRowBandTask_DEFINED
+#define SkRowBandTask_DEFINED
+
+#include "SkTypes.h"
+
+/**
+ *  Callers that leave the thread count to SkRowBandTask (the raster lighting, matrix
+ *  convolution and displacement map filters) work on the calling thread, unless this is
+ *  defined, e.g. in SkUserConfig.h, to a number of worker threads, or to -1 for one per core.
+ */
+#ifndef SK_ROW_BAND_THREAD_COUNT
+    #define SK_ROW_BAND_THREAD_COUNT 0
+#endif
+
+/**
+ *  Work on the rows of an image that can be cut into bands which do not depend on each other,
+ *  so that the bands can be handed to worker threads.
+ */
+class SkRowBandTask : SkNoncopyable {
+public:
+    virtual ~SkRowBandTask() {}
+
+    static const int kDefaultThreadCount = SK_ROW_BAND_THREAD_COUNT;
+
+    /**
+     *  Calls runBand() once for each band of the rows [top, bottom) of an image width pixels
+     *  wide. Bands hold roughly 64K pixels, and their heights are multiples of rowMultiple.
+     *
+     *  @param threadCount Number of worker threads, or SkThreadPool::kThreadPerCore. There
+     *         are never more threads than bands. If 0 or 1, the bands run in order on the
+     *         calling thread. Otherwise this returns once every band is done.
+     */
+    void run(int width, int top, int bottom, int threadCount = kDefaultThreadCount,
+             int rowMultiple = 1);
+
+    /**
+     *  Does the work for the rows [top, bottom). This may be called on several threads at
+     *  once, so it must only write to its own rows.
+     */
+    virtual void runBand(int top, int bottom) = 0;
+};
+
+#endif
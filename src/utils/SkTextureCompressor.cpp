@@ -7,13 +7,17 @@
 
 #include "SkTextureCompressor.h"
 #include "SkTextureCompressor_ASTC.h"
+#include "SkTextureCompressor_BandBlitter.h"
 #include "SkTextureCompressor_LATC.h"
 #include "SkTextureCompressor_R11EAC.h"
 
 #include "SkBitmap.h"
 #include "SkBitmapProcShader.h"
+#include "SkColorPriv.h"
 #include "SkData.h"
 #include "SkEndian.h"
+#include "SkRowBandTask.h"
+#include "SkThread.h"
 
 #include "SkTextureCompression_opts.h"
 
@@ -31,6 +35,83 @@ static bool compress_etc1_565(uint8_t* dst, const uint8_t* src,
 #endif
 }
 
+// ETC1 has no alpha, so we drop it and encode the (premultiplied) color. The encoder
+// only reads 24-bit RGB, so we repack one row of blocks at a time.
+static bool compress_etc1_8888(uint8_t* dst, const uint8_t* src,
+                               int width, int height, int rowBytes) {
+#ifndef SK_IGNORE_ETC1_SUPPORT
+    const int blockRowBytes = 8 * ((width + 3) >> 2);
+    SkAutoTMalloc<uint8_t> rgb(3 * 4 * width);
+    for (int y = 0; y < height; y += 4) {
+        const int rows = SkTMin(4, height - y);
+        uint8_t* rgbPtr = rgb.get();
+        for (int j = 0; j < rows; ++j) {
+            const SkPMColor* row = reinterpret_cast<const SkPMColor*>(src + (y + j) * rowBytes);
+            for (int i = 0; i < width; ++i) {
+                *rgbPtr++ = SkGetPackedR32(row[i]);
+                *rgbPtr++ = SkGetPackedG32(row[i]);
+                *rgbPtr++ = SkGetPackedB32(row[i]);
+            }
+        }
+        if (0 != etc1_encode_image(rgb.get(), width, rows, 3, 3 * width, dst)) {
+            return false;
+        }
+        dst += blockRowBytes;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Compresses bands of whole rows of blocks for CompressBufferToFormatInParallel.
+class CompressBandTask : public SkRowBandTask {
+public:
+    CompressBandTask(uint8_t* dst, const uint8_t* src, SkColorType colorType,
+                     int width, int rowBytes, SkTextureCompressor::Format format)
+        : fDst(dst)
+        , fSrc(src)
+        , fColorType(colorType)
+        , fWidth(width)
+        , fRowBytes(rowBytes)
+        , fFormat(format)
+        , fFailedBands(0) {
+        SkTextureCompressor::GetBlockDimensions(format, &fDimX, &fDimY, true);
+        fBlockRowBytes = static_cast<size_t>(width / fDimX) *
+                         SkTextureCompressor::GetCompressedDataSize(format, fDimX, fDimY);
+    }
+
+    virtual void runBand(int top, int bottom) SK_OVERRIDE {
+        SkASSERT(0 == top % fDimY);
+        if (!SkTextureCompressor::CompressBufferToFormat(
+                fDst + fBlockRowBytes * (top / fDimY),
+                fSrc + static_cast<size_t>(fRowBytes) * top,
+                fColorType, fWidth, bottom - top, fRowBytes, fFormat)) {
+            sk_atomic_inc(&fFailedBands);
+        }
+    }
+
+    bool success() const { return 0 == fFailedBands; }
+
+private:
+    uint8_t* const                    fDst;
+    const uint8_t* const              fSrc;
+    const SkColorType                 fColorType;
+    const int                         fWidth;
+    const int                         fRowBytes;
+    const SkTextureCompressor::Format fFormat;
+    int                               fDimX;
+    int                               fDimY;
+    size_t                            fBlockRowBytes;
+    int32_t                           fFailedBands;
+};
+
+}  // namespace
+
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace SkTextureCompressor {
@@ -160,6 +241,19 @@ bool CompressBufferToFormat(uint8_t* dst, const uint8_t* src, SkColorType srcCol
             }
             break;
 
+            case kN32_SkColorType:
+            {
+                switch (format) {
+                    case kETC1_Format:
+                        proc = compress_etc1_8888;
+                        break;
+                    default:
+                        // Do nothing...
+                        break;
+                }
+            }
+            break;
+
             default:
                 // Do nothing...
                 break;
@@ -173,6 +267,24 @@ bool CompressBufferToFormat(uint8_t* dst, const uint8_t* src, SkColorType srcCol
     return false;
 }
 
+bool CompressBufferToFormatInParallel(uint8_t* dst, const uint8_t* src, SkColorType srcColorType,
+                                      int width, int height, int rowBytes, Format format,
+                                      int threadCount) {
+    if (GetCompressedDataSize(format, width, height) < 0) {
+        return false;
+    }
+
+    // Bands are whole rows of blocks, as tall as the platform encoder likes them.
+    int dimX, dimY, platformDimX, platformDimY;
+    GetBlockDimensions(format, &dimX, &dimY, true);
+    GetBlockDimensions(format, &platformDimX, &platformDimY);
+    const int bandDimY = (platformDimY % dimY) == 0 ? platformDimY : dimY;
+
+    CompressBandTask task(dst, src, srcColorType, width, rowBytes, format);
+    task.run(width, 0, height, threadCount, bandDimY);
+    return task.success();
+}
+
 SkData *CompressBitmapToFormat(const SkBitmap &bitmap, Format format) {
     SkAutoLockPixels alp(bitmap);
 
@@ -212,6 +324,20 @@ SkBlitter* CreateBlitterForFormat(int width, int height, void* compressedBuffer,
     return NULL;
 }
 
+SkBlitter* CreateBandBlitterForFormat(int width, int height, void* compressedBuffer,
+                                      SkTBlitterAllocator *allocator, Format format) {
+    switch(format) {
+        case kLATC_Format:
+        case kR11_EAC_Format:
+            return CreateBandBlitter(width, height, compressedBuffer, allocator, format);
+
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
 bool DecompressBufferFromFormat(uint8_t* dst, int dstRowBytes, const uint8_t* src,
                                 int width, int height, Format format) {
     int dimX, dimY;
@@ -10,6 +10,7 @@
 
 #include "SkBitmapProcShader.h"
 #include "SkImageInfo.h"
+#include "SkThreadPool.h"
 
 class SkBitmap;
 class SkBlitter;
@@ -23,11 +24,9 @@ namespace SkTextureCompressor {
         kR11_EAC_Format,    // 4x4 blocks, (de)compresses A8
 
         // RGB only formats
-        kETC1_Format,       // 4x4 blocks, compresses RGB 565, decompresses 8-bit RGB
-                            //    NOTE: ETC1 supports 8-bit RGB compression, but we
-                            //    currently don't have any RGB8 SkColorTypes. We could
-                            //    support 8-bit RGBA but we would have to preprocess the
-                            //    bitmap to insert alphas.
+        kETC1_Format,       // 4x4 blocks, compresses RGB 565 and N32, decompresses 8-bit RGB
+                            //    NOTE: ETC1 has no alpha, so compressing N32 drops it
+                            //    and keeps the premultiplied color.
 
         // Multi-purpose formats
         kASTC_4x4_Format,   // 4x4 blocks, no compression, decompresses RGBA
@@ -67,6 +66,16 @@ namespace SkTextureCompressor {
                                 int width, int height, int rowBytes, Format format,
                                 bool opt = true /* Use optimization if available */);
 
+    // Same as CompressBufferToFormat, but splits the image into bands of whole rows of
+    // blocks and compresses them on threadCount threads, or one per core for
+    // SkThreadPool::kThreadPerCore. The result does not depend on threadCount, and if it
+    // is 0, everything is compressed on the calling thread.
+    // The dimensions must be multiples of the format's block size.
+    bool CompressBufferToFormatInParallel(uint8_t* dst, const uint8_t* src,
+                                          SkColorType srcColorType, int width, int height,
+                                          int rowBytes, Format format,
+                                          int threadCount = SkThreadPool::kThreadPerCore);
+
     // Decompresses the given src data from the format specified into the
     // destination buffer. The width and height of the data passed corresponds
     // to the width and height of the uncompressed image. The destination buffer (dst)
@@ -106,6 +115,15 @@ namespace SkTextureCompressor {
     SkBlitter* CreateBlitterForFormat(int width, int height, void* compressedBuffer,
                                       SkTBlitterAllocator *allocator, Format format);
 
+    // Returns a blitter for any path fill or stroke into an LATC or R11 EAC texture, or NULL
+    // for other formats. Unlike the blitters above, it accepts every kind of blit, with the
+    // same pixels as compressing the A8 mask that SkA8_Coverage_Blitter would have drawn.
+    // It keeps only one row of blocks uncompressed at a time and compresses it when blits
+    // move on to the next, so it is fastest when blits come from top to bottom, as they
+    // do from SkScan. The compressed buffer is complete once the blitter is destroyed.
+    SkBlitter* CreateBandBlitterForFormat(int width, int height, void* compressedBuffer,
+                                          SkTBlitterAllocator *allocator, Format format);
+
     // Returns the desired dimensions of the block size for the given format. These dimensions
     // don't necessarily correspond to the specification's dimensions, since there may
     // be specialized algorithms that operate on multiple blocks at once. If the
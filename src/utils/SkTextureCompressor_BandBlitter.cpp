@@ -0,0 +1,179 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTextureCompressor_BandBlitter.h"
+
+#include "SkBlitter.h"
+#include "SkMask.h"
+#include "SkTemplates.h"
+
+namespace {
+
+// Blits like SkA8_Coverage_Blitter into an A8 band one row of blocks tall, and compresses
+// the band whenever a blit moves on to another one. SkScan blits from top to bottom, so
+// usually each band is compressed exactly once. A blit into a band that has already been
+// compressed decompresses it first; the fast LATC and R11 EAC encoders reproduce their own
+// decompressed output exactly, so this costs time but not quality.
+class SkCompressedBandBlitter : public SkBlitter {
+public:
+    SkCompressedBandBlitter(int width, int height, void* outputBuffer,
+                            SkTextureCompressor::Format format)
+        : fWidth(width)
+        , fHeight(height)
+        , fBuffer(static_cast<uint8_t*>(outputBuffer))
+        , fFormat(format)
+        , fBandTop(-1)
+        , fWrittenRows(0) {
+        int dimX;
+        SkTextureCompressor::GetBlockDimensions(format, &dimX, &fBandHeight, true);
+        SkASSERT((width % dimX) == 0);
+        SkASSERT((height % fBandHeight) == 0);
+
+        fBlockRowBytes = SkTextureCompressor::GetCompressedDataSize(format, width, fBandHeight);
+        fBand.reset(width * fBandHeight);
+
+        // Untouched rows of blocks get the encoding of a transparent band.
+        fEmptyBlockRow.reset(fBlockRowBytes);
+        sk_bzero(fBand.get(), width * fBandHeight);
+        SkTextureCompressor::CompressBufferToFormat(fEmptyBlockRow.get(), fBand.get(),
+                                                    kAlpha_8_SkColorType, width, fBandHeight,
+                                                    width, format);
+    }
+
+    virtual ~SkCompressedBandBlitter() {
+        this->flushBand();
+        this->fillEmptyBlockRows(fHeight);
+    }
+
+    virtual void blitH(int x, int y, int width) SK_OVERRIDE {
+        memset(this->getAddr(x, y), 0xFF, width);
+    }
+
+    virtual void blitAntiH(int x, int y, const SkAlpha antialias[],
+                           const int16_t runs[]) SK_OVERRIDE {
+        uint8_t* device = this->getAddr(x, y);
+        for (;;) {
+            const int count = runs[0];
+            SkASSERT(count >= 0);
+            if (0 == count) {
+                return;
+            }
+            if (antialias[0]) {
+                memset(device, antialias[0], count);
+            }
+            runs += count;
+            antialias += count;
+            device += count;
+        }
+    }
+
+    virtual void blitV(int x, int y, int height, SkAlpha alpha) SK_OVERRIDE {
+        if (0 == alpha) {
+            return;
+        }
+        for (int i = 0; i < height; ++i) {
+            *this->getAddr(x, y + i) = alpha;
+        }
+    }
+
+    virtual void blitRect(int x, int y, int width, int height) SK_OVERRIDE {
+        for (int i = 0; i < height; ++i) {
+            memset(this->getAddr(x, y + i), 0xFF, width);
+        }
+    }
+
+    virtual void blitMask(const SkMask& mask, const SkIRect& clip) SK_OVERRIDE {
+        if (SkMask::kA8_Format != mask.fFormat) {
+            this->INHERITED::blitMask(mask, clip);
+            return;
+        }
+        for (int y = clip.fTop; y < clip.fBottom; ++y) {
+            memcpy(this->getAddr(clip.fLeft, y), mask.getAddr8(clip.fLeft, y), clip.width());
+        }
+    }
+
+    virtual const SkBitmap* justAnOpaqueColor(uint32_t*) SK_OVERRIDE {
+        return NULL;
+    }
+
+private:
+    uint8_t* blockRow(int y) const {
+        return fBuffer + (y / fBandHeight) * fBlockRowBytes;
+    }
+
+    uint8_t* getAddr(int x, int y) {
+        SkASSERT(x >= 0 && x < fWidth);
+        SkASSERT(y >= 0 && y < fHeight);
+        const int top = y - y % fBandHeight;
+        if (top != fBandTop) {
+            this->moveToBand(top);
+        }
+        return fBand.get() + (y - fBandTop) * fWidth + x;
+    }
+
+    void moveToBand(int top) {
+        this->flushBand();
+        if (top < fWrittenRows) {
+            SkAssertResult(SkTextureCompressor::DecompressBufferFromFormat(
+                fBand.get(), fWidth, this->blockRow(top), fWidth, fBandHeight, fFormat));
+        } else {
+            this->fillEmptyBlockRows(top);
+            sk_bzero(fBand.get(), fWidth * fBandHeight);
+        }
+        fBandTop = top;
+    }
+
+    void flushBand() {
+        if (fBandTop < 0) {
+            return;
+        }
+        SkTextureCompressor::CompressBufferToFormat(this->blockRow(fBandTop), fBand.get(),
+                                                    kAlpha_8_SkColorType, fWidth, fBandHeight,
+                                                    fWidth, fFormat);
+        fWrittenRows = SkTMax(fWrittenRows, fBandTop + fBandHeight);
+        fBandTop = -1;
+    }
+
+    // Writes transparent blocks to every row of blocks not yet written above bottom.
+    void fillEmptyBlockRows(int bottom) {
+        for (; fWrittenRows < bottom; fWrittenRows += fBandHeight) {
+            memcpy(this->blockRow(fWrittenRows), fEmptyBlockRow.get(), fBlockRowBytes);
+        }
+    }
+
+    const int                         fWidth;
+    const int                         fHeight;
+    uint8_t* const                    fBuffer;
+    const SkTextureCompressor::Format fFormat;
+    int                               fBandHeight;
+    size_t                            fBlockRowBytes;
+
+    // The uncompressed band, fWidth x fBandHeight, and the rows it covers.
+    SkAutoTMalloc<uint8_t>            fBand;
+    int                               fBandTop;
+
+    // Every row of blocks above fWrittenRows has been written to fBuffer.
+    int                               fWrittenRows;
+    SkAutoTMalloc<uint8_t>            fEmptyBlockRow;
+
+    typedef SkBlitter INHERITED;
+};
+
+}  // namespace
+
+namespace SkTextureCompressor {
+
+SkBlitter* CreateBandBlitter(int width, int height, void* outputBuffer,
+                             SkTBlitterAllocator* allocator, Format format) {
+    if (GetCompressedDataSize(format, width, height) < 0) {
+        return NULL;
+    }
+    return allocator->createT<SkCompressedBandBlitter, int, int, void*, Format>
+        (width, height, outputBuffer, format);
+}
+
+}  // namespace SkTextureCompressor
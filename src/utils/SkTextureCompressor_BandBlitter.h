@@ -0,0 +1,19 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTextureCompressor_BandBlitter_DEFINED
+#define SkTextureCompressor_BandBlitter_DEFINED
+
+#include "SkTextureCompressor.h"
+
+namespace SkTextureCompressor {
+
+    SkBlitter* CreateBandBlitter(int width, int height, void* outputBuffer,
+                                 SkTBlitterAllocator* allocator, Format format);
+}
+
+#endif  // SkTextureCompressor_BandBlitter_DEFINED
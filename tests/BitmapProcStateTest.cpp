@@ -0,0 +1,292 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapProcState.h"
+#include "SkColorPriv.h"
+#include "SkColorTable.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkShader.h"
+#include "Test.h"
+
+class SkBitmapProcStateTester {
+public:
+    // Sets up the state for the inverse matrix, as SkBitmapProcShader does.
+    static bool ChooseProcs(SkBitmapProcState* state, const SkBitmap& bitmap,
+                            SkShader::TileMode tileX, SkShader::TileMode tileY,
+                            const SkMatrix& inverse, const SkPaint& paint) {
+        state->fTileModeX = tileX;
+        state->fTileModeY = tileY;
+        state->fOrigBitmap = bitmap;
+        return state->chooseProcs(inverse, paint);
+    }
+};
+
+static const int kMaxCount = 300;
+
+// Shades a span with the state's matrix and sample procs, as SkBitmapProcShader does when
+// there is no shader proc.
+static void shade_with_matrix_and_sample_procs(const SkBitmapProcState& state, int x, int y,
+                                               SkPMColor colors[], int count) {
+    uint32_t buffer[kMaxCount + 1];
+    const int max = state.maxCountForBufferSize(sizeof(buffer));
+    while (count > 0) {
+        const int n = SkMin32(count, max);
+        state.getMatrixProc()(state, buffer, n, x, y);
+        state.getSampleProc32()(state, buffer, n, colors);
+        x += n;
+        colors += n;
+        count -= n;
+    }
+}
+
+static void make_n32_bitmap(SkRandom* random, int width, int height, bool opaque,
+                            SkBitmap* bitmap) {
+    bitmap->allocN32Pixels(width, height, opaque);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const U8CPU a = opaque ? 0xFF : random->nextULessThan(256);
+            *bitmap->getAddr32(x, y) = SkPackARGB32(a, random->nextULessThan(a + 1),
+                                                    random->nextULessThan(a + 1),
+                                                    random->nextULessThan(a + 1));
+        }
+    }
+}
+
+static SkPMColor random_pmcolor(SkRandom* random) {
+    const U8CPU a = random->nextULessThan(256);
+    return SkPackARGB32(a, random->nextULessThan(a + 1), random->nextULessThan(a + 1),
+                        random->nextULessThan(a + 1));
+}
+
+static void make_bitmap(SkRandom* random, SkColorType colorType, int width, int height,
+                        SkBitmap* bitmap) {
+    switch (colorType) {
+        case kN32_SkColorType:
+            make_n32_bitmap(random, width, height, false, bitmap);
+            break;
+        case kRGB_565_SkColorType:
+            bitmap->allocPixels(SkImageInfo::Make(width, height, kRGB_565_SkColorType,
+                                                  kOpaque_SkAlphaType));
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    *bitmap->getAddr16(x, y) = random->nextU() & 0xFFFF;
+                }
+            }
+            break;
+        case kIndex_8_SkColorType: {
+            SkPMColor colors[256];
+            for (int i = 0; i < 256; ++i) {
+                colors[i] = random_pmcolor(random);
+            }
+            SkAutoTUnref<SkColorTable> ctable(SkNEW_ARGS(SkColorTable,
+                                                         (colors, 256, kPremul_SkAlphaType)));
+            bitmap->allocPixels(SkImageInfo::Make(width, height, kIndex_8_SkColorType,
+                                                  kPremul_SkAlphaType), NULL, ctable);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    *bitmap->getAddr8(x, y) = random->nextULessThan(256);
+                }
+            }
+            break;
+        }
+        case kARGB_4444_SkColorType:
+            bitmap->allocPixels(SkImageInfo::Make(width, height, kARGB_4444_SkColorType,
+                                                  kPremul_SkAlphaType));
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const unsigned a = random->nextULessThan(16);
+                    *bitmap->getAddr16(x, y) = SkPackARGB4444(a, random->nextULessThan(a + 1),
+                                                              random->nextULessThan(a + 1),
+                                                              random->nextULessThan(a + 1));
+                }
+            }
+            break;
+        case kAlpha_8_SkColorType:
+            bitmap->allocPixels(SkImageInfo::MakeA8(width, height));
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    *bitmap->getAddr8(x, y) = random->nextULessThan(256);
+                }
+            }
+            break;
+        default:
+            SkFAIL("unexpected color type");
+    }
+}
+
+// Compares the shader proc, if there is one, with the matrix and sample procs on spans that
+// start inside and outside the bitmap. Returns false after reporting the first mismatch.
+static bool compare_shader_proc(skiatest::Reporter* reporter, const SkBitmapProcState& state,
+                                SkRandom* random, const char* name) {
+    if (NULL == state.getShaderProc32()) {
+        return true;
+    }
+    SkPMColor expected[kMaxCount], actual[kMaxCount];
+    for (int i = 0; i < 40; ++i) {
+        const int x = random->nextRangeU(0, 120) - 40;
+        const int y = random->nextRangeU(0, 120) - 40;
+        const int count = random->nextRangeU(1, kMaxCount);
+        shade_with_matrix_and_sample_procs(state, x, y, expected, count);
+        state.getShaderProc32()(state, x, y, actual, count);
+        for (int p = 0; p < count; ++p) {
+            if (expected[p] != actual[p]) {
+                ERRORF(reporter, "%s: span (%d, %d) x %d: pixel %d is %x, expected %x",
+                       name, x, y, count, p, actual[p], expected[p]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The fused scale+translate shader procs for clamped N32 bitmaps.
+DEF_TEST(BitmapProcState_ClampScale, reporter) {
+    SkRandom random;
+    static const SkScalar gScales[] = { 0.3f, 0.6f, 0.9f, 1.7f, 3 };
+    for (int i = 0; i < 200; ++i) {
+        const bool opaque = random.nextBool();
+        SkBitmap bitmap;
+        make_n32_bitmap(&random, random.nextRangeU(1, 70), random.nextRangeU(1, 70), opaque,
+                        &bitmap);
+        SkPaint paint;
+        paint.setFilterLevel(random.nextBool() ? SkPaint::kLow_FilterLevel
+                                               : SkPaint::kNone_FilterLevel);
+        paint.setAlpha(random.nextBool() ? 0xFF : random.nextULessThan(256));
+
+        SkMatrix matrix;
+        matrix.setScale(gScales[random.nextULessThan(SK_ARRAY_COUNT(gScales))],
+                        gScales[random.nextULessThan(SK_ARRAY_COUNT(gScales))]);
+        matrix.postTranslate(random.nextRangeScalar(-20, 20), random.nextRangeScalar(-20, 20));
+        SkMatrix inverse;
+        SkAssertResult(matrix.invert(&inverse));
+
+        SkBitmapProcState state;
+        if (!SkBitmapProcStateTester::ChooseProcs(&state, bitmap, SkShader::kClamp_TileMode,
+                                                  SkShader::kClamp_TileMode, inverse, paint)) {
+            ERRORF(reporter, "could not choose the procs for a %dx%d bitmap",
+                   bitmap.width(), bitmap.height());
+            return;
+        }
+        if (!compare_shader_proc(reporter, state, &random, "clamp scale")) {
+            return;
+        }
+    }
+}
+
+// The matrix proc for a clamped scale without filtering packs two x coordinates at a time
+// until the buffer is aligned, so check it at every alignment, with spans that need clamping.
+DEF_TEST(BitmapProcState_ClampNoFilterScaleMatrixProc, reporter) {
+    SkRandom random;
+    SkBitmap bitmap;
+    make_n32_bitmap(&random, 23, 17, true, &bitmap);
+    SkMatrix matrix;
+    matrix.setScale(1.5f, 1.5f);
+    matrix.postTranslate(5.25f, -3.5f);
+    SkMatrix inverse;
+    SkAssertResult(matrix.invert(&inverse));
+    SkBitmapProcState state;
+    SkAssertResult(SkBitmapProcStateTester::ChooseProcs(&state, bitmap,
+                                                        SkShader::kClamp_TileMode,
+                                                        SkShader::kClamp_TileMode, inverse,
+                                                        SkPaint()));
+    const unsigned maxX = bitmap.width() - 1;
+
+    static const int kCount = 60;
+    uint32_t storage[kCount + 8];
+    for (int offset = 0; offset < 4; ++offset) {
+        for (int x = -12; x < 40; x += 13) {
+            uint32_t* xy = storage + offset;
+            state.getMatrixProc()(state, xy, kCount, x, 4);
+
+            SkPoint pt;
+            state.fInvProc(state.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                           SkIntToScalar(4) + SK_ScalarHalf, &pt);
+            const SkFixed fx = SkScalarToFixed(pt.fX);
+            const uint16_t* xx = reinterpret_cast<const uint16_t*>(xy + 1);
+            for (int i = 0; i < kCount; ++i) {
+                const unsigned expected = SkClampMax((fx + state.fInvSx * i) >> 16, maxX);
+                if (xx[i] != expected) {
+                    ERRORF(reporter, "offset %d, x %d: coordinate %d is %d, expected %d",
+                           offset, x, i, xx[i], expected);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// The repeat and mirror shader procs of SkBitmapProcState_shaderproc_template.h, for every
+// source config, pair of tile modes, filter level and paint alpha.
+DEF_TEST(BitmapProcState_TileShaderProcs, reporter) {
+    static const SkColorType gColorTypes[] = {
+        kN32_SkColorType,
+        kRGB_565_SkColorType,
+        kIndex_8_SkColorType,
+        kARGB_4444_SkColorType,
+        kAlpha_8_SkColorType,
+    };
+    static const SkShader::TileMode gTileModes[] = {
+        SkShader::kClamp_TileMode,
+        SkShader::kRepeat_TileMode,
+        SkShader::kMirror_TileMode,
+    };
+    static const SkScalar gScales[] = { 0.3f, 0.7f, 1.3f, 2.5f };
+
+    SkRandom random;
+    SkString name;
+    for (size_t c = 0; c < SK_ARRAY_COUNT(gColorTypes); ++c) {
+    for (size_t tx = 0; tx < SK_ARRAY_COUNT(gTileModes); ++tx) {
+    for (size_t ty = 0; ty < SK_ARRAY_COUNT(gTileModes); ++ty) {
+        if (SkShader::kClamp_TileMode == gTileModes[tx] &&
+            SkShader::kClamp_TileMode == gTileModes[ty]) {
+            continue;
+        }
+        for (int filter = 0; filter < 2; ++filter) {
+        for (int alpha = 0; alpha < 2; ++alpha) {
+            name.printf("color type %d, tile modes %d/%d, filter %d, alpha %d",
+                        gColorTypes[c], gTileModes[tx], gTileModes[ty], filter, alpha);
+            for (int i = 0; i < 4; ++i) {
+                SkBitmap bitmap;
+                make_bitmap(&random, gColorTypes[c], random.nextRangeU(2, 40),
+                            random.nextRangeU(2, 40), &bitmap);
+                SkPaint paint;
+                paint.setFilterLevel(filter ? SkPaint::kLow_FilterLevel
+                                            : SkPaint::kNone_FilterLevel);
+                paint.setColor(random_pmcolor(&random) | 0xFF000000);
+                paint.setAlpha(alpha ? random.nextULessThan(255) : 0xFF);
+
+                SkMatrix matrix;
+                matrix.setScale(gScales[random.nextULessThan(SK_ARRAY_COUNT(gScales))],
+                                gScales[random.nextULessThan(SK_ARRAY_COUNT(gScales))]);
+                matrix.postTranslate(random.nextRangeScalar(-50, 50),
+                                     random.nextRangeScalar(-50, 50));
+                SkMatrix inverse;
+                SkAssertResult(matrix.invert(&inverse));
+
+                SkBitmapProcState state;
+                if (!SkBitmapProcStateTester::ChooseProcs(&state, bitmap, gTileModes[tx],
+                                                          gTileModes[ty], inverse, paint)) {
+                    ERRORF(reporter, "%s: could not choose the procs", name.c_str());
+                    return;
+                }
+                // Filtered N32 sources are left to the SIMD filter sample procs.
+                const bool expectShaderProc = filter == 0 || kN32_SkColorType != gColorTypes[c];
+                if (expectShaderProc && NULL == state.getShaderProc32()) {
+                    ERRORF(reporter, "%s: no shader proc", name.c_str());
+                    return;
+                }
+                if (!compare_shader_proc(reporter, state, &random, name.c_str())) {
+                    return;
+                }
+            }
+        }
+        }
+    }
+    }
+    }
+}
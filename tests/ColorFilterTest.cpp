@@ -7,11 +7,14 @@
 
 #include "SkColor.h"
 #include "SkColorFilter.h"
+#include "SkColorMatrixFilter.h"
+#include "SkColorMatrix_opts.h"
 #include "SkColorPriv.h"
 #include "SkLumaColorFilter.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkRandom.h"
+#include "SkUnPreMultiply.h"
 #include "SkXfermode.h"
 #include "Test.h"
 
@@ -125,3 +128,129 @@ DEF_TEST(LumaColorFilter, reporter) {
         REPORTER_ASSERT(reporter, SkGetPackedB32(out) == 0);
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void random_pixels(SkRandom* rand, SkPMColor pixels[], int count) {
+    for (int i = 0; i < count; ++i) {
+        const U8CPU alpha = rand->nextBool() ? 0xFF : rand->nextULessThan(256);
+        pixels[i] = SkPackARGB32(alpha, rand->nextULessThan(alpha + 1),
+                                 rand->nextULessThan(alpha + 1), rand->nextULessThan(alpha + 1));
+    }
+}
+
+static bool same_spans(const SkColorFilter* a, const SkColorFilter* b, const SkPMColor src[],
+                       int count) {
+    SkAutoTMalloc<SkPMColor> resultA(count), resultB(count);
+    a->filterSpan(src, count, resultA.get());
+    b->filterSpan(src, count, resultB.get());
+    return 0 == memcmp(resultA.get(), resultB.get(), count * sizeof(SkPMColor));
+}
+
+DEF_TEST(ComposeColorFilter, reporter) {
+    SkColorMatrix brighten, gray, saturate;
+    brighten.setIdentity();
+    brighten.postTranslate(40, 40, 40);
+    gray.setSaturation(0);
+    saturate.setSaturation(2);
+    SkAutoTUnref<SkColorFilter> brightenFilter(SkColorMatrixFilter::Create(brighten));
+    SkAutoTUnref<SkColorFilter> grayFilter(SkColorMatrixFilter::Create(gray));
+    SkAutoTUnref<SkColorFilter> saturateFilter(SkColorMatrixFilter::Create(saturate));
+    SkAutoTUnref<SkColorFilter> modeFilter(
+            SkColorFilter::CreateModeFilter(0x80FF0000, SkXfermode::kSrcOver_Mode));
+
+    SkAutoTUnref<SkColorFilter> same(SkColorFilter::CreateComposeFilter(grayFilter, NULL));
+    REPORTER_ASSERT(reporter, same.get() == grayFilter.get());
+    same.reset(SkColorFilter::CreateComposeFilter(NULL, grayFilter));
+    REPORTER_ASSERT(reporter, same.get() == grayFilter.get());
+
+    // The gray matrix never leaves [0, 255], so a filter applied after it folds into one matrix.
+    SkAutoTUnref<SkColorFilter> folded(
+            SkColorFilter::CreateComposeFilter(brightenFilter, grayFilter));
+    SkColorMatrix expected, actual;
+    expected.setConcat(brighten, gray);
+    REPORTER_ASSERT(reporter, folded->asColorMatrix(actual.fMat));
+    REPORTER_ASSERT(reporter, expected == actual);
+
+    // Brightening can saturate, so the gray matrix has to see its pinned output.
+    SkAutoTUnref<SkColorFilter> unfolded(
+            SkColorFilter::CreateComposeFilter(grayFilter, brightenFilter));
+    REPORTER_ASSERT(reporter, !unfolded->asColorMatrix(NULL));
+
+    // Chains of filters that do not fold apply each filter in turn.
+    SkAutoTUnref<SkColorFilter> inner(SkColorFilter::CreateComposeFilter(saturateFilter,
+                                                                         modeFilter));
+    SkAutoTUnref<SkColorFilter> chain(SkColorFilter::CreateComposeFilter(grayFilter, inner));
+    REPORTER_ASSERT(reporter, !chain->asColorMatrix(NULL));
+
+    SkRandom rand;
+    static const int kCount = 67;
+    SkPMColor src[kCount], expectedSpan[kCount], actualSpan[kCount];
+    random_pixels(&rand, src, kCount);
+    modeFilter->filterSpan(src, kCount, expectedSpan);
+    saturateFilter->filterSpan(expectedSpan, kCount, expectedSpan);
+    grayFilter->filterSpan(expectedSpan, kCount, expectedSpan);
+    chain->filterSpan(src, kCount, actualSpan);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expectedSpan, actualSpan, sizeof(actualSpan)));
+
+    SkAutoTUnref<SkColorFilter> chain2(reincarnate_colorfilter(chain));
+    REPORTER_ASSERT(reporter, chain2);
+    REPORTER_ASSERT(reporter, chain2 && same_spans(chain, chain2, src, kCount));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The portable filtering of SkColorMatrixFilter, with the General() proc.
+static SkPMColor filter_pixel(const int32_t matrix[20], int shift, SkPMColor c) {
+    const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
+    unsigned a = SkGetPackedA32(c);
+    unsigned rgba[4] = {
+        SkUnPreMultiply::ApplyScale(table[a], SkGetPackedR32(c)),
+        SkUnPreMultiply::ApplyScale(table[a], SkGetPackedG32(c)),
+        SkUnPreMultiply::ApplyScale(table[a], SkGetPackedB32(c)),
+        a
+    };
+    int32_t result[4];
+    for (int i = 0; i < 4; ++i) {
+        const int32_t* row = &matrix[5 * i];
+        const int32_t sum = row[0] * rgba[0] + row[1] * rgba[1] + row[2] * rgba[2] +
+                            row[3] * rgba[3] + row[4];
+        result[i] = SkClampMax(sum >> shift, 255);
+    }
+    return SkPremultiplyARGBInline(result[3], result[0], result[1], result[2]);
+}
+
+DEF_TEST(ColorMatrixPlatformSpanProc, reporter) {
+    SkColorMatrixSpanProc proc = SkColorMatrixGetPlatformSpanProc();
+    if (NULL == proc) {
+        return;
+    }
+
+    SkRandom rand;
+    static const int gCounts[] = { 1, 2, 3, 4, 5, 8, 13, 40 };
+    SkPMColor src[40], dst[40];
+    for (int i = 0; i < 500; ++i) {
+        // As SkColorMatrixFilter::initState(), the entries fit in 23 bits. Most of them are
+        // small enough for the results to be inside [0, 255] now and then.
+        const int shift = rand.nextRangeU(7, 16);
+        int32_t matrix[20];
+        for (int m = 0; m < 20; ++m) {
+            int32_t range = (1 << 22) - 1;
+            if (rand.nextULessThan(4)) {
+                range = SkTMin(range, (4 == m % 5 ? 256 : 2) << shift);
+            }
+            matrix[m] = rand.nextRangeU(0, 2 * range) - range;
+        }
+        const int count = gCounts[rand.nextULessThan(SK_ARRAY_COUNT(gCounts))];
+        random_pixels(&rand, src, count);
+        proc(matrix, shift, src, count, dst);
+        for (int p = 0; p < count; ++p) {
+            const SkPMColor expected = filter_pixel(matrix, shift, src[p]);
+            if (dst[p] != expected) {
+                ERRORF(reporter, "span %d: pixel %d of %d (%x) is %x, expected %x",
+                       i, p, count, src[p], dst[p], expected);
+                return;
+            }
+        }
+    }
+}
@@ -480,6 +480,59 @@ static void TestDeferredCanvasMemoryLimit(skiatest::Reporter* reporter) {
     REPORTER_ASSERT(reporter, 1 == notificationCounter.fFlushedDrawCommandsCount);
 }
 
+// Verifies that with pipelined flushing each frame is drawn in the background, in order,
+// including frames that the memory limit forces out early.
+static void TestDeferredCanvasPipelinedFlush(skiatest::Reporter* reporter) {
+    SkAutoTUnref<SkSurface> surface(createSurface(0xFFFFFFFF));
+    SkAutoTUnref<SkDeferredCanvas> canvas(SkDeferredCanvas::Create(surface.get()));
+    canvas->setPipelinedFlushing(true);
+
+    NotificationCounter notificationCounter;
+    canvas->setNotificationClient(&notificationCounter);
+
+    const SkRect fullRect = SkRect::MakeWH(SkIntToScalar(gWidth), SkIntToScalar(gHeight));
+    const SkColor colors[] = { SK_ColorRED, SK_ColorGREEN, SK_ColorBLUE };
+    SkPaint paint;
+    for (size_t i = 0; i < SK_ARRAY_COUNT(colors); ++i) {
+        paint.setColor(colors[i]);
+        canvas->drawRect(fullRect, paint);
+        canvas->flush();
+    }
+    REPORTER_ASSERT(reporter, 3 == notificationCounter.fFlushedDrawCommandsCount);
+    canvas->waitForPipelinedFlush();
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorBLUE) == read_pixel(surface, 0, 0));
+
+    // A frame recorded after a flush isn't drawn by waiting for that flush.
+    paint.setColor(SK_ColorRED);
+    canvas->drawRect(fullRect, paint);
+    canvas->waitForPipelinedFlush();
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorBLUE) == read_pixel(surface, 0, 0));
+    canvas->flush();
+    canvas->waitForPipelinedFlush();
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorRED) == read_pixel(surface, 0, 0));
+
+    // With a save to restore, the frame can't be handed off, so it is drawn right away.
+    canvas->save();
+    paint.setColor(SK_ColorGREEN);
+    canvas->drawRect(fullRect, paint);
+    canvas->flush();
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorGREEN) == read_pixel(surface, 0, 0));
+    canvas->restore();
+
+    // Recording more than the limit hands frames off to the raster thread mid-recording.
+    canvas->setMaxRecordingStorage(160000);
+    SkBitmap sourceImage;
+    sourceImage.allocN32Pixels(100, 100);
+    for (int i = 0; i < 10; i++) {
+        sourceImage.eraseColor(0 == (i & 1) ? SK_ColorRED : SK_ColorBLUE);
+        canvas->drawBitmap(sourceImage, 0, 0, NULL);
+    }
+    REPORTER_ASSERT(reporter, notificationCounter.fFlushedDrawCommandsCount > 5);
+    canvas->flush();
+    canvas->waitForPipelinedFlush();
+    REPORTER_ASSERT(reporter, SkPreMultiplyColor(SK_ColorBLUE) == read_pixel(surface, 0, 0));
+}
+
 static void TestDeferredCanvasSilentFlush(skiatest::Reporter* reporter) {
     SkAutoTUnref<SkSurface> surface(createSurface(0));
     SkAutoTUnref<SkDeferredCanvas> canvas(SkDeferredCanvas::Create(surface.get()));
@@ -844,6 +897,7 @@ DEF_TEST(DeferredCanvas_CPU, reporter) {
     TestDeferredCanvasSilentFlush(reporter);
     TestDeferredCanvasFreshFrame(reporter);
     TestDeferredCanvasMemoryLimit(reporter);
+    TestDeferredCanvasPipelinedFlush(reporter);
     TestDeferredCanvasBitmapCaching(reporter);
     TestDeferredCanvasSkip(reporter);
     TestDeferredCanvasBitmapShaderNoLeak(reporter);
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapDevice.h"
+#include "SkBitmapSource.h"
+#include "SkColorPriv.h"
+#include "SkDeviceImageFilterProxy.h"
+#include "SkDisplacementMapEffect.h"
+#include "SkDisplacementMap_opts.h"
+#include "SkRandom.h"
+#include "SkUnPreMultiply.h"
+#include "Test.h"
+
+static const int kMaxCount = 40;
+static const int kColorWidth = kMaxCount + 26;
+static const int kColorHeight = 27;
+
+// The displacement of one pixel, as SkDisplacementMapEffect computes it.
+static SkPMColor displace_pixel(const SkDisplacementMapParams& params, SkPMColor displ,
+                                int x, int y) {
+    const SkUnPreMultiply::Scale* table = SkUnPreMultiply::GetScaleTable();
+    const SkUnPreMultiply::Scale scale = table[SkGetPackedA32(displ)];
+    int channels[2];
+    const int shifts[2] = { params.fXChannelShift, params.fYChannelShift };
+    for (int i = 0; i < 2; ++i) {
+        const U8CPU value = (displ >> shifts[i]) & 0xFF;
+        channels[i] = SK_A32_SHIFT == shifts[i] ? value
+                                                : SkUnPreMultiply::ApplyScale(scale, value);
+    }
+    const int srcX = x + SkScalarTruncToInt(SkScalarMul(params.fScaleX,
+                                                        SkIntToScalar(channels[0])) +
+                                            params.fOffsetX);
+    const int srcY = y + SkScalarTruncToInt(SkScalarMul(params.fScaleY,
+                                                        SkIntToScalar(channels[1])) +
+                                            params.fOffsetY);
+    if (srcX < 0 || srcX >= params.fColorWidth || srcY < 0 || srcY >= params.fColorHeight) {
+        return 0;
+    }
+    return params.fColor[srcY * params.fColorStride + srcX];
+}
+
+DEF_TEST(DisplacementMapPlatformRowProc, reporter) {
+    SkDisplacementMapRowProc checkedProc = SkDisplacementMapGetPlatformRowProc(true);
+    SkDisplacementMapRowProc uncheckedProc = SkDisplacementMapGetPlatformRowProc(false);
+    if (!checkedProc || !uncheckedProc) {
+        return;
+    }
+
+    SkRandom random;
+    static const int gShifts[] = { SK_A32_SHIFT, SK_R32_SHIFT, SK_G32_SHIFT, SK_B32_SHIFT };
+    static const int gCounts[] = { 1, 3, 4, 5, 8, 13, 40 };
+    SkPMColor color[kColorWidth * kColorHeight];
+    for (size_t p = 0; p < SK_ARRAY_COUNT(color); ++p) {
+        color[p] = random.nextU();
+    }
+    SkPMColor displ[kMaxCount];
+    SkPMColor actual[kMaxCount];
+    for (int i = 0; i < 1000; ++i) {
+        SkDisplacementMapParams params;
+        params.fXChannelShift = gShifts[random.nextULessThan(SK_ARRAY_COUNT(gShifts))];
+        params.fYChannelShift = gShifts[random.nextULessThan(SK_ARRAY_COUNT(gShifts))];
+        params.fScaleX = random.nextRangeScalar(-0.1f, 0.1f);
+        params.fScaleY = random.nextRangeScalar(-0.1f, 0.1f);
+        params.fOffsetX = -SkScalarHalf(params.fScaleX) * 255;
+        params.fOffsetY = -SkScalarHalf(params.fScaleY) * 255;
+        params.fColor = color;
+        params.fColorStride = kColorWidth;
+        params.fColorWidth = kColorWidth;
+        params.fColorHeight = kColorHeight;
+        const bool checkBounds = random.nextBool();
+        if (checkBounds) {
+            params.fScaleX *= 100;
+            params.fScaleY *= 100;
+            params.fOffsetX *= 100;
+            params.fOffsetY *= 100;
+        }
+        // Unchecked rows start 13 pixels from the edges of the color bitmap, further than a
+        // displacement of 0.1 * 255 / 2 can take them out of it.
+        const int count = gCounts[random.nextULessThan(SK_ARRAY_COUNT(gCounts))];
+        const int x = checkBounds ? random.nextRangeU(0, kColorWidth) - 10 : 13;
+        const int y = checkBounds ? random.nextRangeU(0, kColorHeight) - 5 : 13;
+        for (int p = 0; p < count; ++p) {
+            const U8CPU alpha = random.nextBool() ? 0xFF : random.nextULessThan(256);
+            displ[p] = SkPackARGB32(alpha, random.nextULessThan(alpha + 1),
+                                    random.nextULessThan(alpha + 1),
+                                    random.nextULessThan(alpha + 1));
+        }
+
+        (checkBounds ? checkedProc : uncheckedProc)(params, displ, x, y, actual, count);
+        for (int p = 0; p < count; ++p) {
+            const SkPMColor expected = displace_pixel(params, displ[p], x + p, y);
+            if (actual[p] != expected) {
+                ERRORF(reporter, "row %d (%s): pixel %d of %d is %x, expected %x",
+                       i, checkBounds ? "checked" : "unchecked", p, count, actual[p], expected);
+                return;
+            }
+        }
+    }
+}
+
+static U8CPU channel_value(SkDisplacementMapEffect::ChannelSelectorType selector,
+                           SkPMColor displ) {
+    const SkUnPreMultiply::Scale scale = SkUnPreMultiply::GetScaleTable()[SkGetPackedA32(displ)];
+    switch (selector) {
+        case SkDisplacementMapEffect::kR_ChannelSelectorType:
+            return SkUnPreMultiply::ApplyScale(scale, SkGetPackedR32(displ));
+        case SkDisplacementMapEffect::kG_ChannelSelectorType:
+            return SkUnPreMultiply::ApplyScale(scale, SkGetPackedG32(displ));
+        case SkDisplacementMapEffect::kB_ChannelSelectorType:
+            return SkUnPreMultiply::ApplyScale(scale, SkGetPackedB32(displ));
+        default:
+            return SkGetPackedA32(displ);
+    }
+}
+
+// The pixel of color that the pixel of displ at (x, y) displaces to (x, y), checking every one
+// against the bounds of color.
+static SkPMColor displace_checked(SkDisplacementMapEffect::ChannelSelectorType xSelector,
+                                  SkDisplacementMapEffect::ChannelSelectorType ySelector,
+                                  SkScalar scale, const SkBitmap& displ, const SkBitmap& color,
+                                  int x, int y) {
+    const SkScalar inv8bit = SkScalarDiv(SK_Scalar1, 255.0f);
+    const SkScalar scaleForColor = SkScalarMul(scale, inv8bit);
+    const SkScalar scaleAdj = SK_ScalarHalf - SkScalarMul(scale, SK_ScalarHalf);
+    const SkPMColor d = *displ.getAddr32(x, y);
+    const int srcX = x + SkScalarTruncToInt(SkScalarMul(scaleForColor,
+                                            SkIntToScalar(channel_value(xSelector, d))) +
+                                            scaleAdj);
+    const int srcY = y + SkScalarTruncToInt(SkScalarMul(scaleForColor,
+                                            SkIntToScalar(channel_value(ySelector, d))) +
+                                            scaleAdj);
+    if (srcX < 0 || srcX >= color.width() || srcY < 0 || srcY >= color.height()) {
+        return 0;
+    }
+    return *color.getAddr32(srcX, srcY);
+}
+
+// Through filterImage(), a scale of 0 (every pixel translated), a scale small enough to leave
+// an interior that skips the bounds checks, and one so large that there is no interior, with
+// and without a crop rect, displace every pixel as the fully checked loop does.
+DEF_TEST(DisplacementMapImageFilter, reporter) {
+    static const int kWidth = 96;
+    static const int kHeight = 80;
+
+    SkRandom random;
+    SkBitmap color, displ;
+    color.allocN32Pixels(kWidth, kHeight);
+    displ.allocN32Pixels(kWidth, kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            *color.getAddr32(x, y) = random.nextU() | SK_A32_MASK << SK_A32_SHIFT;
+            const U8CPU alpha = random.nextBool() ? 0xFF : random.nextULessThan(256);
+            *displ.getAddr32(x, y) = SkPackARGB32(alpha, random.nextULessThan(alpha + 1),
+                                                  random.nextULessThan(alpha + 1),
+                                                  random.nextULessThan(alpha + 1));
+        }
+    }
+    SkAutoTUnref<SkImageFilter> displSource(SkBitmapSource::Create(displ));
+
+    SkBitmap deviceBitmap;
+    deviceBitmap.allocN32Pixels(1, 1);
+    SkBitmapDevice device(deviceBitmap);
+    SkDeviceImageFilterProxy proxy(&device);
+    SkImageFilter::Context ctx(SkMatrix::I(), SkIRect::MakeWH(kWidth, kHeight), NULL);
+
+    static const SkDisplacementMapEffect::ChannelSelectorType gSelectors[][2] = {
+        { SkDisplacementMapEffect::kR_ChannelSelectorType,
+          SkDisplacementMapEffect::kG_ChannelSelectorType },
+        { SkDisplacementMapEffect::kA_ChannelSelectorType,
+          SkDisplacementMapEffect::kB_ChannelSelectorType },
+    };
+    static const SkScalar gScales[] = { 0, 20, -12.5f, 1000 };
+    const SkImageFilter::CropRect cropRect(SkRect::MakeXYWH(7, 11, 61, 50));
+    const SkImageFilter::CropRect* gCropRects[] = { NULL, &cropRect };
+
+    for (size_t s = 0; s < SK_ARRAY_COUNT(gSelectors); ++s) {
+        for (size_t k = 0; k < SK_ARRAY_COUNT(gScales); ++k) {
+            for (size_t c = 0; c < SK_ARRAY_COUNT(gCropRects); ++c) {
+                SkAutoTUnref<SkImageFilter> filter(SkDisplacementMapEffect::Create(
+                        gSelectors[s][0], gSelectors[s][1], gScales[k], displSource, NULL,
+                        gCropRects[c]));
+                SkBitmap result;
+                SkIPoint offset;
+                REPORTER_ASSERT(reporter, filter->filterImage(&proxy, color, ctx, &result,
+                                                              &offset));
+                const SkIRect bounds = gCropRects[c] ? SkIRect::MakeXYWH(7, 11, 61, 50)
+                                                     : SkIRect::MakeWH(kWidth, kHeight);
+                REPORTER_ASSERT(reporter, offset.fX == bounds.left() &&
+                                          offset.fY == bounds.top() &&
+                                          result.width() == bounds.width() &&
+                                          result.height() == bounds.height());
+                if (result.width() != bounds.width() || result.height() != bounds.height()) {
+                    continue;
+                }
+                SkAutoLockPixels alp(result);
+                for (int y = bounds.top(); y < bounds.bottom(); ++y) {
+                    for (int x = bounds.left(); x < bounds.right(); ++x) {
+                        const SkPMColor expected = displace_checked(
+                                gSelectors[s][0], gSelectors[s][1], gScales[k], displ, color,
+                                x, y);
+                        const SkPMColor actual = *result.getAddr32(x - bounds.left(),
+                                                                   y - bounds.top());
+                        if (actual != expected) {
+                            ERRORF(reporter, "selectors %d, scale %g, crop %d: pixel (%d, %d) "
+                                   "is %x, expected %x", (int)s, gScales[k], (int)c, x, y,
+                                   actual, expected);
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDistanceFieldBatch.h"
+#include "SkDistanceFieldGen.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkTArray.h"
+#include "SkTemplates.h"
+#include "Test.h"
+
+static const SkDistanceFieldMethod gMethods[] = {
+    kApproximate_SkDistanceFieldMethod,
+    kExact_SkDistanceFieldMethod,
+};
+
+static void make_glyph(SkRandom* rand, int w, int h, SkBitmap* bm) {
+    bm->allocPixels(SkImageInfo::MakeA8(w, h));
+    bm->eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas canvas(*bm);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    for (int i = 0; i < 3; ++i) {
+        canvas.drawCircle(rand->nextRangeScalar(0, SkIntToScalar(w)),
+                          rand->nextRangeScalar(0, SkIntToScalar(h)),
+                          rand->nextRangeScalar(SkIntToScalar(2), SkIntToScalar(w / 2)),
+                          paint);
+    }
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(SkIntToScalar(3));
+    canvas.drawLine(0, 0, SkIntToScalar(w), SkIntToScalar(h), paint);
+}
+
+static void generate(const SkBitmap& bm, SkDistanceFieldMethod method,
+                     SkAutoTMalloc<unsigned char>* df) {
+    df->reset(SkComputeDistanceFieldSize(bm.width(), bm.height()));
+    SkAutoLockPixels alp(bm);
+    SkGenerateDistanceFieldFromA8Image(df->get(), bm.getAddr8(0, 0), bm.width(), bm.height(),
+                                       SkToInt(bm.rowBytes()), method);
+}
+
+// Both methods find the nearest edge of a straight, vertical edge.
+DEF_TEST(DistanceField_straightEdge, reporter) {
+    static const int kW = 24;
+    static const int kH = 8;
+    SkBitmap bm;
+    bm.allocPixels(SkImageInfo::MakeA8(kW, kH));
+    for (int y = 0; y < kH; ++y) {
+        for (int x = 0; x < kW; ++x) {
+            *bm.getAddr8(x, y) = x < kW / 2 ? 0xFF : 0;
+        }
+    }
+
+    SkAutoTMalloc<unsigned char> approximate, exact;
+    generate(bm, kApproximate_SkDistanceFieldMethod, &approximate);
+    generate(bm, kExact_SkDistanceFieldMethod, &exact);
+
+    // Compare the rows away from the top and bottom, where the outside of the
+    // image adds edges of its own.
+    const int dfWidth = kW + 2 * SK_DistanceFieldPad;
+    for (int y = SK_DistanceFieldPad + 2; y < SK_DistanceFieldPad + kH - 2; ++y) {
+        const unsigned char* a = approximate.get() + y * dfWidth;
+        const unsigned char* e = exact.get() + y * dfWidth;
+        for (int x = SK_DistanceFieldPad + 2; x < SK_DistanceFieldPad + kW - 2; ++x) {
+            REPORTER_ASSERT(reporter, a[x] == e[x]);
+            // Inside is above 128, outside at or below it.
+            REPORTER_ASSERT(reporter, (e[x] > 128) == (x < dfWidth / 2));
+        }
+    }
+}
+
+// The approximate method may settle on an edge slightly farther than the
+// nearest one, but the two should agree almost everywhere.
+DEF_TEST(DistanceField_exactMatchesApproximate, reporter) {
+    SkRandom rand;
+    int total = 0;
+    int farApart = 0;
+    for (int i = 0; i < 20; ++i) {
+        SkBitmap bm;
+        make_glyph(&rand, rand.nextRangeU(8, 96), rand.nextRangeU(8, 96), &bm);
+
+        SkAutoTMalloc<unsigned char> approximate, exact;
+        generate(bm, kApproximate_SkDistanceFieldMethod, &approximate);
+        generate(bm, kExact_SkDistanceFieldMethod, &exact);
+
+        const size_t size = SkComputeDistanceFieldSize(bm.width(), bm.height());
+        for (size_t j = 0; j < size; ++j) {
+            // Same side of the edge.
+            REPORTER_ASSERT(reporter, (approximate[j] >= 128) == (exact[j] >= 128));
+            if (SkAbs32(approximate[j] - exact[j]) > 8) {
+                ++farApart;
+            }
+        }
+        total += SkToInt(size);
+    }
+    REPORTER_ASSERT(reporter, farApart * 100 < total);
+}
+
+// Generating in a batch gives the same distance fields no matter how many
+// threads are used.
+DEF_TEST(DistanceField_batch, reporter) {
+    static const int kGlyphCount = 40;
+    SkRandom rand;
+    SkTArray<SkBitmap> glyphs;
+    for (int i = 0; i < kGlyphCount; ++i) {
+        // Some glyphs large enough to get a task of their own.
+        const int size = (i % 8) ? 24 : 300;
+        make_glyph(&rand, size + rand.nextRangeU(0, 16), size, &glyphs.push_back());
+    }
+
+    // Every glyph's distance field lives at offsets[i] in one buffer.
+    SkTDArray<size_t> offsets;
+    size_t totalSize = 0;
+    for (int i = 0; i < kGlyphCount; ++i) {
+        *offsets.append() = totalSize;
+        totalSize += SkComputeDistanceFieldSize(glyphs[i].width(), glyphs[i].height());
+    }
+
+    const int gThreadCounts[] = { 0, 1, 4, SkThreadPool::kThreadPerCore };
+    for (size_t m = 0; m < SK_ARRAY_COUNT(gMethods); ++m) {
+        SkAutoTMalloc<unsigned char> expected(totalSize);
+        for (int i = 0; i < kGlyphCount; ++i) {
+            SkAutoLockPixels alp(glyphs[i]);
+            SkGenerateDistanceFieldFromA8Image(expected.get() + offsets[i],
+                                               glyphs[i].getAddr8(0, 0),
+                                               glyphs[i].width(), glyphs[i].height(),
+                                               SkToInt(glyphs[i].rowBytes()), gMethods[m]);
+        }
+
+        for (size_t t = 0; t < SK_ARRAY_COUNT(gThreadCounts); ++t) {
+            SkAutoTMalloc<unsigned char> actual(totalSize);
+            SkTDArray<SkDistanceFieldRequest> requests;
+            for (int i = 0; i < kGlyphCount; ++i) {
+                glyphs[i].lockPixels();
+                SkDistanceFieldRequest* request = requests.append();
+                request->fDistanceField = actual.get() + offsets[i];
+                request->fImage = glyphs[i].getAddr8(0, 0);
+                request->fWidth = glyphs[i].width();
+                request->fHeight = glyphs[i].height();
+                request->fRowBytes = SkToInt(glyphs[i].rowBytes());
+            }
+
+            REPORTER_ASSERT(reporter, SkDistanceFieldBatch::GenerateFromA8Images(
+                    requests.begin(), requests.count(), gMethods[m], gThreadCounts[t]));
+            REPORTER_ASSERT(reporter, 0 == memcmp(expected.get(), actual.get(), totalSize));
+
+            for (int i = 0; i < kGlyphCount; ++i) {
+                glyphs[i].unlockPixels();
+            }
+        }
+    }
+}
@@ -7,6 +7,7 @@
 
 #include "SkBitmap.h"
 #include "SkCanvas.h"
+#include "SkColorPriv.h"
 #include "SkData.h"
 #include "SkDiscardableMemoryPool.h"
 #include "SkImageGeneratorPriv.h"
@@ -249,6 +250,71 @@ static void test_giantrepeat_crbug118018(skiatest::Reporter* reporter) {
     }
 }
 
+/*
+ *  Bitmaps wider than 32767 pixels, or scales that step more than 32767 pixels
+ *  at a time, overflow the 16.16 fixed point coordinates of the matrix procs,
+ *  and are sampled with float coordinates instead. So are filtered bitmaps
+ *  wider than 16383 pixels, whose coordinates the filter matrix procs pack
+ *  into 14 bits. Draw one scaled down, and check that each pixel lands on the
+ *  right side of a color edge far past that limit, with and without
+ *  filtering, into 8888 and 565 (which only the 32 bit procs can draw).
+ */
+static void test_wide_bitmap_scale(skiatest::Reporter* reporter) {
+    static const int kScale = 1000;
+    static const struct {
+        int fWidth;
+        int fEdge;
+    } gSizes[] = {
+        { 40000, 35000 },
+        { 20000, 17000 },
+    };
+    const SkPaint::FilterLevel levels[] = {
+        SkPaint::kNone_FilterLevel, SkPaint::kLow_FilterLevel
+    };
+    const SkColorType colorTypes[] = { kN32_SkColorType, kRGB_565_SkColorType };
+
+    for (size_t s = 0; s < SK_ARRAY_COUNT(gSizes); ++s) {
+        const int width = gSizes[s].fWidth;
+        const int edge = gSizes[s].fEdge;
+        SkBitmap src;
+        src.allocN32Pixels(width, 2, true);
+        for (int y = 0; y < src.height(); ++y) {
+            for (int x = 0; x < width; ++x) {
+                *src.getAddr32(x, y) = SkPreMultiplyColor(x < edge ? SK_ColorRED
+                                                                   : SK_ColorGREEN);
+            }
+        }
+
+        for (size_t i = 0; i < SK_ARRAY_COUNT(levels); ++i) {
+            for (size_t c = 0; c < SK_ARRAY_COUNT(colorTypes); ++c) {
+                SkBitmap dst;
+                dst.allocPixels(SkImageInfo::Make(width / kScale, 2, colorTypes[c],
+                                                  kOpaque_SkAlphaType));
+                dst.eraseColor(SK_ColorBLACK);
+                SkCanvas canvas(dst);
+                canvas.scale(SK_Scalar1 / kScale, SK_Scalar1);
+
+                SkPaint paint;
+                paint.setFilterLevel(levels[i]);
+                canvas.drawBitmap(src, 0, 0, &paint);
+
+                // Each pixel samples the middle of kScale pixels, so none of them
+                // blend across the edge.
+                for (int x = 0; x < dst.width(); ++x) {
+                    const SkPMColor expected = SkPreMultiplyColor(
+                            x < edge / kScale ? SK_ColorRED : SK_ColorGREEN);
+                    if (kRGB_565_SkColorType == colorTypes[c]) {
+                        REPORTER_ASSERT(reporter,
+                                        *dst.getAddr16(x, 1) == SkPixel32ToPixel16(expected));
+                    } else {
+                        REPORTER_ASSERT(reporter, *dst.getAddr32(x, 1) == expected);
+                    }
+                }
+            }
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static void test_nan_antihair() {
@@ -313,6 +379,7 @@ DEF_TEST(DrawBitmapRect, reporter) {
 
     test_nan_antihair();
     test_giantrepeat_crbug118018(reporter);
+    test_wide_bitmap_scale(reporter);
 
     test_treatAsSprite(reporter);
     test_faulty_pixelref(reporter);
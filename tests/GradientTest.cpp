@@ -6,8 +6,11 @@
  */
 
 #include "SkCanvas.h"
+#include "SkColorPriv.h"
 #include "SkColorShader.h"
 #include "SkGradientShader.h"
+#include "SkGradient_opts.h"
+#include "SkScaledImageCache.h"
 #include "SkShader.h"
 #include "SkTemplates.h"
 #include "Test.h"
@@ -193,3 +196,549 @@ DEF_TEST(Gradient, reporter) {
     TestGradientShaders(reporter);
     TestConstantGradient(reporter);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// The platform span procs look up the same colors as the portable shadeSpan loops, which add
+// each step once per pixel. Some of the steps here are not exact in float, so positions that
+// are stepped any other way round differently.
+
+static const SkShader::TileMode gSpanTileModes[] = {
+    SkShader::kClamp_TileMode, SkShader::kRepeat_TileMode, SkShader::kMirror_TileMode
+};
+
+static const int gSpanCounts[] = { 1, 2, 3, 4, 5, 7, 8, 13, 100 };
+
+static SkFixed tile_fixed(SkShader::TileMode tileMode, SkFixed x) {
+    switch (tileMode) {
+        case SkShader::kClamp_TileMode:
+            return SkClampMax(x, 0xFFFF);
+        case SkShader::kRepeat_TileMode:
+            return x & 0xFFFF;
+        default:
+            return (x ^ (x << 15 >> 31)) & 0xFFFF;
+    }
+}
+
+// Each entry of the cache is its own index, so the colors show which entry was read.
+static void init_span_cache(SkPMColor cache[512]) {
+    for (int i = 0; i < 512; ++i) {
+        cache[i] = i;
+    }
+}
+
+static void check_span(skiatest::Reporter* reporter, const SkPMColor actual[],
+                       const SkPMColor expected[], int count, const char* name,
+                       SkShader::TileMode tileMode) {
+    for (int i = 0; i < count; ++i) {
+        if (actual[i] != expected[i]) {
+            ERRORF(reporter, "%s, tile mode %d: pixel %d of %d is %x, expected %x",
+                   name, tileMode, i, count, actual[i], expected[i]);
+            return;
+        }
+    }
+}
+
+static void test_linear_span(skiatest::Reporter* reporter, SkShader::TileMode tileMode,
+                             SkFixed fx, SkFixed dx, const SkPMColor* cache0,
+                             const SkPMColor* cache1, int count) {
+    SkLinearGradientSpanProc proc = SkLinearGradientGetPlatformSpanProc(tileMode);
+    if (NULL == proc) {
+        return;
+    }
+    SkPMColor expected[100], actual[100];
+    proc(fx, dx, actual, cache0, cache1, count);
+    for (int i = 0; i < count; ++i) {
+        // Wraps around like SkFixed arithmetic in the portable loops.
+        const SkFixed x = (SkFixed)((uint32_t)fx + (uint32_t)i * (uint32_t)dx);
+        expected[i] = ((i & 1) ? cache1 : cache0)[tile_fixed(tileMode, x) >> 8];
+    }
+    check_span(reporter, actual, expected, count, "linear", tileMode);
+}
+
+static void test_radial_span(skiatest::Reporter* reporter, SkShader::TileMode tileMode,
+                             float fx, float dx, float fy, float dy,
+                             const SkPMColor* cache0, const SkPMColor* cache1, int count) {
+    SkRadialGradientSpanProc proc = SkRadialGradientGetPlatformSpanProc(tileMode);
+    if (NULL == proc) {
+        return;
+    }
+    SkPMColor expected[100], actual[100];
+    proc(fx, dx, fy, dy, actual, cache0, cache1, count);
+    for (int i = 0; i < count; ++i) {
+        const SkFixed dist = SkFloatToFixed(sk_float_sqrt(fx*fx + fy*fy));
+        expected[i] = ((i & 1) ? cache1 : cache0)[tile_fixed(tileMode, dist) >> 8];
+        fx += dx;
+        fy += dy;
+    }
+    check_span(reporter, actual, expected, count, "radial", tileMode);
+}
+
+// TwoPtRadialContext::nextT() with find_quad_roots().
+static SkFixed two_point_conical_t(const SkTwoPointConicalSpan& span) {
+    float roots[2];
+    int rootCount = 0;
+    const float c = span.fRelX * span.fRelX + span.fRelY * span.fRelY - span.fRadius2;
+    if (0 == span.fA) {
+        if (span.fB != 0) {
+            roots[0] = -c / span.fB;
+            rootCount = 1;
+        }
+    } else {
+        float r = span.fB * span.fB - 4 * span.fA * c;
+        if (r >= 0) {
+            r = sk_float_sqrt(r);
+            float q = span.fB < 0 ? span.fB - r : span.fB + r;
+            q *= -0.5f;
+            if (0 == q) {
+                roots[0] = 0;
+                rootCount = 1;
+            } else {
+                const float r0 = q / span.fA;
+                const float r1 = c / q;
+                roots[0] = r0 < r1 ? r0 : r1;
+                roots[1] = r0 > r1 ? r0 : r1;
+                if (span.fFlipped) {
+                    SkTSwap(roots[0], roots[1]);
+                }
+                rootCount = 2;
+            }
+        }
+    }
+    if (0 == rootCount) {
+        return SK_FixedNaN;
+    }
+    float t = roots[rootCount - 1];
+    if (span.fRadius + t * span.fDRadius <= 0) {
+        t = roots[0];
+        if (span.fRadius + t * span.fDRadius <= 0) {
+            return SK_FixedNaN;
+        }
+    }
+    return SkFloatToFixed(t);
+}
+
+static void test_two_point_conical_span(skiatest::Reporter* reporter,
+                                        SkShader::TileMode tileMode,
+                                        SkTwoPointConicalSpan span, const SkPMColor* cache0,
+                                        const SkPMColor* cache1, int count) {
+    SkTwoPointConicalSpanProc proc = SkTwoPointConicalGetPlatformSpanProc(tileMode);
+    if (NULL == proc) {
+        return;
+    }
+    SkPMColor expected[100], actual[100];
+    proc(span, actual, cache0, cache1, count);
+    for (int i = 0; i < count; ++i) {
+        const SkFixed t = two_point_conical_t(span);
+        expected[i] = SK_FixedNaN == t ? 0
+                    : ((i & 1) ? cache1 : cache0)[tile_fixed(tileMode, t) >> 8];
+        span.fRelX += span.fIncX;
+        span.fRelY += span.fIncY;
+        span.fB += span.fDB;
+    }
+    check_span(reporter, actual, expected, count, "two point conical", tileMode);
+}
+
+// Start and end circles of a two point conical gradient, all exact in float, stepped by incX
+// and incY per pixel.
+static SkTwoPointConicalSpan make_two_point_conical_span(float dCenterX, float dCenterY,
+                                                         float radius0, float radius1,
+                                                         bool flipped, float incX = 1.0f / 32,
+                                                         float incY = 1.0f / 64) {
+    SkTwoPointConicalSpan span;
+    span.fRelX = -1.5f;
+    span.fRelY = -0.75f;
+    span.fIncX = incX;
+    span.fIncY = incY;
+    span.fRadius = radius0;
+    span.fDRadius = radius1 - radius0;
+    span.fRadius2 = radius0 * radius0;
+    span.fA = dCenterX * dCenterX + dCenterY * dCenterY - span.fDRadius * span.fDRadius;
+    span.fB = -2 * (dCenterX * span.fRelX + dCenterY * span.fRelY + radius0 * span.fDRadius);
+    span.fDB = -2 * (dCenterX * span.fIncX + dCenterY * span.fIncY);
+    span.fFlipped = flipped;
+    return span;
+}
+
+DEF_TEST(GradientPlatformSpanProcs, reporter) {
+    SkPMColor cache[512];
+    init_span_cache(cache);
+
+    const SkTwoPointConicalSpan conicalSpans[] = {
+        make_two_point_conical_span(0.5f, 0.25f, 0.25f, 1, false),
+        make_two_point_conical_span(0.5f, 0.25f, 0.25f, 1, true),
+        // fA == 0
+        make_two_point_conical_span(0.75f, 1, 0.25f, 1.5f, false),
+        // The start circle is not inside the end circle.
+        make_two_point_conical_span(1, 0.5f, 0.25f, 0.5f, false),
+        // Steps that are not exact in float.
+        make_two_point_conical_span(0.75f, 1, 0.25f, 1.5f, true, 3.17f, -1.23f),
+        make_two_point_conical_span(0.5f, 0.25f, 0.25f, 1, false, 31.7f, 12.3f),
+    };
+
+    for (size_t m = 0; m < SK_ARRAY_COUNT(gSpanTileModes); ++m) {
+        const SkShader::TileMode tileMode = gSpanTileModes[m];
+        for (size_t c = 0; c < SK_ARRAY_COUNT(gSpanCounts); ++c) {
+            const int count = gSpanCounts[c];
+            for (int dither = 0; dither < 2; ++dither) {
+                const SkPMColor* cache0 = dither ? cache + 256 : cache;
+                const SkPMColor* cache1 = dither ? cache : cache + 256;
+
+                test_linear_span(reporter, tileMode, -SK_Fixed1 / 3, 1234, cache0, cache1,
+                                 count);
+                test_linear_span(reporter, tileMode, 5 * SK_Fixed1, -9876, cache0, cache1,
+                                 count);
+                test_linear_span(reporter, tileMode, SK_MaxS32 - 1000, 300, cache0, cache1,
+                                 count);
+
+                test_radial_span(reporter, tileMode, -1.5f, 1.0f / 32, 0.25f, 0,
+                                 cache0, cache1, count);
+                test_radial_span(reporter, tileMode, -2, 1.0f / 16, -1, 1.0f / 64,
+                                 cache0, cache1, count);
+                test_radial_span(reporter, tileMode, 3000.3f, -0.317f, -2000.7f, 0.123f,
+                                 cache0, cache1, count);
+
+                for (size_t i = 0; i < SK_ARRAY_COUNT(conicalSpans); ++i) {
+                    test_two_point_conical_span(reporter, tileMode, conicalSpans[i],
+                                                cache0, cache1, count);
+                }
+            }
+        }
+    }
+}
+
+// The stops' colors are exact in float, and their slopes made from them as SkGradientShaderBase
+// does.
+static void init_stops(SkGradientStop stops[], const float pos[], int count) {
+    for (int i = 0; i < count; ++i) {
+        for (int k = 0; k < 4; ++k) {
+            stops[i].fColor[k] = (float)((i * 71 + k * 53) % 256);
+        }
+        stops[i].fPos = pos[i];
+    }
+    for (int i = 0; i < count; ++i) {
+        const float width = i < count - 1 ? stops[i + 1].fPos - stops[i].fPos : 0;
+        for (int k = 0; k < 4; ++k) {
+            stops[i].fSlope[k] = width > 0 ? (stops[i + 1].fColor[k] - stops[i].fColor[k]) / width
+                                           : 0;
+        }
+    }
+}
+
+static SkPMColor interpolate_color(const SkGradientStop stops[], int stopCount, bool premultiply,
+                                   float t, float bias) {
+    if (SkScalarIsNaN(t)) {
+        return 0;
+    }
+    int i = 0;
+    while (i < stopCount - 2 && t >= stops[i + 1].fPos) {
+        ++i;
+    }
+    int c[4];
+    for (int k = 0; k < 4; ++k) {
+        c[k] = SkPin32((int)(stops[i].fColor[k] + (t - stops[i].fPos) * stops[i].fSlope[k] +
+                             bias), 0, 255);
+    }
+    const int kA = SK_A32_SHIFT / 8;
+    for (int k = 0; premultiply && k < 4; ++k) {
+        if (k != kA) {
+            c[k] = SkMulDiv255Round(c[k], c[kA]);
+        }
+    }
+    return c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+}
+
+DEF_TEST(GradientPlatformInterpolateProc, reporter) {
+    SkGradientInterpolateProc proc = SkGradientGetPlatformInterpolateProc();
+    if (NULL == proc) {
+        return;
+    }
+
+    // Evenly spaced, uneven, and with a hard stop.
+    static const float gPos0[] = { 0, 1 };
+    static const float gPos1[] = { 0, 0.25f, 1 };
+    static const float gPos2[] = { 0, 0.125f, 0.5f, 0.5f, 1 };
+    static const struct {
+        const float*    fPos;
+        int             fCount;
+    } gStops[] = {
+        { gPos0, SK_ARRAY_COUNT(gPos0) },
+        { gPos1, SK_ARRAY_COUNT(gPos1) },
+        { gPos2, SK_ARRAY_COUNT(gPos2) },
+    };
+    static const float gDither[][2] = { { 1/8.f, 5/8.f }, { 7/8.f, 3/8.f } };
+
+    // Runs up and down, jumps, hits every stop, and skips undrawn pixels.
+    float t[100];
+    for (int i = 0; i < 100; ++i) {
+        t[i] = (float)((i * 37) % 101) / 100;
+    }
+    t[3] = 0;
+    t[4] = 1;
+    t[5] = 0.5f;
+    t[6] = SK_FloatNaN;
+    t[10] = 0.125f;
+    t[11] = SK_FloatNaN;
+
+    for (size_t s = 0; s < SK_ARRAY_COUNT(gStops); ++s) {
+        SkGradientStop stops[5];
+        init_stops(stops, gStops[s].fPos, gStops[s].fCount);
+        for (int premultiply = 0; premultiply < 2; ++premultiply) {
+            for (size_t d = 0; d < SK_ARRAY_COUNT(gDither); ++d) {
+                for (size_t c = 0; c < SK_ARRAY_COUNT(gSpanCounts); ++c) {
+                    const int count = gSpanCounts[c];
+                    SkPMColor expected[100], actual[100];
+                    proc(stops, gStops[s].fCount, SkToBool(premultiply), t, gDither[d],
+                         actual, count);
+                    for (int i = 0; i < count; ++i) {
+                        expected[i] = interpolate_color(stops, gStops[s].fCount,
+                                                        SkToBool(premultiply), t[i],
+                                                        gDither[d][i & 1]);
+                    }
+                    check_span(reporter, actual, expected, count, "interpolate",
+                               SkShader::kClamp_TileMode);
+                }
+            }
+        }
+    }
+}
+
+static void draw_gradient(SkBitmap* bitmap, int width, SkShader* shader, U8CPU alpha) {
+    bitmap->allocN32Pixels(width, 8);
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(alpha);
+    canvas.drawPaint(paint);
+}
+
+static int max_channel_diff(SkPMColor a, SkPMColor b) {
+    int diff = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        diff = SkMax32(diff, SkAbs32((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)));
+    }
+    return diff;
+}
+
+static double tile_double(SkShader::TileMode tileMode, double t) {
+    switch (tileMode) {
+        case SkShader::kClamp_TileMode:
+            return SkTMax(0.0, SkTMin(t, 1.0));
+        case SkShader::kRepeat_TileMode:
+            return t - floor(t);
+        default: {
+            const double m = t - 2 * floor(t / 2);
+            return m > 1 ? 2 - m : m;
+        }
+    }
+}
+
+// The color of a gradient at the tiled t, in double.
+static SkPMColor gradient_color(const SkColor colors[], const SkScalar pos[], int count,
+                                bool interpInPremul, U8CPU alpha, double t) {
+    int i = 0;
+    while (i < count - 2 && t >= pos[i + 1]) {
+        ++i;
+    }
+    const double frac = (t - pos[i]) / (pos[i + 1] - pos[i]);
+    double c[4];
+    for (int k = 0; k < 4; ++k) {
+        const int shift = 24 - 8 * k;   // a, r, g, b
+        double c0 = (colors[i] >> shift) & 0xFF;
+        double c1 = (colors[i + 1] >> shift) & 0xFF;
+        if (k > 0 && interpInPremul) {
+            c0 *= SkColorGetA(colors[i]) / 255.0;
+            c1 *= SkColorGetA(colors[i + 1]) / 255.0;
+        }
+        c[k] = c0 + frac * (c1 - c0);
+    }
+    c[0] *= alpha / 255.0;
+    for (int k = 1; k < 4; ++k) {
+        c[k] *= interpInPremul ? alpha / 255.0 : c[0] / 255.0;
+    }
+    return SkPackARGB32((int)(c[0] + 0.5), (int)(c[1] + 0.5), (int)(c[2] + 0.5),
+                        (int)(c[3] + 0.5));
+}
+
+static const U8CPU gInterpolateAlphas[] = { 0xFF, 0x80 };
+
+// kInterpolateColorsPerPixel_Flag draws each pixel's exact color, give or take dithering.
+DEF_TEST(GradientInterpolatePerPixel, reporter) {
+    static const SkColor gColors[] = { 0xFF0000FF, 0x8000FF00, SK_ColorTRANSPARENT, 0xFFFF8040 };
+    static const SkScalar gPos[] = { 0, 0.25f, 0.625f, 1 };
+    const SkPoint pts[2] = { { 64, 0 }, { 320, 0 } };
+
+    for (size_t m = 0; m < SK_ARRAY_COUNT(gSpanTileModes); ++m) {
+        for (int premul = 0; premul < 2; ++premul) {
+            const uint32_t flags = SkGradientShader::kInterpolateColorsPerPixel_Flag |
+                    (premul ? SkGradientShader::kInterpolateColorsInPremul_Flag : 0);
+            SkAutoTUnref<SkShader> shader(SkGradientShader::CreateLinear(
+                    pts, gColors, gPos, SK_ARRAY_COUNT(gColors), gSpanTileModes[m], flags, NULL));
+            for (size_t a = 0; a < SK_ARRAY_COUNT(gInterpolateAlphas); ++a) {
+                SkBitmap bitmap;
+                draw_gradient(&bitmap, 640, shader, gInterpolateAlphas[a]);
+                for (int x = 0; x < bitmap.width(); ++x) {
+                    const double t = tile_double(gSpanTileModes[m], (x + 0.5 - 64) / 256);
+                    const SkPMColor expected = gradient_color(gColors, gPos,
+                                                              SK_ARRAY_COUNT(gColors),
+                                                              SkToBool(premul),
+                                                              gInterpolateAlphas[a], t);
+                    const SkPMColor actual = *bitmap.getAddr32(x, 1);
+                    // One for dithering, and one more for premultiplying a dithered alpha.
+                    if (max_channel_diff(expected, actual) > 2) {
+                        ERRORF(reporter, "tile mode %d, premul %d, alpha %x: pixel %d is %x, "
+                               "expected %x", gSpanTileModes[m], premul,
+                               gInterpolateAlphas[a], x, actual, expected);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static SkShader* make_interpolated_gradient(int type, SkShader::TileMode tileMode,
+                                            uint32_t flags) {
+    // Gentle enough that the cache is within a step of each color.
+    static const SkColor gColors[] = { 0xFF204060, 0x80608040, 0xFF406080 };
+    const SkPoint pts[2] = { { 8, 4 }, { 56, 6 } };
+    switch (type) {
+        case 0:
+            return SkGradientShader::CreateLinear(pts, gColors, NULL, SK_ARRAY_COUNT(gColors),
+                                                  tileMode, flags, NULL);
+        case 1:
+            return SkGradientShader::CreateRadial(pts[0], 40, gColors, NULL,
+                                                  SK_ARRAY_COUNT(gColors), tileMode, flags,
+                                                  NULL);
+        default:
+            return SkGradientShader::CreateTwoPointConical(pts[0], 4, pts[1], 24, gColors, NULL,
+                                                           SK_ARRAY_COUNT(gColors), tileMode,
+                                                           flags, NULL);
+    }
+}
+
+// Radial and two point conical gradients map their pixels like the cached versions do. A
+// clamped radial gradient looks up its distances in an 8-bit sqrt table when cached, which is
+// coarser than a step of the cache, so it is left out.
+DEF_TEST(GradientInterpolatePerPixelMatchesCache, reporter) {
+    for (int type = 0; type < 3; ++type) {
+        for (size_t m = 0; m < SK_ARRAY_COUNT(gSpanTileModes); ++m) {
+            if (1 == type && SkShader::kClamp_TileMode == gSpanTileModes[m]) {
+                continue;
+            }
+            SkAutoTUnref<SkShader> cached(make_interpolated_gradient(type, gSpanTileModes[m], 0));
+            SkAutoTUnref<SkShader> perPixel(make_interpolated_gradient(
+                    type, gSpanTileModes[m], SkGradientShader::kInterpolateColorsPerPixel_Flag));
+            for (size_t a = 0; a < SK_ARRAY_COUNT(gInterpolateAlphas); ++a) {
+                SkBitmap expected, actual;
+                draw_gradient(&expected, 64, cached, gInterpolateAlphas[a]);
+                draw_gradient(&actual, 64, perPixel, gInterpolateAlphas[a]);
+                for (int y = 0; y < 8; ++y) {
+                    for (int x = 0; x < 64; ++x) {
+                        if (max_channel_diff(*expected.getAddr32(x, y),
+                                             *actual.getAddr32(x, y)) > 2) {
+                            ERRORF(reporter, "type %d, tile mode %d, alpha %x: pixel (%d, %d) "
+                                   "is %x, expected %x", type, gSpanTileModes[m],
+                                   gInterpolateAlphas[a], x, y, *actual.getAddr32(x, y),
+                                   *expected.getAddr32(x, y));
+                            return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// A steep segment of a large gradient steps through the cache's few entries for it, but not
+// when interpolated per pixel.
+DEF_TEST(GradientInterpolatePerPixelBanding, reporter) {
+    static const SkColor gColors[] = { SK_ColorBLACK, SK_ColorRED, SK_ColorRED };
+    static const SkScalar gPos[] = { 0, 0.0625f, 1 };
+    const SkPoint pts[2] = { { 0, 0 }, { 1024, 0 } };
+    SkAutoTUnref<SkShader> shader(SkGradientShader::CreateLinear(
+            pts, gColors, gPos, SK_ARRAY_COUNT(gColors), SkShader::kClamp_TileMode,
+            SkGradientShader::kInterpolateColorsPerPixel_Flag, NULL));
+
+    SkBitmap bitmap;
+    draw_gradient(&bitmap, 1024, shader, 0xFF);
+    // Red rises by 255 / 64 per pixel over the first 64 pixels.
+    for (int x = 1; x < 1024; ++x) {
+        const int step = SkGetPackedR32(*bitmap.getAddr32(x, 0)) -
+                         SkGetPackedR32(*bitmap.getAddr32(x - 1, 0));
+        if (step < 0 || step > 5) {
+            ERRORF(reporter, "red steps by %d at pixel %d", step, x);
+            return;
+        }
+    }
+}
+
+static SkShader* make_shared_table_gradient(SkScalar midPos, uint32_t flags, SkAlpha midAlpha) {
+    const SkColor colors[] = { 0xFF102030, SkColorSetA(0x00A0B0C0, midAlpha), 0xFF405060 };
+    const SkScalar pos[] = { 0, midPos, SK_Scalar1 };
+    const SkPoint pts[2] = { { 0, 0 }, { 64, 0 } };
+    return SkGradientShader::CreateLinear(pts, colors, pos, SK_ARRAY_COUNT(colors),
+                                          SkShader::kClamp_TileMode, flags, NULL);
+}
+
+static void draw_shared_table_gradient(SkBitmap* bitmap, SkColorType colorType,
+                                       SkShader* shader, U8CPU alpha) {
+    bitmap->allocPixels(SkImageInfo::Make(64, 4, colorType, kPremul_SkAlphaType));
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(alpha);
+    canvas.drawPaint(paint);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+// Gradients with the same colors, positions, flags and alpha share their color tables through
+// SkScaledImageCache, and gradients that differ in any of them do not.
+DEF_TEST(GradientSharedTables, reporter) {
+    const uint32_t kPremul = SkGradientShader::kInterpolateColorsInPremul_Flag;
+    const struct {
+        SkColorType fColorType;
+        SkScalar    fMidPos;
+        uint32_t    fFlags;
+        SkAlpha     fMidAlpha;
+        U8CPU       fAlpha;
+    } gRecs[] = {
+        { kN32_SkColorType,     0.5f,  0,       0x80, 0xFF },
+        { kN32_SkColorType,     0.25f, 0,       0x80, 0xFF },
+        { kN32_SkColorType,     0.5f,  kPremul, 0x80, 0xFF },
+        { kN32_SkColorType,     0.5f,  0,       0x80, 0x80 },
+        { kN32_SkColorType,     0.5f,  0,       0x40, 0xFF },
+        // Opaque, so drawn with the 16bit table.
+        { kRGB_565_SkColorType, 0.5f,  0,       0xFF, 0xFF },
+        { kRGB_565_SkColorType, 0.25f, 0,       0xFF, 0xFF },
+    };
+
+    SkBitmap expected[SK_ARRAY_COUNT(gRecs)];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gRecs); ++i) {
+        SkAutoTUnref<SkShader> shader(make_shared_table_gradient(
+                gRecs[i].fMidPos, gRecs[i].fFlags, gRecs[i].fMidAlpha));
+        draw_shared_table_gradient(&expected[i], gRecs[i].fColorType, shader, gRecs[i].fAlpha);
+        for (size_t j = 0; j < i; ++j) {
+            if (same_pixels(expected[i], expected[j])) {
+                ERRORF(reporter, "gradients %d and %d drew the same pixels", (int)i, (int)j);
+            }
+        }
+    }
+
+    // New shaders find the tables built for the first ones, in any order.
+    for (int i = SK_ARRAY_COUNT(gRecs) - 1; i >= 0; --i) {
+        SkAutoTUnref<SkShader> shader(make_shared_table_gradient(
+                gRecs[i].fMidPos, gRecs[i].fFlags, gRecs[i].fMidAlpha));
+        SkBitmap actual;
+        const size_t bytesUsed = SkScaledImageCache::GetTotalBytesUsed();
+        draw_shared_table_gradient(&actual, gRecs[i].fColorType, shader, gRecs[i].fAlpha);
+        REPORTER_ASSERT(reporter, bytesUsed == SkScaledImageCache::GetTotalBytesUsed());
+        REPORTER_ASSERT(reporter, same_pixels(expected[i], actual));
+    }
+}
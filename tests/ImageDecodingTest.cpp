@@ -20,6 +20,7 @@
 #include "SkImageGeneratorPriv.h"
 #include "SkImagePriv.h"
 #include "SkOSFile.h"
+#include "SkParallelImageDecoder.h"
 #include "SkPoint.h"
 #include "SkShader.h"
 #include "SkStream.h"
@@ -385,6 +386,57 @@ static void test_stream_life() {
     }
 }
 
+// For every format that supports tile based decoding, ensure that decoding in
+// bands with SkParallelImageDecoder gives the same pixels no matter how many
+// threads are used, and the same pixels as decoding the full rect as a subset.
+static void test_parallel_decode(skiatest::Reporter* reporter) {
+    const SkImageEncoder::Type gTypes[] = {
+#ifdef SK_BUILD_FOR_ANDROID
+        SkImageEncoder::kJPEG_Type,
+        SkImageEncoder::kPNG_Type,
+#endif
+        SkImageEncoder::kWEBP_Type,
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gTypes); ++i) {
+        SkAutoTUnref<SkMemoryStream> stream(create_image_stream(gTypes[i]));
+        if (NULL == stream.get()) {
+            continue;
+        }
+        SkAutoTDelete<SkImageDecoder> decoder(SkImageDecoder::Factory(stream));
+        int width, height;
+        if (NULL == decoder.get() || !decoder->buildTileIndex(stream.get(), &width, &height)) {
+            continue;
+        }
+        // Formats without a tile decoder are skipped above, so decoding the subset must work.
+        SkBitmap expected;
+        if (!decoder->decodeSubset(&expected, SkIRect::MakeWH(width, height),
+                                   kN32_SkColorType)) {
+            ERRORF(reporter, "could not decode the subset of type %d", gTypes[i]);
+            continue;
+        }
+
+        SkAutoTUnref<SkData> data(stream->copyToData());
+        const int gThreadCounts[] = { 0, 1, 4, SkParallelImageDecoder::kThreadPerCore };
+        for (size_t j = 0; j < SK_ARRAY_COUNT(gThreadCounts); ++j) {
+            SkBitmap bm;
+            bool success = SkParallelImageDecoder::Decode(data, &bm, kN32_SkColorType,
+                                                          gThreadCounts[j]);
+            REPORTER_ASSERT(reporter, success);
+            if (!success) {
+                continue;
+            }
+            REPORTER_ASSERT(reporter, bm.width() == width && bm.height() == height);
+            SkAutoLockPixels alpExpected(expected);
+            SkAutoLockPixels alpBm(bm);
+            for (int y = 0; y < height; ++y) {
+                REPORTER_ASSERT(reporter, 0 == memcmp(expected.getAddr32(0, y),
+                                                      bm.getAddr32(0, y),
+                                                      width * sizeof(SkPMColor)));
+            }
+        }
+    }
+}
+
 // Test inside SkScaledBitmapSampler.cpp
 extern void test_row_proc_choice();
 
@@ -394,6 +446,7 @@ DEF_TEST(ImageDecoding, reporter) {
     test_unpremul(reporter);
 #ifdef SK_DEBUG
     test_stream_life();
+    test_parallel_decode(reporter);
     test_row_proc_choice();
 #endif
 }
@@ -12,6 +12,7 @@
 #include "SkCanvas.h"
 #include "SkColorFilterImageFilter.h"
 #include "SkColorMatrixFilter.h"
+#include "SkColorPriv.h"
 #include "SkDeviceImageFilterProxy.h"
 #include "SkDisplacementMapEffect.h"
 #include "SkDropShadowImageFilter.h"
@@ -26,6 +27,7 @@
 #include "SkPicture.h"
 #include "SkPictureImageFilter.h"
 #include "SkPictureRecorder.h"
+#include "SkRandom.h"
 #include "SkReadBuffer.h"
 #include "SkRect.h"
 #include "SkTileImageFilter.h"
@@ -663,6 +665,162 @@ DEF_TEST(ImageFilterClippedPictureImageFilter, reporter) {
     REPORTER_ASSERT(reporter, !imageFilter->filterImage(&proxy, bitmap, ctx, &result, &offset));
 }
 
+DEF_TEST(ImageFilterColorFilterChain, reporter) {
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(10, 10);
+    SkRandom random;
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            const U8CPU alpha = random.nextULessThan(256);
+            *bitmap.getAddr32(x, y) = SkPackARGB32(alpha, random.nextULessThan(alpha + 1),
+                                                   random.nextULessThan(alpha + 1),
+                                                   random.nextULessThan(alpha + 1));
+        }
+    }
+    SkBitmap deviceBitmap;
+    deviceBitmap.allocN32Pixels(10, 10);
+    SkBitmapDevice device(deviceBitmap);
+    SkDeviceImageFilterProxy proxy(&device);
+    SkImageFilter::Context ctx(SkMatrix::I(), SkIRect::MakeLargest(), NULL);
+
+    {
+        // Check that a chain of color filters which cannot be folded together gives the same
+        // pixels as applying them one after the other.
+        SkAutoTUnref<SkColorFilter> mode(SkColorFilter::CreateModeFilter(
+                0x80000080, SkXfermode::kSrcOver_Mode));
+        SkAutoTUnref<SkImageFilter> scale(make_scale(2.0f));
+        SkAutoTUnref<SkImageFilter> modeFilter(SkColorFilterImageFilter::Create(mode, scale));
+        SkAutoTUnref<SkImageFilter> grayscale(make_grayscale(modeFilter));
+        SkColorFilter* grayscaleCF;
+        SkColorFilter* scaleCF;
+        REPORTER_ASSERT(reporter, grayscale->asColorFilter(&grayscaleCF));
+        SkAutoUnref grayscaleUnref(grayscaleCF);
+        REPORTER_ASSERT(reporter, scale->asColorFilter(&scaleCF));
+        SkAutoUnref scaleUnref(scaleCF);
+
+        SkBitmap result;
+        SkIPoint offset;
+        REPORTER_ASSERT(reporter, grayscale->filterImage(&proxy, bitmap, ctx, &result, &offset));
+        REPORTER_ASSERT(reporter, 0 == offset.fX && 0 == offset.fY);
+        REPORTER_ASSERT(reporter, result.width() == 10 && result.height() == 10);
+        SkAutoLockPixels lock(result);
+        for (int y = 0; y < 10; ++y) {
+            SkPMColor expected[10];
+            scaleCF->filterSpan(bitmap.getAddr32(0, y), 10, expected);
+            mode->filterSpan(expected, 10, expected);
+            grayscaleCF->filterSpan(expected, 10, expected);
+            REPORTER_ASSERT(reporter, 0 == memcmp(expected, result.getAddr32(0, y),
+                                                  sizeof(expected)));
+        }
+    }
+
+    {
+        // Check that the identity passes its input through.
+        SkAutoTUnref<SkImageFilter> identity(make_scale(1.0f));
+        SkBitmap result;
+        SkIPoint offset;
+        REPORTER_ASSERT(reporter, identity->filterImage(&proxy, bitmap, ctx, &result, &offset));
+        REPORTER_ASSERT(reporter, result.pixelRef() == bitmap.pixelRef());
+        REPORTER_ASSERT(reporter, 0 == offset.fX && 0 == offset.fY);
+    }
+
+    {
+        // Check that color filters are fused through uncropped offsets, which only move the
+        // result, even when the offsets are scaled by the matrix.
+        SkMatrix matrix;
+        matrix.setScale(2, 2);
+        SkImageFilter::Context scaledCtx(matrix, SkIRect::MakeLargest(), NULL);
+        SkAutoTUnref<SkImageFilter> scale(make_scale(2.0f));
+        SkAutoTUnref<SkImageFilter> move(SkOffsetImageFilter::Create(3, -2, scale));
+        SkAutoTUnref<SkImageFilter> grayscale(make_grayscale(move));
+        SkColorFilter* grayscaleCF;
+        SkColorFilter* scaleCF;
+        REPORTER_ASSERT(reporter, grayscale->asColorFilter(&grayscaleCF));
+        SkAutoUnref grayscaleUnref(grayscaleCF);
+        REPORTER_ASSERT(reporter, scale->asColorFilter(&scaleCF));
+        SkAutoUnref scaleUnref(scaleCF);
+
+        SkBitmap result;
+        SkIPoint offset;
+        REPORTER_ASSERT(reporter, grayscale->filterImage(&proxy, bitmap, scaledCtx, &result,
+                                                         &offset));
+        REPORTER_ASSERT(reporter, 6 == offset.fX && -4 == offset.fY);
+        REPORTER_ASSERT(reporter, result.width() == 10 && result.height() == 10);
+        SkAutoLockPixels lock(result);
+        for (int y = 0; y < 10; ++y) {
+            SkPMColor expected[10];
+            scaleCF->filterSpan(bitmap.getAddr32(0, y), 10, expected);
+            grayscaleCF->filterSpan(expected, 10, expected);
+            REPORTER_ASSERT(reporter, 0 == memcmp(expected, result.getAddr32(0, y),
+                                                  sizeof(expected)));
+        }
+
+        // An identity on top of an offset still passes its input through, moved.
+        SkAutoTUnref<SkImageFilter> identity(make_scale(1.0f, move));
+        REPORTER_ASSERT(reporter, identity->filterImage(&proxy, bitmap, scaledCtx, &result,
+                                                        &offset));
+        REPORTER_ASSERT(reporter, 6 == offset.fX && -4 == offset.fY);
+    }
+
+    {
+        // Check that fusing through an offset keeps the clip of the inner color filter, which
+        // clips before the offset moves its result.
+        SkImageFilter::Context clippedCtx(SkMatrix::I(), SkIRect::MakeWH(8, 8), NULL);
+        SkAutoTUnref<SkImageFilter> scale(make_scale(2.0f));
+        SkAutoTUnref<SkImageFilter> move(SkOffsetImageFilter::Create(-3, -2, scale));
+        SkAutoTUnref<SkImageFilter> grayscale(make_grayscale(move));
+        SkColorFilter* grayscaleCF;
+        SkColorFilter* scaleCF;
+        REPORTER_ASSERT(reporter, grayscale->asColorFilter(&grayscaleCF));
+        SkAutoUnref grayscaleUnref(grayscaleCF);
+        REPORTER_ASSERT(reporter, scale->asColorFilter(&scaleCF));
+        SkAutoUnref scaleUnref(scaleCF);
+
+        SkBitmap result;
+        SkIPoint offset;
+        REPORTER_ASSERT(reporter, grayscale->filterImage(&proxy, bitmap, clippedCtx, &result,
+                                                         &offset));
+        REPORTER_ASSERT(reporter, 0 == offset.fX && 0 == offset.fY);
+        REPORTER_ASSERT(reporter, result.width() == 5 && result.height() == 6);
+        if (result.width() == 5 && result.height() == 6) {
+            SkAutoLockPixels lock(result);
+            for (int y = 0; y < 6; ++y) {
+                SkPMColor expected[5];
+                scaleCF->filterSpan(bitmap.getAddr32(3, y + 2), 5, expected);
+                grayscaleCF->filterSpan(expected, 5, expected);
+                REPORTER_ASSERT(reporter, 0 == memcmp(expected, result.getAddr32(0, y),
+                                                      sizeof(expected)));
+            }
+        }
+
+        // The same holds for an identity on top of the offset.
+        SkAutoTUnref<SkImageFilter> innerIdentity(make_scale(1.0f));
+        SkAutoTUnref<SkImageFilter> moveIdentity(SkOffsetImageFilter::Create(-3, -2,
+                                                                             innerIdentity));
+        SkAutoTUnref<SkImageFilter> identity(make_scale(1.0f, moveIdentity));
+        REPORTER_ASSERT(reporter, identity->filterImage(&proxy, bitmap, clippedCtx, &result,
+                                                        &offset));
+        REPORTER_ASSERT(reporter, 0 == offset.fX && 0 == offset.fY);
+        REPORTER_ASSERT(reporter, result.width() == 5 && result.height() == 6);
+        if (result.width() == 5 && result.height() == 6) {
+            SkAutoLockPixels lock(result);
+            for (int y = 0; y < 6; ++y) {
+                REPORTER_ASSERT(reporter, 0 == memcmp(bitmap.getAddr32(3, y + 2),
+                                                      result.getAddr32(0, y),
+                                                      5 * sizeof(SkPMColor)));
+            }
+        }
+
+        // The inner color filter fails when its input is outside of the clip, even if the
+        // offset would move it inside.
+        SkImageFilter::Context farCtx(SkMatrix::I(), SkIRect::MakeXYWH(12, 0, 4, 4), NULL);
+        SkAutoTUnref<SkImageFilter> moveRight(SkOffsetImageFilter::Create(5, 0, scale));
+        SkAutoTUnref<SkImageFilter> grayscaleRight(make_grayscale(moveRight));
+        REPORTER_ASSERT(reporter, !grayscaleRight->filterImage(&proxy, bitmap, farCtx, &result,
+                                                               &offset));
+    }
+}
+
 DEF_TEST(ImageFilterEmptySaveLayer, reporter) {
     // Even when there's an empty saveLayer()/restore(), ensure that an image
     // filter or color filter which affects transparent black still draws.
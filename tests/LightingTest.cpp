@@ -0,0 +1,134 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkColorPriv.h"
+#include "SkLightingImageFilter.h"
+#include "SkLighting_opts.h"
+#include "SkRandom.h"
+#include "Test.h"
+
+static SkPoint3 to_point3(const float v[3]) {
+    return SkPoint3(v[0], v[1], v[2]);
+}
+
+static void random_point3(SkRandom* random, SkScalar min, SkScalar max, float v[3]) {
+    for (int i = 0; i < 3; ++i) {
+        v[i] = random->nextRangeScalar(min, max);
+    }
+}
+
+static void init_params(SkRandom* random, SkLightingParams* params) {
+    params->fLightType = static_cast<SkLightingParams::LightType>(random->nextULessThan(3));
+    random_point3(random, 0, 255, params->fColor);
+    random_point3(random, -1, 1, params->fDirection);
+    random_point3(random, -50, 50, params->fLocation);
+    SkPoint3 s(random->nextSScalar1(), random->nextSScalar1(), random->nextSScalar1());
+    s.normalize();
+    params->fS[0] = s.fX;
+    params->fS[1] = s.fY;
+    params->fS[2] = s.fZ;
+    params->fSpecularExponent = random->nextRangeScalar(1, 8);
+    // A wider edge of the cone than SkSpotLight's, so that more pixels are on it.
+    const SkScalar antiAliasThreshold = random->nextRangeScalar(0.016f, 0.5f);
+    params->fCosOuterConeAngle = random->nextSScalar1();
+    params->fCosInnerConeAngle = params->fCosOuterConeAngle + antiAliasThreshold;
+    params->fConeScale = SkScalarInvert(antiAliasThreshold);
+    params->fSpecular = random->nextBool();
+    params->fK = random->nextRangeScalar(0, 3);
+    params->fShininess = random->nextRangeScalar(1, 16);
+    params->fSurfaceScale = random->nextRangeScalar(-3, 3);
+}
+
+// The lighting of one interior pixel, as SkLightingImageFilter computes it.
+static SkPMColor light_pixel(const SkLightingParams& params, const SkPMColor* const src[3],
+                             int i, int x, int y) {
+    int m[9];
+    for (int row = 0; row < 3; ++row) {
+        for (int column = 0; column < 3; ++column) {
+            m[3 * row + column] = SkGetPackedA32(src[row][i + column]);
+        }
+    }
+    const SkScalar surfaceScale = params.fSurfaceScale;
+    const SkScalar nx = SkIntToScalar(-m[0] + m[2] - 2 * m[3] + 2 * m[5] - m[6] + m[8]) * 0.25f;
+    const SkScalar ny = SkIntToScalar(-m[0] + m[6] - 2 * m[1] + 2 * m[7] - m[2] + m[8]) * 0.25f;
+    SkPoint3 normal(-nx * surfaceScale, -ny * surfaceScale, SK_Scalar1);
+    normal.normalize();
+
+    SkPoint3 surfaceToLight = to_point3(params.fDirection);
+    SkPoint3 lightColor = to_point3(params.fColor);
+    if (SkLightingParams::kDistant_LightType != params.fLightType) {
+        surfaceToLight = SkPoint3(params.fLocation[0] - SkIntToScalar(x),
+                                  params.fLocation[1] - SkIntToScalar(y),
+                                  params.fLocation[2] - SkIntToScalar(m[4]) * surfaceScale);
+        surfaceToLight.normalize();
+    }
+    if (SkLightingParams::kSpot_LightType == params.fLightType) {
+        const SkScalar cosAngle = -surfaceToLight.dot(to_point3(params.fS));
+        if (cosAngle < params.fCosOuterConeAngle) {
+            lightColor = SkPoint3(0, 0, 0);
+        } else {
+            SkScalar scale = SkScalarPow(cosAngle, params.fSpecularExponent);
+            if (cosAngle < params.fCosInnerConeAngle) {
+                scale = scale * (cosAngle - params.fCosOuterConeAngle) * params.fConeScale;
+            }
+            lightColor = lightColor * scale;
+        }
+    }
+
+    SkScalar colorScale;
+    if (params.fSpecular) {
+        SkPoint3 halfDir(surfaceToLight);
+        halfDir.fZ += SK_Scalar1;
+        halfDir.normalize();
+        colorScale = params.fK * SkScalarPow(normal.dot(halfDir), params.fShininess);
+    } else {
+        colorScale = params.fK * normal.dot(surfaceToLight);
+    }
+    const SkPoint3 color = lightColor * SkScalarClampMax(colorScale, SK_Scalar1);
+    const int alpha = params.fSpecular ? SkScalarRoundToInt(color.maxComponent()) : 255;
+    return SkPackARGB32(SkClampMax(alpha, 255),
+                        SkClampMax(SkScalarRoundToInt(color.fX), 255),
+                        SkClampMax(SkScalarRoundToInt(color.fY), 255),
+                        SkClampMax(SkScalarRoundToInt(color.fZ), 255));
+}
+
+DEF_TEST(LightingPlatformRowProc, reporter) {
+    SkLightingRowProc proc = SkLightingGetPlatformRowProc();
+    if (NULL == proc) {
+        return;
+    }
+
+    SkRandom random;
+    static const int gCounts[] = { 1, 2, 3, 4, 5, 7, 8, 13, 40 };
+    SkPMColor rows[3][42];
+    SkPMColor actual[40];
+    for (int i = 0; i < 300; ++i) {
+        SkLightingParams params;
+        init_params(&random, &params);
+        const int count = gCounts[random.nextULessThan(SK_ARRAY_COUNT(gCounts))];
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < count + 2; ++column) {
+                const U8CPU alpha = random.nextBool() ? random.nextULessThan(256) : 255;
+                rows[row][column] = SkPackARGB32(alpha, 0, 0, 0);
+            }
+        }
+        const SkPMColor* const src[3] = { rows[0], rows[1], rows[2] };
+        const int x = random.nextRangeU(0, 100);
+        const int y = random.nextRangeU(0, 100);
+
+        proc(params, src, x, y, actual, count);
+        for (int p = 0; p < count; ++p) {
+            const SkPMColor expected = light_pixel(params, src, p, x + p, y);
+            if (actual[p] != expected) {
+                ERRORF(reporter, "row %d (light %d, specular %d): pixel %d of %d is %x, "
+                       "expected %x", i, params.fLightType, params.fSpecular, p, count,
+                       actual[p], expected);
+                return;
+            }
+        }
+    }
+}
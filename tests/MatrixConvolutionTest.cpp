@@ -0,0 +1,267 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapDevice.h"
+#include "SkColorPriv.h"
+#include "SkDeviceImageFilterProxy.h"
+#include "SkMatrixConvolutionImageFilter.h"
+#include "SkMatrixConvolution_opts.h"
+#include "SkRandom.h"
+#include "Test.h"
+
+static const int kMaxKernelSize = 9;
+static const int kMaxCount = 40;
+static const int kStride = kMaxCount + kMaxKernelSize;
+
+// Applies the gain and the bias to the sums of a pixel, as SkMatrixConvolutionImageFilter does.
+static SkPMColor pack_pixel(const SkMatrixConvolutionParams& params, const SkScalar sums[4],
+                            SkPMColor src) {
+    int channels[4];
+    for (int i = 0; i < 4; ++i) {
+        channels[i] = SkScalarFloorToInt(sums[i] * params.fGain + params.fBias);
+    }
+    const int a = params.fConvolveAlpha ? SkClampMax(channels[SK_A32_SHIFT / 8], 255) : 255;
+    const int r = SkClampMax(channels[SK_R32_SHIFT / 8], a);
+    const int g = SkClampMax(channels[SK_G32_SHIFT / 8], a);
+    const int b = SkClampMax(channels[SK_B32_SHIFT / 8], a);
+    return params.fConvolveAlpha ? SkPackARGB32(a, r, g, b)
+                                 : SkPreMultiplyARGB(SkGetPackedA32(src), r, g, b);
+}
+
+static void add_pixel(SkPMColor c, SkScalar k, SkScalar sums[4]) {
+    for (int i = 0; i < 4; ++i) {
+        sums[i] += SkIntToScalar((c >> (8 * i)) & 0xFF) * k;
+    }
+}
+
+// The convolution of one pixel with the whole kernel. src points to its top left tap.
+static SkPMColor convolve_pixel(const SkMatrixConvolutionParams& params, const SkPMColor* src) {
+    SkScalar sums[4] = { 0, 0, 0, 0 };
+    for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+        for (int cx = 0; cx < params.fKernelWidth; ++cx) {
+            add_pixel(src[cy * kStride + cx], params.fKernel[cy * params.fKernelWidth + cx],
+                      sums);
+        }
+    }
+    return pack_pixel(params, sums,
+                      src[params.fKernelOffsetY * kStride + params.fKernelOffsetX]);
+}
+
+// The convolution of one pixel with the column, then the row, of a separable kernel.
+static SkPMColor convolve_separable_pixel(const SkMatrixConvolutionParams& params,
+                                          const SkPMColor* src) {
+    SkScalar sums[4] = { 0, 0, 0, 0 };
+    for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+        SkScalar rowSums[4] = { 0, 0, 0, 0 };
+        for (int cx = 0; cx < params.fKernelWidth; ++cx) {
+            add_pixel(src[cy * kStride + cx], params.fRowKernel[cx], rowSums);
+        }
+        for (int i = 0; i < 4; ++i) {
+            sums[i] += rowSums[i] * params.fColumnKernel[cy];
+        }
+    }
+    return pack_pixel(params, sums,
+                      src[params.fKernelOffsetY * kStride + params.fKernelOffsetX]);
+}
+
+static void test_procs(skiatest::Reporter* reporter, SkMatrixConvolutionRowProc convolveRow,
+                       SkMatrixConvolutionSumRowProc sumRow,
+                       SkMatrixConvolutionSumColumnProc sumColumn, const char* name) {
+    SkRandom random;
+    static const int gCounts[] = { 1, 3, 4, 5, 8, 13, 40 };
+    SkPMColor src[(kMaxKernelSize + 1) * kStride];
+    SkScalar kernel[kMaxKernelSize * kMaxKernelSize];
+    SkScalar rowKernel[kMaxKernelSize], columnKernel[kMaxKernelSize];
+    SkScalar sums[kMaxKernelSize][4 * kMaxCount];
+    SkPMColor actual[kMaxCount];
+    for (int i = 0; i < 300; ++i) {
+        SkMatrixConvolutionParams params;
+        params.fKernel = kernel;
+        params.fRowKernel = rowKernel;
+        params.fColumnKernel = columnKernel;
+        params.fKernelWidth = random.nextRangeU(1, kMaxKernelSize);
+        params.fKernelHeight = random.nextRangeU(1, kMaxKernelSize);
+        params.fKernelOffsetX = random.nextULessThan(params.fKernelWidth);
+        params.fKernelOffsetY = random.nextULessThan(params.fKernelHeight);
+        params.fGain = random.nextRangeScalar(0.01f, 2);
+        params.fBias = random.nextRangeScalar(-100, 100);
+        params.fConvolveAlpha = random.nextBool();
+        for (int k = 0; k < params.fKernelWidth * params.fKernelHeight; ++k) {
+            kernel[k] = random.nextSScalar1();
+        }
+        for (int k = 0; k < params.fKernelWidth; ++k) {
+            rowKernel[k] = random.nextSScalar1();
+        }
+        for (int k = 0; k < params.fKernelHeight; ++k) {
+            columnKernel[k] = random.nextSScalar1();
+        }
+        for (size_t p = 0; p < SK_ARRAY_COUNT(src); ++p) {
+            const U8CPU alpha = random.nextULessThan(256);
+            src[p] = SkPackARGB32(alpha, random.nextULessThan(alpha + 1),
+                                  random.nextULessThan(alpha + 1),
+                                  random.nextULessThan(alpha + 1));
+        }
+        const int count = gCounts[random.nextULessThan(SK_ARRAY_COUNT(gCounts))];
+
+        convolveRow(params, src, kStride, actual, count);
+        for (int p = 0; p < count; ++p) {
+            const SkPMColor expected = convolve_pixel(params, src + p);
+            if (actual[p] != expected) {
+                ERRORF(reporter, "%s row %d (kernel %dx%d): pixel %d of %d is %x, expected %x",
+                       name, i, params.fKernelWidth, params.fKernelHeight, p, count, actual[p],
+                       expected);
+                return;
+            }
+        }
+
+        const float* rows[kMaxKernelSize];
+        for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+            sumRow(params, src + cy * kStride, sums[cy], count);
+            rows[cy] = sums[cy];
+        }
+        sumColumn(params, rows, src + params.fKernelOffsetY * kStride + params.fKernelOffsetX,
+                  actual, count);
+        for (int p = 0; p < count; ++p) {
+            const SkPMColor expected = convolve_separable_pixel(params, src + p);
+            if (actual[p] != expected) {
+                ERRORF(reporter, "%s separable row %d (kernel %dx%d): pixel %d of %d is %x, "
+                       "expected %x", name, i, params.fKernelWidth, params.fKernelHeight, p,
+                       count, actual[p], expected);
+                return;
+            }
+        }
+    }
+}
+
+DEF_TEST(MatrixConvolutionProcs, reporter) {
+    SkMatrixConvolutionRowProc convolveRow;
+    SkMatrixConvolutionSumRowProc sumRow;
+    SkMatrixConvolutionSumColumnProc sumColumn;
+    SkMatrixConvolutionGetPortableProcs(&convolveRow, &sumRow, &sumColumn);
+    test_procs(reporter, convolveRow, sumRow, sumColumn, "portable");
+    if (SkMatrixConvolutionGetPlatformProcs(&convolveRow, &sumRow, &sumColumn)) {
+        test_procs(reporter, convolveRow, sumRow, sumColumn, "platform");
+    }
+}
+
+enum KernelKind {
+    kDyadic_KernelKind,     // small whole numbers over powers of two, which factor exactly
+    kRounded_KernelKind,    // separable only to within the rounding of the products
+    kFull_KernelKind,       // not separable at all
+};
+
+static void make_kernel(SkRandom* random, KernelKind kind, int width, int height,
+                        SkScalar kernel[]) {
+    SkScalar row[kMaxKernelSize], column[kMaxKernelSize];
+    for (int cx = 0; cx < width; ++cx) {
+        row[cx] = kDyadic_KernelKind == kind
+                ? SkIntToScalar(static_cast<int>(random->nextRangeU(0, 8)) - 3) / 8
+                : random->nextSScalar1();
+    }
+    for (int cy = 0; cy < height; ++cy) {
+        column[cy] = kDyadic_KernelKind == kind ? SkIntToScalar(random->nextRangeU(1, 6)) / 4
+                                                : random->nextSScalar1();
+    }
+    for (int cy = 0; cy < height; ++cy) {
+        for (int cx = 0; cx < width; ++cx) {
+            kernel[cy * width + cx] = kFull_KernelKind == kind ? random->nextSScalar1()
+                                                               : column[cy] * row[cx];
+        }
+    }
+}
+
+// The convolution of the pixel at (x, y) with the whole kernel, clamping taps to the bitmap.
+static SkPMColor convolve_clamped_pixel(const SkMatrixConvolutionParams& params,
+                                        const SkBitmap& src, int x, int y) {
+    SkScalar sums[4] = { 0, 0, 0, 0 };
+    for (int cy = 0; cy < params.fKernelHeight; ++cy) {
+        for (int cx = 0; cx < params.fKernelWidth; ++cx) {
+            const int sx = SkClampMax(x + cx - params.fKernelOffsetX, src.width() - 1);
+            const int sy = SkClampMax(y + cy - params.fKernelOffsetY, src.height() - 1);
+            add_pixel(*src.getAddr32(SkMax32(sx, 0), SkMax32(sy, 0)),
+                      params.fKernel[cy * params.fKernelWidth + cx], sums);
+        }
+    }
+    return pack_pixel(params, sums, *src.getAddr32(x, y));
+}
+
+// Separable kernels take two passes over the interior, which must give the same pixels as one
+// pass over the whole kernel, in every band of a bitmap tall enough to be cut into several.
+DEF_TEST(MatrixConvolutionImageFilterKernels, reporter) {
+    static const int kWidth = 48;
+    static const int kHeight = 1500;
+
+    SkRandom random;
+    SkBitmap src;
+    src.allocN32Pixels(kWidth, kHeight);
+    SkBitmap opaqueSrc;
+    opaqueSrc.allocN32Pixels(kWidth, kHeight);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            const U8CPU alpha = random.nextULessThan(256);
+            *src.getAddr32(x, y) = SkPackARGB32(alpha, random.nextULessThan(alpha + 1),
+                                                random.nextULessThan(alpha + 1),
+                                                random.nextULessThan(alpha + 1));
+            *opaqueSrc.getAddr32(x, y) = random.nextU() | SK_A32_MASK << SK_A32_SHIFT;
+        }
+    }
+    opaqueSrc.setAlphaType(kOpaque_SkAlphaType);
+
+    SkBitmap deviceBitmap;
+    deviceBitmap.allocN32Pixels(1, 1);
+    SkBitmapDevice device(deviceBitmap);
+    SkDeviceImageFilterProxy proxy(&device);
+    SkImageFilter::Context ctx(SkMatrix::I(), SkIRect::MakeWH(kWidth, kHeight), NULL);
+
+    static const KernelKind gKinds[] = {
+        kDyadic_KernelKind, kRounded_KernelKind, kFull_KernelKind
+    };
+    SkScalar kernel[kMaxKernelSize * kMaxKernelSize];
+    for (int i = 0; i < 12; ++i) {
+        SkMatrixConvolutionParams params;
+        params.fKernel = kernel;
+        params.fKernelWidth = random.nextRangeU(3, 5);
+        params.fKernelHeight = random.nextRangeU(3, 5);
+        params.fKernelOffsetX = random.nextULessThan(params.fKernelWidth);
+        params.fKernelOffsetY = random.nextULessThan(params.fKernelHeight);
+        params.fGain = random.nextRangeScalar(0.01f, 2);
+        params.fBias = random.nextRangeScalar(-100, 100);
+        params.fConvolveAlpha = random.nextBool();
+        const KernelKind kind = gKinds[i % SK_ARRAY_COUNT(gKinds)];
+        make_kernel(&random, kind, params.fKernelWidth, params.fKernelHeight, kernel);
+
+        SkAutoTUnref<SkImageFilter> filter(SkMatrixConvolutionImageFilter::Create(
+                SkISize::Make(params.fKernelWidth, params.fKernelHeight), kernel,
+                params.fGain, params.fBias,
+                SkIPoint::Make(params.fKernelOffsetX, params.fKernelOffsetY),
+                SkMatrixConvolutionImageFilter::kClamp_TileMode, params.fConvolveAlpha));
+        // Convolving only the color unpremultiplies the source, unless it is opaque.
+        const SkBitmap& source = params.fConvolveAlpha ? src : opaqueSrc;
+        SkBitmap result;
+        SkIPoint offset;
+        if (!filter->filterImage(&proxy, source, ctx, &result, &offset)) {
+            ERRORF(reporter, "could not filter with kernel %d", i);
+            return;
+        }
+        REPORTER_ASSERT(reporter, 0 == offset.fX && 0 == offset.fY);
+        REPORTER_ASSERT(reporter, kWidth == result.width() && kHeight == result.height());
+
+        SkAutoLockPixels alp(result);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                const SkPMColor expected = convolve_clamped_pixel(params, source, x, y);
+                if (*result.getAddr32(x, y) != expected) {
+                    ERRORF(reporter, "kernel %d (kind %d, %dx%d, offset %d, %d): pixel (%d, %d) "
+                           "is %x, expected %x", i, kind, params.fKernelWidth,
+                           params.fKernelHeight, params.fKernelOffsetX, params.fKernelOffsetY,
+                           x, y, *result.getAddr32(x, y), expected);
+                    return;
+                }
+            }
+        }
+    }
+}
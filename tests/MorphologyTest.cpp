@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkColorPriv.h"
+#include "SkMorphology_opts.h"
+#include "SkRandom.h"
+#include "SkTemplates.h"
+#include "Test.h"
+
+static U8CPU morph_channel(bool dilate, U8CPU a, U8CPU b) {
+    return dilate ? SkMax32(a, b) : SkMin32(a, b);
+}
+
+// Dilates or erodes one pixel by visiting every pixel in its window, like the filter used to.
+static SkPMColor morph_pixel(SkMorphologyProcType type, const SkPMColor* src, int width,
+                             int height, int x, int y, int radius) {
+    const bool dilate = kDilateX_SkMorphologyProcType == type ||
+                        kDilateY_SkMorphologyProcType == type;
+    const bool horizontal = kDilateX_SkMorphologyProcType == type ||
+                            kErodeX_SkMorphologyProcType == type;
+    U8CPU a = dilate ? 0 : 255, r = a, g = a, b = a;
+    for (int i = -radius; i <= radius; ++i) {
+        const int sx = horizontal ? x + i : x;
+        const int sy = horizontal ? y : y + i;
+        if (sx < 0 || sx >= width || sy < 0 || sy >= height) {
+            continue;
+        }
+        const SkPMColor c = src[sy * width + sx];
+        a = morph_channel(dilate, a, SkGetPackedA32(c));
+        r = morph_channel(dilate, r, SkGetPackedR32(c));
+        g = morph_channel(dilate, g, SkGetPackedG32(c));
+        b = morph_channel(dilate, b, SkGetPackedB32(c));
+    }
+    return SkPackARGB32(a, r, g, b);
+}
+
+static void test_proc(skiatest::Reporter* reporter, SkMorphologyProcType type,
+                      SkMorphologyImageFilter::Proc proc, const char* name) {
+    static const int gSizes[] = { 1, 2, 3, 4, 5, 7, 8, 13, 40 };
+    static const int gRadii[] = { 0, 1, 2, 3, 6, 17, 39, 100 };
+
+    SkRandom random;
+    const bool horizontal = kDilateX_SkMorphologyProcType == type ||
+                            kErodeX_SkMorphologyProcType == type;
+    for (int i = 0; i < 100; ++i) {
+        const int width = gSizes[random.nextULessThan(SK_ARRAY_COUNT(gSizes))];
+        const int height = gSizes[random.nextULessThan(SK_ARRAY_COUNT(gSizes))];
+        const int radius = gRadii[random.nextULessThan(SK_ARRAY_COUNT(gRadii))];
+        SkAutoTMalloc<SkPMColor> src(width * height);
+        SkAutoTMalloc<SkPMColor> dst(width * height);
+        for (int p = 0; p < width * height; ++p) {
+            const U8CPU alpha = random.nextULessThan(256);
+            src[p] = SkPreMultiplyARGB(alpha, random.nextULessThan(256),
+                                       random.nextULessThan(256), random.nextULessThan(256));
+        }
+
+        // The procs take the size along the direction of the morphology first.
+        if (horizontal) {
+            proc(src.get(), dst.get(), radius, width, height, width, width);
+        } else {
+            proc(src.get(), dst.get(), radius, height, width, width, width);
+        }
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const SkPMColor expected = morph_pixel(type, src.get(), width, height,
+                                                       x, y, radius);
+                if (dst[y * width + x] != expected) {
+                    ERRORF(reporter, "%s type %d, %dx%d, radius %d: pixel (%d, %d) is %x, "
+                           "expected %x", name, type, width, height, radius, x, y,
+                           dst[y * width + x], expected);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+DEF_TEST(MorphologyProcs, reporter) {
+    static const SkMorphologyProcType gTypes[] = {
+        kDilateX_SkMorphologyProcType,
+        kDilateY_SkMorphologyProcType,
+        kErodeX_SkMorphologyProcType,
+        kErodeY_SkMorphologyProcType,
+    };
+    for (size_t t = 0; t < SK_ARRAY_COUNT(gTypes); ++t) {
+        test_proc(reporter, gTypes[t], SkMorphologyGetPortableProc(gTypes[t]), "portable");
+        if (SkMorphologyGetPlatformProc(gTypes[t])) {
+            test_proc(reporter, gTypes[t], SkMorphologyGetPlatformProc(gTypes[t]), "platform");
+        }
+    }
+}
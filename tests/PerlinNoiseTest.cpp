@@ -0,0 +1,222 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkPerlinNoiseShader.h"
+#include "SkPerlinNoise_opts.h"
+#include "SkRandom.h"
+#include "SkScaledImageCache.h"
+#include "Test.h"
+
+static const int kPerlinNoise = 4096;
+
+static void init_lattice(SkPerlinNoiseLattice* lattice, SkRandom* random) {
+    for (int i = 0; i < 256; ++i) {
+        lattice->fSelector[i] = i;
+    }
+    for (int i = 255; i > 0; --i) {
+        SkTSwap(lattice->fSelector[i], lattice->fSelector[random->nextULessThan(i + 1)]);
+    }
+    for (int i = 0; i < 256; ++i) {
+        for (int lane = 0; lane < 4; ++lane) {
+            SkVector gradient = SkVector::Make(random->nextSScalar1(), random->nextSScalar1());
+            gradient.normalize();
+            lattice->fGradientX[i][lane] = gradient.fX;
+            lattice->fGradientY[i][lane] = gradient.fY;
+        }
+    }
+}
+
+static void lattice_position(float component, bool stitch, int stitchSize, int* index,
+                             int* nextIndex, float* fraction) {
+    const float position = component + kPerlinNoise;
+    *index = SkScalarFloorToInt(position);
+    *fraction = position - SkIntToScalar(*index);
+    *nextIndex = *index + 1;
+    if (stitch) {
+        if (*index >= stitchSize + kPerlinNoise) {
+            *index -= stitchSize;
+        }
+        if (*nextIndex >= stitchSize + kPerlinNoise) {
+            *nextIndex -= stitchSize;
+        }
+    }
+    *index &= 255;
+    *nextIndex &= 255;
+}
+
+static float smooth(float t) {
+    return (t * t) * (3.0f - 2 * t);
+}
+
+static float gradient_dot(const SkPerlinNoiseLattice& lattice, int index, int lane, float x,
+                          float y) {
+    return lattice.fGradientX[index][lane] * x + lattice.fGradientY[index][lane] * y;
+}
+
+static float interp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+// The noise of one channel at one point, as the SVG spec computes it.
+static U8CPU noise_channel(const SkPerlinNoiseSpan& span, float x, int lane) {
+    const SkPerlinNoiseLattice& lattice = *span.fLattice;
+    float noiseX = x * span.fFrequencyX;
+    float noiseY = span.fY * span.fFrequencyY;
+    int stitchWidth = span.fStitchWidth;
+    int stitchHeight = span.fStitchHeight;
+    float ratio = 1;
+    float sum = 0;
+    for (int octave = 0; octave < span.fNumOctaves; ++octave) {
+        int ix, nextIx, iy, nextIy;
+        float fx, fy;
+        lattice_position(noiseX, span.fStitch, stitchWidth, &ix, &nextIx, &fx);
+        lattice_position(noiseY, span.fStitch, stitchHeight, &iy, &nextIy, &fy);
+        const int i = lattice.fSelector[ix];
+        const int j = lattice.fSelector[nextIx];
+        const float sx = smooth(fx);
+        const float a = interp(gradient_dot(lattice, (i + iy) & 255, lane, fx, fy),
+                               gradient_dot(lattice, (j + iy) & 255, lane, fx - 1, fy), sx);
+        const float b = interp(gradient_dot(lattice, (i + nextIy) & 255, lane, fx, fy - 1),
+                               gradient_dot(lattice, (j + nextIy) & 255, lane, fx - 1, fy - 1),
+                               sx);
+        const float noise = interp(a, b, smooth(fy));
+        sum += (span.fFractalNoise ? noise : SkScalarAbs(noise)) / ratio;
+        noiseX *= 2;
+        noiseY *= 2;
+        ratio *= 2;
+        stitchWidth *= 2;
+        stitchHeight *= 2;
+    }
+    if (span.fFractalNoise) {
+        sum = sum * 0.5f + 0.5f;
+    }
+    if (SK_A32_SHIFT / 8 == lane) {
+        sum *= span.fAlphaScale;
+    }
+    return SkScalarFloorToInt(255 * SkScalarPin(sum, 0, 1));
+}
+
+static SkPMColor noise_color(const SkPerlinNoiseSpan& span, float x) {
+    return SkPreMultiplyARGB(noise_channel(span, x, SK_A32_SHIFT / 8),
+                             noise_channel(span, x, SK_R32_SHIFT / 8),
+                             noise_channel(span, x, SK_G32_SHIFT / 8),
+                             noise_channel(span, x, SK_B32_SHIFT / 8));
+}
+
+static void test_span_proc(skiatest::Reporter* reporter, SkPerlinNoiseSpanProc proc,
+                           const char* name) {
+    SkRandom random;
+    SkPerlinNoiseLattice lattice;
+    init_lattice(&lattice, &random);
+
+    static const int gCounts[] = { 1, 3, 4, 5, 8, 13, 40 };
+    SkPMColor actual[40];
+    for (int i = 0; i < 200; ++i) {
+        SkPerlinNoiseSpan span;
+        span.fLattice = &lattice;
+        span.fX = SkIntToScalar(random.nextRangeU(0, 200)) - 100;
+        span.fY = SkIntToScalar(random.nextRangeU(0, 200)) - 100;
+        span.fFrequencyX = random.nextRangeScalar(0, 0.5f);
+        span.fFrequencyY = random.nextRangeScalar(0, 0.5f);
+        span.fNumOctaves = random.nextULessThan(6);
+        span.fFractalNoise = random.nextBool();
+        span.fStitch = random.nextBool();
+        span.fStitchWidth = random.nextRangeU(1, 20);
+        span.fStitchHeight = random.nextRangeU(1, 20);
+        span.fAlphaScale = random.nextBool() ? 1 : random.nextUScalar1();
+        const int count = gCounts[random.nextULessThan(SK_ARRAY_COUNT(gCounts))];
+
+        proc(span, actual, count);
+        for (int x = 0; x < count; ++x) {
+            const SkPMColor expected = noise_color(span, span.fX + SkIntToScalar(x));
+            if (actual[x] != expected) {
+                ERRORF(reporter, "%s span %d: pixel %d of %d is %x, expected %x",
+                       name, i, x, count, actual[x], expected);
+                return;
+            }
+        }
+    }
+}
+
+DEF_TEST(PerlinNoiseSpanProcs, reporter) {
+    test_span_proc(reporter, SkPerlinNoiseGetPortableSpanProc(), "portable");
+    if (SkPerlinNoiseGetPlatformSpanProc()) {
+        test_span_proc(reporter, SkPerlinNoiseGetPlatformSpanProc(), "platform");
+    }
+}
+
+static void draw_noise(SkBitmap* bitmap, SkShader* shader, bool byColumn) {
+    bitmap->allocN32Pixels(60, 50);
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    canvas.translate(7, 5);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(0xC0);
+    if (byColumn) {
+        for (int x = -7; x < 53; ++x) {
+            canvas.drawRect(SkRect::MakeXYWH(SkIntToScalar(x), -5, 1, 50), paint);
+        }
+    } else {
+        canvas.drawPaint(paint);
+    }
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a), alpb(b);
+    return a.getSize() == b.getSize() && 0 == memcmp(a.getPixels(), b.getPixels(), a.getSize());
+}
+
+static SkShader* make_stitched_noise(SkScalar baseFrequencyX, SkScalar baseFrequencyY,
+                                     int width, int height) {
+    const SkISize tileSize = SkISize::Make(width, height);
+    return SkPerlinNoiseShader::CreateTurbulence(baseFrequencyX, baseFrequencyY, 3, 11,
+                                                 &tileSize);
+}
+
+// Stitched noise takes the pixels of its tile from a copy in SkScaledImageCache, and computes
+// the others. With a base frequency of 0 along one axis, the noise does not depend on the size
+// of the tile along it, so a tile too large to cache draws the same noise as one that is cached.
+DEF_TEST(PerlinNoiseStitchedTile, reporter) {
+    static const struct {
+        SkScalar    fBaseFrequencyX, fBaseFrequencyY;
+        int         fWidth, fHeight;
+        int         fLargeWidth, fLargeHeight;
+    } gRecs[] = {
+        { 0.07f, 0,     240, 256, 240, 300 },
+        { 0,     0.05f, 256, 240, 300, 240 },
+    };
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gRecs); ++i) {
+        const SkScalar fx = gRecs[i].fBaseFrequencyX;
+        const SkScalar fy = gRecs[i].fBaseFrequencyY;
+        SkAutoTUnref<SkShader> large(make_stitched_noise(fx, fy, gRecs[i].fLargeWidth,
+                                                         gRecs[i].fLargeHeight));
+        SkAutoTUnref<SkShader> shader(make_stitched_noise(fx, fy, gRecs[i].fWidth,
+                                                          gRecs[i].fHeight));
+
+        SkBitmap expected, actual;
+        draw_noise(&expected, large, false);
+        draw_noise(&actual, shader, false);
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+
+        // Each column is a span either in or out of the tile, which is cached now.
+        const size_t bytesUsed = SkScaledImageCache::GetTotalBytesUsed();
+        draw_noise(&actual, shader, true);
+        REPORTER_ASSERT(reporter, bytesUsed == SkScaledImageCache::GetTotalBytesUsed());
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+
+        // Another shader of the same noise finds the same tile.
+        SkAutoTUnref<SkShader> same(make_stitched_noise(fx, fy, gRecs[i].fWidth,
+                                                        gRecs[i].fHeight));
+        draw_noise(&actual, same, false);
+        REPORTER_ASSERT(reporter, bytesUsed == SkScaledImageCache::GetTotalBytesUsed());
+        REPORTER_ASSERT(reporter, same_pixels(expected, actual));
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBBHFactory.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkImageGenerator.h"
+#include "SkPicture.h"
+#include "SkPicturePrefetcher.h"
+#include "SkPictureRecorder.h"
+#include "SkThread.h"
+#include "SkUtils.h"
+#include "Test.h"
+
+namespace {
+
+// Fills with a solid color, and counts how many times it has been asked to decode.
+class CountingImageGenerator : public SkImageGenerator {
+public:
+    CountingImageGenerator(int32_t* decodeCount) : fDecodeCount(decodeCount) {}
+
+    static const int kSize = 16;
+
+protected:
+    virtual bool onGetInfo(SkImageInfo* info) SK_OVERRIDE {
+        *info = SkImageInfo::MakeN32Premul(kSize, kSize);
+        return true;
+    }
+
+    virtual bool onGetPixels(const SkImageInfo& info, void* pixels, size_t rowBytes,
+                             SkPMColor ctable[], int* ctableCount) SK_OVERRIDE {
+        sk_atomic_inc(fDecodeCount);
+        char* row = static_cast<char*>(pixels);
+        for (int y = 0; y < info.fHeight; ++y) {
+            sk_memset32(reinterpret_cast<uint32_t*>(row), SK_ColorBLUE, info.fWidth);
+            row += rowBytes;
+        }
+        return true;
+    }
+
+private:
+    int32_t* fDecodeCount;
+};
+
+}  // namespace
+
+static const int kQuadrants = 4;
+
+// Draws one lazily decoded bitmap in each quadrant of a 2x2 grid.
+static SkPicture* record_lazy_bitmaps(int32_t decodeCounts[kQuadrants]) {
+    const SkScalar size = SkIntToScalar(CountingImageGenerator::kSize);
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(2 * CountingImageGenerator::kSize,
+                                               2 * CountingImageGenerator::kSize, &factory);
+    for (int i = 0; i < kQuadrants; ++i) {
+        SkBitmap bm;
+        SkInstallDiscardablePixelRef(SkNEW_ARGS(CountingImageGenerator, (&decodeCounts[i])), &bm);
+        canvas->drawBitmap(bm, (i & 1) * size, (i >> 1) * size);
+    }
+    return recorder.endRecording();
+}
+
+static void test_prefetch(skiatest::Reporter* reporter, int threadCount) {
+    int32_t decodeCounts[kQuadrants] = { 0, 0, 0, 0 };
+    SkAutoTUnref<SkPicture> pict(record_lazy_bitmaps(decodeCounts));
+
+    const SkScalar size = SkIntToScalar(CountingImageGenerator::kSize);
+    const SkRect topLeft = SkRect::MakeWH(size - 2, size - 2);
+
+    SkPicturePrefetcher prefetcher(threadCount);
+    REPORTER_ASSERT(reporter, 1 == prefetcher.prefetch(pict, topLeft));
+    // Already scheduled, so it isn't scheduled again.
+    REPORTER_ASSERT(reporter, 0 == prefetcher.prefetch(pict, topLeft));
+    prefetcher.wait();
+
+    REPORTER_ASSERT(reporter, 1 == decodeCounts[0]);
+    for (int i = 1; i < kQuadrants; ++i) {
+        REPORTER_ASSERT(reporter, 0 == decodeCounts[i]);
+    }
+
+    // Playback of the prefetched area must not decode again.
+    SkBitmap dst;
+    dst.allocN32Pixels(CountingImageGenerator::kSize, CountingImageGenerator::kSize);
+    SkCanvas canvas(dst);
+    canvas.clipRect(topLeft);
+    canvas.drawPicture(pict);
+    REPORTER_ASSERT(reporter, 1 == decodeCounts[0]);
+
+    // The rest of the picture.
+    const SkRect all = SkRect::MakeWH(2 * size, 2 * size);
+    REPORTER_ASSERT(reporter, kQuadrants - 1 == prefetcher.prefetch(pict, all));
+    prefetcher.wait();
+    for (int i = 0; i < kQuadrants; ++i) {
+        REPORTER_ASSERT(reporter, 1 == decodeCounts[i]);
+    }
+
+    // After a reset everything is eligible for prefetching again.
+    prefetcher.reset();
+    REPORTER_ASSERT(reporter, kQuadrants == prefetcher.prefetch(pict, all));
+}
+
+DEF_TEST(PicturePrefetcher, reporter) {
+    test_prefetch(reporter, 0);
+    test_prefetch(reporter, 1);
+    test_prefetch(reporter, 4);
+}
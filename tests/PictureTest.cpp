@@ -1434,6 +1434,173 @@ static void test_bitmap_with_encoded_data(skiatest::Reporter* reporter) {
     SkSetErrorCallback(NULL, NULL);
 }
 
+static void test_create_from_data(skiatest::Reporter* reporter) {
+    SkBitmap bm;
+    make_bm(&bm, 16, 16, SK_ColorRED, true);
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(32, 32);
+    canvas->drawBitmap(bm, 0, 0);
+    canvas->drawRect(SkRect::MakeXYWH(16, 16, 16, 16), SkPaint());
+    SkAutoTUnref<SkPicture> original(recorder.endRecording());
+
+    SkDynamicMemoryWStream wStream;
+    original->serialize(&wStream);
+    SkAutoDataUnref streamData(wStream.copyToData());
+    // Make a copy that nothing else refs, to tell whether the picture references it.
+    SkAutoDataUnref data(SkData::NewWithCopy(streamData->data(), streamData->size()));
+
+    SkMemoryStream stream(data);
+    SkAutoTUnref<SkPicture> fromStream(SkPicture::CreateFromStream(&stream));
+    REPORTER_ASSERT(reporter, NULL != fromStream.get());
+
+    SkAutoTUnref<SkPicture> fromData(SkPicture::CreateFromData(data));
+    REPORTER_ASSERT(reporter, NULL != fromData.get());
+    if (NULL == fromStream.get() || NULL == fromData.get()) {
+        return;
+    }
+
+    SkBitmap expected, actual;
+    draw(fromStream, 32, 32, &expected);
+    draw(fromData, 32, 32, &actual);
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+
+    // The picture plays back out of data in place, so it holds onto it.
+    stream.setData(NULL);
+    REPORTER_ASSERT(reporter, !data->unique());
+    fromData.reset(NULL);
+    REPORTER_ASSERT(reporter, data->unique());
+}
+
+static int gLazyDecodeCount;
+
+static bool counting_decode(const void* buffer, size_t size, SkBitmap* bm) {
+    ++gLazyDecodeCount;
+    return SkImageDecoder::DecodeMemory(buffer, size, bm);
+}
+
+// Loads a picture recorded with a BBH from data, and checks that drawing one corner of it
+// only decodes the bitmap drawn in that corner.
+static void test_create_from_data_lazily(skiatest::Reporter* reporter) {
+    SkBitmap red, blue;
+    make_bm(&red, 16, 16, SK_ColorRED, true);
+    make_bm(&blue, 16, 16, SK_ColorBLUE, true);
+    SkAutoDataUnref encoded(encode_bitmap_to_data(NULL, red));
+    if (NULL == encoded.get()) {
+        // The bitmaps would be written unencoded, so there would be nothing to count.
+        return;
+    }
+
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(40, 40, &factory);
+    canvas->drawBitmap(red, 0, 0);
+    canvas->drawBitmap(blue, 20, 20);
+    SkAutoTUnref<SkPicture> original(recorder.endRecording());
+
+    SkDynamicMemoryWStream wStream;
+    original->serialize(&wStream, &encode_bitmap_to_data);
+    SkAutoDataUnref data(wStream.copyToData());
+
+    gLazyDecodeCount = 0;
+    SkAutoTUnref<SkPicture> fromData(SkPicture::CreateFromData(data, &counting_decode));
+    REPORTER_ASSERT(reporter, NULL != fromData.get());
+    if (NULL == fromData.get()) {
+        return;
+    }
+    REPORTER_ASSERT(reporter, 0 == gLazyDecodeCount);
+
+    SkBitmap tile;
+    draw(fromData, 16, 16, &tile);
+    REPORTER_ASSERT(reporter, 1 == gLazyDecodeCount);
+    SkAutoLockPixels alpTile(tile);
+    REPORTER_ASSERT(reporter, SK_ColorRED == tile.getColor(8, 8));
+
+    SkBitmap expected, actual;
+    draw(original, 40, 40, &expected);
+    draw(fromData, 40, 40, &actual);
+    REPORTER_ASSERT(reporter, 2 == gLazyDecodeCount);
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+
+    // Serializing a lazily loaded picture writes out the same picture again.
+    SkDynamicMemoryWStream reserialized;
+    fromData->serialize(&reserialized, &encode_bitmap_to_data);
+    SkAutoDataUnref reserializedData(reserialized.copyToData());
+    SkAutoTUnref<SkPicture> roundTrip(SkPicture::CreateFromData(reserializedData));
+    REPORTER_ASSERT(reporter, NULL != roundTrip.get());
+    if (NULL != roundTrip.get()) {
+        SkBitmap roundTripResult;
+        draw(roundTrip, 40, 40, &roundTripResult);
+        SkAutoLockPixels alpRoundTrip(roundTripResult);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), roundTripResult.getPixels(),
+                                              expected.getSize()));
+    }
+}
+
+// Runs of similar ops should shrink when serialized compactly, and load back identically
+// through both CreateFromStream and CreateFromData.
+static void test_serialize_compact(skiatest::Reporter* reporter) {
+    SkBitmap bm;
+    make_bm(&bm, 8, 8, SK_ColorGREEN, true);
+
+    SkPictureRecorder nestedRecorder;
+    nestedRecorder.beginRecording(10, 10)->drawCircle(5, 5, 4, SkPaint());
+    SkAutoTUnref<SkPicture> nested(nestedRecorder.endRecording());
+
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(64, 64);
+    SkPaint paint;
+    for (int i = 0; i < 64; ++i) {
+        paint.setColor(SkColorSetARGB(0xFF, 4 * i, 0x80, 0xFF - 4 * i));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i), SkIntToScalar(i % 8), 3, 5), paint);
+    }
+    SkPath path;
+    path.moveTo(2, 60);
+    path.lineTo(30, 40);
+    path.quadTo(40, 60, 62, 62);
+    canvas->drawPath(path, paint);
+    canvas->drawBitmap(bm, 40, 8);
+    canvas->translate(20, 30);
+    canvas->drawPicture(nested);
+    SkAutoTUnref<SkPicture> original(recorder.endRecording());
+
+    SkDynamicMemoryWStream normalStream, compactStream;
+    original->serialize(&normalStream);
+    original->serializeCompact(&compactStream);
+    SkAutoDataUnref normal(normalStream.copyToData());
+    SkAutoDataUnref compact(compactStream.copyToData());
+    REPORTER_ASSERT(reporter, compact->size() < normal->size());
+
+    SkBitmap expected;
+    draw(original, 64, 64, &expected);
+    SkAutoLockPixels alpExpected(expected);
+
+    SkMemoryStream stream(compact);
+    SkAutoTUnref<SkPicture> fromStream(SkPicture::CreateFromStream(&stream));
+    SkAutoTUnref<SkPicture> fromData(SkPicture::CreateFromData(compact));
+    SkPicture* loaded[] = { fromStream.get(), fromData.get() };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(loaded); ++i) {
+        REPORTER_ASSERT(reporter, NULL != loaded[i]);
+        if (NULL == loaded[i]) {
+            continue;
+        }
+        SkBitmap actual;
+        draw(loaded[i], 64, 64, &actual);
+        SkAutoLockPixels alpActual(actual);
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                              expected.getSize()));
+    }
+
+    // A truncated compact picture must fail to load, not crash.
+    SkAutoDataUnref truncated(SkData::NewSubset(compact, 0, compact->size() - 8));
+    SkAutoTUnref<SkPicture> fromTruncated(SkPicture::CreateFromData(truncated));
+    REPORTER_ASSERT(reporter, NULL == fromTruncated.get());
+}
+
 static void test_draw_empty(skiatest::Reporter* reporter) {
     SkBitmap result;
     make_bm(&result, 2, 2, SK_ColorBLACK, false);
@@ -1718,6 +1885,9 @@ DEF_TEST(Picture, reporter) {
     test_gatherpixelrefs(reporter);
     test_gatherpixelrefsandrects(reporter);
     test_bitmap_with_encoded_data(reporter);
+    test_create_from_data(reporter);
+    test_create_from_data_lazily(reporter);
+    test_serialize_compact(reporter);
     test_draw_empty(reporter);
     test_clip_bound_opt(reporter);
     test_clip_expansion(reporter);
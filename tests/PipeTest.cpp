@@ -9,6 +9,7 @@
 #include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkGPipe.h"
+#include "SkGPipeRingController.h"
 #include "SkPaint.h"
 #include "SkShader.h"
 #include "Test.h"
@@ -41,6 +42,53 @@ static void testDrawingAfterEndRecording(SkCanvas* canvas) {
     pipeCanvas->drawBitmap(bm, 0, 0);
 }
 
+static void draw_rects_and_bitmap(SkCanvas* canvas, const SkBitmap& bm) {
+    SkPaint paint;
+    for (int i = 0; i < 2000; ++i) {
+        paint.setColor(SkColorSetRGB(i & 0xFF, (i >> 3) & 0xFF, 0x80));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(i % 60), SkIntToScalar(i % 50), 4, 8),
+                         paint);
+    }
+    canvas->drawBitmap(bm, 8, 8);
+    canvas->drawRect(SkRect::MakeWH(10, 10), paint);
+}
+
+// Records through a ring small enough to wrap around several times (and to have to grow for
+// the bitmap) while another thread plays it back, and checks the result matches drawing
+// directly.
+static void test_ring_controller(skiatest::Reporter* reporter) {
+    static const int kSize = 64;
+    SkBitmap expected, actual;
+    expected.allocN32Pixels(kSize, kSize);
+    actual.allocN32Pixels(kSize, kSize);
+    expected.eraseColor(SK_ColorWHITE);
+    actual.eraseColor(SK_ColorWHITE);
+
+    SkBitmap bm;
+    bm.allocN32Pixels(128, 128);
+    bm.eraseColor(SK_ColorBLUE);
+
+    SkCanvas expectedCanvas(expected);
+    draw_rects_and_bitmap(&expectedCanvas, bm);
+
+    SkCanvas actualCanvas(actual);
+    SkGPipeRingController controller(40 * 1024);
+    SkGPipeReaderThread thread(&controller, &actualCanvas);
+    if (!thread.start()) {
+        return;
+    }
+    SkGPipeWriter writer;
+    SkCanvas* pipeCanvas = writer.startRecording(&controller, SkGPipeRingController::kWriterFlags,
+                                                 kSize, kSize);
+    draw_rects_and_bitmap(pipeCanvas, bm);
+    writer.endRecording();
+    REPORTER_ASSERT(reporter, SkGPipeReader::kDone_Status == thread.join());
+
+    SkAutoLockPixels alpExpected(expected), alpActual(actual);
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
+
 DEF_TEST(Pipe, reporter) {
     SkBitmap bitmap;
     bitmap.setInfo(SkImageInfo::MakeN32Premul(64, 64));
@@ -53,4 +101,5 @@ DEF_TEST(Pipe, reporter) {
     writer.endRecording();
 
     testDrawingAfterEndRecording(&canvas);
+    test_ring_controller(reporter);
 }
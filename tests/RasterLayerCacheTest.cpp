@@ -0,0 +1,159 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapCache.h"
+#include "SkCanvas.h"
+#include "SkPictureRecorder.h"
+#include "Test.h"
+
+static const int kWidth = 100;
+static const int kHeight = 100;
+
+// create a picture with the structure:
+// 1)
+//      SaveLayer w/ alpha
+//          DrawRect
+//      Restore
+// 2)
+//      SaveLayer
+//          Translate
+//          SaveLayer w/ bound
+//              DrawOval
+//          Restore
+//      Restore
+// 3)
+//      Translate
+//      SaveLayer w/ bound & xfermode
+//          DrawCircle
+//      Restore
+static SkPicture* make_picture() {
+    SkPictureRecorder recorder;
+
+    SkCanvas* c = recorder.DEPRECATED_beginRecording(kWidth, kHeight);
+    c->drawColor(SK_ColorWHITE);
+
+    SkPaint red;
+    red.setColor(SK_ColorRED);
+    SkPaint blue;
+    blue.setColor(SK_ColorBLUE);
+    blue.setAntiAlias(true);
+
+    // 1)
+    {
+        SkPaint p;
+        p.setAlpha(0x80);
+        c->saveLayer(NULL, &p);
+            c->drawRect(SkRect::MakeXYWH(10, 10, 50, 30), red);
+        c->restore();
+    }
+
+    // 2)
+    c->saveLayer(NULL, NULL);
+        c->translate(kWidth/2, kHeight/2);
+        SkRect r = SkRect::MakeXYWH(0, 0, kWidth/2, kHeight/2);
+        c->saveLayer(&r, NULL);
+            c->drawOval(SkRect::MakeXYWH(5, 5, 30, 40), blue);
+        c->restore();
+    c->restore();
+
+    // 3)
+    c->translate(20, 60);
+    {
+        SkPaint p;
+        p.setXfermodeMode(SkXfermode::kMultiply_Mode);
+        SkRect bound = SkRect::MakeWH(30, 30);
+        c->saveLayer(&bound, &p);
+            c->drawCircle(15, 15, 12, blue);
+        c->restore();
+    }
+
+    return recorder.endRecording();
+}
+
+static void draw(const SkPicture* picture, bool optimize, int dx, int dy, SkBitmap* result) {
+    result->allocN32Pixels(kWidth + dx, kHeight + dy);
+    result->eraseColor(SK_ColorTRANSPARENT);
+
+    SkCanvas canvas(*result);
+    if (optimize) {
+        canvas.EXPERIMENTAL_optimize(picture);
+    }
+    canvas.translate(SkIntToScalar(dx), SkIntToScalar(dy));
+    canvas.drawPicture(picture);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    if (a.width() != b.width() || a.height() != b.height()) {
+        return false;
+    }
+    for (int y = 0; y < a.height(); ++y) {
+        if (0 != memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Drawing a picture through the raster layer cache, whether the layers are
+// rendered anew or found in the cache, gives the same pixels as drawing it
+// normally.
+DEF_TEST(RasterLayerCache_draw, reporter) {
+    SkAutoTUnref<SkPicture> picture(make_picture());
+
+    static const SkIPoint gOffsets[] = { { 0, 0 }, { 7, 3 } };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(gOffsets); ++i) {
+        const int dx = gOffsets[i].fX;
+        const int dy = gOffsets[i].fY;
+
+        SkBitmap expected, first, second;
+        draw(picture, false, dx, dy, &expected);
+        draw(picture, true, dx, dy, &first);
+        // The second draw finds every layer in the cache.
+        const size_t bytesUsed = SkScaledImageCache::GetTotalBytesUsed();
+        draw(picture, true, dx, dy, &second);
+        REPORTER_ASSERT(reporter, bytesUsed == SkScaledImageCache::GetTotalBytesUsed());
+
+        REPORTER_ASSERT(reporter, same_pixels(expected, first));
+        REPORTER_ASSERT(reporter, same_pixels(expected, second));
+    }
+}
+
+DEF_TEST(RasterLayerCache_findAndAdd, reporter) {
+    SkAutoTUnref<SkPicture> picture(make_picture());
+
+    SkBitmap layer;
+    layer.allocN32Pixels(16, 16);
+    layer.eraseColor(SK_ColorGREEN);
+
+    SkMatrix ctm;
+    ctm.setTranslate(-3, -4);
+
+    SkLayerCache::ID* id = SkLayerCache::AddAndLock(picture->uniqueID(), 12, 40, ctm, layer);
+    REPORTER_ASSERT(reporter, NULL != id);
+    SkLayerCache::Unlock(id);
+
+    SkBitmap found;
+    id = SkLayerCache::FindAndLock(picture->uniqueID(), 12, 40, ctm, &found);
+    REPORTER_ASSERT(reporter, NULL != id);
+    if (NULL != id) {
+        REPORTER_ASSERT(reporter, found.width() == 16 && found.height() == 16);
+        REPORTER_ASSERT(reporter, same_pixels(layer, found));
+        SkLayerCache::Unlock(id);
+    }
+
+    // Any difference in the key misses.
+    SkMatrix otherCTM;
+    otherCTM.setTranslate(-3, -5);
+    REPORTER_ASSERT(reporter, NULL == SkLayerCache::FindAndLock(picture->uniqueID(), 12, 40,
+                                                                otherCTM, &found));
+    REPORTER_ASSERT(reporter, NULL == SkLayerCache::FindAndLock(picture->uniqueID(), 12, 41,
+                                                                ctm, &found));
+    REPORTER_ASSERT(reporter, NULL == SkLayerCache::FindAndLock(picture->uniqueID() + 1, 12, 40,
+                                                                ctm, &found));
+}
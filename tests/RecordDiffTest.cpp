@@ -0,0 +1,208 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBlurImageFilter.h"
+#include "SkCanvas.h"
+#include "SkIncrementalRaster.h"
+#include "SkPictureRecorder.h"
+#include "SkPictureUtils.h"
+#include "SkRandom.h"
+#include "SkRTree.h"
+#include "Test.h"
+
+static const int kWidth = 200;
+static const int kHeight = 160;
+
+static const SkIRect kArea = SkIRect::MakeWH(kWidth, kHeight);
+
+// A frame of a simple animation: a static background, some blocks with their own clips and
+// matrices, and one moving oval.
+struct Frame {
+    SkScalar ovalX;
+    SkColor  blockColor;
+    SkScalar blockAngle;
+    int      extraRects;
+};
+
+static SkPicture* record(const Frame& frame, bool deprecated = false) {
+    SkPictureRecorder recorder;
+    SkRTreeFactory factory;
+    SkCanvas* canvas = deprecated ? recorder.DEPRECATED_beginRecording(kWidth, kHeight, &factory)
+                                  : recorder.EXPERIMENTAL_beginRecording(kWidth, kHeight, &factory);
+
+    // Anti-aliased edges crossing the edge of a clip often rasterize a little differently, so
+    // for exact comparisons with a full redraw we stick to aliased drawing.
+    SkPaint paint;
+
+    paint.setColor(0xFFEEEEEE);
+    canvas->drawRect(SkRect::MakeWH(SkIntToScalar(kWidth), SkIntToScalar(kHeight)), paint);
+
+    for (int i = 0; i < 4; i++) {
+        canvas->save();
+            canvas->translate(SkIntToScalar(10 + 45 * i), SkIntToScalar(10));
+            canvas->clipRect(SkRect::MakeWH(40, 60));
+            if (1 == i) {
+                canvas->translate(20, 30);
+                canvas->rotate(frame.blockAngle);
+                canvas->translate(-20, -30);
+            }
+            paint.setColor(2 == i ? frame.blockColor : SK_ColorBLUE);
+            canvas->drawRect(SkRect::MakeXYWH(5, 5, 30, 50), paint);
+            paint.setColor(SK_ColorYELLOW);
+            canvas->drawCircle(20, 30, 12, paint);
+        canvas->restore();
+    }
+
+    for (int i = 0; i < frame.extraRects; i++) {
+        paint.setColor(SK_ColorGREEN);
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(10 + 20 * i), 130, 15, 15), paint);
+    }
+
+    paint.setColor(SK_ColorRED);
+    canvas->drawOval(SkRect::MakeXYWH(frame.ovalX, 90, 30, 20), paint);
+
+    return recorder.endRecording();
+}
+
+static void draw_fully(const SkPicture* picture, SkBitmap* bitmap) {
+    bitmap->allocN32Pixels(kWidth, kHeight);
+    bitmap->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*bitmap);
+    canvas.drawPicture(picture);
+}
+
+static bool same_pixels(const SkBitmap& a, const SkBitmap& b) {
+    SkAutoLockPixels alpa(a);
+    SkAutoLockPixels alpb(b);
+    for (int y = 0; y < a.height(); y++) {
+        if (0 != memcmp(a.getAddr32(0, y), b.getAddr32(0, y), a.width() * sizeof(SkPMColor))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DEF_TEST(RecordDiff_unchanged, r) {
+    const Frame frame = { 50, SK_ColorCYAN, 0, 2 };
+    SkAutoTUnref<SkPicture> before(record(frame)), after(record(frame));
+
+    SkRegion damage;
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, damage.isEmpty());
+}
+
+DEF_TEST(RecordDiff_damage, r) {
+    const Frame frame = { 50, SK_ColorCYAN, 0, 2 };
+    SkAutoTUnref<SkPicture> before(record(frame));
+    SkRegion damage;
+
+    // Moving the oval damages where it was and where it is, and nothing else.
+    Frame moved = frame;
+    moved.ovalX = 120;
+    SkAutoTUnref<SkPicture> after(record(moved));
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, damage.contains(SkIRect::MakeXYWH(50, 90, 30, 20)));
+    REPORTER_ASSERT(r, damage.contains(SkIRect::MakeXYWH(120, 90, 30, 20)));
+    REPORTER_ASSERT(r, !damage.intersects(SkIRect::MakeXYWH(0, 0, kWidth, 80)));
+    REPORTER_ASSERT(r, !damage.intersects(SkIRect::MakeXYWH(90, 90, 20, 20)));
+
+    // A change of state inside a block damages only that block.
+    Frame rotated = frame;
+    rotated.blockAngle = 30;
+    after.reset(record(rotated));
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, !damage.isEmpty());
+    REPORTER_ASSERT(r, SkIRect::MakeXYWH(55, 10, 40, 60).contains(damage.getBounds()));
+
+    // Inserting ops damages just the new ops.
+    Frame inserted = frame;
+    inserted.extraRects = 3;
+    after.reset(record(inserted));
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, damage.contains(SkIRect::MakeXYWH(50, 130, 15, 15)));
+    REPORTER_ASSERT(r, !damage.intersects(SkIRect::MakeXYWH(10, 130, 35, 15)));
+
+    // Pictures that can't be compared op by op are entirely damaged.
+    after.reset(record(frame, true));
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, damage.isRect() && damage.getBounds() == kArea);
+
+    // As are pictures that can't be drawn piecewise.
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.EXPERIMENTAL_beginRecording(kWidth, kHeight);
+    SkAutoTUnref<SkImageFilter> blur(SkBlurImageFilter::Create(2, 2));
+    SkPaint paint;
+    paint.setImageFilter(blur);
+    canvas->drawRect(SkRect::MakeWH(10, 10), paint);
+    after.reset(recorder.endRecording());
+    SkPictureUtils::ComputeDamage(before, after, kArea, &damage);
+    REPORTER_ASSERT(r, damage.isRect() && damage.getBounds() == kArea);
+}
+
+// Incrementally drawing a sequence of frames always matches drawing each from scratch.
+DEF_TEST(RecordDiff_incrementalRaster, r) {
+    SkRandom rand;
+    SkIncrementalRaster raster(SkImageInfo::MakeN32Premul(kWidth, kHeight));
+
+    Frame frame = { 50, SK_ColorCYAN, 0, 2 };
+    for (int i = 0; i < 20; i++) {
+        switch (rand.nextULessThan(4)) {
+            case 0: frame.ovalX = rand.nextRangeScalar(0, kWidth); break;
+            case 1: frame.blockColor = rand.nextU() | 0xFF000000; break;
+            case 2: frame.blockAngle = rand.nextRangeScalar(0, 90); break;
+            case 3: frame.extraRects = rand.nextULessThan(8); break;
+        }
+        SkAutoTUnref<SkPicture> picture(record(frame));
+
+        SkRegion damage;
+        raster.draw(picture, &damage);
+        if (0 == i) {
+            REPORTER_ASSERT(r, damage.isRect() && damage.getBounds() == kArea);
+        }
+
+        SkBitmap expected;
+        draw_fully(picture, &expected);
+        REPORTER_ASSERT(r, same_pixels(expected, raster.bitmap()));
+    }
+}
+
+static SkPicture* record_grid(SkColor color) {
+    SkPictureRecorder recorder;
+    SkRTreeFactory factory;
+    SkCanvas* canvas = recorder.EXPERIMENTAL_beginRecording(kWidth, kHeight, &factory);
+
+    SkPaint paint;
+    paint.setColor(0xFFEEEEEE);
+    canvas->drawRect(SkRect::MakeWH(SkIntToScalar(kWidth), SkIntToScalar(kHeight)), paint);
+
+    paint.setColor(color);
+    for (int y = 0; y < 3; y++) {
+        for (int x = 0; x < 3; x++) {
+            canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar(10 + 60 * x),
+                                              SkIntToScalar(10 + 50 * y), 20, 20), paint);
+        }
+    }
+    return recorder.endRecording();
+}
+
+// Damage scattered over many rects is redrawn as one, not replayed once per rect.
+DEF_TEST(RecordDiff_incrementalRasterScattered, r) {
+    SkIncrementalRaster raster(SkImageInfo::MakeN32Premul(kWidth, kHeight));
+
+    SkAutoTUnref<SkPicture> before(record_grid(SK_ColorBLUE));
+    raster.draw(before);
+
+    SkAutoTUnref<SkPicture> after(record_grid(SK_ColorRED));
+    SkRegion damage;
+    raster.draw(after, &damage);
+    REPORTER_ASSERT(r, damage.isRect());
+    REPORTER_ASSERT(r, damage.getBounds() == SkIRect::MakeLTRB(10, 10, 150, 130));
+
+    SkBitmap expected;
+    draw_fully(after, &expected);
+    REPORTER_ASSERT(r, same_pixels(expected, raster.bitmap()));
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRowBandTask.h"
+#include "SkTemplates.h"
+#include "SkThreadPool.h"
+#include "Test.h"
+
+namespace {
+
+// Counts how many bands cover each row. Bands only write their own rows, so the counts need
+// no locking.
+class CountingTask : public SkRowBandTask {
+public:
+    CountingTask(int top, int bottom, int rowMultiple)
+        : fTop(top)
+        , fRowMultiple(rowMultiple)
+        , fCounts(bottom - top) {
+        sk_bzero(fCounts.get(), (bottom - top) * sizeof(int));
+    }
+
+    virtual void runBand(int top, int bottom) SK_OVERRIDE {
+        for (int y = top; y < bottom; ++y) {
+            fCounts[y - fTop]++;
+        }
+        // A band that does not start on a multiple of the row multiple spoils its first row.
+        if ((top - fTop) % fRowMultiple != 0) {
+            fCounts[top - fTop] = -1;
+        }
+    }
+
+    // Returns the first row not covered exactly once, or -1 if there is none.
+    int firstBadRow(int bottom) const {
+        for (int y = fTop; y < bottom; ++y) {
+            if (1 != fCounts[y - fTop]) {
+                return y;
+            }
+        }
+        return -1;
+    }
+
+private:
+    const int          fTop;
+    const int          fRowMultiple;
+    SkAutoTMalloc<int> fCounts;
+};
+
+}  // namespace
+
+DEF_TEST(RowBandTask_CoversEveryRowOnce, reporter) {
+    static const int kWidths[] = { 0, 1, 100, 1000, 70000 };
+    static const int kRanges[][2] = { { 0, 1 }, { 0, 1000 }, { -17, 2000 }, { 5, 5 } };
+    static const int kThreadCounts[] = { 0, 1, 3, SkThreadPool::kThreadPerCore };
+    static const int kRowMultiples[] = { 1, 4 };
+
+    for (size_t w = 0; w < SK_ARRAY_COUNT(kWidths); ++w) {
+        for (size_t r = 0; r < SK_ARRAY_COUNT(kRanges); ++r) {
+            for (size_t t = 0; t < SK_ARRAY_COUNT(kThreadCounts); ++t) {
+                for (size_t m = 0; m < SK_ARRAY_COUNT(kRowMultiples); ++m) {
+                    const int top = kRanges[r][0];
+                    const int bottom = kRanges[r][1];
+                    CountingTask task(top, bottom, kRowMultiples[m]);
+                    task.run(kWidths[w], top, bottom, kThreadCounts[t], kRowMultiples[m]);
+                    const int badRow = task.firstBadRow(bottom);
+                    if (badRow >= 0) {
+                        ERRORF(reporter, "row %d of [%d, %d) is not covered exactly once by "
+                               "bands %d wide, rows a multiple of %d, on %d threads",
+                               badRow, top, bottom, kWidths[w], kRowMultiples[m],
+                               kThreadCounts[t]);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
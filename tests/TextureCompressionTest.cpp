@@ -6,9 +6,13 @@
  */
 
 #include "SkBitmap.h"
+#include "SkColorPriv.h"
 #include "SkData.h"
+#include "SkDraw.h"
 #include "SkEndian.h"
 #include "SkImageInfo.h"
+#include "SkRandom.h"
+#include "SkRasterClip.h"
 #include "SkTextureCompressor.h"
 #include "Test.h"
 
@@ -274,3 +278,300 @@ DEF_TEST(CompressLATC, reporter) {
         }
     }
 }
+
+// Random alpha with a good number of solid and nearly solid blocks.
+static void fill_random_a8(SkRandom* random, uint8_t* pixels, int width, int height) {
+    for (int y = 0; y < height; y += 4) {
+        for (int x = 0; x < width; x += 4) {
+            const int kind = random->nextULessThan(4);
+            for (int j = 0; j < 4; ++j) {
+                for (int i = 0; i < 4; ++i) {
+                    uint8_t a;
+                    switch (kind) {
+                        case 0:  a = 0;                                   break;
+                        case 1:  a = 0xFF;                                break;
+                        case 2:  a = random->nextBool() ? 0xFF : 0xFE;    break;
+                        default: a = random->nextU() & 0xFF;              break;
+                    }
+                    pixels[(y + j) * width + x + i] = a;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Make sure that the platform-optimized alpha encoders produce exactly the bits of the
+ * portable ones, including when the width is not a multiple of their preferred width.
+ */
+DEF_TEST(CompressAlphaOptimized, reporter) {
+    static const int kWidths[] = { 4, 16, 52, 64 };
+    static const int kHeight = 12;
+    static const SkTextureCompressor::Format kFormats[] = {
+        SkTextureCompressor::kLATC_Format,
+        SkTextureCompressor::kR11_EAC_Format,
+    };
+
+    SkRandom random;
+    for (size_t w = 0; w < SK_ARRAY_COUNT(kWidths); ++w) {
+        const int width = kWidths[w];
+        SkAutoTMalloc<uint8_t> pixels(width * kHeight);
+        fill_random_a8(&random, pixels.get(), width, kHeight);
+
+        for (size_t f = 0; f < SK_ARRAY_COUNT(kFormats); ++f) {
+            const int size =
+                SkTextureCompressor::GetCompressedDataSize(kFormats[f], width, kHeight);
+            SkAutoTMalloc<uint8_t> opt(size), portable(size);
+            REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                opt.get(), pixels.get(), kAlpha_8_SkColorType, width, kHeight, width,
+                kFormats[f], true));
+            REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                portable.get(), pixels.get(), kAlpha_8_SkColorType, width, kHeight, width,
+                kFormats[f], false));
+            REPORTER_ASSERT(reporter, 0 == memcmp(opt.get(), portable.get(), size));
+        }
+    }
+}
+
+/**
+ * Make sure that compressing in parallel gives the same result as compressing serially.
+ */
+DEF_TEST(CompressInParallel, reporter) {
+    // Tall enough to be split into several bands, and multiples of 12 for ASTC.
+    static const int kWidth = 240;
+    static const int kHeight = 768;
+
+    SkRandom random;
+    SkBitmap a8, n32;
+    a8.allocPixels(SkImageInfo::MakeA8(kWidth, kHeight));
+    n32.allocN32Pixels(kWidth, kHeight);
+    {
+        SkAutoLockPixels alp8(a8), alp32(n32);
+        fill_random_a8(&random, a8.getAddr8(0, 0), kWidth, kHeight);
+        for (int y = 0; y < kHeight; ++y) {
+            for (int x = 0; x < kWidth; ++x) {
+                *n32.getAddr32(x, y) = SkPreMultiplyColor(random.nextU());
+            }
+        }
+    }
+
+    static const struct {
+        SkTextureCompressor::Format fFormat;
+        const SkBitmap*             fBitmap;
+    } kCases[] = {
+        { SkTextureCompressor::kLATC_Format,       &a8  },
+        { SkTextureCompressor::kR11_EAC_Format,    &a8  },
+        { SkTextureCompressor::kASTC_12x12_Format, &a8  },
+        { SkTextureCompressor::kETC1_Format,       &n32 },
+    };
+
+    static const int kThreadCounts[] = { 0, 3, SkThreadPool::kThreadPerCore };
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(kCases); ++i) {
+        const SkBitmap& bitmap = *kCases[i].fBitmap;
+        SkAutoLockPixels alp(bitmap);
+
+        const int size =
+            SkTextureCompressor::GetCompressedDataSize(kCases[i].fFormat, kWidth, kHeight);
+        SkAutoTMalloc<uint8_t> serial(size);
+        REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+            serial.get(), reinterpret_cast<const uint8_t*>(bitmap.getPixels()),
+            bitmap.colorType(), kWidth, kHeight, bitmap.rowBytes(), kCases[i].fFormat));
+
+        for (size_t t = 0; t < SK_ARRAY_COUNT(kThreadCounts); ++t) {
+            SkAutoTMalloc<uint8_t> parallel(size);
+            REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormatInParallel(
+                parallel.get(), reinterpret_cast<const uint8_t*>(bitmap.getPixels()),
+                bitmap.colorType(), kWidth, kHeight, bitmap.rowBytes(), kCases[i].fFormat,
+                kThreadCounts[t]));
+            REPORTER_ASSERT(reporter, 0 == memcmp(serial.get(), parallel.get(), size));
+        }
+    }
+}
+
+/**
+ * Make sure that ETC1 compresses N32 bitmaps, and that they decompress to nearly the
+ * original colors.
+ */
+DEF_TEST(CompressETC1FromN32, reporter) {
+    static const int kWidth = 32;
+    static const int kHeight = 32;
+
+    // A smooth opaque gradient, which ETC1 should encode closely.
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(kWidth, kHeight);
+    SkAutoLockPixels alp(bitmap);
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            *bitmap.getAddr32(x, y) = SkPackARGB32(0xFF, 8 * x, 8 * y, 128);
+        }
+    }
+
+    SkAutoDataUnref data(
+        SkTextureCompressor::CompressBitmapToFormat(bitmap, SkTextureCompressor::kETC1_Format));
+    REPORTER_ASSERT(reporter, NULL != data);
+    if (NULL == data) {
+        return;
+    }
+
+    SkAutoTMalloc<uint8_t> rgb(3 * kWidth * kHeight);
+    REPORTER_ASSERT(reporter, SkTextureCompressor::DecompressBufferFromFormat(
+        rgb.get(), 3 * kWidth, data->bytes(), kWidth, kHeight,
+        SkTextureCompressor::kETC1_Format));
+
+    int maxError = 0;
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            const SkPMColor c = *bitmap.getAddr32(x, y);
+            const uint8_t* decoded = rgb.get() + 3 * (y * kWidth + x);
+            maxError = SkTMax(maxError, SkAbs32(decoded[0] - (int)SkGetPackedR32(c)));
+            maxError = SkTMax(maxError, SkAbs32(decoded[1] - (int)SkGetPackedG32(c)));
+            maxError = SkTMax(maxError, SkAbs32(decoded[2] - (int)SkGetPackedB32(c)));
+        }
+    }
+    // ETC1 is lossy, but nowhere near as lossy as dropping or swapping a channel.
+    REPORTER_ASSERT(reporter, maxError <= 32);
+}
+
+static const int kBandWidth = 100;
+static const int kBandHeight = 68;
+
+// Draws path with paint through SkDraw. If format is an A8-compressible format, draws
+// through the band blitter into compressed, otherwise into the A8 bitmap.
+static void draw_coverage(const SkPath& path, const SkPaint& paint, SkBitmap* bitmap,
+                          SkTextureCompressor::Format format, uint8_t* compressed) {
+    SkRasterClip rasterClip(SkIRect::MakeWH(kBandWidth, kBandHeight));
+    SkMatrix identity;
+    identity.reset();
+
+    SkDraw draw;
+    draw.fBitmap = bitmap;
+    draw.fMatrix = &identity;
+    draw.fClip = &rasterClip.bwRgn();
+    draw.fRC = &rasterClip;
+
+    if (NULL == compressed) {
+        draw.drawPathCoverage(path, paint);
+        return;
+    }
+
+    SkTBlitterAllocator allocator;
+    SkBlitter* blitter = SkTextureCompressor::CreateBandBlitterForFormat(
+        kBandWidth, kBandHeight, compressed, &allocator, format);
+    SkASSERT(NULL != blitter);
+    draw.drawPathCoverage(path, paint, blitter);
+}
+
+// The band blitter may encode a block differently from compressing the whole A8 mask when it
+// revisits the block, e.g. as a solid block, but it must decompress to the same pixels.
+static bool decompress_equal(SkTextureCompressor::Format format,
+                             const uint8_t* expected, const uint8_t* actual) {
+    uint8_t expectedPixels[kBandWidth * kBandHeight];
+    uint8_t actualPixels[kBandWidth * kBandHeight];
+    SkTextureCompressor::DecompressBufferFromFormat(expectedPixels, kBandWidth, expected,
+                                                    kBandWidth, kBandHeight, format);
+    SkTextureCompressor::DecompressBufferFromFormat(actualPixels, kBandWidth, actual,
+                                                    kBandWidth, kBandHeight, format);
+    return 0 == memcmp(expectedPixels, actualPixels, sizeof(expectedPixels));
+}
+
+/**
+ * Make sure that blitting straight into compressed blocks a band at a time gives the same
+ * result as drawing an A8 mask and compressing that, for all kinds of path drawing.
+ */
+DEF_TEST(CompressBandBlitter, reporter) {
+    static const SkTextureCompressor::Format kFormats[] = {
+        SkTextureCompressor::kLATC_Format,
+        SkTextureCompressor::kR11_EAC_Format,
+    };
+
+    SkPath star;
+    star.moveTo(50, 2);
+    star.lineTo(80, 64);
+    star.lineTo(5, 22);
+    star.lineTo(95, 22);
+    star.lineTo(20, 64);
+    star.close();
+
+    SkPath inverse(star);
+    inverse.setFillType(SkPath::kInverseWinding_FillType);
+
+    SkPath circle;
+    circle.addCircle(30, 40, 25);
+
+    const struct {
+        const SkPath*  fPath;
+        SkPaint::Style fStyle;
+        SkScalar       fStrokeWidth;
+    } kDraws[] = {
+        { &star,    SkPaint::kFill_Style,   0  },
+        { &inverse, SkPaint::kFill_Style,   0  },
+        { &circle,  SkPaint::kStroke_Style, 0  },  // hairline
+        { &circle,  SkPaint::kStroke_Style, 7  },
+    };
+
+    SkBitmap a8;
+    a8.allocPixels(SkImageInfo::MakeA8(kBandWidth, kBandHeight));
+
+    // The band blitter doesn't need pixels, just the size.
+    SkBitmap noPixels;
+    noPixels.setInfo(SkImageInfo::MakeA8(kBandWidth, kBandHeight));
+
+    for (size_t f = 0; f < SK_ARRAY_COUNT(kFormats); ++f) {
+        const int size =
+            SkTextureCompressor::GetCompressedDataSize(kFormats[f], kBandWidth, kBandHeight);
+        SkAutoTMalloc<uint8_t> expected(size), actual(size);
+
+        for (size_t d = 0; d < SK_ARRAY_COUNT(kDraws); ++d) {
+            for (int aa = 0; aa < 2; ++aa) {
+                SkPaint paint;
+                paint.setAntiAlias(SkToBool(aa));
+                paint.setStyle(kDraws[d].fStyle);
+                paint.setStrokeWidth(kDraws[d].fStrokeWidth);
+
+                a8.eraseColor(SK_ColorTRANSPARENT);
+                draw_coverage(*kDraws[d].fPath, paint, &a8, kFormats[f], NULL);
+                SkAutoLockPixels alp(a8);
+                REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                    expected.get(), a8.getAddr8(0, 0), kAlpha_8_SkColorType,
+                    kBandWidth, kBandHeight, a8.rowBytes(), kFormats[f]));
+
+                draw_coverage(*kDraws[d].fPath, paint, &noPixels, kFormats[f], actual.get());
+                REPORTER_ASSERT(reporter, decompress_equal(kFormats[f], expected, actual));
+            }
+        }
+
+        // Blits can also come out of order.
+        a8.eraseColor(SK_ColorTRANSPARENT);
+        {
+            SkAutoLockPixels alp(a8);
+            SkTBlitterAllocator allocator;
+            SkBlitter* blitter = SkTextureCompressor::CreateBandBlitterForFormat(
+                kBandWidth, kBandHeight, actual.get(), &allocator, kFormats[f]);
+
+            blitter->blitRect(10, 30, 50, 9);
+            blitter->blitV(70, 3, 60, 0x80);
+            blitter->blitH(2, 1, 40);
+            blitter->blitH(20, 35, 70);
+
+            for (int y = 30; y < 39; ++y) {
+                memset(a8.getAddr8(10, y), 0xFF, 50);
+            }
+            for (int y = 3; y < 63; ++y) {
+                *a8.getAddr8(70, y) = 0x80;
+            }
+            memset(a8.getAddr8(2, 1), 0xFF, 40);
+            memset(a8.getAddr8(20, 35), 0xFF, 70);
+
+            REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                expected.get(), a8.getAddr8(0, 0), kAlpha_8_SkColorType,
+                kBandWidth, kBandHeight, a8.rowBytes(), kFormats[f]));
+        }
+        REPORTER_ASSERT(reporter, decompress_equal(kFormats[f], expected, actual));
+    }
+
+    // Formats without a band blitter.
+    SkTBlitterAllocator allocator;
+    REPORTER_ASSERT(reporter, NULL == SkTextureCompressor::CreateBandBlitterForFormat(
+        kBandWidth, kBandHeight, NULL, &allocator, SkTextureCompressor::kETC1_Format));
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2014 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCommandLineFlags.h"
+#include "SkData.h"
+#include "SkForceLinking.h"
+#include "SkGraphics.h"
+#include "SkOSFile.h"
+#include "SkPicture.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+#include "Stats.h"
+#include "Timer.h"
+
+__SK_FORCE_IMAGE_DECODER_LINKING;
+
+DEFINE_string2(skps, r, "skps", "Directory containing SKPs to serialize.");
+DEFINE_int32(samples, 10, "Gather this many samples of each picture load.");
+DEFINE_string(match, "", "The usual filters on file names of SKPs to bench.");
+DEFINE_string(timescale, "ms", "Print times in ms, us, or ns");
+
+static double timescale() {
+    if (FLAGS_timescale.contains("us")) return 1000;
+    if (FLAGS_timescale.contains("ns")) return 1000000;
+    return 1;
+}
+
+// Returns the fastest of FLAGS_samples loads of data, or -1 if it fails to load.
+static double time_load(SkData* data) {
+    WallTimer timer;
+    SkAutoTMalloc<double> samples(FLAGS_samples);
+    for (int i = 0; i < FLAGS_samples; i++) {
+        SkMemoryStream stream(data);
+        timer.start();
+        SkAutoTUnref<SkPicture> picture(SkPicture::CreateFromStream(&stream));
+        timer.end();
+        if (NULL == picture.get()) {
+            return -1;
+        }
+        samples[i] = timer.fWall * timescale();
+    }
+    return Stats(samples.get(), FLAGS_samples).min;
+}
+
+int tool_main(int argc, char** argv);
+int tool_main(int argc, char** argv) {
+    SkCommandLineFlags::Parse(argc, argv);
+    SkAutoGraphics autoGraphics;
+
+    printf("size\tcompact\tratio\tload\tcompact\tname\n");
+
+    SkOSFile::Iter it(FLAGS_skps[0], ".skp");
+    SkString filename;
+    bool failed = false;
+    size_t totalSize = 0, totalCompactSize = 0;
+    while (it.next(&filename)) {
+        if (SkCommandLineFlags::ShouldSkip(FLAGS_match, filename.c_str())) {
+            continue;
+        }
+
+        const SkString path = SkOSPath::Join(FLAGS_skps[0], filename.c_str());
+
+        SkAutoTUnref<SkStream> stream(SkStream::NewFromFile(path.c_str()));
+        if (!stream) {
+            SkDebugf("Could not read %s.\n", path.c_str());
+            failed = true;
+            continue;
+        }
+        SkAutoTUnref<const SkPicture> src(SkPicture::CreateFromStream(stream));
+        if (!src) {
+            SkDebugf("Could not read %s as an SkPicture.\n", path.c_str());
+            failed = true;
+            continue;
+        }
+
+        // Reserialize rather than using the file as is, so both are written by the same code.
+        SkDynamicMemoryWStream normalStream, compactStream;
+        src->serialize(&normalStream);
+        src->serializeCompact(&compactStream);
+        SkAutoDataUnref normal(normalStream.copyToData());
+        SkAutoDataUnref compact(compactStream.copyToData());
+
+        const double loadTime = time_load(normal);
+        const double compactLoadTime = time_load(compact);
+        if (loadTime < 0 || compactLoadTime < 0) {
+            SkDebugf("Could not reload %s.\n", path.c_str());
+            failed = true;
+            continue;
+        }
+
+        totalSize += normal->size();
+        totalCompactSize += compact->size();
+        printf("%u\t%u\t%.3f\t%g\t%g\t%s\n",
+               SkToU32(normal->size()), SkToU32(compact->size()),
+               (double)compact->size() / normal->size(),
+               loadTime, compactLoadTime, filename.c_str());
+    }
+    if (totalSize > 0) {
+        printf("%u\t%u\t%.3f\t\t\ttotal\n",
+               SkToU32(totalSize), SkToU32(totalCompactSize),
+               (double)totalCompactSize / totalSize);
+    }
+    return failed ? 1 : 0;
+}
+
+#if !defined SK_BUILD_FOR_IOS
+int main(int argc, char * const argv[]) {
+    return tool_main(argc, (char**) argv);
+}
+#endif
@@ -8,6 +8,7 @@
 #include "SkCommandLineFlags.h"
 #include "SkPicture.h"
 #include "SkPictureData.h"
+#include "SkReadBuffer.h"
 #include "SkStream.h"
 
 DEFINE_string2(input, i, "", "skp on which to report");
@@ -83,6 +84,28 @@ int tool_main(int argc, char** argv) {
         }
 
         uint32_t chunkSize = stream.readU32();
+
+        // As of V34 the op stream and buffer chunks are preceded by a byte giving the
+        // amount of padding that follows it.
+        if (info.fVersion >= SkReadBuffer::kAlignedPictureChunks_Version &&
+            (SK_PICT_READER_TAG == tag || SK_PICT_BUFFER_SIZE_TAG == tag)) {
+            const size_t padding = stream.readU8();
+            if (padding >= 4 || !stream.move(padding)) {
+                if (!FLAGS_quiet) {
+                    SkDebugf("bad chunk padding\n");
+                }
+                return kTruncatedFile;
+            }
+        }
+
+        // The draw index chunk's size is its number of entries.
+        if (SK_PICT_DRAW_INDEX_TAG == tag) {
+            if (FLAGS_tags && !FLAGS_quiet) {
+                SkDebugf("SK_PICT_DRAW_INDEX_TAG %d\n", chunkSize);
+            }
+            chunkSize *= sizeof(SkPictDrawIndexEntry);
+        }
+
         size_t curPos = stream.getPosition();
 
         // "move" doesn't error out when seeking beyond the end of file
@@ -104,6 +127,18 @@ int tool_main(int argc, char** argv) {
                 SkDebugf("SK_PICT_READER_TAG %d\n", chunkSize);
             }
             break;
+        case SK_PICT_COMPACT_READER_TAG:
+            if (FLAGS_tags && !FLAGS_quiet) {
+                SkDebugf("SK_PICT_COMPACT_READER_TAG %d\n", chunkSize);
+            }
+            break;
+        case SK_PICT_DRAW_INDEX_TAG:
+            break;
+        case SK_PICT_RESOURCE_INDEX_TAG:
+            if (FLAGS_tags && !FLAGS_quiet) {
+                SkDebugf("SK_PICT_RESOURCE_INDEX_TAG %d\n", chunkSize);
+            }
+            break;
         case SK_PICT_FACTORY_TAG:
             if (FLAGS_tags && !FLAGS_quiet) {
                 SkDebugf("SK_PICT_FACTORY_TAG %d\n", chunkSize);
@@ -137,6 +172,11 @@ int tool_main(int argc, char** argv) {
                 SkDebugf("SK_PICT_BUFFER_SIZE_TAG %d\n", chunkSize);
             }
             break;
+        case SK_PICT_COMPACT_BUFFER_TAG:
+            if (FLAGS_tags && !FLAGS_quiet) {
+                SkDebugf("SK_PICT_COMPACT_BUFFER_TAG %d\n", chunkSize);
+            }
+            break;
         default:
             if (!FLAGS_quiet) {
                 SkDebugf("Unknown tag %d\n", chunkSize);